@@ -37,20 +37,29 @@ uniform Material _Material;
 uniform vec3 _CamPos;
 uniform sampler2D _Texture;
 
-//Terrain texture
-uniform sampler2D _TextureSnow;
-uniform sampler2D _TextureGrass;
-uniform sampler2D _TextureRock;
+//Terrain textures: one array layer per surface, and a lookup from normalized height to the layers
+//blended there (JSLib::buildTerrainWeights). Adding layers adds no samplers or binds.
+uniform sampler2DArray _TerrainLayers;
+uniform sampler1D _TerrainWeights;
+
+//Virtual texture (ew/virtualTexture.h) used instead of the layers when set: a page table with a mip per
+//virtual mip, whose texels hold an atlas slot and the mip of the page there, and the atlas of resident pages
+uniform bool _UseVirtualTexture;
+uniform usampler2D _PageTable;
+uniform sampler2D _PageAtlas;
+uniform vec4 _VTParams; //Virtual size, page size, border, last mip
+uniform float _VTAtlasSize;
+
+//Image based lighting (gjn/cubemap.h): ambient light from the irradiance map, and a reflection from the
+//prefiltered specular level matching the material's shininess
+uniform bool _UseIBL;
+uniform samplerCube _IrradianceMap;
+uniform samplerCube _SpecularMap;
 
 //Terrain uniforms
 uniform float _terMinY;
 uniform float _terMaxY;
 
-uniform float _HBTrange1;
-uniform float _HBTrange2;
-uniform float _HBTrange3;
-uniform float _HBTrange4;
-
 /*     Pre:  Uniform values from Lights distance and radius. Takes in clamp range. 
 *  Purpose:  Calculate UE windows for spotlight and point light
 *************************************************************/
@@ -63,59 +72,56 @@ float calculateWindowed(float lDistance, float lRadius, int clampValue) {
 *************************************************************/
 vec4 heightBasedTexture(float scaleIn)
 {
-		vec4 color;
+		//r and g are the even and odd layer at this height, b is the odd layer's weight
+		vec3 weights = texture(_TerrainWeights, scaleIn).rgb;
 
-		//If vertex below range 1 texture as rock
-		if (scaleIn >= 0.0 && scaleIn <= _HBTrange1)
+		//Gradients from outside the branches, so each layer is fetched only where it is visible
+		vec2 dx = dFdx(fs_in.UV), dy = dFdy(fs_in.UV);
+		vec4 color = vec4(0.0);
+		if (weights.b < 1.0)
 		{
-			color = texture(_TextureRock,fs_in.UV);
+			color += textureGrad(_TerrainLayers, vec3(fs_in.UV, weights.r * 255.0), dx, dy) * (1.0 - weights.b);
 		}
-		//If vertex between range1 and range2 texture as mix between rock and grass
-		else if (scaleIn <= _HBTrange2)
+		if (weights.b > 0.0)
 		{
-			scaleIn -= _HBTrange1;
-			scaleIn /= (_HBTrange2 - _HBTrange1);
-
-			float scaletmp = scaleIn;
-			scaleIn = 1.0f - scaleIn;
-
-			color += texture(_TextureRock,fs_in.UV) * scaleIn;
-			color += texture(_TextureGrass,fs_in.UV) * scaletmp;
+			color += textureGrad(_TerrainLayers, vec3(fs_in.UV, weights.g * 255.0), dx, dy) * weights.b;
 		}
-		//If vertex between range2 and range 3 texture as grass
-		else if (scaleIn <= _HBTrange3)
-		{
-			color = texture(_TextureGrass,fs_in.UV);
-		}
-		//If vertex between range3 and range4 texture as mix between grass and snow
-		else if (scaleIn <= _HBTrange4)
-		{
-			scaleIn -= _HBTrange3;
-			scaleIn /= (_HBTrange4 - _HBTrange3);
 
-			float scaletmp = scaleIn;
-			scaleIn = 1.0f - scaleIn;
+		return color;
+}
 
-			color += texture(_TextureGrass,fs_in.UV) * scaleIn;
-			color += texture(_TextureSnow,fs_in.UV) * scaletmp;
-		}
-		//If vertex above range4 texture as snow
-		else
+/*     Pre:  UV across the whole virtual texture.
+ *  Purpose:  Sample the page this pixel needs, or the finest resident page above it. vtFeedback.frag picks
+ *            the same mip and page, so what is drawn here is what gets loaded.
+*************************************************************/
+vec4 virtualTexture(vec2 uv)
+{
+		vec2 texel = uv * _VTParams.x;
+		vec2 dx = dFdx(texel), dy = dFdy(texel);
+		int mip = int(clamp(floor(0.5 * log2(max(dot(dx, dx), dot(dy, dy)))), 0.0, _VTParams.w));
+		int pages = int(_VTParams.x / _VTParams.y) >> mip;
+		ivec2 page = clamp(ivec2(uv * pages), ivec2(0), ivec2(pages - 1));
+		uvec4 entry = texelFetch(_PageTable, page, mip);
+		if (entry.b == 255u)
 		{
-			color = texture(_TextureSnow,fs_in.UV);
+			return vec4(0.5, 0.5, 0.5, 1.0);
 		}
 
-		return color;
+		//Position within the page that is resident, which may be coarser than the one asked for
+		int residentMip = int(entry.b);
+		vec2 inPage = uv * float(int(_VTParams.x / _VTParams.y) >> residentMip) - vec2(page >> (residentMip - mip));
+		vec2 atlasUV = (vec2(entry.rg) * (_VTParams.y + 2.0 * _VTParams.z) + _VTParams.z + inPage * _VTParams.y) / _VTAtlasSize;
+		return textureLod(_PageAtlas, atlasUV, 0.0);
 }
 
 void main(){
 	vec3 normal = normalize(fs_in.WorldNormal);
 
 	float scale = abs(fs_in.WorldPosition.y - _terMinY) / abs(_terMaxY - _terMinY);
-	vec4 newTexture =  heightBasedTexture(scale);
+	vec4 newTexture = _UseVirtualTexture ? virtualTexture(fs_in.UV) : heightBasedTexture(scale);
 
 	vec3 v = normalize(_CamPos - fs_in.WorldPosition);
-	vec3 totalLightColor, h;
+	vec3 totalLightColor = vec3(0.0), h;
 	float lightIntensity = 1.0f;
 
 	for(int i = 0; i < _NumLights; i++) {
@@ -177,5 +183,15 @@ void main(){
 		}
 	}
 	
-	FragColor = vec4(newTexture.rgb *= totalLightColor, 1.0);
+	vec3 color = newTexture.rgb * totalLightColor;
+	if (_UseIBL) {
+		color += newTexture.rgb * _Material.ambientK * texture(_IrradianceMap, normal).rgb;
+
+		//Blinn-Phong exponent to GGX roughness, whose square is the specular levels' alpha
+		float roughness = pow(2.0 / (_Material.shininess + 2.0), 0.25);
+		float maxLevel = float(textureQueryLevels(_SpecularMap) - 1);
+		float fresnel = 0.04 + 0.96 * pow(1.0 - max(dot(normal, v), 0.0), 5.0);
+		color += _Material.specular * fresnel * textureLod(_SpecularMap, reflect(-v, normal), roughness * maxLevel).rgb;
+	}
+	FragColor = vec4(color, 1.0);
 }
@@ -8,10 +8,13 @@ out vec3 TexCoords;
 
 uniform mat4 _Projection;
 uniform mat4 _View;
+//1 normally, 0 with reverse-Z
+uniform float _FarDepth = 1.0;
 
 void main()
 {
     TexCoords = aPos;
     vec4 pos = _Projection * _View * vec4(aPos, 1.0);
-    gl_Position = pos.xyww;
+    //Pin depth to the far plane, behind everything
+    gl_Position = vec4(pos.xy, pos.w * _FarDepth, pos.w);
 }  
\ No newline at end of file
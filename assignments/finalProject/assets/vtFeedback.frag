@@ -0,0 +1,21 @@
+#version 450
+out vec4 FragColor;
+
+in Surface{
+	vec2 UV;
+	vec3 WorldPosition, WorldNormal;
+}fs_in;
+
+//Writes the virtual texture page this pixel samples, in ew::encodeFeedbackTexel's layout.
+//Drawn into a framebuffer _VTMipBias stops smaller than the screen, so it picks defaultLit.frag's mip.
+uniform vec4 _VTParams; //Virtual size, page size, border, last mip
+uniform float _VTMipBias;
+
+void main(){
+	vec2 texel = fs_in.UV * _VTParams.x;
+	vec2 dx = dFdx(texel), dy = dFdy(texel);
+	int mip = int(clamp(floor(0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + _VTMipBias), 0.0, _VTParams.w));
+	int pages = int(_VTParams.x / _VTParams.y) >> mip;
+	ivec2 page = clamp(ivec2(fs_in.UV * pages), ivec2(0), ivec2(pages - 1));
+	FragColor = vec4(page.x & 255, page.y & 255, (page.x >> 8) | ((page.y >> 8) << 4), mip + 1) / 255.0;
+}
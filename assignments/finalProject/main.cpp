@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include <vector>
 #include <filesystem>
@@ -16,6 +17,15 @@
 #include <ew/transform.h>
 #include <ew/camera.h>
 #include <ew/cameraController.h>
+#include <ew/fileWatcher.h>
+#include <ew/renderState.h>
+#include <ew/framebuffer.h>
+#include <ew/assetLoader.h>
+#include <ew/textureManager.h>
+#include <ew/textureStreamer.h>
+#include <ew/virtualTexture.h>
+#include <ew/renderQueue.h>
+#include <ew/profiler.h>
 #include <ew/external/stb_image.h>
 
 #include <gjn/cubemap.h>
@@ -25,7 +35,7 @@
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 void resetCamera(ew::Camera& camera, ew::CameraController& cameraController);
 void resetTerrain(ew::Transform& terrainTransform, float& HBTrange1, float& HBTrange2, float& HBTrange3, float& HBTrange4);
-ew::Mat4 mat3Conversion(const ew::Mat4& m);
+bool openTerrainVirtualTexture(ew::VirtualTexture& virtualTexture, int heightmapNum, const std::vector<std::string>& layerPaths, const float* blendHeights, bool rebake);
 
 int SCREEN_WIDTH = 1080;
 int SCREEN_HEIGHT = 720;
@@ -79,26 +89,87 @@ int main() {
 	ImGui_ImplOpenGL3_Init();
 
 	//Global settings
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
-	glEnable(GL_DEPTH_TEST);
+	ew::renderState::setEnabled(GL_CULL_FACE, true);
+	ew::renderState::cullFace(GL_BACK);
+	ew::renderState::setEnabled(GL_DEPTH_TEST, true);
+	ew::renderState::depthFunc(GL_LESS);
+
+	//The scene is drawn into a float depth target with reverse-Z, so the terrain can be seen to any distance
+	//without z-fighting. It is copied to the window before the UI is drawn.
+	camera.reverseZ = ew::renderState::setReverseZ(true);
+	ew::Framebuffer sceneFramebuffer = ew::createFramebuffer(SCREEN_WIDTH, SCREEN_HEIGHT, true);
+
+	//Images are decoded and terrain built on worker threads. Handles are valid right away, and
+	//everything is uploaded by assetLoader.finish() below.
+	ew::AssetLoader assetLoader;
+	//Textures loaded through textureManager share a memory budget: idle ones lose their top mips to make room
+	ew::TextureManager textureManager(assetLoader, (size_t)256 << 20);
+	//Edited terrain layers go through textureStreamer, a few MB per frame, so saving one doesn't hitch a frame
+	ew::TextureStreamer textureStreamer;
+	//Terrain surfaces from the bottom of the terrain to the top, as the layers of one texture array.
+	//Color textures are BC1 compressed when the context supports it: 6x less memory and bandwidth than RGB8.
+	const std::vector<std::string> terrainLayerPaths{
+		"assets/textures/rock_color.jpg",
+		"assets/textures/grass_color.jpg",
+		"assets/textures/snow_color.jpg"
+	};
+	const int numTerrainLayers = (int)terrainLayerPaths.size();
+	unsigned int terrainLayers = textureManager.loadArray(terrainLayerPaths, GL_REPEAT, GL_LINEAR, ew::TextureCompression::BC1);
+
+	//Create terrain mesh
+	ew::Mesh terrainMesh1, terrainMesh2, terrainMesh3;
+	ew::loadMeshAsync(assetLoader, terrainMesh1, "assets/heightmaps/heightmap01.jpg", JSLib::createTerrain);
+	ew::loadMeshAsync(assetLoader, terrainMesh2, "assets/heightmaps/heightmap02.jpg", JSLib::createTerrain);
+	ew::loadMeshAsync(assetLoader, terrainMesh3, "assets/heightmaps/heightmap03.jpg", JSLib::createTerrain);
+
+	std::vector<std::string> faces {
+			"assets/right.jpg",
+			"assets/left.jpg",
+			"assets/top.jpg",
+			"assets/bottom.jpg",
+			"assets/front.jpg",
+			"assets/back.jpg"
+	};
+	//The sky, with the prefiltered maps for image based lighting. Built on first run and cached after.
+	gjn::CubemapOptions skyOptions;
+	skyOptions.prefilter = true;
+	gjn::Cubemap sky = gjn::loadEnvironmentAsync(assetLoader, faces, skyOptions);
+	bool useIBL = false;
 
 	ew::Shader shader("assets/defaultLit.vert", "assets/defaultLit.frag");
 	ew::Shader unlitShader("assets/unlit.vert", "assets/unlit.frag");
 	ew::Shader skyboxShader("assets/skybox.vert", "assets/skybox.frag");
-
-	unsigned int brickTexture = ew::loadTexture("assets/brick_color.jpg", GL_REPEAT,GL_LINEAR);
-	unsigned int snowTexture = ew::loadTexture("assets/textures/snow_color.jpg", GL_REPEAT, GL_LINEAR);
-	unsigned int grassTexture = ew::loadTexture("assets/textures/grass_color.jpg", GL_REPEAT, GL_LINEAR);
-	unsigned int rockTexture = ew::loadTexture("assets/textures/rock_color.jpg", GL_REPEAT, GL_LINEAR);
-
-	//Create terrain mesh
-	ew::Mesh terrainMesh1(JSLib::createTerrain("assets/heightmaps/heightmap01.jpg"));
-	ew::Mesh terrainMesh2(JSLib::createTerrain("assets/heightmaps/heightmap02.jpg"));
-	ew::Mesh terrainMesh3(JSLib::createTerrain("assets/heightmaps/heightmap03.jpg"));
+	ew::Shader feedbackShader("assets/defaultLit.vert", "assets/vtFeedback.frag");
 
 	ew::Mesh sphereMesh(ew::createSphere(0.5f, 64));
 
+	//Hot reload shaders, textures and heightmaps when they are saved
+	ew::FileWatcher fileWatcher;
+	ew::watchShader(fileWatcher, shader);
+	ew::watchShader(fileWatcher, unlitShader);
+	ew::watchShader(fileWatcher, skyboxShader);
+	ew::watchShader(fileWatcher, feedbackShader);
+	//A saved layer streams into the array while it still matches the array's size and format. Otherwise the
+	//manager re-uploads the whole array at its current size, from the caches rebuilt for the new images.
+	const ew::TextureCompression terrainCompression = ew::getSupportedCompression(ew::TextureCompression::BC1);
+	for (int i = 0; i < numTerrainLayers; i++) {
+		fileWatcher.watch(terrainLayerPaths[i], [&textureManager, &textureStreamer, terrainLayers, i, terrainCompression](const std::string& path) -> std::function<void()> {
+			auto image = std::make_shared<ew::TextureImage>();
+			if (!ew::loadTextureImage(path.c_str(), *image, false, terrainCompression)) {
+				printf("Failed to load image %s, keeping previous version\n", path.c_str());
+				return {};
+			}
+			return [&textureManager, &textureStreamer, terrainLayers, i, image]() {
+				if (!textureStreamer.streamLayer(terrainLayers, i, image)) {
+					textureManager.reload(terrainLayers);
+				}
+			};
+		});
+	}
+	ew::watchMesh(fileWatcher, terrainMesh1, "assets/heightmaps/heightmap01.jpg", JSLib::createTerrain);
+	ew::watchMesh(fileWatcher, terrainMesh2, "assets/heightmaps/heightmap02.jpg", JSLib::createTerrain);
+	ew::watchMesh(fileWatcher, terrainMesh3, "assets/heightmaps/heightmap03.jpg", JSLib::createTerrain);
+
 	//Create skybox mesh
 	ew::Mesh skyboxMesh = ew::Mesh(ew::createCube(2));
 
@@ -120,6 +191,16 @@ int main() {
 	float HBTrange3 = 0.65f;
 	float HBTrange4 = 0.85f;
 
+	//Maps terrain height to the layers blended there. Rebuilt below whenever the ranges change.
+	float terrainBlendHeights[4] = { HBTrange1, HBTrange2, HBTrange3, HBTrange4 };
+	unsigned int terrainWeights = JSLib::createTerrainWeightMap(terrainBlendHeights, numTerrainLayers);
+
+	//Optionally color the terrain from one unique map baked from the layers, paged in as the camera needs it
+	ew::VirtualTexture virtualTexture;
+	bool useVirtualTexture = false;
+	bool rebakeVirtualTexture = false;
+	int virtualTextureHeightmap = 0; //Heightmap the open virtual texture was baked from
+
 	//Initialize Lights
 	Light lights[MAX_LIGHTS];
 
@@ -151,25 +232,42 @@ int main() {
 	skyboxShader.use();
 	skyboxShader.setInt("_Skybox", 0);
 
-	std::vector<std::string> faces {
-			"assets/right.jpg",
-			"assets/left.jpg",
-			"assets/top.jpg",
-			"assets/bottom.jpg",
-			"assets/front.jpg",
-			"assets/back.jpg"
+	//Textures each group of draws needs bound. The virtual texture's follow these on units 2 and 3.
+	ew::MaterialBinding terrainTextures;
+	terrainTextures.textures = {
+		{ 0, GL_TEXTURE_2D_ARRAY, terrainLayers },
+		{ 1, GL_TEXTURE_1D, terrainWeights },
+		{ 4, GL_TEXTURE_CUBE_MAP, sky.irradiance },
+		{ 5, GL_TEXTURE_CUBE_MAP, sky.specular }
 	};
-	unsigned int cubemapTexture = gjn::loadCubemap(faces);
+	const size_t numTerrainTextures = terrainTextures.textures.size();
+	ew::MaterialBinding skyboxTextures;
+	skyboxTextures.textures = { { 0, GL_TEXTURE_CUBE_MAP, sky.environment } };
+
+	//Shaders and meshes above were set up while the workers decoded
+	assetLoader.finish();
+	assetLoader.printReport();
+
+	ew::Profiler profiler;
+	ew::RenderQueue renderQueue;
+	renderQueue.setProfiler(&profiler);
 
 	resetCamera(camera,cameraController);
 
-	//Camera stuff to see terrain better
+	//Camera stuff to see terrain better. The far plane only clips with reverse-Z turned off.
 	camera.farPlane = 200.0f;
 	camera.position.y = 75.0f;
 	camera.target.y = 75.0f;
 
 	while (!glfwWindowShouldClose(window)) {
 		glfwPollEvents();
+		ew::renderState::beginFrame();
+		profiler.beginFrame();
+
+		//Swap in any assets that were rebuilt or loaded since last frame
+		fileWatcher.update();
+		assetLoader.update();
+		textureStreamer.update();
 
 		float time = (float)glfwGetTime();
 		float deltaTime = time - prevTime;
@@ -179,7 +277,43 @@ int main() {
 		camera.aspectRatio = (float)SCREEN_WIDTH / SCREEN_HEIGHT;
 		cameraController.Move(window, &camera, deltaTime);
 
+		//Bake and open the virtual texture when it is turned on or its heightmap changes
+		if (useVirtualTexture && (virtualTextureHeightmap != heightmapNum || rebakeVirtualTexture)) {
+			useVirtualTexture = openTerrainVirtualTexture(virtualTexture, heightmapNum, terrainLayerPaths, terrainBlendHeights, rebakeVirtualTexture);
+			virtualTextureHeightmap = useVirtualTexture ? heightmapNum : 0;
+			rebakeVirtualTexture = false;
+			terrainTextures.textures.resize(numTerrainTextures);
+			if (useVirtualTexture) {
+				terrainTextures.textures.push_back({ 2, GL_TEXTURE_2D, virtualTexture.getPageTable() });
+				terrainTextures.textures.push_back({ 3, GL_TEXTURE_2D, virtualTexture.getAtlas() });
+			}
+		}
+		const ew::Mesh* terrainMesh = heightmapNum == 2 ? &terrainMesh2 : heightmapNum == 3 ? &terrainMesh3 : &terrainMesh1;
+
+		//Map the pages that arrived, then record the pages this view needs
+		if (useVirtualTexture) {
+			ew::ProfileScope feedbackScope(profiler, "VT feedback");
+			virtualTexture.update();
+			virtualTexture.beginFeedback(SCREEN_WIDTH, SCREEN_HEIGHT);
+			feedbackShader.use();
+			feedbackShader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
+			virtualTexture.setFeedbackUniforms(feedbackShader);
+			renderQueue.begin(camera);
+			ew::DrawPacket feedbackPacket;
+			feedbackPacket.mesh = terrainMesh;
+			feedbackPacket.shader = &feedbackShader;
+			feedbackPacket.model = terrainTransform.getModelMatrix();
+			renderQueue.submit(feedbackPacket);
+			renderQueue.flush();
+			virtualTexture.endFeedback();
+		}
+
 		//RENDER
+		if (sceneFramebuffer.width != SCREEN_WIDTH || sceneFramebuffer.height != SCREEN_HEIGHT) {
+			ew::deleteFramebuffer(sceneFramebuffer);
+			sceneFramebuffer = ew::createFramebuffer(SCREEN_WIDTH, SCREEN_HEIGHT, true);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer.fbo);
 		glClearColor(bgColor.x, bgColor.y,bgColor.z,1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -187,20 +321,19 @@ int main() {
 		terMinY = terrainTransform.position.y;
 		terMaxY = terrainTransform.position.y + (64.0f * terrainTransform.scale.y);
 
+		//Per-frame uniforms. Draws are submitted to the render queue below.
 		shader.use();
-		
-		//Bind textures
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, snowTexture);
-		shader.setInt("_TextureSnow", 0);
-
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, grassTexture);
-		shader.setInt("_TextureGrass", 1);
-
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, rockTexture);
-		shader.setInt("_TextureRock", 2);
+		shader.setInt("_TerrainLayers", 0);
+		shader.setInt("_TerrainWeights", 1);
+		shader.setInt("_PageTable", 2);
+		shader.setInt("_PageAtlas", 3);
+		shader.setInt("_UseVirtualTexture", useVirtualTexture);
+		shader.setInt("_IrradianceMap", 4);
+		shader.setInt("_SpecularMap", 5);
+		shader.setInt("_UseIBL", useIBL);
+		if (useVirtualTexture) {
+			virtualTexture.setUniforms(shader, 2, 3);
+		}
 
 		shader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
 
@@ -231,50 +364,79 @@ int main() {
 		shader.setFloat("_terMinY", terMinY);
 		shader.setFloat("_terMaxY", terMaxY);
 
-		shader.setFloat("_HBTrange1", HBTrange1);
-		shader.setFloat("_HBTrange2", HBTrange2);
-		shader.setFloat("_HBTrange3", HBTrange3);
-		shader.setFloat("_HBTrange4", HBTrange4);
-
-		//Draw terrain
-		shader.setMat4("_Model", terrainTransform.getModelMatrix());
-		switch (heightmapNum)
-		{
-		case 1:
-			terrainMesh1.draw();
-			break;
-		case 2:
-			terrainMesh2.draw();
-			break;
-		case 3:
-			terrainMesh3.draw();
-			break;
-		default:
-			terrainMesh1.draw();
-			break;
+		const float blendHeights[4] = { HBTrange1, HBTrange2, HBTrange3, HBTrange4 };
+		if (memcmp(blendHeights, terrainBlendHeights, sizeof(blendHeights)) != 0) {
+			memcpy(terrainBlendHeights, blendHeights, sizeof(blendHeights));
+			JSLib::updateTerrainWeightMap(terrainWeights, terrainBlendHeights, numTerrainLayers);
 		}
 
 		unlitShader.use();
 		unlitShader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
 
+		skyboxShader.use();
+		ew::Mat4 view = ew::WithoutTranslation(camera.ViewMatrix());
+		skyboxShader.setMat4("_View", view);
+		skyboxShader.setMat4("_Projection", camera.ProjectionMatrix());
+		skyboxShader.setFloat("_FarDepth", ew::renderState::getFarDepth());
+
+		renderQueue.begin(camera);
+
+		//Terrain
+		ew::DrawPacket terrainPacket;
+		terrainPacket.mesh = terrainMesh;
+		terrainPacket.shader = &shader;
+		terrainPacket.material = &terrainTextures;
+		terrainPacket.model = terrainTransform.getModelMatrix();
+		terrainPacket.label = "Terrain";
+		const ew::Frustum viewFrustum = camera.ViewFrustum();
+		if (ew::TestAABB(viewFrustum, ew::TransformAABB(terrainPacket.model, terrainPacket.mesh->getBounds()))) {
+			renderQueue.submit(terrainPacket);
+		}
+
+		//Light gizmos, skipping any outside the view
+		ew::Mat4 lightModels[MAX_LIGHTS];
+		ew::BoundingSphere lightBounds[MAX_LIGHTS];
+		for (int i = 0; i < numLights; i++) {
+			lightModels[i] = lightTransforms[i].getModelMatrix();
+			lightBounds[i] = ew::TransformSphere(lightModels[i], sphereMesh.getBoundingSphere());
+		}
+		uint32_t lightVisibility[ew::NumVisibilityWords(MAX_LIGHTS)];
+		ew::CullSpheres(viewFrustum, lightBounds, numLights, lightVisibility);
 		for (int i = 0; i < numLights; i++) {
-			unlitShader.setMat4("_Model", lightTransforms[i].getModelMatrix());
-			unlitShader.setVec3("_Color", lights[i].color);
-			sphereMesh.draw();
+			if (!ew::IsVisible(lightVisibility, i)) {
+				continue;
+			}
+			ew::DrawPacket lightPacket;
+			lightPacket.mesh = &sphereMesh;
+			lightPacket.shader = &unlitShader;
+			lightPacket.model = lightModels[i];
+			lightPacket.setUniforms = [](const ew::Shader& shader, const void* light) {
+				shader.setVec3("_Color", ((const Light*)light)->color);
+			};
+			lightPacket.userData = &lights[i];
+			lightPacket.label = "Light gizmos";
+			renderQueue.submit(lightPacket);
 		}
 
 		//Skybox
-		glDepthFunc(GL_LEQUAL);
-		glCullFace(GL_FRONT);
-		skyboxShader.use();
-		ew::Mat4 view = ew::Mat4(mat3Conversion(camera.ViewMatrix()));
-		skyboxShader.setMat4("_View", view);
-		skyboxShader.setMat4("_Projection", camera.ProjectionMatrix());
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-		skyboxMesh.draw();
-		glCullFace(GL_BACK);
-		glDepthFunc(GL_LESS);
+		ew::DrawPacket skyboxPacket;
+		skyboxPacket.mesh = &skyboxMesh;
+		skyboxPacket.shader = &skyboxShader;
+		skyboxPacket.material = &skyboxTextures;
+		skyboxPacket.pass = ew::RenderPass::SKYBOX;
+		skyboxPacket.label = "Skybox";
+		renderQueue.submit(skyboxPacket);
+
+		renderQueue.flush();
+
+		//Every texture this frame uses is bound by now
+		textureManager.update();
+		textureManager.exportCounters(profiler);
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFramebuffer.fbo);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 		//Render UI
 		{
@@ -295,6 +457,9 @@ int main() {
 				}
 				ImGui::DragFloat("Near Plane", &camera.nearPlane, 0.1f, 0.0f);
 				ImGui::DragFloat("Far Plane", &camera.farPlane, 0.1f, 0.0f);
+				if (ImGui::Checkbox("Reverse-Z (no far plane)", &camera.reverseZ)) {
+					camera.reverseZ = ew::renderState::setReverseZ(camera.reverseZ);
+				}
 				ImGui::DragFloat("Move Speed", &cameraController.moveSpeed, 0.1f);
 				ImGui::DragFloat("Sprint Speed", &cameraController.sprintMoveSpeed, 0.1f);
 				if (ImGui::Button("Reset")) {
@@ -304,11 +469,19 @@ int main() {
 
 			ImGui::ColorEdit3("BG color", &bgColor.x);
 
+			if (ImGui::CollapsingHeader("Render State")) {
+				const ew::RenderStateStats& stats = ew::renderState::getFrameStats();
+				ImGui::Text("GL calls issued: %u", stats.issued);
+				ImGui::Text("GL calls elided: %u", stats.elided);
+			}
+
 			if (ImGui::CollapsingHeader("Material")) {
 				ImGui::DragFloat("AmbientK", &mat.ambientK, 0.1f, 0.0f, 1.0f);
 				ImGui::DragFloat("DiffuseK", &mat.diffuseK, 0.1f, 0.0f, 1.0f);
 				ImGui::DragFloat("SpecularK", &mat.specular, 0.1f, 0.0f, 1.0f);
 				ImGui::DragFloat("Shininess", &mat.shininess, 0.1f, 2.0f);
+				//Ambient light and reflections from the sky
+				ImGui::Checkbox("Image Based Lighting", &useIBL);
 			}
 
 			ImGui::SliderInt("# of Lights", &numLights, 1, MAX_LIGHTS);
@@ -375,16 +548,33 @@ int main() {
 				if (ImGui::Button("Reset Terrain")) {
 					resetTerrain(terrainTransform, HBTrange1, HBTrange2, HBTrange3, HBTrange4);
 				}
+
+				//The baked colors don't follow the ranges until rebaked
+				ImGui::Checkbox("Virtual Texture", &useVirtualTexture);
+				if (useVirtualTexture && virtualTexture.isOpen()) {
+					const ew::PageCache* cache = virtualTexture.getCache();
+					const ew::PageCacheStats& stats = cache->getStats();
+					ImGui::Text("Pages resident: %d / %d, pending: %zu", cache->getNumResident(), cache->getNumSlots(), virtualTexture.getNumPending());
+					ImGui::Text("Inserted: %zu, evicted: %zu, dropped: %zu", stats.inserted, stats.evicted, stats.dropped);
+					if (ImGui::Button("Rebake Virtual Texture")) {
+						rebakeVirtualTexture = true;
+					}
+				}
 			}
 
 			ImGui::End();
+
+			profiler.drawImGui();
+			textureManager.drawImGui();
 			
 			ImGui::Render();
+			ew::ProfileScope uiScope(profiler, "ImGui");
 			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 		}
 
 		glfwSwapBuffers(window);
 	}
+	ew::deleteFramebuffer(sceneFramebuffer);
 	printf("Shutting down...");
 }
 
@@ -420,9 +610,27 @@ void resetTerrain(ew::Transform& terrainTransform, float& HBTrange1, float& HBTr
 	HBTrange4 = 0.85f;
 }
 
-ew::Mat4 mat3Conversion(const ew::Mat4& m) {
-	return ew::Mat4(m[0][0], m[1][0], m[2][0], 0.0f,
-					m[0][1], m[1][1], m[2][1], 0.0f,
-					m[0][2], m[1][2], m[2][2], 0.0f,
-					m[0][3], m[1][3], m[2][3], 1.0f);
+/// <summary>
+/// Opens the virtual texture for a heightmap, baking it from the layers and blend heights first if it doesn't exist
+/// yet or rebake is set. Baking an 8192 map takes a few seconds, and the file is kept next to the heightmap.
+/// </summary>
+bool openTerrainVirtualTexture(ew::VirtualTexture& virtualTexture, int heightmapNum, const std::vector<std::string>& layerPaths, const float* blendHeights, bool rebake)
+{
+	const int size = 8192;
+	const std::string heightmapPath = "assets/heightmaps/heightmap0" + std::to_string(heightmapNum) + ".jpg";
+	const ew::TextureCompression compression = ew::getSupportedCompression(ew::TextureCompression::BC1);
+	//Named for the compression actually used, which can be BC7 where BC1 is not supported
+	const char* suffix = compression == ew::TextureCompression::BC1 ? ".bc1" : (compression == ew::TextureCompression::BC7 ? ".bc7" : "");
+	const std::string filePath = heightmapPath.substr(0, heightmapPath.size() - 4) + "_" + std::to_string(size) + suffix + ".ewvt";
+	virtualTexture.close();
+	if (rebake || !std::filesystem::exists(filePath)) {
+		printf("Baking %s...\n", filePath.c_str());
+		std::vector<unsigned char> colors = JSLib::bakeTerrainColorMap(heightmapPath.c_str(), layerPaths, blendHeights, size);
+		ew::VirtualTextureBuildOptions options;
+		options.compression = compression;
+		if (colors.empty() || !ew::buildVirtualTexture(filePath.c_str(), colors.data(), size, 3, options)) {
+			return false;
+		}
+	}
+	return virtualTexture.open(filePath.c_str());
 }
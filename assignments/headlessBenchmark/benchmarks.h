@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <vector>
+
+//CPU timing modes main.cpp runs in place of the scene. None needs a GL context; the correctness checks for the
+//same code are in tests/. Those returning bool return false when their input can't be read.
+
+//The math, transform and procedural generation paths the assignments use, through both the ew and ns entry points,
+//and each Mat4 operation on the SIMD path the build takes
+void runMathBenchmark(int iterations);
+//count random transforms through the five matrix product, getModelMatrix, and a TransformHierarchy rebuilt whole,
+//with nothing dirty and after editing a few nodes
+void runTransformBenchmark(int count);
+//RenderQueue::radixSort against std::sort and std::stable_sort on count scene-like and count random sort keys
+void runSortBenchmark(int count);
+//Encode time, throughput, compression ratio and PSNR of the image with every BCn format and quality
+bool runTextureBenchmark(const char* imagePath);
+//A mip chain of the image with each filter on one thread and on all, and how much detail each keeps
+bool runResampleBenchmark(const char* imagePath);
+//Decoding paths' faces one after another and in parallel, building with and without the prefiltered maps,
+//and loading back from the cache written next to the first path
+bool runCubemapBenchmark(const std::vector<std::string>& paths);
+//Every image under directory with stb_image into a fresh buffer, as loads did before imageDecoder.h, against
+//the default decoder into a pooled buffer and at 1/2, 1/4 and 1/8 scale
+bool runDecodeBenchmark(const char* directory);
+//Building a synthetic virtual texture into filePath, reading its pages and processing feedback for its page cache
+bool runPageCacheBenchmark(const char* filePath);
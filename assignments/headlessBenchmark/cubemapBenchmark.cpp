@@ -0,0 +1,66 @@
+#include "benchmarks.h"
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#include <gjn/cubemapImage.h>
+
+namespace {
+	double msSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+/// <summary>
+/// The build and cache timings use fresh images each time; the cache is written next to the first path
+/// </summary>
+bool runCubemapBenchmark(const std::vector<std::string>& paths) {
+	const unsigned int numCores = std::max(1u, std::thread::hardware_concurrency());
+	printf("Cubemap from %d image(s), %u threads\n", (int)paths.size(), numCores);
+
+	std::vector<gjn::CubemapSource> sources(paths.size());
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < paths.size(); i++) {
+		if (!gjn::decodeCubemapSource(paths[i].c_str(), sources[i]))
+			return false;
+	}
+	const double serialMs = msSince(start);
+	start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < paths.size(); i++) {
+		threads.emplace_back([&, i]() { gjn::decodeCubemapSource(paths[i].c_str(), sources[i]); });
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	printf("Decode: %.1f ms one after another, %.1f ms in parallel\n", serialMs, msSince(start));
+
+	gjn::CubemapOptions options;
+	options.useCache = false;
+	gjn::CubemapImage image;
+	start = std::chrono::steady_clock::now();
+	std::vector<gjn::CubemapSource> copies = sources;
+	if (!gjn::buildCubemapImage(paths, copies, image, options))
+		return false;
+	printf("Build %dx%d faces, %d levels: %.1f ms\n", image.environment.size, image.environment.size, image.environment.getNumLevels(), msSince(start));
+
+	gjn::CubemapImage prefiltered;
+	options.prefilter = true;
+	start = std::chrono::steady_clock::now();
+	copies = sources;
+	if (!gjn::buildCubemapImage(paths, copies, prefiltered, options))
+		return false;
+	printf("Build with prefiltered maps (%d specular levels from %d, %d samples; %d irradiance): %.1f ms\n", prefiltered.specular.getNumLevels(),
+		prefiltered.specular.size, options.specularSamples, prefiltered.irradiance.size, msSince(start));
+
+	options.useCache = true;
+	gjn::CubemapImage cached;
+	start = std::chrono::steady_clock::now();
+	bool ok = gjn::loadCubemapImage(paths, cached, options);
+	const double firstMs = msSince(start);
+	start = std::chrono::steady_clock::now();
+	ok = ok && gjn::loadCubemapImage(paths, cached, options);
+	printf("Load through the cache: %.1f ms first, %.1f ms from the cache\n", firstMs, msSince(start));
+	return ok;
+}
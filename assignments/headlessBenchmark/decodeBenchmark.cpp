@@ -0,0 +1,105 @@
+#include "benchmarks.h"
+#include <stdio.h>
+#include <ctype.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <algorithm>
+
+#include <ew/imageDecoder.h>
+#include <ew/external/stb_image.h>
+
+namespace {
+	const int ITERATIONS = 3;
+	const int SCALES[] = { 2, 4, 8 };
+
+	double msSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//Fastest of ITERATIONS runs, in milliseconds
+	template <typename Fn>
+	double timeBest(Fn fn) {
+		double best = 1e30;
+		for (int i = 0; i < ITERATIONS; i++) {
+			auto start = std::chrono::steady_clock::now();
+			fn();
+			best = std::min(best, msSince(start));
+		}
+		return best;
+	}
+
+	bool isImagePath(const std::filesystem::path& path) {
+		std::string extension = path.extension().string();
+		for (char& c : extension) {
+			c = (char)tolower(c);
+		}
+		const char* extensions[] = { ".jpg", ".jpeg", ".png", ".bmp", ".tga", ".hdr", ".gif", ".psd" };
+		for (const char* known : extensions) {
+			if (extension == known)
+				return true;
+		}
+		return false;
+	}
+}
+
+/// <summary>
+/// Times include reading the file, as stbi_load did. Each is the fastest of a few runs, so the pool is warm
+/// for the pooled decodes and the file is in the OS cache for all of them.
+/// </summary>
+bool runDecodeBenchmark(const char* directory) {
+	std::vector<std::string> paths;
+	std::error_code error;
+	for (auto it = std::filesystem::recursive_directory_iterator(directory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+		if (it->is_regular_file() && isImagePath(it->path())) {
+			paths.push_back(it->path().string());
+		}
+	}
+	std::sort(paths.begin(), paths.end());
+	if (paths.empty()) {
+		printf("No images under %s\n", directory);
+		return false;
+	}
+	std::shared_ptr<ew::ImageDecoder> jpeg = ew::getJpegImageDecoder();
+	printf("%d images under %s. JPEG decoder: %s\n", (int)paths.size(), directory, jpeg ? jpeg->getName() : "none, stb_image decodes everything");
+	printf("%-40s %10s %-14s %8s %8s %8s %8s %8s\n", "Image", "Size", "Decoder", "stb ms", "ms", "1/2 ms", "1/4 ms", "1/8 ms");
+
+	bool ok = true;
+	double stbTotal = 0.0, total = 0.0, scaledTotals[3] = {};
+	for (const std::string& path : paths) {
+		ew::ImageFile file;
+		if (!file.open(path.c_str())) {
+			printf("%-40s no decoder reads it\n", path.c_str());
+			ok = false;
+			continue;
+		}
+		const ew::ImageInfo& info = file.getInfo();
+
+		const double stbMs = timeBest([&]() {
+			int w, h, c;
+			stbi_image_free(stbi_load(path.c_str(), &w, &h, &c, 0));
+		});
+		ew::DecodedImage image;
+		const double ms = timeBest([&]() { ew::decodeImage(path.c_str(), image); });
+		double scaledMs[3];
+		for (int i = 0; i < 3; i++) {
+			ew::DecodeOptions options;
+			options.scale = SCALES[i];
+			ew::DecodedImage scaled;
+			scaledMs[i] = timeBest([&]() { ew::decodeImage(path.c_str(), scaled, options); });
+			scaledTotals[i] += scaledMs[i];
+		}
+
+		char size[32];
+		snprintf(size, sizeof(size), "%dx%dx%d", info.width, info.height, info.channels);
+		printf("%-40s %10s %-14s %8.2f %8.2f %8.2f %8.2f %8.2f\n", path.c_str(), size, file.getDecoderName(), stbMs, ms,
+			scaledMs[0], scaledMs[1], scaledMs[2]);
+		stbTotal += stbMs;
+		total += ms;
+	}
+	printf("Total: stb_image %.1f ms, default decoder %.1f ms (%.2fx), 1/2 %.1f ms, 1/4 %.1f ms, 1/8 %.1f ms\n", stbTotal, total,
+		total > 0.0 ? stbTotal / total : 0.0, scaledTotals[0], scaledTotals[1], scaledTotals[2]);
+
+	return ok;
+}
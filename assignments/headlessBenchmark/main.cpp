@@ -0,0 +1,435 @@
+/*
+	Renders the finalProject terrain scene into an offscreen framebuffer with no window,
+	so frame times can be measured on machines without a display or GPU.
+
+	Usage: headlessBenchmark [scene options]    renders the scene and writes per-frame times
+	       headlessBenchmark --<mode> <args>     runs one CPU timing mode instead (see benchmarks.h)
+
+	Scene option              Default                 Effect
+	--frames N                300                     frames rendered, orbiting the terrain once
+	--size WxH                1280x720                framebuffer size
+	--heightmap 1-3           1                       terrain heightmap
+	--timings file.csv        headless_timings.csv    where per-frame times go
+	--png file.png            none                    writes the last frame
+	--reverse-z               off                     reverse-Z depth
+	--compress none|bc1|bc7   none                    block compresses the terrain textures
+	--reload-frame N          none                    loads the terrain layers again into the drawn array at frame N
+	--stream-budget KB        0                       streams reloads through TextureStreamer at KB per frame
+	--vt SIZE                 off                     colors the terrain from a SIZE x SIZE virtual texture (built on first use)
+	--terrain-size N          full                    downsamples the heightmap to at most N vertices per side
+	--ibl                     off                     lights the terrain from the sky's prefiltered maps (built on first use)
+
+	Mode                      Args                    Times
+	--math                    N                       math, each Mat4 operation and procGen, N iterations per case
+	--transforms              N                       N model matrices per object and through TransformHierarchy
+	--sort                    N                       radix sorting N draw packets against std::sort
+	--bc                      image                   block compression per format and quality, with PSNR
+	--resample                image                   mip chains per filter, one thread and all
+	--cubemap                 face0 [.. face5]        cubemap decode, build and cache load
+	--decode                  directory               decoding every image under directory, full and scaled
+	--page-cache              file.ewvt               virtual texture build, page reads and feedback processing
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+#include <ew/external/glad.h>
+#include <ew/ewMath/ewMath.h>
+
+#include <ew/headless.h>
+#include <ew/framebuffer.h>
+#include <ew/imageWriter.h>
+#include <ew/shader.h>
+#include <ew/texture.h>
+#include <ew/procGen.h>
+#include <ew/transform.h>
+#include <ew/camera.h>
+#include <ew/renderState.h>
+#include <ew/renderQueue.h>
+#include <ew/assetLoader.h>
+#include <ew/textureStreamer.h>
+#include <ew/virtualTexture.h>
+
+#include <gjn/cubemap.h>
+
+#include <JSLib/terrain.h>
+
+#include "benchmarks.h"
+
+
+int main(int argc, char** argv) {
+	int numFrames = 300;
+	int width = 1280;
+	int height = 720;
+	int heightmapNum = 1;
+	const char* timingsPath = "headless_timings.csv";
+	const char* pngPath = nullptr;
+	bool reverseZ = false;
+	ew::TextureCompression compression = ew::TextureCompression::None;
+	int reloadFrame = -1;
+	int streamBudgetKB = 0;
+	int virtualTextureSize = 0;
+	int terrainSize = 0;
+	bool useIBL = false;
+
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--frames") == 0 && hasValue) {
+			numFrames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--size") == 0 && hasValue) {
+			sscanf(argv[++i], "%dx%d", &width, &height);
+		}
+		else if (strcmp(argv[i], "--heightmap") == 0 && hasValue) {
+			heightmapNum = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--timings") == 0 && hasValue) {
+			timingsPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--png") == 0 && hasValue) {
+			pngPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--reverse-z") == 0) {
+			reverseZ = true;
+		}
+		else if (strcmp(argv[i], "--compress") == 0 && hasValue) {
+			const char* name = argv[++i];
+			compression = strcmp(name, "bc1") == 0 ? ew::TextureCompression::BC1 : (strcmp(name, "bc7") == 0 ? ew::TextureCompression::BC7 : ew::TextureCompression::None);
+		}
+		else if (strcmp(argv[i], "--reload-frame") == 0 && hasValue) {
+			reloadFrame = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--stream-budget") == 0 && hasValue) {
+			streamBudgetKB = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--vt") == 0 && hasValue) {
+			virtualTextureSize = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--terrain-size") == 0 && hasValue) {
+			terrainSize = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--ibl") == 0) {
+			useIBL = true;
+		}
+		else if (strcmp(argv[i], "--transforms") == 0 && hasValue) {
+			int count = atoi(argv[++i]);
+			runTransformBenchmark(count > 0 ? count : 1);
+			return 0;
+		}
+		else if (strcmp(argv[i], "--sort") == 0 && hasValue) {
+			int count = atoi(argv[++i]);
+			runSortBenchmark(count > 0 ? count : 1);
+			return 0;
+		}
+		else if (strcmp(argv[i], "--bc") == 0 && hasValue) {
+			return runTextureBenchmark(argv[++i]) ? 0 : 1;
+		}
+		else if (strcmp(argv[i], "--resample") == 0 && hasValue) {
+			return runResampleBenchmark(argv[++i]) ? 0 : 1;
+		}
+		else if (strcmp(argv[i], "--cubemap") == 0 && hasValue) {
+			return runCubemapBenchmark(std::vector<std::string>(argv + i + 1, argv + argc)) ? 0 : 1;
+		}
+		else if (strcmp(argv[i], "--decode") == 0 && hasValue) {
+			return runDecodeBenchmark(argv[++i]) ? 0 : 1;
+		}
+		else if (strcmp(argv[i], "--page-cache") == 0 && hasValue) {
+			return runPageCacheBenchmark(argv[++i]) ? 0 : 1;
+		}
+		else if (strcmp(argv[i], "--math") == 0 && hasValue) {
+			int iterations = atoi(argv[++i]);
+			runMathBenchmark(iterations > 0 ? iterations : 1);
+			return 0;
+		}
+		else {
+			printf("Usage: %s [--frames N] [--size WxH] [--heightmap 1-3] [--timings file.csv] [--png file.png] [--reverse-z] [--compress none|bc1|bc7]\n", argv[0]);
+			printf("       %*s [--reload-frame N] [--stream-budget KB] [--vt SIZE] [--terrain-size N] [--ibl]\n", (int)strlen(argv[0]), "");
+			printf("       %s --math N | --transforms N | --sort N | --bc image | --resample image | --cubemap face0 [.. face5] | --decode directory | --page-cache file.ewvt\n", argv[0]);
+			return 1;
+		}
+	}
+	if (numFrames < 1 || width < 1 || height < 1) {
+		printf("Frames and size must be positive\n");
+		return 1;
+	}
+
+	ew::HeadlessContext context;
+	if (!context.create()) {
+		return 1;
+	}
+
+	ew::Framebuffer framebuffer = ew::createFramebuffer(width, height, reverseZ);
+	if (framebuffer.fbo == 0) {
+		return 1;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
+	glViewport(0, 0, width, height);
+
+	//Global settings
+	ew::renderState::setEnabled(GL_CULL_FACE, true);
+	ew::renderState::cullFace(GL_BACK);
+	ew::renderState::setEnabled(GL_DEPTH_TEST, true);
+	ew::renderState::depthFunc(GL_LESS);
+	if (reverseZ && !ew::renderState::setReverseZ(true)) {
+		return 1;
+	}
+
+	//Same scene as finalProject, loaded the same way
+	ew::AssetLoader assetLoader;
+	const std::vector<std::string> terrainLayerPaths{
+		"assets/textures/rock_color.jpg",
+		"assets/textures/grass_color.jpg",
+		"assets/textures/snow_color.jpg"
+	};
+	unsigned int terrainLayers = ew::loadTextureArrayAsync(assetLoader, terrainLayerPaths, GL_REPEAT, GL_LINEAR, compression);
+	const float terrainBlendHeights[4] = { 0.15f, 0.3f, 0.65f, 0.85f };
+	unsigned int terrainWeights = JSLib::createTerrainWeightMap(terrainBlendHeights, (int)terrainLayerPaths.size());
+
+	std::string heightmapPath = "assets/heightmaps/heightmap0" + std::to_string(std::clamp(heightmapNum, 1, 3)) + ".jpg";
+	ew::Mesh terrainMesh;
+	ew::loadMeshAsync(assetLoader, terrainMesh, heightmapPath, [terrainSize](const char* filePath) {
+		return JSLib::createTerrainScaled(filePath, terrainSize);
+	});
+
+	std::vector<std::string> faces{
+		"assets/right.jpg",
+		"assets/left.jpg",
+		"assets/top.jpg",
+		"assets/bottom.jpg",
+		"assets/front.jpg",
+		"assets/back.jpg"
+	};
+	gjn::CubemapOptions skyOptions;
+	skyOptions.prefilter = useIBL;
+	gjn::Cubemap sky = gjn::loadEnvironmentAsync(assetLoader, faces, skyOptions);
+
+	ew::Shader shader("assets/defaultLit.vert", "assets/defaultLit.frag");
+	ew::Shader unlitShader("assets/unlit.vert", "assets/unlit.frag");
+	ew::Shader skyboxShader("assets/skybox.vert", "assets/skybox.frag");
+	ew::Mesh sphereMesh(ew::createSphere(0.5f, 64));
+	ew::Mesh skyboxMesh(ew::createCube(2));
+	ew::Shader feedbackShader("assets/defaultLit.vert", "assets/vtFeedback.frag");
+
+	assetLoader.finish();
+	assetLoader.printReport();
+
+	//The layers baked into one unique color map, streamed in pages as the camera needs them
+	ew::VirtualTexture virtualTexture;
+	if (virtualTextureSize > 0) {
+		const char* compressionNames[] = { "", ".bc1", ".bc7" };
+		const std::string vtPath = heightmapPath.substr(0, heightmapPath.size() - 4) + "_" + std::to_string(virtualTextureSize)
+			+ compressionNames[(int)compression] + ".ewvt";
+		if (!std::filesystem::exists(vtPath)) {
+			auto bakeStart = std::chrono::steady_clock::now();
+			std::vector<unsigned char> colors = JSLib::bakeTerrainColorMap(heightmapPath.c_str(), terrainLayerPaths, terrainBlendHeights, virtualTextureSize);
+			auto buildStart = std::chrono::steady_clock::now();
+			ew::VirtualTextureBuildOptions options;
+			options.compression = compression;
+			if (colors.empty() || !ew::buildVirtualTexture(vtPath.c_str(), colors.data(), virtualTextureSize, 3, options)) {
+				return 1;
+			}
+			auto buildEnd = std::chrono::steady_clock::now();
+			printf("Baked %s in %.0f ms, built in %.0f ms\n", vtPath.c_str(),
+				std::chrono::duration<double, std::milli>(buildStart - bakeStart).count(), std::chrono::duration<double, std::milli>(buildEnd - buildStart).count());
+		}
+		if (!virtualTexture.open(vtPath.c_str())) {
+			return 1;
+		}
+	}
+
+	ew::MaterialBinding terrainTextures;
+	terrainTextures.textures = {
+		{ 0, GL_TEXTURE_2D_ARRAY, terrainLayers },
+		{ 1, GL_TEXTURE_1D, terrainWeights }
+	};
+	if (useIBL) {
+		terrainTextures.textures.push_back({ 4, GL_TEXTURE_CUBE_MAP, sky.irradiance });
+		terrainTextures.textures.push_back({ 5, GL_TEXTURE_CUBE_MAP, sky.specular });
+	}
+	if (virtualTexture.isOpen()) {
+		terrainTextures.textures.push_back({ 2, GL_TEXTURE_2D, virtualTexture.getPageTable() });
+		terrainTextures.textures.push_back({ 3, GL_TEXTURE_2D, virtualTexture.getAtlas() });
+	}
+	ew::MaterialBinding skyboxTextures;
+	skyboxTextures.textures = { { 0, GL_TEXTURE_CUBE_MAP, sky.environment } };
+
+	ew::Transform terrainTransform;
+	ew::Transform lightTransform;
+	lightTransform.position = ew::Vec3(2.0f, 65.0f, 0.0f);
+	lightTransform.scale = ew::Vec3(0.5f);
+	ew::Vec3 lightColor = ew::Vec3(1.0f);
+
+	//Uniforms that never change
+	shader.use();
+	shader.setInt("_TerrainLayers", 0);
+	shader.setInt("_TerrainWeights", 1);
+	shader.setInt("_PageTable", 2);
+	shader.setInt("_PageAtlas", 3);
+	shader.setInt("_UseVirtualTexture", virtualTexture.isOpen());
+	if (virtualTexture.isOpen()) {
+		virtualTexture.setUniforms(shader, 2, 3);
+	}
+	shader.setInt("_IrradianceMap", 4);
+	shader.setInt("_SpecularMap", 5);
+	shader.setInt("_UseIBL", useIBL);
+	shader.setInt("_NumLights", 1);
+	shader.setFloat("_Material.ambientK", 0.4f);
+	shader.setFloat("_Material.diffuseK", 0.4f);
+	shader.setFloat("_Material.specular", 0.2f);
+	shader.setFloat("_Material.shininess", 8.0f);
+	shader.setVec3("_Lights[0].position", lightTransform.position);
+	shader.setVec3("_Lights[0].color", lightColor);
+	shader.setVec3("_Lights[0].direction", ew::Vec3(0, -1, 0));
+	shader.setInt("_Lights[0].lightType", 1);
+	shader.setFloat("_terMinY", 0.0f);
+	shader.setFloat("_terMaxY", 64.0f);
+	unlitShader.use();
+	unlitShader.setVec3("_Color", lightColor);
+	skyboxShader.use();
+	skyboxShader.setInt("_Skybox", 0);
+	skyboxShader.setFloat("_FarDepth", ew::renderState::getFarDepth());
+
+	ew::Camera camera;
+	camera.fov = 60.0f;
+	camera.nearPlane = 0.1f;
+	camera.farPlane = 200.0f;
+	camera.reverseZ = reverseZ;
+	camera.aspectRatio = (float)width / height;
+	camera.target = ew::Vec3(0.0f, 20.0f, 0.0f);
+
+	ew::RenderQueue renderQueue;
+	std::vector<double> frameTimes(numFrames);
+	//Mid-run texture loads into the array the terrain samples, like a layer being saved while finalProject runs
+	ew::TextureStreamer textureStreamer((size_t)std::max(streamBudgetKB, 1) << 10);
+
+	for (int frame = 0; frame < numFrames; frame++) {
+		auto frameStart = std::chrono::steady_clock::now();
+		ew::renderState::beginFrame();
+
+		if (frame == reloadFrame) {
+			for (int layer = 0; layer < (int)terrainLayerPaths.size(); layer++) {
+				if (streamBudgetKB > 0) {
+					ew::loadTextureLayerStreamed(assetLoader, textureStreamer, terrainLayers, layer, terrainLayerPaths[layer], compression);
+				}
+				else {
+					ew::loadTextureLayerAsync(assetLoader, terrainLayers, layer, terrainLayerPaths[layer], compression);
+				}
+			}
+		}
+		assetLoader.update();
+		textureStreamer.update();
+
+		//Orbit the terrain once over the run so every run sees the same views
+		float angle = ew::TAU * frame / numFrames;
+		camera.position = ew::Vec3(cosf(angle) * 120.0f, 75.0f, sinf(angle) * 120.0f);
+
+		//Map the pages that arrived, then record the pages this view needs
+		if (virtualTexture.isOpen()) {
+			virtualTexture.update();
+			virtualTexture.beginFeedback(width, height);
+			feedbackShader.use();
+			feedbackShader.setMat4("_ViewProjection", camera.ProjectionMatrix() * camera.ViewMatrix());
+			virtualTexture.setFeedbackUniforms(feedbackShader);
+			renderQueue.begin(camera);
+			ew::DrawPacket feedbackPacket;
+			feedbackPacket.mesh = &terrainMesh;
+			feedbackPacket.shader = &feedbackShader;
+			feedbackPacket.model = terrainTransform.getModelMatrix();
+			renderQueue.submit(feedbackPacket);
+			renderQueue.flush();
+			virtualTexture.endFeedback();
+		}
+
+		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		ew::Mat4 viewProjection = camera.ProjectionMatrix() * camera.ViewMatrix();
+		shader.use();
+		shader.setMat4("_ViewProjection", viewProjection);
+		shader.setVec3("_CamPos", camera.position);
+		unlitShader.use();
+		unlitShader.setMat4("_ViewProjection", viewProjection);
+		skyboxShader.use();
+		skyboxShader.setMat4("_View", ew::WithoutTranslation(camera.ViewMatrix()));
+		skyboxShader.setMat4("_Projection", camera.ProjectionMatrix());
+
+		renderQueue.begin(camera);
+
+		ew::DrawPacket terrainPacket;
+		terrainPacket.mesh = &terrainMesh;
+		terrainPacket.shader = &shader;
+		terrainPacket.material = &terrainTextures;
+		terrainPacket.model = terrainTransform.getModelMatrix();
+		renderQueue.submit(terrainPacket);
+
+		ew::DrawPacket lightPacket;
+		lightPacket.mesh = &sphereMesh;
+		lightPacket.shader = &unlitShader;
+		lightPacket.model = lightTransform.getModelMatrix();
+		renderQueue.submit(lightPacket);
+
+		ew::DrawPacket skyboxPacket;
+		skyboxPacket.mesh = &skyboxMesh;
+		skyboxPacket.shader = &skyboxShader;
+		skyboxPacket.material = &skyboxTextures;
+		skyboxPacket.pass = ew::RenderPass::SKYBOX;
+		renderQueue.submit(skyboxPacket);
+
+		renderQueue.flush();
+
+		//Wait for the GPU so the time covers the whole frame, not just command submission
+		glFinish();
+		frameTimes[frame] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+	}
+
+	//Per-frame timings
+	FILE* timingsFile = fopen(timingsPath, "w");
+	if (timingsFile) {
+		fprintf(timingsFile, "frame,ms\n");
+		for (int frame = 0; frame < numFrames; frame++) {
+			fprintf(timingsFile, "%d,%.4f\n", frame, frameTimes[frame]);
+		}
+		fclose(timingsFile);
+	}
+	else {
+		printf("Failed to open %s for writing\n", timingsPath);
+	}
+
+	std::vector<double> sorted = frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+	double total = 0.0;
+	for (double ms : sorted) {
+		total += ms;
+	}
+	printf("%d frames at %dx%d: min %.3f ms, avg %.3f ms, median %.3f ms, max %.3f ms\n",
+		numFrames, width, height, sorted.front(), total / numFrames, sorted[numFrames / 2], sorted.back());
+	if (reloadFrame >= 0 && reloadFrame < numFrames) {
+		//The hitch, if any, lands in the frame the decoded images come back, not the reload frame itself
+		double reloadMax = *std::max_element(frameTimes.begin() + reloadFrame, frameTimes.end());
+		printf("Reloaded %zu terrain layers at frame %d (%s): max %.3f ms from then on, %zu KB still queued\n",
+			terrainLayerPaths.size(), reloadFrame, streamBudgetKB > 0 ? "streamed" : "direct", reloadMax, textureStreamer.getBytesPending() >> 10);
+	}
+
+	if (virtualTexture.isOpen()) {
+		const ew::PageCacheStats& stats = virtualTexture.getCache()->getStats();
+		printf("Virtual texture: %d of %d pages resident, %zu requests, %zu hits, %zu inserted, %zu evicted, %zu dropped\n",
+			virtualTexture.getCache()->getNumResident(), virtualTexture.getCache()->getNumSlots(), stats.requested, stats.hits, stats.inserted, stats.evicted, stats.dropped);
+	}
+
+	if (pngPath) {
+		std::vector<unsigned char> pixels = ew::readFramebufferPixels(framebuffer);
+		if (ew::writePNG(pngPath, width, height, 4, pixels.data(), true)) {
+			printf("Wrote last frame to %s\n", pngPath);
+		}
+	}
+
+	ew::renderState::deleteTexture(terrainLayers);
+	ew::renderState::deleteTexture(terrainWeights);
+	ew::deleteFramebuffer(framebuffer);
+	return 0;
+}
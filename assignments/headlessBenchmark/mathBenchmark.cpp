@@ -0,0 +1,271 @@
+#include "benchmarks.h"
+#include <stdio.h>
+#include <chrono>
+#include <math.h>
+#include <vector>
+#include <random>
+
+#include <ew/ewMath/ewMath.h>
+#include <ew/transform.h>
+#include <ew/camera.h>
+#include <ew/procGen.h>
+#include <ew/ewMath/frustum.h>
+
+#include <ns/transformations.h>
+#include <ns/camera.h>
+#include <ns/procGen.h>
+
+//Keeps results alive so the optimizer can't remove the timed work
+static volatile float s_sink;
+
+/// <summary>
+/// Times fn over the given number of iterations and prints the average cost of one call
+/// </summary>
+template<typename Fn>
+static void timeCase(const char* name, int iterations, Fn fn) {
+	float sink = 0.0f;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		sink += fn(i);
+	}
+	auto end = std::chrono::steady_clock::now();
+	s_sink = sink;
+	double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+	printf("%-28s %12.1f ns\n", name, ns);
+}
+
+/// <summary>
+/// Times one way of filling sines and cosines for the angles, and prints its cost per angle
+/// and its largest error against double precision sin/cos
+/// </summary>
+template<typename Fn>
+static void timeSinCos(const char* name, const std::vector<float>& angles, Fn fn) {
+	const size_t count = angles.size();
+	std::vector<float> sines(count), cosines(count);
+	const int repeats = 20;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < repeats; i++) {
+		fn(angles.data(), sines.data(), cosines.data(), count);
+	}
+	auto end = std::chrono::steady_clock::now();
+	double maxError = 0.0;
+	for (size_t i = 0; i < count; i++) {
+		maxError = fmax(maxError, fabs(sines[i] - sin((double)angles[i])));
+		maxError = fmax(maxError, fabs(cosines[i] - cos((double)angles[i])));
+	}
+	double ns = std::chrono::duration<double, std::nano>(end - start).count() / ((double)repeats * count);
+	printf("%-28s %12.2f ns   max error %.2e\n", name, ns, maxError);
+}
+
+/// <summary>
+/// Times one culling method over all the bounds, and prints its cost and how many were visible
+/// </summary>
+template<typename Fn>
+static void timeCull(const char* name, size_t count, std::vector<uint32_t>& visibleBits, Fn fn) {
+	const int repeats = 10;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < repeats; i++) {
+		fn(visibleBits.data());
+	}
+	auto end = std::chrono::steady_clock::now();
+	size_t numVisible = 0;
+	for (size_t i = 0; i < count; i++) {
+		numVisible += ew::IsVisible(visibleBits.data(), i);
+	}
+	double ms = std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+	printf("%-28s %12.2f ms   %zu visible\n", name, ms, numVisible);
+}
+
+/// <summary>
+/// Frustum culling of 1M random spheres and boxes, one at a time and with the batch functions
+/// </summary>
+static void runCullingBenchmark() {
+	const size_t count = 1 << 20;
+	printf("\nFrustum culling of %zu bounds\n", count);
+	ew::Camera camera;
+	camera.position = ew::Vec3(0.0f, 10.0f, 50.0f);
+	const ew::Frustum frustum = camera.ViewFrustum();
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+	std::uniform_real_distribution<float> size(0.1f, 4.0f);
+	std::vector<ew::BoundingSphere> spheres(count);
+	std::vector<ew::AABB> boxes(count);
+	std::vector<float> x(count), y(count), z(count), radius(count), extentX(count), extentY(count), extentZ(count);
+	for (size_t i = 0; i < count; i++) {
+		const ew::Vec3 center(position(random), position(random), position(random));
+		const ew::Vec3 extents(size(random), size(random), size(random));
+		spheres[i].center = center;
+		spheres[i].radius = size(random);
+		boxes[i].min = center - extents;
+		boxes[i].max = center + extents;
+		x[i] = center.x;
+		y[i] = center.y;
+		z[i] = center.z;
+		radius[i] = spheres[i].radius;
+		extentX[i] = extents.x;
+		extentY[i] = extents.y;
+		extentZ[i] = extents.z;
+	}
+
+	std::vector<uint32_t> visibleBits(ew::NumVisibilityWords(count));
+	timeCull("TestSphere loop", count, visibleBits, [&](uint32_t* bits) {
+		for (size_t i = 0; i < ew::NumVisibilityWords(count); i++) {
+			bits[i] = 0;
+		}
+		for (size_t i = 0; i < count; i++) {
+			bits[i / 32] |= (uint32_t)ew::TestSphere(frustum, spheres[i].center, spheres[i].radius) << (i % 32);
+		}
+	});
+	timeCull("CullSpheres", count, visibleBits, [&](uint32_t* bits) {
+		ew::CullSpheres(frustum, spheres.data(), count, bits);
+	});
+	timeCull("CullSpheresSoA", count, visibleBits, [&](uint32_t* bits) {
+		ew::CullSpheresSoA(frustum, x.data(), y.data(), z.data(), radius.data(), count, bits);
+	});
+	timeCull("TestAABB loop", count, visibleBits, [&](uint32_t* bits) {
+		for (size_t i = 0; i < ew::NumVisibilityWords(count); i++) {
+			bits[i] = 0;
+		}
+		for (size_t i = 0; i < count; i++) {
+			bits[i / 32] |= (uint32_t)ew::TestAABB(frustum, boxes[i]) << (i % 32);
+		}
+	});
+	timeCull("CullAABBs", count, visibleBits, [&](uint32_t* bits) {
+		ew::CullAABBs(frustum, boxes.data(), count, bits);
+	});
+	timeCull("CullAABBsSoA", count, visibleBits, [&](uint32_t* bits) {
+		ew::CullAABBsSoA(frustum, x.data(), y.data(), z.data(), extentX.data(), extentY.data(), extentZ.data(), count, bits);
+	});
+}
+
+void runMathBenchmark(int iterations) {
+	printf("Math benchmark, %d iterations per case\n", iterations);
+
+	timeCase("ew::Transform model matrix", iterations, [](int i) {
+		ew::Transform t;
+		t.rotation = ew::Vec3(i * 0.1f, i * 0.2f, i * 0.3f);
+		return t.getModelMatrix()[0][0];
+	});
+	timeCase("ns::Transform model matrix", iterations, [](int i) {
+		ns::Transform t;
+		t.rotation = ew::Vec3(i * 0.1f, i * 0.2f, i * 0.3f);
+		return t.getModelMatrix()[0][0];
+	});
+	timeCase("ew::RotateX/Y/Z", iterations, [](int i) {
+		return (ew::RotateX(i * 0.1f) * ew::RotateY(i * 0.2f) * ew::RotateZ(i * 0.3f))[0][0];
+	});
+	timeCase("ns::RotateX/Y/Z", iterations, [](int i) {
+		return (ns::RotateX(i * 0.1f) * ns::RotateY(i * 0.2f) * ns::RotateZ(i * 0.3f))[0][0];
+	});
+	timeCase("ew::Camera view*projection", iterations, [](int i) {
+		ew::Camera camera;
+		camera.position = ew::Vec3(i * 0.01f, 2.0f, 5.0f);
+		return (camera.ProjectionMatrix() * camera.ViewMatrix())[3][2];
+	});
+	timeCase("ns::Camera view*projection", iterations, [](int i) {
+		ns::Camera camera;
+		camera.position = ew::Vec3(i * 0.01f, 2.0f, 5.0f);
+		camera.target = ew::Vec3(0.0f);
+		camera.fov = 60.0f;
+		camera.aspectRatio = 1.77f;
+		camera.nearPlane = 0.1f;
+		camera.farPlane = 100.0f;
+		camera.orthographic = false;
+		return (camera.ProjectionMatrix() * camera.ViewMatrix())[3][2];
+	});
+
+	//Each Mat4 operation on its own, on whichever path this build takes. Build with EW_NO_SIMD to time the scalar one.
+	printf("\nMat4 operations, %s path\n", EW_SIMD_NAME);
+	std::vector<ew::Mat4> matrices;
+	std::vector<ew::Vec4> vectors;
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> value(-2.0f, 2.0f);
+	for (int i = 0; i < 64; i++) {
+		ew::Transform t;
+		t.position = ew::Vec3(value(random), value(random), value(random));
+		t.rotation = ew::Vec3(value(random), value(random), value(random)) * 90.0f;
+		t.scale = ew::Vec3(1.0f + value(random) * 0.25f);
+		matrices.push_back(t.getModelMatrix());
+		vectors.push_back(ew::Vec4(value(random), value(random), value(random), 1.0f));
+	}
+	timeCase("Mat4 * Mat4", iterations, [&](int i) {
+		return (matrices[i & 63] * matrices[(i + 1) & 63])[3][2];
+	});
+	timeCase("Mat4 * Vec4", iterations, [&](int i) {
+		return (matrices[i & 63] * vectors[i & 63]).z;
+	});
+	timeCase("Transpose", iterations, [&](int i) {
+		return ew::Transpose(matrices[i & 63])[2][3];
+	});
+	timeCase("Determinant", iterations, [&](int i) {
+		return ew::Determinant(matrices[i & 63]);
+	});
+	timeCase("Inverse", iterations, [&](int i) {
+		return ew::Inverse(matrices[i & 63])[3][2];
+	});
+	timeCase("AffineInverse", iterations, [&](int i) {
+		return ew::AffineInverse(matrices[i & 63])[3][2];
+	});
+	timeCase("NormalMatrix", iterations, [&](int i) {
+		return ew::NormalMatrix(matrices[i & 63])[2][2];
+	});
+
+	//Mesh generation is far slower per call, so it gets fewer iterations
+	printf("\n");
+	const int meshIterations = iterations / 1000 > 0 ? iterations / 1000 : 1;
+	timeCase("ew::createSphere(64)", meshIterations, [](int) {
+		return ew::createSphere(1.0f, 64).vertices.back().pos.y;
+	});
+	timeCase("ns::createSphere(64)", meshIterations, [](int) {
+		return ns::createSphere(1.0f, 64).vertices.back().pos.y;
+	});
+	timeCase("ew::createCylinder(64)", meshIterations, [](int) {
+		return ew::createCylinder(1.0f, 1.0f, 64).vertices.back().pos.y;
+	});
+	timeCase("ns::createCylinder(64)", meshIterations, [](int) {
+		return ns::createCylinder(1.0f, 1.0f, 64).vertices.back().pos.y;
+	});
+	//Bounds of an existing mesh, as after loading or editing vertices. The generators fill them in analytically.
+	ew::MeshData boundsMesh = ew::createSphere(1.0f, 64);
+	timeCase("ew::computeBounds(sphere 64)", meshIterations * 10, [&boundsMesh](int) {
+		ew::computeBounds(boundsMesh);
+		return boundsMesh.boundingSphere.radius;
+	});
+
+	//Accuracy vs speed of the sin/cos options, per angle. Evenly spaced angles, like a ring of vertices.
+	//The step is a power of two so every angle is exact in float, and the recurrence is judged fairly.
+	const double step = 1.0 / 1024.0;
+	printf("\nsin + cos of %d angles from -100 in steps of 1/1024\n", iterations);
+	std::vector<float> angles(iterations);
+	for (int i = 0; i < iterations; i++) {
+		angles[i] = (float)(-100.0 + i * step);
+	}
+	timeSinCos("sinf + cosf", angles, [](const float* a, float* s, float* c, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			s[i] = sinf(a[i]);
+			c[i] = cosf(a[i]);
+		}
+	});
+	timeSinCos("FastSinCos Accurate", angles, [](const float* a, float* s, float* c, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			ew::FastSinCos(a[i], s[i], c[i], ew::TrigPrecision::Accurate);
+		}
+	});
+	timeSinCos("FastSinCos Fast", angles, [](const float* a, float* s, float* c, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			ew::FastSinCos(a[i], s[i], c[i], ew::TrigPrecision::Fast);
+		}
+	});
+	timeSinCos("SinCos Accurate", angles, [](const float* a, float* s, float* c, size_t n) {
+		ew::SinCos(a, s, c, n, ew::TrigPrecision::Accurate);
+	});
+	timeSinCos("SinCos Fast", angles, [](const float* a, float* s, float* c, size_t n) {
+		ew::SinCos(a, s, c, n, ew::TrigPrecision::Fast);
+	});
+	timeSinCos("SinCosRecurrence", angles, [step](const float*, float* s, float* c, size_t n) {
+		ew::SinCosRecurrence(-100.0, step, s, c, n);
+	});
+
+	runCullingBenchmark();
+}
@@ -0,0 +1,61 @@
+#include "benchmarks.h"
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+#include <ew/blockCompression.h>
+#include <ew/external/stb_image.h>
+
+/// <summary>
+/// Compresses and decompresses the image once per format and quality. PSNR covers the channels the format stores.
+/// </summary>
+bool runTextureBenchmark(const char* imagePath) {
+	int width, height, channels;
+	unsigned char* pixels = stbi_load(imagePath, &width, &height, &channels, 0);
+	if (pixels == NULL) {
+		printf("Failed to load image %s\n", imagePath);
+		return false;
+	}
+	printf("%s: %dx%d, %d channels, %u threads\n", imagePath, width, height, channels, std::max(1u, std::thread::hardware_concurrency()));
+	printf("%-12s %10s %10s %8s %10s\n", "Format", "ms", "MPix/s", "ratio", "PSNR dB");
+
+	const char* formatNames[] = { "BC1", "BC4", "BC5", "BC7" };
+	const char* qualityNames[] = { "fast", "normal", "best" };
+	const size_t numPixels = (size_t)width * height;
+	std::vector<unsigned char> decoded(numPixels * 4);
+	for (int f = 0; f < 4; f++) {
+		const ew::BlockFormat format = (ew::BlockFormat)f;
+		//Channels each format reads from the source
+		const int numChannels = format == ew::BlockFormat::BC4 ? 1 : (format == ew::BlockFormat::BC5 ? 2 : (format == ew::BlockFormat::BC1 ? 3 : 4));
+		const int compared = std::min(numChannels, channels);
+		std::vector<unsigned char> blocks(ew::getCompressedSize(format, width, height));
+		std::vector<unsigned char> source(numPixels * compared), result(numPixels * compared);
+		for (size_t i = 0; i < numPixels; i++) {
+			for (int c = 0; c < compared; c++) {
+				source[i * compared + c] = pixels[i * channels + c];
+			}
+		}
+		for (int q = 0; q < 3; q++) {
+			ew::BlockCompressionOptions options;
+			options.quality = (ew::CompressionQuality)q;
+			auto start = std::chrono::steady_clock::now();
+			ew::compressImage(pixels, width, height, channels, format, blocks.data(), options);
+			auto end = std::chrono::steady_clock::now();
+			double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+			ew::decompressImage(blocks.data(), width, height, format, decoded.data(), 4);
+			for (size_t i = 0; i < numPixels; i++) {
+				for (int c = 0; c < compared; c++) {
+					result[i * compared + c] = decoded[i * 4 + c];
+				}
+			}
+			const double ratio = (double)(numPixels * compared) / blocks.size();
+			const double psnr = ew::computePSNR(source.data(), result.data(), width, height, compared);
+			printf("%s %-8s %10.1f %10.1f %7.1f:1 %10.2f\n", formatNames[f], qualityNames[q], ms, numPixels / (ms * 1000.0), ratio, psnr);
+		}
+	}
+	stbi_image_free(pixels);
+	return true;
+}
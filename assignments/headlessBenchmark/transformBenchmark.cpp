@@ -0,0 +1,74 @@
+#include "benchmarks.h"
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include <random>
+
+#include <ew/transform.h>
+#include <ew/transformHierarchy.h>
+#include <ew/ewMath/transformations.h>
+
+namespace {
+	const int NUM_EDITS = 1000;
+	//Keeps results alive so the optimizer can't remove the timed work
+	volatile float s_sink;
+
+	double msSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+/// <summary>
+/// Per object matrices are written to an array, as a renderer filling per-draw data would. The hierarchy has the
+/// same transforms, each parented to a random earlier node or to none.
+/// </summary>
+void runTransformBenchmark(int count) {
+	std::mt19937 random(33);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f), angle(-360.0f, 360.0f), scale(0.25f, 4.0f);
+	std::vector<ew::Transform> transforms(count);
+	for (ew::Transform& t : transforms) {
+		t.position = ew::Vec3(position(random), position(random), position(random));
+		t.rotation = ew::Vec3(angle(random), angle(random), angle(random));
+		t.scale = ew::Vec3(scale(random), scale(random), scale(random));
+	}
+	std::vector<ew::Mat4> matrices(count);
+	printf("%d transforms\n", count);
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; i++) {
+		const ew::Transform& t = transforms[i];
+		matrices[i] = ew::Translate(t.position) * ew::RotateY(ew::Radians(t.rotation.y)) * ew::RotateX(ew::Radians(t.rotation.x))
+			* ew::RotateZ(ew::Radians(t.rotation.z)) * ew::Scale(t.scale);
+	}
+	s_sink = matrices[count - 1][3][0];
+	printf("%-36s %8.2f ms\n", "Five matrix product per object", msSince(start));
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; i++) {
+		matrices[i] = transforms[i].getModelMatrix();
+	}
+	s_sink = matrices[count - 1][3][0];
+	printf("%-36s %8.2f ms\n", "getModelMatrix per object", msSince(start));
+
+	ew::TransformHierarchy hierarchy;
+	for (int i = 0; i < count; i++) {
+		hierarchy.addNode(transforms[i], i > 0 && random() % 8 != 0 ? (int)(random() % i) : -1);
+	}
+	start = std::chrono::steady_clock::now();
+	hierarchy.updateWorldMatrices();
+	printf("%-36s %8.2f ms\n", "Hierarchy, every node dirty", msSince(start));
+	start = std::chrono::steady_clock::now();
+	hierarchy.updateWorldMatrices();
+	printf("%-36s %8.2f ms\n", "Hierarchy, nothing dirty", msSince(start));
+
+	hierarchy.takeNumRebuilt();
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < NUM_EDITS; i++) {
+		const int node = (int)(random() % count);
+		ew::Transform local = hierarchy.getLocal(node);
+		local.position.y += 1.0f;
+		hierarchy.setLocal(node, local);
+	}
+	hierarchy.updateWorldMatrices();
+	const double editMs = msSince(start);
+	printf("%-36s %8.2f ms   %d matrices rebuilt\n", "Hierarchy, 1000 random nodes edited", editMs, hierarchy.takeNumRebuilt());
+}
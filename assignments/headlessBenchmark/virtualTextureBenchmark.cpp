@@ -0,0 +1,90 @@
+#include "benchmarks.h"
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#include <ew/virtualTexture.h>
+
+namespace {
+	const int TEXTURE_SIZE = 2048;
+	const int ATLAS_PAGES_PER_SIDE = 4;
+	const int ITERATIONS = 200;
+
+	double msSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//Spreads pages over a feedback buffer round robin, the top rows left empty like sky
+	void fillFeedback(const std::vector<uint32_t>& pages, int width, int height, std::vector<unsigned char>& texels) {
+		texels.assign((size_t)width * height * 4, 0);
+		size_t next = 0;
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				if (y >= height / 4 && !pages.empty()) {
+					ew::encodeFeedbackTexel(pages[next++ % pages.size()], &texels[((size_t)y * width + x) * 4]);
+				}
+			}
+		}
+	}
+}
+
+/// <summary>
+/// A 2048 texture in 128 pixel pages, 16x16 at mip 0. Feedback is for a 1280x720 screen at 1/8 resolution
+/// showing 20 pages, more than the atlas holds, so every pass goes through eviction and dropping.
+/// </summary>
+bool runPageCacheBenchmark(const char* filePath) {
+	std::vector<unsigned char> source((size_t)TEXTURE_SIZE * TEXTURE_SIZE * 3);
+	for (int y = 0; y < TEXTURE_SIZE; y++) {
+		for (int x = 0; x < TEXTURE_SIZE; x++) {
+			unsigned char* pixel = &source[((size_t)y * TEXTURE_SIZE + x) * 3];
+			pixel[0] = (unsigned char)(x * 7 ^ y * 3);
+			pixel[1] = (unsigned char)(x + y);
+			pixel[2] = (unsigned char)(x / 8 * 31 + y / 8 * 17);
+		}
+	}
+	auto start = std::chrono::steady_clock::now();
+	if (!ew::buildVirtualTexture(filePath, source.data(), TEXTURE_SIZE, 3)) {
+		return false;
+	}
+	const double buildMs = msSince(start);
+	ew::VirtualTextureFile file;
+	if (!file.open(filePath)) {
+		printf("Failed to open %s\n", filePath);
+		return false;
+	}
+	const ew::VirtualTextureInfo& info = file.getInfo();
+	printf("%s: %d pixels, %d pixel pages, %d mips, built in %.1f ms\n", filePath, info.size, info.pageSize, info.numMips, buildMs);
+
+	//Every mip 0 page read back through the loader's threads
+	ew::PageLoader loader(file, 2);
+	std::vector<uint32_t> pages;
+	for (int y = 0; y < info.getPagesPerSide(0); y++) {
+		for (int x = 0; x < info.getPagesPerSide(0); x++) {
+			pages.push_back(ew::makePageId(0, x, y));
+		}
+	}
+	std::vector<ew::LoadedPage> loaded;
+	start = std::chrono::steady_clock::now();
+	loader.request(pages);
+	loader.finish();
+	loader.collect(loaded);
+	const double readMs = msSince(start);
+	printf("Read %zu pages: %.1f ms, %.3f ms per page\n", loaded.size(), readMs, readMs / std::max((size_t)1, loaded.size()));
+
+	ew::PageCache cache(info, ATLAS_PAGES_PER_SIDE);
+	cache.insert(ew::makePageId(info.numMips - 1, 0, 0), true);
+	std::vector<uint32_t> crowd, missing;
+	for (int x = 0; x < 10; x++) {
+		crowd.push_back(ew::makePageId(0, x, 0));
+		crowd.push_back(ew::makePageId(0, x, 1));
+	}
+	std::vector<unsigned char> feedback;
+	fillFeedback(crowd, 160, 90, feedback);
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < ITERATIONS; i++) {
+		cache.processFeedback(feedback.data(), (size_t)160 * 90, missing);
+	}
+	printf("processFeedback 160x90: %.3f ms\n", msSince(start) / ITERATIONS);
+	return true;
+}
@@ -4,42 +4,148 @@
 */
 
 #include "terrain.h"
+#include <math.h>
+#include <thread>
+#include <algorithm>
+#include "../ew/renderState.h"
+#include "../ew/imageResample.h"
+#include "../ew/imageDecoder.h"
+
+namespace
+{
+	//The layers blended at normalized height h: lower to upper, with the upper layer's weight
+	void getTerrainBlend(const float* blendHeights, int numLayers, float h, int& lower, int& upper, float& weight)
+	{
+		lower = upper = numLayers - 1;
+		weight = 0.0f;
+		for (int layer = 0; layer < numLayers - 1; layer++)
+		{
+			const float blendStart = blendHeights[2 * layer], blendEnd = blendHeights[2 * layer + 1];
+			if (h <= blendStart)
+			{
+				lower = upper = layer;
+				return;
+			}
+			if (h < blendEnd)
+			{
+				lower = layer;
+				upper = layer + 1;
+				weight = (h - blendStart) / (blendEnd - blendStart);
+				return;
+			}
+		}
+	}
+
+	//Bilinear sample of a tightly packed 8 bit image with repeat wrapping, at texel coordinates
+	void sampleRepeat(const unsigned char* pixels, int width, int height, int channels, float x, float y, float* out)
+	{
+		x -= 0.5f;
+		y -= 0.5f;
+		const float fx = floorf(x), fy = floorf(y);
+		const float tx = x - fx, ty = y - fy;
+		const int x0 = ((int)fx % width + width) % width, y0 = ((int)fy % height + height) % height;
+		const int x1 = (x0 + 1) % width, y1 = (y0 + 1) % height;
+		for (int c = 0; c < channels; c++)
+		{
+			const float top = pixels[((size_t)y0 * width + x0) * channels + c] * (1.0f - tx) + pixels[((size_t)y0 * width + x1) * channels + c] * tx;
+			const float bottom = pixels[((size_t)y1 * width + x0) * channels + c] * (1.0f - tx) + pixels[((size_t)y1 * width + x1) * channels + c] * tx;
+			out[c] = top * (1.0f - ty) + bottom * ty;
+		}
+	}
+}
+
 namespace JSLib
 {
-	ew::MeshData createTerrain(char* heightMap)
+	ew::MeshData createTerrain(const char* heightMap)
 	{
-		int row, col, start;
+		return createTerrainScaled(heightMap, 0);
+	}
+
+	/// <summary>
+	/// A heightmap larger than maxSize is first resampled with a Lanczos filter into float heights, so the
+	/// smaller grid keeps sub-step detail instead of snapping to the 8 bit levels. Vertices are spread out to
+	/// keep the terrain's extent and UVs where the full resolution mesh has them.
+	/// </summary>
+	ew::MeshData createTerrainScaled(const char* heightMap, int maxSize)
+	{
+		int row, col;
 		ew::Vertex v;
 		ew::MeshData mesh;
 
-		int width, height, numComponents;
-		unsigned char* data = stbi_load(heightMap, &width, &height, &numComponents, 0);
+		ew::DecodedImage image;
+		if (!ew::decodeImage(heightMap, image) || image.getInfo().type != ew::PixelType::UInt8)
+		{
+			printf("Failed to load heightmap %s\n", heightMap);
+			return mesh;
+		}
+		const int srcWidth = image.getInfo().width, srcHeight = image.getInfo().height, numComponents = image.getInfo().channels;
+		//The height is the first channel
+		std::vector<unsigned char> texels((size_t)srcWidth * srcHeight);
+		for (size_t i = 0; i < texels.size(); i++)
+		{
+			texels[i] = image.getPixels()[i * numComponents];
+		}
+		image.release();
+
+		//Heights in texel units (0-255), downsampled if asked
+		int width = srcWidth, height = srcHeight;
+		if (maxSize > 1 && std::max(width, height) > maxSize)
+		{
+			const float shrink = (float)maxSize / std::max(width, height);
+			width = std::max(2, (int)(width * shrink + 0.5f));
+			height = std::max(2, (int)(height * shrink + 0.5f));
+		}
+		std::vector<float> heights(texels.begin(), texels.end());
+		if (width != srcWidth || height != srcHeight)
+		{
+			heights.resize((size_t)width * height);
+			ew::ResampleOptions options;
+			options.filter = ew::ResampleFilter::Lanczos;
+			options.numThreads = 0;
+			ew::resampleImage(texels.data(), srcWidth, srcHeight, ew::PixelType::UInt8, heights.data(), width, height, ew::PixelType::Float, 1, options);
+			for (float& h : heights)
+			{
+				h = std::clamp(h, 0.0f, 1.0f) * 255.0f;
+			}
+		}
+		//Grid spacing that stretches the smaller grid over the full size one
+		const float rowStep = height > 1 ? (srcHeight - 1) / (float)(height - 1) : 1.0f;
+		const float colStep = width > 1 ? (srcWidth - 1) / (float)(width - 1) : 1.0f;
 
 		float yScale = 64.0f / 256.0f;
+		//x and z are known from the grid, so only the height range is tracked
+		float minTexel = 255.0f, maxTexel = 0.0f;
 
 		//Vertices
+		mesh.vertices.reserve((size_t)width * height);
 		for (row = 0; row < height; row++)
 		{
 			for (col = 0; col < width; col++)
 			{
-				//Get texel for where current vertex is at and get its pixel data
-				unsigned char* texel = data + (col + width * row) * numComponents;
-				unsigned char y = texel[0];
+				//Get the height where the current vertex is
+				float y = heights[col + (size_t)width * row];
+				minTexel = y < minTexel ? y : minTexel;
+				maxTexel = y > maxTexel ? y : maxTexel;
 
-				v.pos.x = -height / 2.0f + row;
-				v.pos.y = (int)y * yScale;
-				v.pos.z = -width / 2.0f + col;
+				v.pos.x = -srcHeight / 2.0f + row * rowStep;
+				v.pos.y = y * yScale;
+				v.pos.z = -srcWidth / 2.0f + col * colStep;
 
 				v.normal = ew::Vec3(0.0f, 0.0f, 0.0f);
 
-				v.uv.x = col / (float)height;
-				v.uv.y = row / (float)width;
+				v.uv.x = col * colStep / (float)srcHeight;
+				v.uv.y = row * rowStep / (float)srcWidth;
 
 				mesh.vertices.push_back(v);
 			}
 		}
 
-		stbi_image_free(data);
+		if (width > 0 && height > 0)
+		{
+			mesh.bounds.min = ew::Vec3(-srcHeight / 2.0f, minTexel * yScale, -srcWidth / 2.0f);
+			mesh.bounds.max = ew::Vec3(-srcHeight / 2.0f + (srcHeight - 1), maxTexel * yScale, -srcWidth / 2.0f + (srcWidth - 1));
+			mesh.boundingSphere = ew::SphereAroundAABB(mesh.bounds);
+		}
 
 		//Indices
 		int indBottomLeft, indTopLeft, indTopRight, indBottomRight;
@@ -94,4 +200,165 @@ namespace JSLib
 
 		return mesh;
 	}
-}
\ No newline at end of file
+
+	/// <summary>
+	/// Only two neighboring layers ever blend, and neighbors differ in parity, so each texel stores one even
+	/// and one odd layer. A layer index only changes between texels where that layer's weight is 0, so linear
+	/// filtering blends the weights without ever mixing in a wrong layer.
+	/// </summary>
+	void buildTerrainWeights(const float* blendHeights, int numLayers, unsigned char* texels)
+	{
+		for (int i = 0; i < TERRAIN_WEIGHT_MAP_SIZE; i++)
+		{
+			const float h = (i + 0.5f) / TERRAIN_WEIGHT_MAP_SIZE;
+			int lower, upper;
+			float weight;
+			getTerrainBlend(blendHeights, numLayers, h, lower, upper, weight);
+			//A layer drawn alone pairs with the neighbor across its nearest blend
+			if (lower == upper && numLayers > 1)
+			{
+				const int layer = lower;
+				const bool hasBelow = layer > 0, hasAbove = layer < numLayers - 1;
+				const bool useBelow = hasBelow && (!hasAbove || h - blendHeights[2 * layer - 1] < blendHeights[2 * layer] - h);
+				lower = useBelow ? layer - 1 : layer;
+				upper = useBelow ? layer : layer + 1;
+				weight = useBelow ? 1.0f : 0.0f;
+			}
+			const bool lowerIsEven = lower % 2 == 0;
+			unsigned char* texel = texels + i * 3;
+			texel[0] = (unsigned char)(lowerIsEven ? lower : upper);
+			texel[1] = (unsigned char)(lowerIsEven ? upper : lower);
+			const float oddWeight = lower == upper ? 0.0f : (lowerIsEven ? weight : 1.0f - weight);
+			texel[2] = (unsigned char)(oddWeight * 255.0f + 0.5f);
+		}
+	}
+
+	unsigned int createTerrainWeightMap(const float* blendHeights, int numLayers)
+	{
+		unsigned int texture;
+		glGenTextures(1, &texture);
+		ew::renderState::bindTexture(0, GL_TEXTURE_1D, texture);
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexStorage1D(GL_TEXTURE_1D, 1, GL_RGB8, TERRAIN_WEIGHT_MAP_SIZE);
+		updateTerrainWeightMap(texture, blendHeights, numLayers);
+		return texture;
+	}
+
+	void updateTerrainWeightMap(unsigned int texture, const float* blendHeights, int numLayers)
+	{
+		unsigned char texels[TERRAIN_WEIGHT_MAP_SIZE * 3];
+		buildTerrainWeights(blendHeights, numLayers, texels);
+		ew::renderState::bindTexture(0, GL_TEXTURE_1D, texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage1D(GL_TEXTURE_1D, 0, 0, TERRAIN_WEIGHT_MAP_SIZE, GL_RGB, GL_UNSIGNED_BYTE, texels);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		ew::renderState::bindTexture(0, GL_TEXTURE_1D, 0);
+	}
+
+	/// <summary>
+	/// Each texel finds its point on the heightmap grid the way createTerrain lays out UVs, interpolates the height
+	/// between the four vertices around it, and blends the layers there as the terrain shader does, with the layer
+	/// images stretched once over the terrain. Rows are split across threads.
+	/// </summary>
+	std::vector<unsigned char> bakeTerrainColorMap(const char* heightMap, const std::vector<std::string>& layerPaths, const float* blendHeights, int size)
+	{
+		std::vector<unsigned char> colors;
+		ew::DecodeOptions heightOptions;
+		heightOptions.channels = 1;
+		ew::DecodedImage heightImage;
+		if (!ew::decodeImage(heightMap, heightImage, heightOptions) || heightImage.getInfo().type != ew::PixelType::UInt8)
+		{
+			printf("Failed to load heightmap %s\n", heightMap);
+			return colors;
+		}
+		const int width = heightImage.getInfo().width, height = heightImage.getInfo().height;
+		const unsigned char* heights = heightImage.getPixels();
+		struct Layer
+		{
+			ew::DecodedImage image;
+			const unsigned char* pixels;
+			int width, height;
+		};
+		std::vector<Layer> layers;
+		for (const std::string& path : layerPaths)
+		{
+			//A layer stretched over fewer texels than it has is decoded reduced, which also keeps it from aliasing
+			ew::ImageFile file;
+			ew::DecodeOptions options;
+			options.channels = 3;
+			Layer layer;
+			if (file.open(path.c_str()) && file.getInfo().type == ew::PixelType::UInt8)
+			{
+				options.scale = ew::getDecodeScale(file.getInfo().width, file.getInfo().height, size);
+			}
+			if (!file.decode(layer.image, options))
+			{
+				printf("Failed to load terrain layer %s\n", path.c_str());
+				break;
+			}
+			layer.pixels = layer.image.getPixels();
+			layer.width = layer.image.getInfo().width;
+			layer.height = layer.image.getInfo().height;
+			layers.push_back(std::move(layer));
+		}
+		if (layers.size() == layerPaths.size() && !layers.empty())
+		{
+			const int numLayers = (int)layers.size();
+			colors.resize((size_t)size * size * 3);
+			auto bakeRows = [&](int begin, int end)
+			{
+				for (int y = begin; y < end; y++)
+				{
+					const float v = (y + 0.5f) / size;
+					for (int x = 0; x < size; x++)
+					{
+						const float u = (x + 0.5f) / size;
+						//createTerrain: u = col / height, v = row / width, and y = texel * 64 / 256
+						const float col = std::clamp(u * height, 0.0f, (float)(width - 1));
+						const float row = std::clamp(v * width, 0.0f, (float)(height - 1));
+						const int col0 = (int)col, row0 = (int)row;
+						const int col1 = std::min(col0 + 1, width - 1), row1 = std::min(row0 + 1, height - 1);
+						const float tc = col - col0, tr = row - row0;
+						const float top = heights[row0 * width + col0] * (1.0f - tc) + heights[row0 * width + col1] * tc;
+						const float bottom = heights[row1 * width + col0] * (1.0f - tc) + heights[row1 * width + col1] * tc;
+						const float h = (top * (1.0f - tr) + bottom * tr) / 256.0f;
+
+						int lower, upper;
+						float weight;
+						getTerrainBlend(blendHeights, numLayers, h, lower, upper, weight);
+						float color[3] = {}, sample[3];
+						const Layer& a = layers[lower];
+						sampleRepeat(a.pixels, a.width, a.height, 3, u * a.width, v * a.height, sample);
+						for (int c = 0; c < 3; c++)
+							color[c] = sample[c] * (1.0f - weight);
+						if (weight > 0.0f)
+						{
+							const Layer& b = layers[upper];
+							sampleRepeat(b.pixels, b.width, b.height, 3, u * b.width, v * b.height, sample);
+							for (int c = 0; c < 3; c++)
+								color[c] += sample[c] * weight;
+						}
+						unsigned char* out = &colors[((size_t)y * size + x) * 3];
+						for (int c = 0; c < 3; c++)
+							out[c] = (unsigned char)std::min(color[c] + 0.5f, 255.0f);
+					}
+				}
+			};
+			const unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());
+			const int rowsPerThread = (size + numThreads - 1) / numThreads;
+			std::vector<std::thread> threads;
+			for (int begin = rowsPerThread; begin < size; begin += rowsPerThread)
+			{
+				threads.emplace_back(bakeRows, begin, std::min(size, begin + rowsPerThread));
+			}
+			bakeRows(0, std::min(size, rowsPerThread));
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+		}
+		return colors;
+	}
+}
@@ -4,10 +4,30 @@
 */
 
 #pragma once
+#include <vector>
+#include <string>
 #include "../ew/mesh.h"
 #include "../ew/external/stb_image.h"
 #include "../ew/external/glad.h"
 namespace JSLib
 {
-	ew::MeshData createTerrain(char* heightMap);
+	ew::MeshData createTerrain(const char* heightMap);
+	//Meshes the heightmap downsampled to at most maxSize vertices per side, over the same area and UVs as
+	//createTerrain. 0 keeps every texel.
+	ew::MeshData createTerrainScaled(const char* heightMap, int maxSize);
+
+	//Height-based splatting over the layers of a texture array. Layer i is drawn alone up to blendHeights[2i],
+	//then blends linearly into layer i + 1, which is drawn alone from blendHeights[2i + 1]. Heights are normalized
+	//to the terrain's range, so numLayers layers take 2 * (numLayers - 1) of them.
+	const int TERRAIN_WEIGHT_MAP_SIZE = 256;
+	//Fills TERRAIN_WEIGHT_MAP_SIZE RGB texels, from height 0 to 1: an even layer, an odd layer and the odd layer's weight
+	void buildTerrainWeights(const float* blendHeights, int numLayers, unsigned char* texels);
+	//A linearly filtered 1D texture of those texels, for the terrain shader's _TerrainWeights
+	unsigned int createTerrainWeightMap(const float* blendHeights, int numLayers);
+	//Rebuilds the texels after the heights change
+	void updateTerrainWeightMap(unsigned int texture, const float* blendHeights, int numLayers);
+
+	//Bakes the layer images blended by height into one size x size RGB color map over the whole terrain, in
+	//createTerrain's UVs, for a virtual texture (ew/virtualTexture.h). Empty if an image fails to load.
+	std::vector<unsigned char> bakeTerrainColorMap(const char* heightMap, const std::vector<std::string>& layerPaths, const float* blendHeights, int size);
 }
\ No newline at end of file
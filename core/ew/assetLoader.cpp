@@ -0,0 +1,214 @@
+#include "assetLoader.h"
+#include <memory>
+#include <algorithm>
+#include <stdio.h>
+#include "texture.h"
+#include "textureCache.h"
+#include "renderState.h"
+#include "external/glad.h"
+
+namespace ew {
+	AssetLoader::AssetLoader(unsigned int numThreads)
+		:m_start(std::chrono::steady_clock::now())
+	{
+		if (numThreads == 0) {
+			unsigned int cores = std::thread::hardware_concurrency();
+			numThreads = cores > 1 ? cores - 1 : 1;
+		}
+		for (unsigned int i = 0; i < numThreads; i++) {
+			m_threads.emplace_back(&AssetLoader::run, this);
+		}
+	}
+	AssetLoader::~AssetLoader()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_running = false;
+		}
+		m_jobReady.notify_all();
+		for (std::thread& thread : m_threads) {
+			thread.join();
+		}
+	}
+	double AssetLoader::now() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+	}
+	void AssetLoader::load(const std::string& name, LoadFn job)
+	{
+		AssetTiming timing;
+		timing.name = name;
+		timing.queued = now();
+		m_timings.push_back(timing);
+		m_numPending++;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobs.push_back({ m_timings.size() - 1, std::move(job) });
+		}
+		m_jobReady.notify_one();
+	}
+	size_t AssetLoader::update()
+	{
+		std::vector<Finished> finished;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			finished.swap(m_finished);
+		}
+		for (Finished& job : finished) {
+			AssetTiming& timing = m_timings[job.timing];
+			timing.started = job.started;
+			timing.decoded = job.decoded;
+			const double uploadStart = now();
+			if (job.apply) {
+				job.apply();
+			}
+			timing.uploaded = now();
+			timing.uploadTime = timing.uploaded - uploadStart;
+		}
+		m_numPending -= finished.size();
+		return finished.size();
+	}
+	/// <summary>
+	/// Uploads each job as soon as it is decoded, so uploads overlap the decodes still running
+	/// </summary>
+	void AssetLoader::finish()
+	{
+		while (m_numPending > 0) {
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_jobFinished.wait(lock, [this]() { return !m_finished.empty(); });
+			}
+			update();
+		}
+	}
+	void AssetLoader::run()
+	{
+		while (true) {
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_jobReady.wait(lock, [this]() { return !m_running || !m_jobs.empty(); });
+				if (m_jobs.empty()) {
+					return;
+				}
+				job = std::move(m_jobs.front());
+				m_jobs.pop_front();
+			}
+			const double started = now();
+			std::function<void()> apply = job.load();
+			const double decoded = now();
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_finished.push_back({ job.timing, started, decoded, std::move(apply) });
+			}
+			m_jobFinished.notify_one();
+		}
+	}
+	/// <summary>
+	/// The critical path replays the measured decode and upload times with a worker per job: every decode
+	/// starts at once, and the GL thread uploads each as it lands. It is the floor that more cores approach.
+	/// </summary>
+	void AssetLoader::printReport() const
+	{
+		if (m_timings.empty()) {
+			return;
+		}
+		printf("%-40s %9s %9s %9s %9s\n", "Asset", "wait ms", "decode ms", "upload ms", "done ms");
+		double decodeTotal = 0.0, uploadTotal = 0.0, first = m_timings[0].queued, last = 0.0;
+		std::vector<std::pair<double, double>> decodeUpload;
+		for (const AssetTiming& timing : m_timings) {
+			const double decode = timing.decoded - timing.started;
+			printf("%-40s %9.1f %9.1f %9.1f %9.1f\n", timing.name.c_str(),
+				timing.started - timing.queued, decode, timing.uploadTime, timing.uploaded);
+			decodeTotal += decode;
+			uploadTotal += timing.uploadTime;
+			first = std::min(first, timing.queued);
+			last = std::max(last, timing.uploaded);
+			decodeUpload.push_back({ decode, timing.uploadTime });
+		}
+		std::sort(decodeUpload.begin(), decodeUpload.end());
+		double criticalPath = 0.0;
+		for (const auto& job : decodeUpload) {
+			criticalPath = std::max(criticalPath, job.first) + job.second;
+		}
+		const double wall = last - first;
+		printf("%zu assets in %.1f ms on %u worker threads. Decode %.1f ms total (%.2fx overlap), GL uploads %.1f ms.\n",
+			m_timings.size(), wall, getNumThreads(), decodeTotal, wall > 0.0 ? decodeTotal / wall : 0.0, uploadTotal);
+		printf("Critical path with a worker per asset: %.1f ms\n", criticalPath);
+	}
+
+	unsigned int loadTextureAsync(AssetLoader& loader, const std::string& filePath, int wrapMode, int filterMode, TextureCompression compression)
+	{
+		unsigned int texture = createTextureForWorker(wrapMode, filterMode, compression);
+		loader.load(filePath, [texture, filePath, compression]() -> std::function<void()> {
+			auto image = std::make_shared<TextureImage>();
+			if (!loadTextureImage(filePath.c_str(), *image, false, compression)) {
+				printf("Failed to load image %s\n", filePath.c_str());
+				return {};
+			}
+			return [texture, image]() {
+				uploadTextureImage(texture, *image);
+				renderState::bindTexture(0, GL_TEXTURE_2D, 0);
+			};
+		});
+		return texture;
+	}
+	/// <summary>
+	/// One job per layer. Whichever layer reaches the GL thread first allocates the array's storage.
+	/// </summary>
+	unsigned int loadTextureArrayAsync(AssetLoader& loader, const std::vector<std::string>& filePaths, int wrapMode, int filterMode, TextureCompression compression)
+	{
+		unsigned int texture = createTextureArrayForWorker(wrapMode, filterMode, compression);
+		//Only touched on the GL thread
+		auto allocated = std::make_shared<bool>(false);
+		const int numLayers = (int)filePaths.size();
+		for (int layer = 0; layer < numLayers; layer++) {
+			const std::string filePath = filePaths[layer];
+			loader.load(filePath, [texture, filePath, layer, numLayers, compression, allocated]() -> std::function<void()> {
+				auto image = std::make_shared<TextureImage>();
+				if (!loadTextureImage(filePath.c_str(), *image, false, compression)) {
+					printf("Failed to load image %s\n", filePath.c_str());
+					return {};
+				}
+				return [texture, filePath, layer, numLayers, image, allocated]() {
+					if (!*allocated) {
+						allocateTextureArray(texture, *image, numLayers);
+						*allocated = true;
+					}
+					if (!uploadTextureImageLayer(texture, layer, *image)) {
+						printf("Texture array layer %s does not match the size and format of the other layers\n", filePath.c_str());
+					}
+					renderState::bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+				};
+			});
+		}
+		return texture;
+	}
+	void loadTextureLayerAsync(AssetLoader& loader, unsigned int texture, int layer, const std::string& filePath, TextureCompression compression)
+	{
+		compression = getSupportedCompression(compression);
+		loader.load(filePath, [texture, layer, filePath, compression]() -> std::function<void()> {
+			auto image = std::make_shared<TextureImage>();
+			if (!loadTextureImage(filePath.c_str(), *image, false, compression)) {
+				printf("Failed to load image %s\n", filePath.c_str());
+				return {};
+			}
+			return [texture, layer, filePath, image]() {
+				if (!uploadTextureImageLayer(texture, layer, *image)) {
+					printf("%s does not match the size and format of its texture array\n", filePath.c_str());
+				}
+				renderState::bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+			};
+		});
+	}
+	void loadMeshAsync(AssetLoader& loader, Mesh& mesh, const std::string& filePath, std::function<MeshData(const char* filePath)> buildMesh)
+	{
+		Mesh* target = &mesh;
+		loader.load(filePath, [target, filePath, buildMesh]() -> std::function<void()> {
+			auto meshData = std::make_shared<MeshData>(buildMesh(filePath.c_str()));
+			return [target, meshData]() {
+				target->load(*meshData);
+			};
+		});
+	}
+}
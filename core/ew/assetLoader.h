@@ -0,0 +1,87 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include "mesh.h"
+#include "textureCache.h"
+
+namespace ew {
+	//Timings of one job, in milliseconds since the loader was created
+	struct AssetTiming {
+		std::string name;
+		double queued = 0.0;
+		double started = 0.0; //Picked up by a worker
+		double decoded = 0.0; //CPU side done, waiting for the GL thread
+		double uploaded = 0.0; //GL side done
+		double uploadTime = 0.0; //Time spent in the GL side
+	};
+
+	//Loads assets on a pool of worker threads. Like FileWatcher's rebuilds, each job does its CPU side
+	//(file reads, decoding, meshing) on a worker and returns a function that finishes it on the GL thread.
+	class AssetLoader {
+	public:
+		using LoadFn = std::function<std::function<void()>()>;
+
+		//0 threads picks one per core, less the GL thread
+		explicit AssetLoader(unsigned int numThreads = 0);
+		~AssetLoader();
+		AssetLoader(const AssetLoader&) = delete;
+		AssetLoader& operator=(const AssetLoader&) = delete;
+
+		//Queues a job. name labels it in the report.
+		void load(const std::string& name, LoadFn job);
+		//Runs the GL side of every job finished so far. Call on the thread that owns the GL context.
+		//Returns the number of jobs completed.
+		size_t update();
+		//Calls update until every queued job has completed
+		void finish();
+		inline size_t getNumPending()const { return m_numPending; }
+		inline unsigned int getNumThreads()const { return (unsigned int)m_threads.size(); }
+
+		inline const std::vector<AssetTiming>& getTimings()const { return m_timings; }
+		//Per-job table, then wall time against total decode work, and the critical path:
+		//the shortest possible load given the measured times, since uploads share the GL thread
+		void printReport()const;
+	private:
+		struct Job {
+			size_t timing;
+			LoadFn load;
+		};
+		//Workers report their times here, so only the GL thread touches m_timings
+		struct Finished {
+			size_t timing;
+			double started;
+			double decoded;
+			std::function<void()> apply;
+		};
+		void run();
+		double now()const;
+
+		std::chrono::steady_clock::time_point m_start;
+		std::vector<std::thread> m_threads;
+		bool m_running = true;
+		std::mutex m_mutex;
+		std::condition_variable m_jobReady;
+		std::condition_variable m_jobFinished;
+		std::deque<Job> m_jobs;
+		std::vector<Finished> m_finished;
+		std::vector<AssetTiming> m_timings; //GL thread only
+		size_t m_numPending = 0; //GL thread only
+	};
+
+	//Returns a texture handle right away. The image and its mips are loaded from the texture cache (built on
+	//first use) on a worker and uploaded by update(). compression works as in loadTexture.
+	unsigned int loadTextureAsync(AssetLoader& loader, const std::string& filePath, int wrapMode, int filterMode, TextureCompression compression = TextureCompression::None);
+	//loadTextureArray on the pool, one job per layer. The array gets its storage when the first layer arrives.
+	unsigned int loadTextureArrayAsync(AssetLoader& loader, const std::vector<std::string>& filePaths, int wrapMode, int filterMode, TextureCompression compression = TextureCompression::None);
+	//Replaces one layer of an existing array with filePath's image, decoded on the pool. A layer that no longer
+	//matches the array's size and format is reported and left as it was.
+	void loadTextureLayerAsync(AssetLoader& loader, unsigned int texture, int layer, const std::string& filePath, TextureCompression compression = TextureCompression::None);
+	//Builds mesh data with buildMesh (e.g. JSLib::createTerrain) on a worker and loads it into mesh in update()
+	void loadMeshAsync(AssetLoader& loader, Mesh& mesh, const std::string& filePath, std::function<MeshData(const char* filePath)> buildMesh);
+}
@@ -0,0 +1,767 @@
+#include "blockCompression.h"
+#include "ewMath/simd.h"
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace {
+	using ew::BlockFormat;
+	using ew::CompressionQuality;
+
+	//Palette searches run over 4 pixels at a time. AVX builds use this too, a block is only 16 pixels.
+#if defined(EW_SIMD_SSE)
+	typedef __m128 Lane;
+	const int LANES = 4;
+	inline Lane lSet(float f) { return _mm_set1_ps(f); }
+	inline Lane lLoad(const float* p) { return _mm_load_ps(p); }
+	inline void lStore(float* p, Lane v) { _mm_store_ps(p, v); }
+	inline Lane lSub(Lane a, Lane b) { return _mm_sub_ps(a, b); }
+	inline Lane lMulAdd(Lane a, Lane b, Lane c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+	inline Lane lMin(Lane a, Lane b) { return _mm_min_ps(a, b); }
+	//ifLess where a < b, otherwise the last argument
+	inline Lane lSelectLess(Lane a, Lane b, Lane ifLess, Lane otherwise) {
+		const Lane mask = _mm_cmplt_ps(a, b);
+		return _mm_or_ps(_mm_and_ps(mask, ifLess), _mm_andnot_ps(mask, otherwise));
+	}
+#elif defined(EW_SIMD_NEON)
+	typedef float32x4_t Lane;
+	const int LANES = 4;
+	inline Lane lSet(float f) { return vdupq_n_f32(f); }
+	inline Lane lLoad(const float* p) { return vld1q_f32(p); }
+	inline void lStore(float* p, Lane v) { vst1q_f32(p, v); }
+	inline Lane lSub(Lane a, Lane b) { return vsubq_f32(a, b); }
+	inline Lane lMulAdd(Lane a, Lane b, Lane c) { return vmlaq_f32(c, a, b); }
+	inline Lane lMin(Lane a, Lane b) { return vminq_f32(a, b); }
+	inline Lane lSelectLess(Lane a, Lane b, Lane ifLess, Lane otherwise) { return vbslq_f32(vcltq_f32(a, b), ifLess, otherwise); }
+#else
+	typedef float Lane;
+	const int LANES = 1;
+	inline Lane lSet(float f) { return f; }
+	inline Lane lLoad(const float* p) { return *p; }
+	inline void lStore(float* p, Lane v) { *p = v; }
+	inline Lane lSub(Lane a, Lane b) { return a - b; }
+	inline Lane lMulAdd(Lane a, Lane b, Lane c) { return a * b + c; }
+	inline Lane lMin(Lane a, Lane b) { return a < b ? a : b; }
+	inline Lane lSelectLess(Lane a, Lane b, Lane ifLess, Lane otherwise) { return a < b ? ifLess : otherwise; }
+#endif
+
+	//One 4x4 block, stored a channel at a time so the palette search loads 4 pixels of a channel at once
+	struct Block {
+		alignas(16) float values[4][16];
+		int numChannels = 0;
+	};
+	//Up to 16 colors of up to 4 channels, as the decoder will reconstruct them
+	typedef float Palette[16][4];
+
+	inline float clampByte(float v) {
+		return v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v);
+	}
+	inline int roundByte(float v) {
+		return (int)(clampByte(v) + 0.5f);
+	}
+
+	/// <summary>
+	/// Picks the nearest palette entry for every pixel of the block
+	/// </summary>
+	/// <returns>Total squared error</returns>
+	float chooseIndices(const Block& block, const Palette palette, int numColors, uint8_t* indices) {
+		float error = 0.0f;
+		for (int i = 0; i < 16; i += LANES) {
+			Lane best = lSet(FLT_MAX);
+			Lane bestIndex = lSet(0.0f);
+			for (int k = 0; k < numColors; k++) {
+				Lane distance = lSet(0.0f);
+				for (int c = 0; c < block.numChannels; c++) {
+					const Lane d = lSub(lLoad(&block.values[c][i]), lSet(palette[k][c]));
+					distance = lMulAdd(d, d, distance);
+				}
+				bestIndex = lSelectLess(distance, best, lSet((float)k), bestIndex);
+				best = lMin(distance, best);
+			}
+			alignas(16) float distances[LANES];
+			alignas(16) float chosen[LANES];
+			lStore(distances, best);
+			lStore(chosen, bestIndex);
+			for (int j = 0; j < LANES; j++) {
+				indices[i + j] = (uint8_t)chosen[j];
+				error += distances[j];
+			}
+		}
+		return error;
+	}
+
+	/// <summary>
+	/// Endpoints at the corners of the block's bounding box. Each channel runs low to high or high to low
+	/// depending on whether it rises or falls with the channel of widest range.
+	/// </summary>
+	void fitBox(const Block& block, float* a, float* b) {
+		float lo[4], hi[4], mean[4];
+		int widest = 0;
+		for (int c = 0; c < block.numChannels; c++) {
+			lo[c] = hi[c] = block.values[c][0];
+			mean[c] = 0.0f;
+			for (int i = 0; i < 16; i++) {
+				lo[c] = fminf(lo[c], block.values[c][i]);
+				hi[c] = fmaxf(hi[c], block.values[c][i]);
+				mean[c] += block.values[c][i] / 16.0f;
+			}
+			if (hi[c] - lo[c] > hi[widest] - lo[widest]) {
+				widest = c;
+			}
+		}
+		for (int c = 0; c < block.numChannels; c++) {
+			float covariance = 0.0f;
+			for (int i = 0; i < 16; i++) {
+				covariance += (block.values[c][i] - mean[c]) * (block.values[widest][i] - mean[widest]);
+			}
+			a[c] = covariance < 0.0f ? hi[c] : lo[c];
+			b[c] = covariance < 0.0f ? lo[c] : hi[c];
+		}
+	}
+
+	/// <summary>
+	/// Endpoints at the block's extremes along its principal axis, found by power iteration on the covariance
+	/// </summary>
+	void fitPrincipalAxis(const Block& block, float* a, float* b) {
+		const int n = block.numChannels;
+		float mean[4] = {}, covariance[4][4] = {};
+		for (int c = 0; c < n; c++) {
+			for (int i = 0; i < 16; i++) {
+				mean[c] += block.values[c][i] / 16.0f;
+			}
+		}
+		for (int i = 0; i < 16; i++) {
+			for (int r = 0; r < n; r++) {
+				for (int c = r; c < n; c++) {
+					covariance[r][c] += (block.values[r][i] - mean[r]) * (block.values[c][i] - mean[c]);
+				}
+			}
+		}
+		for (int r = 0; r < n; r++) {
+			for (int c = 0; c < r; c++) {
+				covariance[r][c] = covariance[c][r];
+			}
+		}
+		//Start from the bounding box diagonal, which is usually close already
+		float axis[4];
+		fitBox(block, a, b);
+		for (int c = 0; c < n; c++) {
+			axis[c] = b[c] - a[c];
+		}
+		for (int iteration = 0; iteration < 8; iteration++) {
+			float next[4] = {}, lengthSq = 0.0f;
+			for (int r = 0; r < n; r++) {
+				for (int c = 0; c < n; c++) {
+					next[r] += covariance[r][c] * axis[c];
+				}
+				lengthSq += next[r] * next[r];
+			}
+			if (lengthSq < 1e-12f) {
+				break;
+			}
+			const float invLength = 1.0f / sqrtf(lengthSq);
+			for (int c = 0; c < n; c++) {
+				axis[c] = next[c] * invLength;
+			}
+		}
+		float lengthSq = 0.0f;
+		for (int c = 0; c < n; c++) {
+			lengthSq += axis[c] * axis[c];
+		}
+		if (lengthSq < 1e-12f) {
+			//Flat block: the box corners are the mean already
+			return;
+		}
+		float tMin = FLT_MAX, tMax = -FLT_MAX;
+		for (int i = 0; i < 16; i++) {
+			float t = 0.0f;
+			for (int c = 0; c < n; c++) {
+				t += (block.values[c][i] - mean[c]) * axis[c];
+			}
+			tMin = fminf(tMin, t);
+			tMax = fmaxf(tMax, t);
+		}
+		const float invLengthSq = 1.0f / lengthSq;
+		for (int c = 0; c < n; c++) {
+			a[c] = clampByte(mean[c] + tMin * axis[c] * invLengthSq);
+			b[c] = clampByte(mean[c] + tMax * axis[c] * invLengthSq);
+		}
+	}
+
+	/// <summary>
+	/// Least squares endpoints for fixed indices
+	/// </summary>
+	/// <param name="weights">Position of each palette entry from a (0) to b (1)</param>
+	/// <returns>False if every pixel uses the same weight, leaving a and b unchanged</returns>
+	bool refit(const Block& block, const uint8_t* indices, const float* weights, float* a, float* b) {
+		float aa = 0.0f, bb = 0.0f, ab = 0.0f, ax[4] = {}, bx[4] = {};
+		for (int i = 0; i < 16; i++) {
+			const float w = weights[indices[i]];
+			const float u = 1.0f - w;
+			aa += u * u;
+			bb += w * w;
+			ab += u * w;
+			for (int c = 0; c < block.numChannels; c++) {
+				ax[c] += u * block.values[c][i];
+				bx[c] += w * block.values[c][i];
+			}
+		}
+		const float det = aa * bb - ab * ab;
+		if (fabsf(det) < 1e-6f) {
+			return false;
+		}
+		const float invDet = 1.0f / det;
+		for (int c = 0; c < block.numChannels; c++) {
+			a[c] = clampByte((ax[c] * bb - bx[c] * ab) * invDet);
+			b[c] = clampByte((bx[c] * aa - ax[c] * ab) * invDet);
+		}
+		return true;
+	}
+
+	int getNumRefinements(CompressionQuality quality) {
+		return quality == CompressionQuality::Fast ? 0 : (quality == CompressionQuality::Normal ? 1 : 3);
+	}
+
+	//Writes values least significant bit first, as BC7 lays out its fields
+	struct BitWriter {
+		uint8_t* out;
+		int position = 0;
+		void write(uint32_t value, int numBits) {
+			for (int i = 0; i < numBits; i++, position++) {
+				out[position >> 3] |= (uint8_t)(((value >> i) & 1) << (position & 7));
+			}
+		}
+	};
+	struct BitReader {
+		const uint8_t* in;
+		int position = 0;
+		uint32_t read(int numBits) {
+			uint32_t value = 0;
+			for (int i = 0; i < numBits; i++, position++) {
+				value |= (uint32_t)((in[position >> 3] >> (position & 7)) & 1) << i;
+			}
+			return value;
+		}
+	};
+
+	//BC1
+
+	inline int expand5(int v) { return (v << 3) | (v >> 2); }
+	inline int expand6(int v) { return (v << 2) | (v >> 4); }
+	inline uint16_t to565(const float* color) {
+		return (uint16_t)((int)(clampByte(color[0]) * 31.0f / 255.0f + 0.5f) << 11
+			| (int)(clampByte(color[1]) * 63.0f / 255.0f + 0.5f) << 5
+			| (int)(clampByte(color[2]) * 31.0f / 255.0f + 0.5f));
+	}
+	void from565(uint16_t c, int* color) {
+		color[0] = expand5(c >> 11);
+		color[1] = expand6((c >> 5) & 63);
+		color[2] = expand5(c & 31);
+	}
+	//c0 > c1 gives 4 colors. Otherwise 3, and black.
+	void paletteBC1(uint16_t c0, uint16_t c1, int palette[4][3]) {
+		from565(c0, palette[0]);
+		from565(c1, palette[1]);
+		for (int c = 0; c < 3; c++) {
+			if (c0 > c1) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+			}
+			else {
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+	}
+	void encodeBC1(const Block& block, CompressionQuality quality, uint8_t* out) {
+		float a[4], b[4];
+		if (quality == CompressionQuality::Fast) {
+			fitBox(block, a, b);
+		}
+		else {
+			fitPrincipalAxis(block, a, b);
+		}
+		const float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+		const int numRefinements = getNumRefinements(quality);
+		float bestError = FLT_MAX;
+		uint16_t best0 = 0, best1 = 0;
+		uint8_t bestIndices[16] = {};
+		for (int pass = 0; ; pass++) {
+			uint16_t c0 = to565(a), c1 = to565(b);
+			//Only c0 > c1 gives the 4 color palette. Swapping the endpoints just relabels the indices.
+			if (c0 < c1) {
+				std::swap(c0, c1);
+				std::swap(a, b);
+			}
+			int colors[4][3];
+			paletteBC1(c0, c1, colors);
+			Palette palette;
+			for (int k = 0; k < 4; k++) {
+				for (int c = 0; c < 3; c++) {
+					palette[k][c] = (float)colors[k][c];
+				}
+			}
+			uint8_t indices[16];
+			//Equal endpoints select the 3 color palette, where index 3 is black, so use index 0 alone
+			const float error = chooseIndices(block, palette, c0 == c1 ? 1 : 4, indices);
+			if (error < bestError) {
+				bestError = error;
+				best0 = c0;
+				best1 = c1;
+				memcpy(bestIndices, indices, 16);
+			}
+			if (pass == numRefinements || c0 == c1 || !refit(block, indices, weights, a, b)) {
+				break;
+			}
+		}
+		uint32_t packed = 0;
+		for (int i = 0; i < 16; i++) {
+			packed |= (uint32_t)bestIndices[i] << (2 * i);
+		}
+		out[0] = best0 & 0xFF;
+		out[1] = best0 >> 8;
+		out[2] = best1 & 0xFF;
+		out[3] = best1 >> 8;
+		memcpy(out + 4, &packed, 4);
+	}
+	void decodeBC1(const uint8_t* in, uint8_t pixels[16][4]) {
+		const uint16_t c0 = (uint16_t)(in[0] | in[1] << 8);
+		const uint16_t c1 = (uint16_t)(in[2] | in[3] << 8);
+		int palette[4][3];
+		paletteBC1(c0, c1, palette);
+		uint32_t packed;
+		memcpy(&packed, in + 4, 4);
+		for (int i = 0; i < 16; i++) {
+			const int index = (packed >> (2 * i)) & 3;
+			for (int c = 0; c < 3; c++) {
+				pixels[i][c] = (uint8_t)palette[index][c];
+			}
+			pixels[i][3] = c0 <= c1 && index == 3 ? 0 : 255;
+		}
+	}
+
+	//BC4
+
+	//a0 > a1 gives 6 values between them. Otherwise 4, then 0 and 255.
+	void paletteBC4(int a0, int a1, int palette[8]) {
+		palette[0] = a0;
+		palette[1] = a1;
+		if (a0 > a1) {
+			for (int i = 1; i < 7; i++) {
+				palette[i + 1] = ((7 - i) * a0 + i * a1 + 3) / 7;
+			}
+		}
+		else {
+			for (int i = 1; i < 5; i++) {
+				palette[i + 1] = ((5 - i) * a0 + i * a1 + 2) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+	float evaluateBC4(const Block& block, int a0, int a1, uint8_t* indices) {
+		int values[8];
+		paletteBC4(a0, a1, values);
+		Palette palette;
+		for (int k = 0; k < 8; k++) {
+			palette[k][0] = (float)values[k];
+		}
+		return chooseIndices(block, palette, 8, indices);
+	}
+	/// <summary>
+	/// Encodes channel 0 of the block
+	/// </summary>
+	void encodeBC4(const Block& block, CompressionQuality quality, uint8_t* out) {
+		float lo = 255.0f, hi = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			lo = fminf(lo, block.values[0][i]);
+			hi = fmaxf(hi, block.values[0][i]);
+		}
+		const float weights[8] = { 0.0f, 1.0f, 1.0f / 7, 2.0f / 7, 3.0f / 7, 4.0f / 7, 5.0f / 7, 6.0f / 7 };
+		const int numRefinements = getNumRefinements(quality);
+		float a = hi, b = lo;
+		float bestError = FLT_MAX;
+		int best0 = 0, best1 = 0;
+		uint8_t bestIndices[16] = {};
+		for (int pass = 0; ; pass++) {
+			int a0 = roundByte(a), a1 = roundByte(b);
+			if (a0 < a1) {
+				std::swap(a0, a1);
+				std::swap(a, b);
+			}
+			else if (a0 == a1) {
+				//Keep the 8 value mode
+				if (a0 < 255) {
+					a0++;
+				}
+				else {
+					a1--;
+				}
+			}
+			uint8_t indices[16];
+			const float error = evaluateBC4(block, a0, a1, indices);
+			if (error < bestError) {
+				bestError = error;
+				best0 = a0;
+				best1 = a1;
+				memcpy(bestIndices, indices, 16);
+			}
+			if (pass == numRefinements || error == 0.0f || !refit(block, indices, weights, &a, &b)) {
+				break;
+			}
+		}
+		//Blocks that touch 0 or 255 can spend the 6 value mode's interpolants on the rest of their range
+		if (quality == CompressionQuality::Best && bestError > 0.0f) {
+			float innerLo = 255.0f, innerHi = 0.0f;
+			for (int i = 0; i < 16; i++) {
+				const float v = block.values[0][i];
+				if (v > 0.0f && v < 255.0f) {
+					innerLo = fminf(innerLo, v);
+					innerHi = fmaxf(innerHi, v);
+				}
+			}
+			if (innerLo <= innerHi) {
+				uint8_t indices[16];
+				const int a0 = roundByte(innerLo), a1 = roundByte(innerHi);
+				const float error = evaluateBC4(block, a0, a1, indices);
+				if (error < bestError) {
+					bestError = error;
+					best0 = a0;
+					best1 = a1;
+					memcpy(bestIndices, indices, 16);
+				}
+			}
+		}
+		uint64_t packed = 0;
+		for (int i = 0; i < 16; i++) {
+			packed |= (uint64_t)bestIndices[i] << (3 * i);
+		}
+		out[0] = (uint8_t)best0;
+		out[1] = (uint8_t)best1;
+		for (int i = 0; i < 6; i++) {
+			out[2 + i] = (uint8_t)(packed >> (8 * i));
+		}
+	}
+	void decodeBC4(const uint8_t* in, uint8_t pixels[16][4], int channel) {
+		int palette[8];
+		paletteBC4(in[0], in[1], palette);
+		uint64_t packed = 0;
+		for (int i = 0; i < 6; i++) {
+			packed |= (uint64_t)in[2 + i] << (8 * i);
+		}
+		for (int i = 0; i < 16; i++) {
+			pixels[i][channel] = (uint8_t)palette[(packed >> (3 * i)) & 7];
+		}
+	}
+
+	//BC7 mode 6
+
+	const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	/// <summary>
+	/// Quantizes an endpoint to 7 bits per channel plus the low bit shared by its channels, choosing the low bit that lands closer
+	/// </summary>
+	void quantizeBC7(const float* color, int* quantized, int& pBit) {
+		float bestError = FLT_MAX;
+		for (int p = 0; p < 2; p++) {
+			int q[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++) {
+				q[c] = std::min(127, std::max(0, (int)((clampByte(color[c]) - p) * 0.5f + 0.5f)));
+				const float d = (float)(q[c] * 2 + p) - color[c];
+				error += d * d;
+			}
+			if (error < bestError) {
+				bestError = error;
+				pBit = p;
+				memcpy(quantized, q, sizeof(q));
+			}
+		}
+	}
+	void paletteBC7(const int* q0, int p0, const int* q1, int p1, int palette[16][4]) {
+		for (int c = 0; c < 4; c++) {
+			const int e0 = q0[c] * 2 + p0;
+			const int e1 = q1[c] * 2 + p1;
+			for (int k = 0; k < 16; k++) {
+				palette[k][c] = ((64 - BC7_WEIGHTS[k]) * e0 + BC7_WEIGHTS[k] * e1 + 32) >> 6;
+			}
+		}
+	}
+
+	//Endpoints for one value at one index, q0 | q1 << 7, or -1 when no pair decodes to it exactly
+	struct BC7SolidTable {
+		int16_t endpoints[4][16][256]; //[p0 | p1 << 1][index][value]
+		BC7SolidTable() {
+			memset(endpoints, 0xFF, sizeof(endpoints));
+			for (int p = 0; p < 4; p++) {
+				for (int k = 0; k < 16; k++) {
+					for (int q0 = 0; q0 < 128; q0++) {
+						for (int q1 = 0; q1 < 128; q1++) {
+							const int value = ((64 - BC7_WEIGHTS[k]) * (q0 * 2 + (p & 1)) + BC7_WEIGHTS[k] * (q1 * 2 + (p >> 1)) + 32) >> 6;
+							if (endpoints[p][k][value] < 0) {
+								endpoints[p][k][value] = (int16_t)(q0 | q1 << 7);
+							}
+						}
+					}
+				}
+			}
+		}
+	};
+
+	/// <summary>
+	/// Endpoints and an index that decode exactly to a block of one color. Rounding to the nearest endpoints can miss by one,
+	/// so this looks for p-bits and an index every channel can hit. Mode 6 has none for a color with both a 0 and a 255 channel.
+	/// </summary>
+	bool encodeSolidBC7(const Block& block, int* q0, int* q1, int& p0, int& p1, uint8_t& index) {
+		int color[4];
+		for (int c = 0; c < 4; c++) {
+			for (int i = 1; i < 16; i++) {
+				if (block.values[c][i] != block.values[c][0])
+					return false;
+			}
+			color[c] = (int)block.values[c][0];
+		}
+		//Built by the first thread to need it
+		static const BC7SolidTable table;
+		for (int p = 0; p < 4; p++) {
+			for (int k = 0; k < 16; k++) {
+				int c = 0;
+				while (c < 4 && table.endpoints[p][k][color[c]] >= 0) {
+					c++;
+				}
+				if (c < 4)
+					continue;
+				for (c = 0; c < 4; c++) {
+					q0[c] = table.endpoints[p][k][color[c]] & 127;
+					q1[c] = table.endpoints[p][k][color[c]] >> 7;
+				}
+				p0 = p & 1;
+				p1 = p >> 1;
+				index = (uint8_t)k;
+				return true;
+			}
+		}
+		return false;
+	}
+	void encodeBC7(const Block& block, CompressionQuality quality, uint8_t* out) {
+		int best0[4] = {}, best1[4] = {}, bestP0 = 0, bestP1 = 0;
+		uint8_t bestIndices[16] = {};
+		uint8_t solidIndex = 0;
+		if (encodeSolidBC7(block, best0, best1, bestP0, bestP1, solidIndex)) {
+			memset(bestIndices, solidIndex, 16);
+		}
+		else {
+			float a[4], b[4];
+			if (quality == CompressionQuality::Fast) {
+				fitBox(block, a, b);
+			}
+			else {
+				fitPrincipalAxis(block, a, b);
+			}
+			float weights[16];
+			for (int k = 0; k < 16; k++) {
+				weights[k] = BC7_WEIGHTS[k] / 64.0f;
+			}
+			const int numRefinements = getNumRefinements(quality);
+			float bestError = FLT_MAX;
+			for (int pass = 0; ; pass++) {
+				int q0[4], q1[4], p0, p1;
+				quantizeBC7(a, q0, p0);
+				quantizeBC7(b, q1, p1);
+				int colors[16][4];
+				paletteBC7(q0, p0, q1, p1, colors);
+				Palette palette;
+				for (int k = 0; k < 16; k++) {
+					for (int c = 0; c < 4; c++) {
+						palette[k][c] = (float)colors[k][c];
+					}
+				}
+				uint8_t indices[16];
+				const float error = chooseIndices(block, palette, 16, indices);
+				if (error < bestError) {
+					bestError = error;
+					memcpy(best0, q0, sizeof(q0));
+					memcpy(best1, q1, sizeof(q1));
+					bestP0 = p0;
+					bestP1 = p1;
+					memcpy(bestIndices, indices, 16);
+				}
+				if (pass == numRefinements || error == 0.0f || !refit(block, indices, weights, a, b)) {
+					break;
+				}
+			}
+		}
+		//The first pixel's index is stored without its top bit, so it must be below 8
+		if (bestIndices[0] >= 8) {
+			std::swap(best0, best1);
+			std::swap(bestP0, bestP1);
+			for (int i = 0; i < 16; i++) {
+				bestIndices[i] = 15 - bestIndices[i];
+			}
+		}
+		memset(out, 0, 16);
+		BitWriter writer = { out };
+		writer.write(1 << 6, 7);
+		for (int c = 0; c < 4; c++) {
+			writer.write(best0[c], 7);
+			writer.write(best1[c], 7);
+		}
+		writer.write(bestP0, 1);
+		writer.write(bestP1, 1);
+		for (int i = 0; i < 16; i++) {
+			writer.write(bestIndices[i], i == 0 ? 3 : 4);
+		}
+	}
+	void decodeBC7(const uint8_t* in, uint8_t pixels[16][4]) {
+		BitReader reader = { in };
+		if (reader.read(7) != 1 << 6) {
+			memset(pixels, 0, 16 * 4);
+			return;
+		}
+		int q0[4], q1[4];
+		for (int c = 0; c < 4; c++) {
+			q0[c] = reader.read(7);
+			q1[c] = reader.read(7);
+		}
+		const int p0 = reader.read(1);
+		const int p1 = reader.read(1);
+		int palette[16][4];
+		paletteBC7(q0, p0, q1, p1, palette);
+		for (int i = 0; i < 16; i++) {
+			const int index = reader.read(i == 0 ? 3 : 4);
+			for (int c = 0; c < 4; c++) {
+				pixels[i][c] = (uint8_t)palette[index][c];
+			}
+		}
+	}
+
+	/// <summary>
+	/// Gathers a block, repeating the last row and column past the edges of the image
+	/// </summary>
+	/// <param name="sourceChannels">Pixel channel for each block channel, or -1 for a constant 255</param>
+	void loadBlock(const unsigned char* pixels, int width, int height, int channels, int blockX, int blockY, const int* sourceChannels, int numChannels, Block& block) {
+		block.numChannels = numChannels;
+		for (int i = 0; i < 16; i++) {
+			const int x = std::min(blockX * 4 + (i & 3), width - 1);
+			const int y = std::min(blockY * 4 + (i >> 2), height - 1);
+			const unsigned char* pixel = pixels + ((size_t)y * width + x) * channels;
+			for (int c = 0; c < numChannels; c++) {
+				block.values[c][i] = sourceChannels[c] < 0 ? 255.0f : (float)pixel[sourceChannels[c]];
+			}
+		}
+	}
+}
+
+namespace ew {
+	size_t getBlockSize(BlockFormat format) {
+		return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+	}
+	size_t getCompressedSize(BlockFormat format, int width, int height) {
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+	}
+	/// <summary>
+	/// Splits the image into bands of block rows, one per thread
+	/// </summary>
+	void compressImage(const unsigned char* pixels, int width, int height, int channels, BlockFormat format, unsigned char* blocks, const BlockCompressionOptions& options) {
+		const int blocksX = (width + 3) / 4;
+		const int blocksY = (height + 3) / 4;
+		const size_t blockSize = getBlockSize(format);
+		//Color formats repeat gray into green and blue and treat a missing alpha as opaque
+		int colorChannels[4];
+		for (int c = 0; c < 4; c++) {
+			colorChannels[c] = c < channels ? c : (c == 3 ? -1 : 0);
+		}
+		const int redChannel[1] = { 0 };
+		const int greenChannel[1] = { channels > 1 ? 1 : 0 };
+		auto encodeRows = [=](int rowBegin, int rowEnd) {
+			Block block;
+			for (int y = rowBegin; y < rowEnd; y++) {
+				unsigned char* out = blocks + (size_t)y * blocksX * blockSize;
+				for (int x = 0; x < blocksX; x++, out += blockSize) {
+					switch (format) {
+					case BlockFormat::BC1:
+						loadBlock(pixels, width, height, channels, x, y, colorChannels, 3, block);
+						encodeBC1(block, options.quality, out);
+						break;
+					case BlockFormat::BC4:
+						loadBlock(pixels, width, height, channels, x, y, redChannel, 1, block);
+						encodeBC4(block, options.quality, out);
+						break;
+					case BlockFormat::BC5:
+						loadBlock(pixels, width, height, channels, x, y, redChannel, 1, block);
+						encodeBC4(block, options.quality, out);
+						loadBlock(pixels, width, height, channels, x, y, greenChannel, 1, block);
+						encodeBC4(block, options.quality, out + 8);
+						break;
+					case BlockFormat::BC7:
+						loadBlock(pixels, width, height, channels, x, y, colorChannels, 4, block);
+						encodeBC7(block, options.quality, out);
+						break;
+					}
+				}
+			}
+		};
+		unsigned int numThreads = options.numThreads > 0 ? options.numThreads : std::max(1u, std::thread::hardware_concurrency());
+		numThreads = std::min(numThreads, (unsigned int)blocksY);
+		if (numThreads <= 1) {
+			encodeRows(0, blocksY);
+			return;
+		}
+		const int rowsPerThread = (blocksY + numThreads - 1) / numThreads;
+		std::vector<std::thread> threads;
+		for (int begin = rowsPerThread; begin < blocksY; begin += rowsPerThread) {
+			threads.emplace_back(encodeRows, begin, std::min(blocksY, begin + rowsPerThread));
+		}
+		encodeRows(0, std::min(blocksY, rowsPerThread));
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+	}
+	void decompressImage(const unsigned char* blocks, int width, int height, BlockFormat format, unsigned char* pixels, int channels) {
+		const int blocksX = (width + 3) / 4;
+		const int blocksY = (height + 3) / 4;
+		const size_t blockSize = getBlockSize(format);
+		for (int blockY = 0; blockY < blocksY; blockY++) {
+			for (int blockX = 0; blockX < blocksX; blockX++) {
+				const unsigned char* in = blocks + ((size_t)blockY * blocksX + blockX) * blockSize;
+				uint8_t decoded[16][4] = {};
+				switch (format) {
+				case BlockFormat::BC1:
+					decodeBC1(in, decoded);
+					break;
+				case BlockFormat::BC4:
+					decodeBC4(in, decoded, 0);
+					break;
+				case BlockFormat::BC5:
+					decodeBC4(in, decoded, 0);
+					decodeBC4(in + 8, decoded, 1);
+					break;
+				case BlockFormat::BC7:
+					decodeBC7(in, decoded);
+					break;
+				}
+				for (int i = 0; i < 16; i++) {
+					const int x = blockX * 4 + (i & 3);
+					const int y = blockY * 4 + (i >> 2);
+					if (x < width && y < height) {
+						memcpy(pixels + ((size_t)y * width + x) * channels, decoded[i], channels);
+					}
+				}
+			}
+		}
+	}
+	double computePSNR(const unsigned char* a, const unsigned char* b, int width, int height, int channels) {
+		const size_t count = (size_t)width * height * channels;
+		double sumSq = 0.0;
+		for (size_t i = 0; i < count; i++) {
+			const double d = (double)a[i] - b[i];
+			sumSq += d * d;
+		}
+		const double mse = sumSq / count;
+		return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : INFINITY;
+	}
+}
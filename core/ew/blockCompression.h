@@ -0,0 +1,47 @@
+/*
+	CPU encoders for the BCn block compressed formats. Each 4x4 block of pixels becomes 8 or 16 bytes:
+	BC1: RGB. Two 565 endpoints and 2 bit indices, 8 bytes. 6:1 against RGB8.
+	BC4: One channel. Two 8 bit endpoints and 3 bit indices, 8 bytes. Heightmaps, masks.
+	BC5: Two channels, as two BC4 blocks, 16 bytes. Normal map XY.
+	BC7: RGBA, 16 bytes. Only mode 6 is written: one pair of 7 bit + shared bit endpoints and 4 bit indices.
+	     3:1 against RGB8, 4:1 against RGBA8, with a good deal less error than BC1.
+	Blocks are encoded in parallel and pick palette indices 4 pixels at a time with SIMD.
+	Images whose size is not a multiple of 4 repeat their last row and column to fill the edge blocks.
+*/
+
+#pragma once
+#include <stddef.h>
+
+namespace ew {
+	enum class BlockFormat {
+		BC1,
+		BC4,
+		BC5,
+		BC7
+	};
+
+	//Trades encode time for error. Fast fits endpoints to the block's bounding box, Normal to its principal axis
+	//with one least squares refinement, Best refines further and tries BC4's second palette mode.
+	enum class CompressionQuality {
+		Fast,
+		Normal,
+		Best
+	};
+
+	struct BlockCompressionOptions {
+		CompressionQuality quality = CompressionQuality::Normal;
+		unsigned int numThreads = 0; //0 uses one per core
+	};
+
+	//Bytes per 4x4 block: 8 or 16
+	size_t getBlockSize(BlockFormat format);
+	size_t getCompressedSize(BlockFormat format, int width, int height);
+	//Encodes tightly packed 8 bit pixels with 1-4 channels. BC1 and BC7 read RGB(A), repeating gray and
+	//treating a missing alpha as opaque. BC4 reads the first channel, BC5 the first two.
+	//blocks must hold getCompressedSize bytes.
+	void compressImage(const unsigned char* pixels, int width, int height, int channels, BlockFormat format, unsigned char* blocks, const BlockCompressionOptions& options = {});
+	//Decodes blocks written by compressImage (BC7: mode 6 only) into pixels with the given channel count
+	void decompressImage(const unsigned char* blocks, int width, int height, BlockFormat format, unsigned char* pixels, int channels);
+	//Peak signal to noise ratio in dB over every channel of two 8 bit images. Infinite if they are identical.
+	double computePSNR(const unsigned char* a, const unsigned char* b, int width, int height, int channels);
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "ewMath/transformations.h"
 #include "ewMath/ewMath.h"
+#include "ewMath/frustum.h"
 namespace ew {
 
 	struct Camera {
@@ -11,6 +12,8 @@ namespace ew {
 		float nearPlane = 0.01f;
 		float farPlane = 100.0f;
 		bool orthographic = false;
+		//[0, 1] clip depth with near at 1. Perspective then has no far plane. Needs renderState::setReverseZ(true).
+		bool reverseZ = false;
 		float orthoHeight = 6.0f;
 		float aspectRatio = 1.77f;
 
@@ -20,12 +23,22 @@ namespace ew {
 		inline ew::Mat4 ProjectionMatrix()const {
 
 			if (orthographic) {
+				if (reverseZ) {
+					return ew::OrthographicReverseZ(orthoHeight, aspectRatio, nearPlane, farPlane);
+				}
 				return ew::Orthographic(orthoHeight, aspectRatio, nearPlane, farPlane);
 			}
 			else {
+				if (reverseZ) {
+					return ew::PerspectiveReverseZ(ew::Radians(fov), aspectRatio, nearPlane);
+				}
 				return ew::Perspective(ew::Radians(fov), aspectRatio, nearPlane, farPlane);
 			}
 		}
+		//World space planes of the view volume, for culling
+		inline ew::Frustum ViewFrustum()const {
+			return ew::ExtractFrustum(ProjectionMatrix() * ViewMatrix(), reverseZ);
+		}
 	};
 
 }
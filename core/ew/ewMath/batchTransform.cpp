@@ -0,0 +1,348 @@
+#include "batchTransform.h"
+#include "simd.h"
+#include <math.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace {
+	//A register of LANES floats with the handful of operations the kernels need
+#if defined(EW_SIMD_AVX)
+	typedef __m256 Lane;
+	const size_t LANES = 8;
+	inline Lane lSet(float f) { return _mm256_set1_ps(f); }
+	inline Lane lLoad(const float* p) { return _mm256_loadu_ps(p); }
+	inline void lStore(float* p, Lane v) { _mm256_storeu_ps(p, v); }
+	inline Lane lAdd(Lane a, Lane b) { return _mm256_add_ps(a, b); }
+	inline Lane lMul(Lane a, Lane b) { return _mm256_mul_ps(a, b); }
+	//1/sqrt(v), or 0 where v is 0
+	inline Lane lInvLength(Lane lengthSq) {
+		Lane inv = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(lengthSq));
+		return _mm256_and_ps(_mm256_cmp_ps(lengthSq, _mm256_setzero_ps(), _CMP_GT_OQ), inv);
+	}
+#elif defined(EW_SIMD_SSE)
+	typedef __m128 Lane;
+	const size_t LANES = 4;
+	inline Lane lSet(float f) { return _mm_set1_ps(f); }
+	inline Lane lLoad(const float* p) { return _mm_loadu_ps(p); }
+	inline void lStore(float* p, Lane v) { _mm_storeu_ps(p, v); }
+	inline Lane lAdd(Lane a, Lane b) { return _mm_add_ps(a, b); }
+	inline Lane lMul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+	inline Lane lInvLength(Lane lengthSq) {
+		Lane inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSq));
+		return _mm_and_ps(_mm_cmpgt_ps(lengthSq, _mm_setzero_ps()), inv);
+	}
+#elif defined(EW_SIMD_NEON)
+	typedef float32x4_t Lane;
+	const size_t LANES = 4;
+	inline Lane lSet(float f) { return vdupq_n_f32(f); }
+	inline Lane lLoad(const float* p) { return vld1q_f32(p); }
+	inline void lStore(float* p, Lane v) { vst1q_f32(p, v); }
+	inline Lane lAdd(Lane a, Lane b) { return vaddq_f32(a, b); }
+	inline Lane lMul(Lane a, Lane b) { return vmulq_f32(a, b); }
+	inline Lane lInvLength(Lane lengthSq) {
+		//32-bit NEON has no vector sqrt or divide
+		float v[4];
+		vst1q_f32(v, lengthSq);
+		for (int i = 0; i < 4; i++) {
+			v[i] = v[i] > 0.0f ? 1.0f / sqrtf(v[i]) : 0.0f;
+		}
+		return vld1q_f32(v);
+	}
+#else
+	typedef float Lane;
+	const size_t LANES = 1;
+	inline Lane lSet(float f) { return f; }
+	inline Lane lLoad(const float* p) { return *p; }
+	inline void lStore(float* p, Lane v) { *p = v; }
+	inline Lane lAdd(Lane a, Lane b) { return a + b; }
+	inline Lane lMul(Lane a, Lane b) { return a * b; }
+	inline Lane lInvLength(Lane lengthSq) { return lengthSq > 0.0f ? 1.0f / sqrtf(lengthSq) : 0.0f; }
+#endif
+
+	enum Kind {
+		POINTS,
+		DIRECTIONS,
+		NORMALS
+	};
+
+	//Below this many elements per thread, starting threads costs more than it saves
+	const size_t MIN_ELEMENTS_PER_THREAD = 1 << 16;
+	//Elements per job before moving to the next one. Small enough to stay in L1, and a multiple of LANES.
+	const size_t BLOCK_SIZE = 256;
+
+	//x, y and z float streams sharing one byte stride. With any stride but sizeof(float)
+	//the stream is a run of Vec3s, so y and z directly follow x.
+	struct Stream {
+		char* x;
+		char* y;
+		char* z;
+		size_t stride;
+	};
+
+	//Coefficients broadcast to every lane
+	struct Columns {
+		Lane c[4][3];
+	};
+
+	/// <summary>
+	/// Transforms LANES elements held in x/y/z. Products are added in the same order as Mat4 * Vec4,
+	/// so points and directions match it exactly.
+	/// </summary>
+	inline void transformLanes(const Columns& m, Kind kind, Lane x, Lane y, Lane z, Lane& ox, Lane& oy, Lane& oz) {
+		Lane r[3];
+		for (int row = 0; row < 3; row++) {
+			r[row] = lAdd(lAdd(lMul(m.c[0][row], x), lMul(m.c[1][row], y)), lMul(m.c[2][row], z));
+			if (kind == POINTS) {
+				r[row] = lAdd(r[row], m.c[3][row]);
+			}
+		}
+		if (kind == NORMALS) {
+			Lane invLength = lInvLength(lAdd(lAdd(lMul(r[0], r[0]), lMul(r[1], r[1])), lMul(r[2], r[2])));
+			for (int row = 0; row < 3; row++) {
+				r[row] = lMul(r[row], invLength);
+			}
+		}
+		ox = r[0];
+		oy = r[1];
+		oz = r[2];
+	}
+
+	/// <summary>
+	/// Interleaved Vec3s, one element at a time with the matrix columns in registers, like Mat4 * Vec4.
+	/// Going through lanes would need a gather and scatter per element, which costs more than it saves.
+	/// </summary>
+	template<Kind KIND>
+	void transformStridedRange(const float (&coefficients)[4][3], const Stream& in, const Stream& out, size_t begin, size_t end) {
+		const char* src = in.x + begin * in.stride;
+		char* dst = out.x + begin * out.stride;
+		const size_t inStride = in.stride;
+		const size_t outStride = out.stride;
+#if defined(EW_SIMD_SSE)
+		const __m128 c0 = _mm_setr_ps(coefficients[0][0], coefficients[0][1], coefficients[0][2], 0.0f);
+		const __m128 c1 = _mm_setr_ps(coefficients[1][0], coefficients[1][1], coefficients[1][2], 0.0f);
+		const __m128 c2 = _mm_setr_ps(coefficients[2][0], coefficients[2][1], coefficients[2][2], 0.0f);
+		const __m128 c3 = _mm_setr_ps(coefficients[3][0], coefficients[3][1], coefficients[3][2], 0.0f);
+		for (size_t i = begin; i < end; i++) {
+			const float* v = (const float*)src;
+			__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(v[0])), _mm_mul_ps(c1, _mm_set1_ps(v[1]))), _mm_mul_ps(c2, _mm_set1_ps(v[2])));
+			if (KIND == POINTS) {
+				r = _mm_add_ps(r, c3);
+			}
+			if (KIND == NORMALS) {
+				const __m128 sq = _mm_mul_ps(r, r);
+				const __m128 lengthSq = _mm_add_ss(_mm_add_ss(sq, _mm_shuffle_ps(sq, sq, 1)), _mm_shuffle_ps(sq, sq, 2));
+				const __m128 invLength = _mm_and_ps(_mm_cmpgt_ss(lengthSq, _mm_setzero_ps()), _mm_div_ss(_mm_set_ss(1.0f), _mm_sqrt_ss(lengthSq)));
+				r = _mm_mul_ps(r, _mm_shuffle_ps(invLength, invLength, 0));
+			}
+			float* o = (float*)dst;
+			_mm_storel_pi((__m64*)o, r);
+			_mm_store_ss(o + 2, _mm_movehl_ps(r, r));
+			src += inStride;
+			dst += outStride;
+		}
+#else
+		//Copied to locals, since the output stores could otherwise alias them and force reloads
+		const float m00 = coefficients[0][0], m01 = coefficients[0][1], m02 = coefficients[0][2];
+		const float m10 = coefficients[1][0], m11 = coefficients[1][1], m12 = coefficients[1][2];
+		const float m20 = coefficients[2][0], m21 = coefficients[2][1], m22 = coefficients[2][2];
+		const float m30 = coefficients[3][0], m31 = coefficients[3][1], m32 = coefficients[3][2];
+		for (size_t i = begin; i < end; i++) {
+			const float* v = (const float*)src;
+			float rx = m00 * v[0] + m10 * v[1] + m20 * v[2];
+			float ry = m01 * v[0] + m11 * v[1] + m21 * v[2];
+			float rz = m02 * v[0] + m12 * v[1] + m22 * v[2];
+			if (KIND == POINTS) {
+				rx += m30;
+				ry += m31;
+				rz += m32;
+			}
+			if (KIND == NORMALS) {
+				const float lengthSq = rx * rx + ry * ry + rz * rz;
+				const float invLength = lengthSq > 0.0f ? 1.0f / sqrtf(lengthSq) : 0.0f;
+				rx *= invLength;
+				ry *= invLength;
+				rz *= invLength;
+			}
+			float* o = (float*)dst;
+			o[0] = rx;
+			o[1] = ry;
+			o[2] = rz;
+			src += inStride;
+			dst += outStride;
+		}
+#endif
+	}
+
+	void transformPackedRange(const Columns& m, Kind kind, const Stream& in, const Stream& out, size_t begin, size_t end) {
+		const float* inX = (const float*)in.x;
+		const float* inY = (const float*)in.y;
+		const float* inZ = (const float*)in.z;
+		float* outX = (float*)out.x;
+		float* outY = (float*)out.y;
+		float* outZ = (float*)out.z;
+		size_t i = begin;
+		Lane ox, oy, oz;
+		for (; i + LANES <= end; i += LANES) {
+			transformLanes(m, kind, lLoad(inX + i), lLoad(inY + i), lLoad(inZ + i), ox, oy, oz);
+			lStore(outX + i, ox);
+			lStore(outY + i, oy);
+			lStore(outZ + i, oz);
+		}
+		//Pad the last partial block
+		const size_t remaining = end - i;
+		if (remaining > 0) {
+			alignas(32) float values[3][LANES] = {};
+			for (size_t j = 0; j < remaining; j++) {
+				values[0][j] = inX[i + j];
+				values[1][j] = inY[i + j];
+				values[2][j] = inZ[i + j];
+			}
+			transformLanes(m, kind, lLoad(values[0]), lLoad(values[1]), lLoad(values[2]), ox, oy, oz);
+			lStore(values[0], ox);
+			lStore(values[1], oy);
+			lStore(values[2], oz);
+			for (size_t j = 0; j < remaining; j++) {
+				outX[i + j] = values[0][j];
+				outY[i + j] = values[1][j];
+				outZ[i + j] = values[2][j];
+			}
+		}
+	}
+
+	//The upper 3 rows of each matrix column, as used by the kernel for this kind of transform
+	struct Coefficients {
+		float m[4][3];
+	};
+
+	Coefficients makeCoefficients(const ew::Mat4& m, Kind kind) {
+		Coefficients coefficients;
+		for (int col = 0; col < 4; col++) {
+			for (int row = 0; row < 3; row++) {
+				coefficients.m[col][row] = m[col][row];
+			}
+		}
+		if (kind == NORMALS) {
+			//Inverse-transpose up to scale. The scale is removed by renormalizing, but the determinant's sign has to be kept.
+			ew::Vec3 cofactors[3];
+			ew::Cofactors3x3(m, cofactors[0], cofactors[1], cofactors[2]);
+			float sign = ew::Dot(m[0].toVec3(), cofactors[0]) < 0.0f ? -1.0f : 1.0f;
+			for (int col = 0; col < 3; col++) {
+				coefficients.m[col][0] = cofactors[col].x * sign;
+				coefficients.m[col][1] = cofactors[col].y * sign;
+				coefficients.m[col][2] = cofactors[col].z * sign;
+			}
+		}
+		return coefficients;
+	}
+
+	void transformRange(const Coefficients& coefficients, Kind kind, const Stream& in, const Stream& out, size_t begin, size_t end) {
+		if (in.stride == sizeof(float) && out.stride == sizeof(float)) {
+			Columns columns;
+			for (int col = 0; col < 4; col++) {
+				for (int row = 0; row < 3; row++) {
+					columns.c[col][row] = lSet(coefficients.m[col][row]);
+				}
+			}
+			transformPackedRange(columns, kind, in, out, begin, end);
+		}
+		else {
+			switch (kind) {
+			case POINTS:
+				transformStridedRange<POINTS>(coefficients.m, in, out, begin, end);
+				break;
+			case DIRECTIONS:
+				transformStridedRange<DIRECTIONS>(coefficients.m, in, out, begin, end);
+				break;
+			case NORMALS:
+				transformStridedRange<NORMALS>(coefficients.m, in, out, begin, end);
+				break;
+			}
+		}
+	}
+
+	struct Job {
+		Kind kind;
+		Coefficients coefficients;
+		Stream in;
+		Stream out;
+	};
+
+	//Jobs over the same elements are interleaved in blocks, so data shared by one vertex is read from memory once
+	void runJobs(const Job* jobs, int numJobs, size_t begin, size_t end) {
+		for (size_t block = begin; block < end; block += BLOCK_SIZE) {
+			const size_t blockEnd = std::min(end, block + BLOCK_SIZE);
+			for (int i = 0; i < numJobs; i++) {
+				transformRange(jobs[i].coefficients, jobs[i].kind, jobs[i].in, jobs[i].out, block, blockEnd);
+			}
+		}
+	}
+
+	void transform(const Job* jobs, int numJobs, size_t count) {
+		size_t numThreads = std::min((size_t)std::max(1u, std::thread::hardware_concurrency()), count / MIN_ELEMENTS_PER_THREAD);
+		if (numThreads <= 1) {
+			runJobs(jobs, numJobs, 0, count);
+			return;
+		}
+		//Chunks are whole multiples of LANES so only the last one has a partial block
+		size_t chunk = (count + numThreads - 1) / numThreads;
+		chunk = (chunk + LANES - 1) / LANES * LANES;
+		std::vector<std::thread> threads;
+		for (size_t begin = chunk; begin < count; begin += chunk) {
+			threads.emplace_back(runJobs, jobs, numJobs, begin, std::min(count, begin + chunk));
+		}
+		runJobs(jobs, numJobs, 0, std::min(count, chunk));
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+	}
+
+	void transform(const ew::Mat4& m, Kind kind, const Stream& in, const Stream& out, size_t count) {
+		const Job job = { kind, makeCoefficients(m, kind), in, out };
+		transform(&job, 1, count);
+	}
+
+	Stream vec3Stream(const ew::Vec3* v, size_t stride) {
+		char* p = (char*)v;
+		return { p, p + sizeof(float), p + 2 * sizeof(float), stride };
+	}
+
+	Stream soaStream(const float* x, const float* y, const float* z) {
+		return { (char*)x, (char*)y, (char*)z, sizeof(float) };
+	}
+}
+
+namespace ew {
+	void TransformPoints(const Mat4& m, const Vec3* in, Vec3* out, size_t count, size_t stride)
+	{
+		transform(m, POINTS, vec3Stream(in, stride), vec3Stream(out, stride), count);
+	}
+	void TransformDirections(const Mat4& m, const Vec3* in, Vec3* out, size_t count, size_t stride)
+	{
+		transform(m, DIRECTIONS, vec3Stream(in, stride), vec3Stream(out, stride), count);
+	}
+	void TransformNormals(const Mat4& m, const Vec3* in, Vec3* out, size_t count, size_t stride)
+	{
+		transform(m, NORMALS, vec3Stream(in, stride), vec3Stream(out, stride), count);
+	}
+	void TransformPointsAndNormals(const Mat4& m, const Vec3* points, const Vec3* normals, Vec3* outPoints, Vec3* outNormals, size_t count, size_t stride)
+	{
+		const Job jobs[2] = {
+			{ POINTS, makeCoefficients(m, POINTS), vec3Stream(points, stride), vec3Stream(outPoints, stride) },
+			{ NORMALS, makeCoefficients(m, NORMALS), vec3Stream(normals, stride), vec3Stream(outNormals, stride) }
+		};
+		transform(jobs, 2, count);
+	}
+	void TransformPointsSoA(const Mat4& m, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, size_t count)
+	{
+		transform(m, POINTS, soaStream(x, y, z), soaStream(outX, outY, outZ), count);
+	}
+	void TransformDirectionsSoA(const Mat4& m, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, size_t count)
+	{
+		transform(m, DIRECTIONS, soaStream(x, y, z), soaStream(outX, outY, outZ), count);
+	}
+	void TransformNormalsSoA(const Mat4& m, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, size_t count)
+	{
+		transform(m, NORMALS, soaStream(x, y, z), soaStream(outX, outY, outZ), count);
+	}
+}
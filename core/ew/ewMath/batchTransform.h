@@ -0,0 +1,27 @@
+/*
+	Transforms arrays of points, directions and normals by a Mat4.
+	Matrices are treated as affine: w is taken as 1 (points) or 0 (directions, normals) and never divided.
+	Arrays can be tightly packed Vec3s, a Vec3 member of a larger struct (pass the struct size as the stride),
+	or separate x/y/z arrays (the SoA versions). Input and output may be the same array.
+	Large inputs are split across threads.
+*/
+
+#pragma once
+#include <stddef.h>
+#include "mat4.h"
+#include "vec3.h"
+
+namespace ew {
+	//Stride is the distance in bytes between consecutive elements, the same for in and out
+	void TransformPoints(const Mat4& m, const Vec3* in, Vec3* out, size_t count, size_t stride = sizeof(Vec3));
+	//Ignores translation
+	void TransformDirections(const Mat4& m, const Vec3* in, Vec3* out, size_t count, size_t stride = sizeof(Vec3));
+	//Uses the inverse-transpose of the upper 3x3 and renormalizes, so non-uniform scale is handled
+	void TransformNormals(const Mat4& m, const Vec3* in, Vec3* out, size_t count, size_t stride = sizeof(Vec3));
+	//Both at once, for vertex structs holding a position and a normal. Reads each vertex from memory once.
+	void TransformPointsAndNormals(const Mat4& m, const Vec3* points, const Vec3* normals, Vec3* outPoints, Vec3* outNormals, size_t count, size_t stride = sizeof(Vec3));
+
+	void TransformPointsSoA(const Mat4& m, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, size_t count);
+	void TransformDirectionsSoA(const Mat4& m, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, size_t count);
+	void TransformNormalsSoA(const Mat4& m, const float* x, const float* y, const float* z, float* outX, float* outY, float* outZ, size_t count);
+}
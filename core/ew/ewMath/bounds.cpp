@@ -0,0 +1,110 @@
+#include "bounds.h"
+#include "simd.h"
+#include <math.h>
+
+namespace {
+	inline const ew::Vec3& pointAt(const ew::Vec3* points, size_t i, size_t stride) {
+		return *(const ew::Vec3*)((const char*)points + i * stride);
+	}
+#if defined(EW_SIMD_SSE)
+	//x, y, z and 0 in lane 3. Loading the last point whole could read past the end of a packed array.
+	inline __m128 loadLast(const ew::Vec3* points, size_t count, size_t stride) {
+		const ew::Vec3& p = pointAt(points, count - 1, stride);
+		return _mm_setr_ps(p.x, p.y, p.z, 0.0f);
+	}
+	//Squared distance in lane 0. Lane 3 of p is whatever follows the position and is ignored.
+	inline __m128 distanceSq(__m128 p, __m128 c) {
+		const __m128 d = _mm_sub_ps(p, c);
+		const __m128 sq = _mm_mul_ps(d, d);
+		return _mm_add_ss(_mm_add_ss(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 2, 2, 2)));
+	}
+#elif defined(EW_SIMD_NEON)
+	inline float32x4_t loadLast(const ew::Vec3* points, size_t count, size_t stride) {
+		const ew::Vec3& p = pointAt(points, count - 1, stride);
+		const float v[4] = { p.x, p.y, p.z, 0.0f };
+		return vld1q_f32(v);
+	}
+	inline float distanceSq(float32x4_t p, float32x4_t c) {
+		const float32x4_t d = vsubq_f32(p, c);
+		const float32x4_t sq = vmulq_f32(d, d);
+		return (vgetq_lane_f32(sq, 0) + vgetq_lane_f32(sq, 1)) + vgetq_lane_f32(sq, 2);
+	}
+#endif
+}
+
+namespace ew {
+	/// <summary>
+	/// Two passes over the points: one for the box, then one for the farthest point from its center.
+	/// With SIMD each point is a single vector load, and stride lets this read positions straight out of vertex arrays.
+	/// </summary>
+	void ComputeBounds(const Vec3* points, size_t count, AABB& box, BoundingSphere& sphere, size_t stride) {
+		box = EmptyAABB();
+		sphere = BoundingSphere();
+		if (count == 0)
+			return;
+#if defined(EW_SIMD_SSE)
+		//Every point but the last is loaded whole. Two max registers halve the dependency chain in the second pass.
+		const __m128 last = loadLast(points, count, stride);
+		__m128 lo = last, hi = last;
+		for (size_t i = 0; i + 1 < count; i++) {
+			const __m128 p = _mm_loadu_ps(&pointAt(points, i, stride).x);
+			lo = _mm_min_ps(lo, p);
+			hi = _mm_max_ps(hi, p);
+		}
+		float loOut[4], hiOut[4];
+		_mm_storeu_ps(loOut, lo);
+		_mm_storeu_ps(hiOut, hi);
+		box = AABB{ Vec3(loOut[0], loOut[1], loOut[2]), Vec3(hiOut[0], hiOut[1], hiOut[2]) };
+		const Vec3 center = box.center();
+		const __m128 c = _mm_setr_ps(center.x, center.y, center.z, 0.0f);
+		__m128 maxSq = distanceSq(last, c), maxSq2 = _mm_setzero_ps();
+		size_t i = 0;
+		for (; i + 2 < count; i += 2) {
+			maxSq = _mm_max_ss(maxSq, distanceSq(_mm_loadu_ps(&pointAt(points, i, stride).x), c));
+			maxSq2 = _mm_max_ss(maxSq2, distanceSq(_mm_loadu_ps(&pointAt(points, i + 1, stride).x), c));
+		}
+		if (i + 1 < count) {
+			maxSq = _mm_max_ss(maxSq, distanceSq(_mm_loadu_ps(&pointAt(points, i, stride).x), c));
+		}
+		sphere.center = center;
+		sphere.radius = sqrtf(_mm_cvtss_f32(_mm_max_ss(maxSq, maxSq2)));
+#elif defined(EW_SIMD_NEON)
+		const float32x4_t last = loadLast(points, count, stride);
+		float32x4_t lo = last, hi = last;
+		for (size_t i = 0; i + 1 < count; i++) {
+			const float32x4_t p = vld1q_f32(&pointAt(points, i, stride).x);
+			lo = vminq_f32(lo, p);
+			hi = vmaxq_f32(hi, p);
+		}
+		box = AABB{ Vec3(vgetq_lane_f32(lo, 0), vgetq_lane_f32(lo, 1), vgetq_lane_f32(lo, 2)),
+			Vec3(vgetq_lane_f32(hi, 0), vgetq_lane_f32(hi, 1), vgetq_lane_f32(hi, 2)) };
+		const Vec3 center = box.center();
+		const float cv[4] = { center.x, center.y, center.z, 0.0f };
+		const float32x4_t c = vld1q_f32(cv);
+		float maxSq = distanceSq(last, c);
+		for (size_t i = 0; i + 1 < count; i++) {
+			maxSq = fmaxf(maxSq, distanceSq(vld1q_f32(&pointAt(points, i, stride).x), c));
+		}
+		sphere.center = center;
+		sphere.radius = sqrtf(maxSq);
+#else
+		Vec3 lo = pointAt(points, 0, stride);
+		Vec3 hi = lo;
+		for (size_t i = 1; i < count; i++) {
+			const Vec3& p = pointAt(points, i, stride);
+			lo = Vec3(fminf(lo.x, p.x), fminf(lo.y, p.y), fminf(lo.z, p.z));
+			hi = Vec3(fmaxf(hi.x, p.x), fmaxf(hi.y, p.y), fmaxf(hi.z, p.z));
+		}
+		box = AABB{ lo, hi };
+		const Vec3 center = box.center();
+		float maxSq = 0.0f;
+		for (size_t i = 0; i < count; i++) {
+			const Vec3& p = pointAt(points, i, stride);
+			const float dx = p.x - center.x, dy = p.y - center.y, dz = p.z - center.z;
+			maxSq = fmaxf(maxSq, (dx * dx + dy * dy) + dz * dz);
+		}
+		sphere.center = center;
+		sphere.radius = sqrtf(maxSq);
+#endif
+	}
+}
@@ -0,0 +1,75 @@
+/*
+	Bounding volumes used for visibility tests
+*/
+
+#pragma once
+#include <stddef.h>
+#include <math.h>
+#include <limits>
+#include "vec3.h"
+#include "mat4.h"
+
+namespace ew {
+	//Axis aligned box
+	struct AABB {
+		Vec3 min;
+		Vec3 max;
+		constexpr Vec3 center()const { return (min + max) * 0.5f; }
+		constexpr Vec3 extents()const { return (max - min) * 0.5f; }
+		//True for EmptyAABB(), which contains nothing
+		constexpr bool isEmpty()const { return min.x > max.x; }
+	};
+
+	//Packs into 4 floats, so arrays of spheres can be loaded one vector per sphere
+	struct BoundingSphere {
+		Vec3 center;
+		float radius = 0.0f;
+	};
+
+	//min above max, so growing it by any point gives a box around just that point
+	constexpr AABB EmptyAABB() {
+		return AABB{ Vec3(std::numeric_limits<float>::infinity()), Vec3(-std::numeric_limits<float>::infinity()) };
+	}
+
+	//Smallest sphere centered on the box that contains it
+	inline BoundingSphere SphereAroundAABB(const AABB& box) {
+		BoundingSphere sphere;
+		sphere.center = box.center();
+		sphere.radius = Magnitude(box.extents());
+		return sphere;
+	}
+
+	//Box around box transformed by an affine m. Uses the absolute 3x3 to project the extents,
+	//so it costs about one Mat4 * Vec4 instead of transforming 8 corners.
+	inline AABB TransformAABB(const Mat4& m, const AABB& box) {
+		const Vec3 c = box.center();
+		const Vec3 e = box.extents();
+		float center[3], extents[3];
+		for (int row = 0; row < 3; row++) {
+			center[row] = m[0][row] * c.x + m[1][row] * c.y + m[2][row] * c.z + m[3][row];
+			extents[row] = fabsf(m[0][row]) * e.x + fabsf(m[1][row]) * e.y + fabsf(m[2][row]) * e.z;
+		}
+		return AABB{
+			Vec3(center[0] - extents[0], center[1] - extents[1], center[2] - extents[2]),
+			Vec3(center[0] + extents[0], center[1] + extents[1], center[2] + extents[2])
+		};
+	}
+
+	//Sphere around sphere transformed by an affine m. The radius is scaled by the largest axis scale.
+	inline BoundingSphere TransformSphere(const Mat4& m, const BoundingSphere& sphere) {
+		const Vec3 c = sphere.center;
+		float center[3], scaleSq = 0.0f;
+		for (int i = 0; i < 3; i++) {
+			center[i] = m[0][i] * c.x + m[1][i] * c.y + m[2][i] * c.z + m[3][i];
+			scaleSq = fmaxf(scaleSq, m[i][0] * m[i][0] + m[i][1] * m[i][1] + m[i][2] * m[i][2]);
+		}
+		BoundingSphere result;
+		result.center = Vec3(center[0], center[1], center[2]);
+		result.radius = sphere.radius * sqrtf(scaleSq);
+		return result;
+	}
+
+	//Box and sphere around points spaced stride bytes apart. The sphere is centered on the box, which is
+	//quick and tight for most meshes, though not the minimal sphere. Empty box and zero sphere for no points.
+	void ComputeBounds(const Vec3* points, size_t count, AABB& box, BoundingSphere& sphere, size_t stride = sizeof(Vec3));
+}
@@ -9,31 +9,75 @@
 #include "vec2.h"
 #include "vec3.h"
 #include "mat4.h"
+#include "quat.h"
+#include "trig.h"
 
 namespace ew {
 	constexpr float PI = 3.14159265359f;
 	constexpr float TAU = 6.283185307179586f;
 	constexpr float DEG2RAD = (PI / 180.0f);
 	constexpr float RAD2DEG = (180.0f / PI);
-	inline float Radians(float degrees) {
+	constexpr float Radians(float degrees) {
 		return degrees * DEG2RAD;
 	}
-	inline float Degrees(float radians) {
+	constexpr float Degrees(float radians) {
 		return radians * RAD2DEG;
 	}
 	inline float RandomRange(float min, float max) {
 		float t = (float)rand() / RAND_MAX;
 		return min + (max - min) * t;
 	}
-	inline float Clamp(float x, float min, float max) {
-		return std::fminf(std::fmaxf(x, min), max);
+	//Written without fminf/fmaxf so it works at compile time. NaN clamps to min, as before.
+	constexpr float Clamp(float x, float min, float max) {
+		return !(x >= min) ? min : (x > max ? max : x);
 	}
 	/// <summary>
 	/// Returns the sign of x
 	/// </summary>
 	/// <param name="x"></param>
 	/// <returns>1 when x>=0, -1 if x<0</returns>
-	inline float Sign(float x) {
+	constexpr float Sign(float x) {
 		return x >= 0 ? 1 : -1;
 	}
+
+	//Compile time versions of sqrtf, sinf and cosf, for baking tables and meshes into constexpr data.
+	//Accurate to float precision for reasonable inputs, but far slower than the runtime functions.
+	constexpr float ConstSqrt(float x) {
+		if (!(x > 0.0f))
+			return x == 0.0f ? 0.0f : NAN;
+		double r = x >= 1.0f ? (double)x : 1.0;
+		for (int i = 0; i < 256; i++) {
+			double next = 0.5 * (r + x / r);
+			if (next >= r)
+				break;
+			r = next;
+		}
+		return (float)r;
+	}
+	namespace detail {
+		//sin(x + phase), with the phase added in double precision
+		constexpr float constSin(double x, double phase) {
+			//Reduce to [-pi, pi], then Taylor series
+			constexpr double TAU_D = 6.28318530717958647692;
+			x += phase;
+			double turns = x / TAU_D;
+			x -= (double)(long long)(turns + (turns >= 0 ? 0.5 : -0.5)) * TAU_D;
+			double term = x, sum = x;
+			for (int n = 1; n < 12; n++) {
+				term *= -x * x / ((2 * n) * (2 * n + 1));
+				sum += term;
+			}
+			return (float)sum;
+		}
+	}
+	constexpr float ConstSin(float radians) {
+		return detail::constSin(radians, 0.0);
+	}
+	constexpr float ConstCos(float radians) {
+		return detail::constSin(radians, 1.57079632679489661923);
+	}
+
+	static_assert(ConstSqrt(16.0f) == 4.0f && ConstSqrt(0.25f) == 0.5f, "ConstSqrt");
+	static_assert(ConstSin(0.0f) == 0.0f && ConstCos(0.0f) == 1.0f, "ConstSin/ConstCos");
+	static_assert(Clamp(2.0f, 0.0f, 1.0f) == 1.0f && Clamp(-1.0f, 0.0f, 1.0f) == 0.0f, "Clamp");
 }
@@ -0,0 +1,220 @@
+#include "frustum.h"
+#include "simd.h"
+#include <math.h>
+
+namespace {
+	//A register of LANES floats, and comparison masks over them
+#if defined(EW_SIMD_AVX)
+	typedef __m256 Lane;
+	const size_t LANES = 8;
+	inline Lane lSet(float f) { return _mm256_set1_ps(f); }
+	inline Lane lLoad(const float* p) { return _mm256_loadu_ps(p); }
+	inline Lane lAdd(Lane a, Lane b) { return _mm256_add_ps(a, b); }
+	inline Lane lMul(Lane a, Lane b) { return _mm256_mul_ps(a, b); }
+	inline Lane lAllOnes() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+	//Mask of lanes where a + b >= 0
+	inline Lane lSumNotNegative(Lane a, Lane b) { return _mm256_cmp_ps(_mm256_add_ps(a, b), _mm256_setzero_ps(), _CMP_GE_OQ); }
+	inline Lane lAnd(Lane a, Lane b) { return _mm256_and_ps(a, b); }
+	//One bit per lane, lane 0 lowest
+	inline uint32_t lBits(Lane mask) { return (uint32_t)_mm256_movemask_ps(mask); }
+#elif defined(EW_SIMD_SSE)
+	typedef __m128 Lane;
+	const size_t LANES = 4;
+	inline Lane lSet(float f) { return _mm_set1_ps(f); }
+	inline Lane lLoad(const float* p) { return _mm_loadu_ps(p); }
+	inline Lane lAdd(Lane a, Lane b) { return _mm_add_ps(a, b); }
+	inline Lane lMul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+	inline Lane lAllOnes() { return _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps()); }
+	inline Lane lSumNotNegative(Lane a, Lane b) { return _mm_cmpge_ps(_mm_add_ps(a, b), _mm_setzero_ps()); }
+	inline Lane lAnd(Lane a, Lane b) { return _mm_and_ps(a, b); }
+	inline uint32_t lBits(Lane mask) { return (uint32_t)_mm_movemask_ps(mask); }
+#elif defined(EW_SIMD_NEON)
+	typedef float32x4_t Lane;
+	const size_t LANES = 4;
+	inline Lane lSet(float f) { return vdupq_n_f32(f); }
+	inline Lane lLoad(const float* p) { return vld1q_f32(p); }
+	inline Lane lAdd(Lane a, Lane b) { return vaddq_f32(a, b); }
+	inline Lane lMul(Lane a, Lane b) { return vmulq_f32(a, b); }
+	inline Lane lAllOnes() { return vreinterpretq_f32_u32(vdupq_n_u32(0xFFFFFFFFu)); }
+	inline Lane lSumNotNegative(Lane a, Lane b) { return vreinterpretq_f32_u32(vcgeq_f32(vaddq_f32(a, b), vdupq_n_f32(0.0f))); }
+	inline Lane lAnd(Lane a, Lane b) { return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+	inline uint32_t lBits(Lane mask) {
+		const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+		uint32x4_t bits = vandq_u32(vreinterpretq_u32_f32(mask), vld1q_u32(laneBits));
+		uint32x2_t sum = vorr_u32(vget_low_u32(bits), vget_high_u32(bits));
+		return vget_lane_u32(sum, 0) | vget_lane_u32(sum, 1);
+	}
+#else
+	typedef float Lane;
+	const size_t LANES = 1;
+	inline Lane lSet(float f) { return f; }
+	inline Lane lLoad(const float* p) { return *p; }
+	inline Lane lAdd(Lane a, Lane b) { return a + b; }
+	inline Lane lMul(Lane a, Lane b) { return a * b; }
+	//The scalar "mask" is 1 or 0
+	inline Lane lAllOnes() { return 1.0f; }
+	inline Lane lSumNotNegative(Lane a, Lane b) { return a + b >= 0.0f ? 1.0f : 0.0f; }
+	inline Lane lAnd(Lane a, Lane b) { return a * b; }
+	inline uint32_t lBits(Lane mask) { return mask != 0.0f ? 1u : 0u; }
+#endif
+
+	//AoS inputs are transposed this many at a time, on the stack. A multiple of 32 so blocks start on a new bitmask word.
+	const size_t BLOCK_SIZE = 256;
+
+	//Plane coefficients broadcast once per call, plus their absolute values for box extents
+	struct PlaneLanes {
+		Lane a[6], b[6], c[6], d[6];
+		Lane absA[6], absB[6], absC[6];
+		PlaneLanes(const ew::Frustum& frustum) {
+			for (int i = 0; i < 6; i++) {
+				const ew::Vec4& p = frustum.planes[i];
+				a[i] = lSet(p.x);
+				b[i] = lSet(p.y);
+				c[i] = lSet(p.z);
+				d[i] = lSet(p.w);
+				absA[i] = lSet(fabsf(p.x));
+				absB[i] = lSet(fabsf(p.y));
+				absC[i] = lSet(fabsf(p.z));
+			}
+		}
+	};
+
+	//Summed in the same order as the SIMD kernels, so the tail and single tests agree with them exactly
+	inline float planeDistance(const ew::Vec4& p, float x, float y, float z) {
+		return (p.x * x + p.y * y) + (p.z * z + p.w);
+	}
+
+	//A volume is visible when, for every plane, its signed distance plus its reach toward the plane is >= 0.
+	//For a sphere the reach is the radius. For a box it is the extents projected onto the plane normal.
+	template<bool BOX>
+	void cullSoA(const ew::Frustum& frustum, const float* x, const float* y, const float* z,
+		const float* ex, const float* ey, const float* ez, size_t count, uint32_t* visibleBits) {
+		const PlaneLanes planes(frustum);
+		size_t i = 0;
+		for (; i + 32 <= count; i += 32) {
+			uint32_t word = 0;
+			for (size_t lane = 0; lane < 32; lane += LANES) {
+				const size_t j = i + lane;
+				const Lane px = lLoad(x + j), py = lLoad(y + j), pz = lLoad(z + j);
+				const Lane rx = lLoad(ex + j);
+				Lane ry = rx, rz = rx;
+				if (BOX) {
+					ry = lLoad(ey + j);
+					rz = lLoad(ez + j);
+				}
+				Lane visible = lAllOnes();
+				for (int p = 0; p < 6; p++) {
+					const Lane distance = lAdd(lAdd(lMul(planes.a[p], px), lMul(planes.b[p], py)), lAdd(lMul(planes.c[p], pz), planes.d[p]));
+					const Lane reach = BOX ? lAdd(lAdd(lMul(planes.absA[p], rx), lMul(planes.absB[p], ry)), lMul(planes.absC[p], rz)) : rx;
+					visible = lAnd(visible, lSumNotNegative(distance, reach));
+				}
+				word |= lBits(visible) << lane;
+			}
+			visibleBits[i / 32] = word;
+		}
+		//Partial last word
+		if (i < count) {
+			uint32_t word = 0;
+			for (size_t j = i; j < count; j++) {
+				bool visible = true;
+				for (int p = 0; p < 6 && visible; p++) {
+					const ew::Vec4& plane = frustum.planes[p];
+					const float reach = BOX ? fabsf(plane.x) * ex[j] + fabsf(plane.y) * ey[j] + fabsf(plane.z) * ez[j] : ex[j];
+					visible = planeDistance(plane, x[j], y[j], z[j]) + reach >= 0.0f;
+				}
+				word |= (uint32_t)visible << (j - i);
+			}
+			visibleBits[i / 32] = word;
+		}
+	}
+}
+
+namespace ew {
+	/// <summary>
+	/// Gribb/Hartmann extraction: each plane is the last row of the matrix plus or minus one of the others.
+	/// With [0, 1] depth the depth 0 plane is the z row alone.
+	/// </summary>
+	Frustum ExtractFrustum(const Mat4& m, bool zeroToOneDepth) {
+		//Rows of the matrix. Mat4 is indexed [column][row].
+		Vec4 rows[4];
+		for (int r = 0; r < 4; r++) {
+			rows[r] = Vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+		}
+		Frustum frustum;
+		for (int i = 0; i < 6; i++) {
+			//Vec4's arithmetic operators leave w alone, so this is written out per component
+			const Vec4& row = rows[i / 2];
+			const float sign = (i % 2) == 0 ? 1.0f : -1.0f;
+			const float w = zeroToOneDepth && i == 4 ? 0.0f : 1.0f;
+			const float a = w * rows[3].x + sign * row.x;
+			const float b = w * rows[3].y + sign * row.y;
+			const float c = w * rows[3].z + sign * row.z;
+			const float d = w * rows[3].w + sign * row.w;
+			const float length = sqrtf(a * a + b * b + c * c);
+			//An infinite far plane comes out with no normal. Nothing can be behind it.
+			if (length > 0.0f && length > 1e-6f * fabsf(d)) {
+				const float inv = 1.0f / length;
+				frustum.planes[i] = Vec4(a * inv, b * inv, c * inv, d * inv);
+			}
+			else {
+				frustum.planes[i] = Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			}
+		}
+		return frustum;
+	}
+	bool TestSphere(const Frustum& frustum, const Vec3& center, float radius) {
+		for (int i = 0; i < 6; i++) {
+			if (planeDistance(frustum.planes[i], center.x, center.y, center.z) + radius < 0.0f)
+				return false;
+		}
+		return true;
+	}
+	bool TestAABB(const Frustum& frustum, const AABB& box) {
+		const Vec3 c = box.center();
+		const Vec3 e = box.extents();
+		for (int i = 0; i < 6; i++) {
+			const Vec4& p = frustum.planes[i];
+			const float reach = fabsf(p.x) * e.x + fabsf(p.y) * e.y + fabsf(p.z) * e.z;
+			if (planeDistance(p, c.x, c.y, c.z) + reach < 0.0f)
+				return false;
+		}
+		return true;
+	}
+	void CullSpheresSoA(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, size_t count, uint32_t* visibleBits) {
+		cullSoA<false>(frustum, x, y, z, radius, nullptr, nullptr, count, visibleBits);
+	}
+	void CullAABBsSoA(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ,
+		const float* extentX, const float* extentY, const float* extentZ, size_t count, uint32_t* visibleBits) {
+		cullSoA<true>(frustum, centerX, centerY, centerZ, extentX, extentY, extentZ, count, visibleBits);
+	}
+	void CullSpheres(const Frustum& frustum, const BoundingSphere* spheres, size_t count, uint32_t* visibleBits) {
+		float x[BLOCK_SIZE], y[BLOCK_SIZE], z[BLOCK_SIZE], r[BLOCK_SIZE];
+		for (size_t start = 0; start < count; start += BLOCK_SIZE) {
+			const size_t n = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+			for (size_t i = 0; i < n; i++) {
+				const BoundingSphere& s = spheres[start + i];
+				x[i] = s.center.x;
+				y[i] = s.center.y;
+				z[i] = s.center.z;
+				r[i] = s.radius;
+			}
+			CullSpheresSoA(frustum, x, y, z, r, n, visibleBits + start / 32);
+		}
+	}
+	void CullAABBs(const Frustum& frustum, const AABB* boxes, size_t count, uint32_t* visibleBits) {
+		float cx[BLOCK_SIZE], cy[BLOCK_SIZE], cz[BLOCK_SIZE], ex[BLOCK_SIZE], ey[BLOCK_SIZE], ez[BLOCK_SIZE];
+		for (size_t start = 0; start < count; start += BLOCK_SIZE) {
+			const size_t n = count - start < BLOCK_SIZE ? count - start : BLOCK_SIZE;
+			for (size_t i = 0; i < n; i++) {
+				const AABB& b = boxes[start + i];
+				cx[i] = (b.min.x + b.max.x) * 0.5f;
+				cy[i] = (b.min.y + b.max.y) * 0.5f;
+				cz[i] = (b.min.z + b.max.z) * 0.5f;
+				ex[i] = (b.max.x - b.min.x) * 0.5f;
+				ey[i] = (b.max.y - b.min.y) * 0.5f;
+				ez[i] = (b.max.z - b.min.z) * 0.5f;
+			}
+			CullAABBsSoA(frustum, cx, cy, cz, ex, ey, ez, n, visibleBits + start / 32);
+		}
+	}
+}
@@ -0,0 +1,44 @@
+/*
+	View frustum planes and visibility tests against them.
+	The array tests take SoA inputs (one array per component) for the SIMD kernels, or arrays of
+	AABB/BoundingSphere which are transposed in small blocks first. Results are bitmasks:
+	bit i % 32 of word i / 32 is set when element i is at least partly inside.
+	Tests are conservative: a volume near a frustum corner can pass while being just outside.
+*/
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "mat4.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "bounds.h"
+
+namespace ew {
+	struct Frustum {
+		//Left, right, bottom, top, near, far. A point p is inside plane (a,b,c,d) when a*p.x + b*p.y + c*p.z + d >= 0.
+		//xyz is unit length, so the result is a distance.
+		Vec4 planes[6];
+	};
+
+	//Planes of the volume that viewProjection maps to clip space, in the space viewProjection maps from.
+	//Pass projection * view for world space planes. A plane at infinity becomes one every point is inside.
+	//zeroToOneDepth is for [0, 1] clip depth (reverse-Z). Its near and far slots then hold depth 0 and depth 1,
+	//which for reverse-Z are the far and near planes.
+	Frustum ExtractFrustum(const Mat4& viewProjection, bool zeroToOneDepth = false);
+
+	bool TestSphere(const Frustum& frustum, const Vec3& center, float radius);
+	bool TestAABB(const Frustum& frustum, const AABB& box);
+
+	//Words needed for count visibility bits
+	constexpr size_t NumVisibilityWords(size_t count) { return (count + 31) / 32; }
+	constexpr bool IsVisible(const uint32_t* visibleBits, size_t i) { return (visibleBits[i / 32] >> (i % 32)) & 1u; }
+
+	//visibleBits needs NumVisibilityWords(count) words. Every word is overwritten.
+	void CullSpheres(const Frustum& frustum, const BoundingSphere* spheres, size_t count, uint32_t* visibleBits);
+	void CullAABBs(const Frustum& frustum, const AABB* boxes, size_t count, uint32_t* visibleBits);
+	void CullSpheresSoA(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, size_t count, uint32_t* visibleBits);
+	//Boxes given as centers and half sizes
+	void CullAABBsSoA(const Frustum& frustum, const float* centerX, const float* centerY, const float* centerZ,
+		const float* extentX, const float* extentY, const float* extentZ, size_t count, uint32_t* visibleBits);
+}
@@ -4,44 +4,62 @@
 
 #pragma once
 #include "vec4.h"
+#include "simd.h"
 #include <cstddef>
 
 namespace ew {
-	struct Mat4 {
+	//Column-major, n[column][row]. Aligned so each column loads as one vector.
+	struct alignas(16) Mat4 {
 	private:
-		float n[4][4];
+		Vec4 n[4];
 	public:
 		Mat4() = default;
-		Mat4(float n00)
+		constexpr Mat4(float n00)
+			:n{ Vec4(n00), Vec4(n00), Vec4(n00), Vec4(n00) }
 		{
-			n[0][0] = n00; n[1][0] = n00; n[2][0] = n00; n[3][0] = n00;
-			n[0][1] = n00; n[1][1] = n00; n[2][1] = n00; n[3][1] = n00;
-			n[0][2] = n00; n[1][2] = n00; n[2][2] = n00; n[3][2] = n00;
-			n[0][3] = n00; n[1][3] = n00; n[2][3] = n00; n[3][3] = n00;
 		};
-		Mat4(float n00, float n10, float n20, float n30,
+		//Arguments are given row by row
+		constexpr Mat4(float n00, float n10, float n20, float n30,
 			 float n01, float n11, float n21, float n31,
 			 float n02, float n12, float n22, float n32,
 			 float n03, float n13, float n23, float n33)
+			:n{ Vec4(n00, n01, n02, n03), Vec4(n10, n11, n12, n13), Vec4(n20, n21, n22, n23), Vec4(n30, n31, n32, n33) }
 		{
-			n[0][0] = n00; n[1][0] = n10; n[2][0] = n20; n[3][0] = n30;
-			n[0][1] = n01; n[1][1] = n11; n[2][1] = n21; n[3][1] = n31;
-			n[0][2] = n02; n[1][2] = n12; n[2][2] = n22; n[3][2] = n32;
-			n[0][3] = n03; n[1][3] = n13; n[2][3] = n23; n[3][3] = n33;
 		};
-		Mat4(const Vec4& a, const Vec4& b, const Vec4& c, const Vec4& d) {
-			n[0][0] = a.x; n[0][1] = a.y; n[0][2] = a.z; n[0][3] = a.w;
-			n[1][0] = b.x; n[1][1] = b.y; n[1][2] = b.z; n[1][3] = b.w;
-			n[2][0] = c.x; n[2][1] = c.y; n[2][2] = c.z; n[2][3] = c.w;
-			n[3][0] = d.x; n[3][1] = d.y; n[3][2] = d.z; n[3][3] = d.w;
+		//Columns
+		constexpr Mat4(const Vec4& a, const Vec4& b, const Vec4& c, const Vec4& d)
+			:n{ a, b, c, d }
+		{
 		}
-		inline Vec4& operator[](int i) {
-			return (*reinterpret_cast<Vec4*>(n[i]));
+		constexpr Vec4& operator[](int i) {
+			return n[i];
 		}
-		inline const Vec4& operator[](int i) const{
-			return (*reinterpret_cast<const Vec4*>(n[i]));
+		constexpr const Vec4& operator[](int i) const{
+			return n[i];
 		}
-		inline friend Vec4 operator * (const Mat4& m, const Vec4& v) {
+		//Constant expressions take the scalar path, since intrinsics can not be evaluated at compile time
+		friend EW_SIMD_CONSTEXPR Vec4 operator * (const Mat4& m, const Vec4& v) {
+#if defined(EW_SIMD_SSE)
+			if (!EW_IS_CONSTANT_EVALUATED()) {
+				__m128 r = _mm_mul_ps(_mm_load_ps(&m.n[0].x), _mm_set1_ps(v.x));
+				r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(&m.n[1].x), _mm_set1_ps(v.y)));
+				r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(&m.n[2].x), _mm_set1_ps(v.z)));
+				r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(&m.n[3].x), _mm_set1_ps(v.w)));
+				Vec4 result;
+				_mm_store_ps(&result.x, r);
+				return result;
+			}
+#elif defined(EW_SIMD_NEON)
+			if (!EW_IS_CONSTANT_EVALUATED()) {
+				float32x4_t r = vmulq_n_f32(vld1q_f32(&m.n[0].x), v.x);
+				r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(&m.n[1].x), v.y));
+				r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(&m.n[2].x), v.z));
+				r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(&m.n[3].x), v.w));
+				Vec4 result;
+				vst1q_f32(&result.x, r);
+				return result;
+			}
+#endif
 			return Vec4(
 				m[0][0] * v.x + m[1][0] * v.y + m[2][0] * v.z + m[3][0] * v.w,
 				m[0][1] * v.x + m[1][1] * v.y + m[2][1] * v.z + m[3][1] * v.w,
@@ -49,8 +67,58 @@ namespace ew {
 				m[0][3] * v.x + m[1][3] * v.y + m[2][3] * v.z + m[3][3] * v.w
 			);
 		}
-		inline friend Mat4 operator * (const Mat4& l, const Mat4& r) {
+		//Each result column is the left matrix's columns weighted by one column of the right.
+		//Products are summed in the same order on every path, so results match the scalar code exactly.
+		friend EW_SIMD_CONSTEXPR Mat4 operator * (const Mat4& l, const Mat4& r) {
 			Mat4 m;
+#if defined(EW_SIMD_AVX)
+			if (!EW_IS_CONSTANT_EVALUATED()) {
+				//Two result columns per iteration. Each 128-bit lane holds one column of r.
+				const __m256 l0 = _mm256_broadcast_ps((const __m128*)&l.n[0].x);
+				const __m256 l1 = _mm256_broadcast_ps((const __m128*)&l.n[1].x);
+				const __m256 l2 = _mm256_broadcast_ps((const __m128*)&l.n[2].x);
+				const __m256 l3 = _mm256_broadcast_ps((const __m128*)&l.n[3].x);
+				for (int i = 0; i < 4; i += 2) {
+					__m256 c = _mm256_loadu_ps(&r.n[i].x);
+					__m256 o = _mm256_mul_ps(l0, _mm256_permute_ps(c, 0x00));
+					o = _mm256_add_ps(o, _mm256_mul_ps(l1, _mm256_permute_ps(c, 0x55)));
+					o = _mm256_add_ps(o, _mm256_mul_ps(l2, _mm256_permute_ps(c, 0xAA)));
+					o = _mm256_add_ps(o, _mm256_mul_ps(l3, _mm256_permute_ps(c, 0xFF)));
+					_mm256_storeu_ps(&m.n[i].x, o);
+				}
+				return m;
+			}
+#elif defined(EW_SIMD_SSE)
+			if (!EW_IS_CONSTANT_EVALUATED()) {
+				const __m128 l0 = _mm_load_ps(&l.n[0].x);
+				const __m128 l1 = _mm_load_ps(&l.n[1].x);
+				const __m128 l2 = _mm_load_ps(&l.n[2].x);
+				const __m128 l3 = _mm_load_ps(&l.n[3].x);
+				for (int i = 0; i < 4; i++) {
+					__m128 o = _mm_mul_ps(l0, _mm_set1_ps(r.n[i].x));
+					o = _mm_add_ps(o, _mm_mul_ps(l1, _mm_set1_ps(r.n[i].y)));
+					o = _mm_add_ps(o, _mm_mul_ps(l2, _mm_set1_ps(r.n[i].z)));
+					o = _mm_add_ps(o, _mm_mul_ps(l3, _mm_set1_ps(r.n[i].w)));
+					_mm_store_ps(&m.n[i].x, o);
+				}
+				return m;
+			}
+#elif defined(EW_SIMD_NEON)
+			if (!EW_IS_CONSTANT_EVALUATED()) {
+				const float32x4_t l0 = vld1q_f32(&l.n[0].x);
+				const float32x4_t l1 = vld1q_f32(&l.n[1].x);
+				const float32x4_t l2 = vld1q_f32(&l.n[2].x);
+				const float32x4_t l3 = vld1q_f32(&l.n[3].x);
+				for (int i = 0; i < 4; i++) {
+					float32x4_t o = vmulq_n_f32(l0, r.n[i].x);
+					o = vaddq_f32(o, vmulq_n_f32(l1, r.n[i].y));
+					o = vaddq_f32(o, vmulq_n_f32(l2, r.n[i].z));
+					o = vaddq_f32(o, vmulq_n_f32(l3, r.n[i].w));
+					vst1q_f32(&m.n[i].x, o);
+				}
+				return m;
+			}
+#endif
 			//Row 0
 			m[0][0] = l[0][0] * r[0][0] + l[1][0] * r[0][1] + l[2][0] * r[0][2] + l[3][0] * r[0][3];//dot(l_row_0,r_col_0)
 			m[1][0] = l[0][0] * r[1][0] + l[1][0] * r[1][1] + l[2][0] * r[1][2] + l[3][0] * r[1][3];//dot(l_row_0,r_col_1)
@@ -71,10 +139,10 @@ namespace ew {
 			m[1][3] = l[0][3] * r[1][0] + l[1][3] * r[1][1] + l[2][3] * r[1][2] + l[3][3] * r[1][3];//dot(l_row_3,r_col_1)
 			m[2][3] = l[0][3] * r[2][0] + l[1][3] * r[2][1] + l[2][3] * r[2][2] + l[3][3] * r[2][3];//dot(l_row_3,r_col_2)
 			m[3][3] = l[0][3] * r[3][0] + l[1][3] * r[3][1] + l[2][3] * r[3][2] + l[3][3] * r[3][3];//dot(l_row_3,r_col_3)
-			return m;		  
+			return m;
 		}
 	};
-	inline Mat4 IdentityMatrix() {
+	constexpr Mat4 IdentityMatrix() {
 		return Mat4(
 			1.0f, 0.0f, 0.0f, 0.0f,
 			0.0f, 1.0f, 0.0f, 0.0f,
@@ -82,4 +150,126 @@ namespace ew {
 			0.0f, 0.0f, 0.0f, 1.0f
 		);
 	}
+	constexpr Mat4 Transpose(const Mat4& m) {
+		//The 16 float constructor takes rows, so passing columns transposes
+		return Mat4(
+			m[0][0], m[0][1], m[0][2], m[0][3],
+			m[1][0], m[1][1], m[1][2], m[1][3],
+			m[2][0], m[2][1], m[2][2], m[2][3],
+			m[3][0], m[3][1], m[3][2], m[3][3]
+		);
+	}
+	//Same matrix with the translation removed and the bottom row reset, e.g. a view matrix for a skybox
+	constexpr Mat4 WithoutTranslation(const Mat4& m) {
+		return Mat4(
+			Vec4(m[0].toVec3(), 0.0f),
+			Vec4(m[1].toVec3(), 0.0f),
+			Vec4(m[2].toVec3(), 0.0f),
+			Vec4(0.0f, 0.0f, 0.0f, 1.0f)
+		);
+	}
+	//The 2x2 sub-determinants of the top and bottom halves are shared between Determinant and Inverse.
+	//Inverting the transpose gives the transposed inverse, so indexing as [column][row] works unchanged.
+	struct Mat4Minors {
+		float s[6];
+		float c[6];
+		constexpr Mat4Minors(const Mat4& m)
+			:s{}, c{}
+		{
+			s[0] = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+			s[1] = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+			s[2] = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+			s[3] = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+			s[4] = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+			s[5] = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+			c[5] = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+			c[4] = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+			c[3] = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+			c[2] = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+			c[1] = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+			c[0] = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+		}
+		constexpr float determinant()const {
+			return s[0] * c[5] - s[1] * c[4] + s[2] * c[3] + s[3] * c[2] - s[4] * c[1] + s[5] * c[0];
+		}
+	};
+	constexpr float Determinant(const Mat4& m) {
+		return Mat4Minors(m).determinant();
+	}
+	//General inverse. Returns a zero matrix if m is singular.
+	constexpr Mat4 Inverse(const Mat4& m) {
+		const Mat4Minors minors(m);
+		const float* s = minors.s;
+		const float* c = minors.c;
+		const float det = minors.determinant();
+		if (det == 0.0f) {
+			return Mat4(0.0f);
+		}
+		const float invDet = 1.0f / det;
+		Mat4 r;
+		r[0][0] = (m[1][1] * c[5] - m[1][2] * c[4] + m[1][3] * c[3]) * invDet;
+		r[0][1] = (-m[0][1] * c[5] + m[0][2] * c[4] - m[0][3] * c[3]) * invDet;
+		r[0][2] = (m[3][1] * s[5] - m[3][2] * s[4] + m[3][3] * s[3]) * invDet;
+		r[0][3] = (-m[2][1] * s[5] + m[2][2] * s[4] - m[2][3] * s[3]) * invDet;
+		r[1][0] = (-m[1][0] * c[5] + m[1][2] * c[2] - m[1][3] * c[1]) * invDet;
+		r[1][1] = (m[0][0] * c[5] - m[0][2] * c[2] + m[0][3] * c[1]) * invDet;
+		r[1][2] = (-m[3][0] * s[5] + m[3][2] * s[2] - m[3][3] * s[1]) * invDet;
+		r[1][3] = (m[2][0] * s[5] - m[2][2] * s[2] + m[2][3] * s[1]) * invDet;
+		r[2][0] = (m[1][0] * c[4] - m[1][1] * c[2] + m[1][3] * c[0]) * invDet;
+		r[2][1] = (-m[0][0] * c[4] + m[0][1] * c[2] - m[0][3] * c[0]) * invDet;
+		r[2][2] = (m[3][0] * s[4] - m[3][1] * s[2] + m[3][3] * s[0]) * invDet;
+		r[2][3] = (-m[2][0] * s[4] + m[2][1] * s[2] - m[2][3] * s[0]) * invDet;
+		r[3][0] = (-m[1][0] * c[3] + m[1][1] * c[1] - m[1][2] * c[0]) * invDet;
+		r[3][1] = (m[0][0] * c[3] - m[0][1] * c[1] + m[0][2] * c[0]) * invDet;
+		r[3][2] = (-m[3][0] * s[3] + m[3][1] * s[1] - m[3][2] * s[0]) * invDet;
+		r[3][3] = (m[2][0] * s[3] - m[2][1] * s[1] + m[2][2] * s[0]) * invDet;
+		return r;
+	}
+	//Columns of the upper 3x3 inverse-transpose, scaled by the determinant
+	constexpr void Cofactors3x3(const Mat4& m, Vec3& c0, Vec3& c1, Vec3& c2) {
+		const Vec3 a = m[0].toVec3();
+		const Vec3 b = m[1].toVec3();
+		const Vec3 c = m[2].toVec3();
+		c0 = Cross(b, c);
+		c1 = Cross(c, a);
+		c2 = Cross(a, b);
+	}
+	//Inverse of a matrix whose bottom row is (0,0,0,1), such as a model or view matrix.
+	//Cheaper than Inverse. Returns a zero matrix if the 3x3 part is singular.
+	constexpr Mat4 AffineInverse(const Mat4& m) {
+		Vec3 c0, c1, c2;
+		Cofactors3x3(m, c0, c1, c2);
+		const float det = Dot(m[0].toVec3(), c0);
+		if (det == 0.0f) {
+			return Mat4(0.0f);
+		}
+		//The inverse 3x3 is the cofactor matrix transposed, so the cofactors become rows
+		const Vec3 r0 = c0 / det;
+		const Vec3 r1 = c1 / det;
+		const Vec3 r2 = c2 / det;
+		const Vec3 t = m[3].toVec3();
+		return Mat4(
+			r0.x, r0.y, r0.z, -Dot(r0, t),
+			r1.x, r1.y, r1.z, -Dot(r1, t),
+			r2.x, r2.y, r2.z, -Dot(r2, t),
+			0.0f, 0.0f, 0.0f, 1.0f
+		);
+	}
+	//Inverse-transpose of the upper 3x3, for transforming normals. Translation is zero.
+	//Returns a zero matrix if the 3x3 part is singular.
+	constexpr Mat4 NormalMatrix(const Mat4& m) {
+		Vec3 c0, c1, c2;
+		Cofactors3x3(m, c0, c1, c2);
+		const float det = Dot(m[0].toVec3(), c0);
+		if (det == 0.0f) {
+			return Mat4(0.0f);
+		}
+		const float invDet = 1.0f / det;
+		return Mat4(
+			Vec4(c0 * invDet, 0.0f),
+			Vec4(c1 * invDet, 0.0f),
+			Vec4(c2 * invDet, 0.0f),
+			Vec4(0.0f, 0.0f, 0.0f, 1.0f)
+		);
+	}
 }
@@ -0,0 +1,160 @@
+/*
+	Unit quaternions for rotations. Matches the conventions of transformations.h:
+	FromEuler(r) rotates like RotateY(r.y) * RotateX(r.x) * RotateZ(r.z), and ToMat4 gives the same matrix.
+*/
+
+#pragma once
+#include <math.h>
+#include "vec3.h"
+#include "mat4.h"
+#include "simd.h"
+#include "trig.h"
+
+namespace ew {
+	struct alignas(16) Quat {
+		float x, y, z, w;
+
+		constexpr Quat() :x(0), y(0), z(0), w(1) {};
+		constexpr Quat(float x, float y, float z, float w) :x(x), y(y), z(z), w(w) {};
+
+		//Hamilton product: rotates by rhs, then by lhs
+		friend constexpr Quat operator*(const Quat& lhs, const Quat& rhs);
+		//Rotates a vector
+		friend constexpr Vec3 operator*(const Quat& q, const Vec3& v);
+	};
+
+	constexpr Quat operator*(const Quat& a, const Quat& b) {
+		return Quat(
+			a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+		);
+	}
+
+	constexpr Vec3 operator*(const Quat& q, const Vec3& v) {
+		//v + 2w(u x v) + 2u x (u x v), with u the vector part
+		const Vec3 u(q.x, q.y, q.z);
+		const Vec3 t = Cross(u, v) * 2.0f;
+		return v + t * q.w + Cross(u, t);
+	}
+
+	constexpr float Dot(const Quat& a, const Quat& b) {
+		return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	}
+
+	//Inverse of a unit quaternion
+	constexpr Quat Conjugate(const Quat& q) {
+		return Quat(-q.x, -q.y, -q.z, q.w);
+	}
+
+	inline Quat Normalize(const Quat& q) {
+		float mag = sqrtf(Dot(q, q));
+		if (mag == 0)
+			return Quat();
+		float inv = 1.0f / mag;
+		return Quat(q.x * inv, q.y * inv, q.z * inv, q.w * inv);
+	}
+
+	//Rotation around a unit length axis, in radians
+	inline Quat AngleAxis(float rad, const Vec3& axis) {
+		float s, c;
+		FastSinCos(rad * 0.5f, s, c);
+		return Quat(axis.x * s, axis.y * s, axis.z * s, c);
+	}
+
+	//Euler angles in radians, applied in the same order as Transform (Z, then X, then Y)
+	inline Quat FromEuler(const Vec3& rad) {
+		float cx, sx, cy, sy, cz, sz;
+		FastSinCos(rad.x * 0.5f, sx, cx);
+		FastSinCos(rad.y * 0.5f, sy, cy);
+		FastSinCos(rad.z * 0.5f, sz, cz);
+		//Expanded qY * qX * qZ
+		return Quat(
+			cy * sx * cz + sy * cx * sz,
+			sy * cx * cz - cy * sx * sz,
+			cy * cx * sz - sy * sx * cz,
+			cy * cx * cz + sy * sx * sz
+		);
+	}
+
+	constexpr Mat4 ToMat4(const Quat& q) {
+		const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+		const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+		const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+		return Mat4(
+			1.0f - 2.0f * (yy + zz), 2.0f * (xy - wz), 2.0f * (xz + wy), 0.0f,
+			2.0f * (xy + wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz - wx), 0.0f,
+			2.0f * (xz - wy), 2.0f * (yz + wx), 1.0f - 2.0f * (xx + yy), 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f
+		);
+	}
+
+	//Rotation of a matrix whose upper 3x3 is a pure rotation (no scale)
+	inline Quat FromMat4(const Mat4& m) {
+		//Pick the largest of w, x, y, z to divide by, for precision
+		const float trace = m[0][0] + m[1][1] + m[2][2];
+		if (trace > 0.0f) {
+			const float s = sqrtf(trace + 1.0f) * 2.0f;
+			return Quat((m[1][2] - m[2][1]) / s, (m[2][0] - m[0][2]) / s, (m[0][1] - m[1][0]) / s, 0.25f * s);
+		}
+		if (m[0][0] > m[1][1] && m[0][0] > m[2][2]) {
+			const float s = sqrtf(1.0f + m[0][0] - m[1][1] - m[2][2]) * 2.0f;
+			return Quat(0.25f * s, (m[1][0] + m[0][1]) / s, (m[2][0] + m[0][2]) / s, (m[1][2] - m[2][1]) / s);
+		}
+		if (m[1][1] > m[2][2]) {
+			const float s = sqrtf(1.0f + m[1][1] - m[0][0] - m[2][2]) * 2.0f;
+			return Quat((m[1][0] + m[0][1]) / s, 0.25f * s, (m[2][1] + m[1][2]) / s, (m[2][0] - m[0][2]) / s);
+		}
+		const float s = sqrtf(1.0f + m[2][2] - m[0][0] - m[1][1]) * 2.0f;
+		return Quat((m[2][0] + m[0][2]) / s, (m[2][1] + m[1][2]) / s, 0.25f * s, (m[0][1] - m[1][0]) / s);
+	}
+
+	//wa * a + wb * b, normalized. Identity if that is zero, as Normalize gives.
+	inline Quat BlendNormalized(const Quat& a, float wa, const Quat& b, float wb) {
+#if defined(EW_SIMD_SSE)
+		__m128 r = _mm_add_ps(_mm_mul_ps(_mm_load_ps(&a.x), _mm_set1_ps(wa)), _mm_mul_ps(_mm_load_ps(&b.x), _mm_set1_ps(wb)));
+		__m128 sq = _mm_mul_ps(r, r);
+		sq = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1)));
+		sq = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(1, 0, 3, 2)));
+		if (_mm_cvtss_f32(sq) == 0.0f)
+			return Quat();
+		Quat q;
+		_mm_store_ps(&q.x, _mm_div_ps(r, _mm_sqrt_ps(sq)));
+		return q;
+#elif defined(EW_SIMD_NEON)
+		float32x4_t r = vaddq_f32(vmulq_n_f32(vld1q_f32(&a.x), wa), vmulq_n_f32(vld1q_f32(&b.x), wb));
+		float32x4_t sq = vmulq_f32(r, r);
+		float32x2_t sum = vadd_f32(vget_low_f32(sq), vget_high_f32(sq));
+		sum = vpadd_f32(sum, sum);
+		const float sumSq = vget_lane_f32(sum, 0);
+		if (sumSq == 0.0f)
+			return Quat();
+		Quat q;
+		vst1q_f32(&q.x, vmulq_n_f32(r, 1.0f / sqrtf(sumSq)));
+		return q;
+#else
+		return Normalize(Quat(a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb));
+#endif
+	}
+
+	//Normalized linear interpolation along the shorter arc. Cheaper than Slerp, but speed varies over t.
+	inline Quat Nlerp(const Quat& a, const Quat& b, float t) {
+		const float wb = Dot(a, b) < 0.0f ? -t : t;
+		return BlendNormalized(a, 1.0f - t, b, wb);
+	}
+
+	//Spherical interpolation along the shorter arc, at constant angular speed
+	inline Quat Slerp(const Quat& a, const Quat& b, float t) {
+		float cosAngle = Dot(a, b);
+		const float sign = cosAngle < 0.0f ? -1.0f : 1.0f;
+		cosAngle *= sign;
+		//Nearly parallel: sin(angle) is too small to divide by, and Nlerp is just as good
+		if (cosAngle > 0.9995f) {
+			return BlendNormalized(a, 1.0f - t, b, t * sign);
+		}
+		const float angle = acosf(cosAngle);
+		const float invSin = 1.0f / sinf(angle);
+		return BlendNormalized(a, sinf((1.0f - t) * angle) * invSin, b, sinf(t * angle) * invSin * sign);
+	}
+}
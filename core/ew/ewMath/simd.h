@@ -0,0 +1,48 @@
+/*
+	Picks the vector instruction set used by Vec4 and Mat4 at compile time.
+	The widest available of EW_SIMD_AVX, EW_SIMD_SSE, EW_SIMD_NEON or EW_SIMD_SCALAR is defined, plus every narrower
+	one it implies: AVX builds define EW_SIMD_SSE too, so SSE paths also cover them. EW_SIMD_NAME names the widest.
+	AVX needs the compiler to target it (-mavx, /arch:AVX or the EW_ENABLE_AVX CMake option).
+	Define EW_NO_SIMD to force the scalar code.
+
+	Functions with a SIMD path are declared EW_SIMD_CONSTEXPR and check EW_IS_CONSTANT_EVALUATED()
+	to fall back to scalar code at compile time. Compilers without that builtin lose constexpr there,
+	and leave EW_SIMD_HAS_CONSTEXPR undefined. Where it is defined, a constant expression computes
+	exactly what an EW_NO_SIMD build would, which lets tests compare both paths in one binary.
+*/
+
+#pragma once
+
+#if defined(EW_NO_SIMD)
+#define EW_SIMD_SCALAR 1
+#define EW_SIMD_NAME "scalar"
+#elif defined(__AVX__)
+#define EW_SIMD_AVX 1
+#define EW_SIMD_SSE 1
+#define EW_SIMD_NAME "AVX"
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define EW_SIMD_SSE 1
+#define EW_SIMD_NAME "SSE"
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define EW_SIMD_NEON 1
+#define EW_SIMD_NAME "NEON"
+#include <arm_neon.h>
+#else
+#define EW_SIMD_SCALAR 1
+#define EW_SIMD_NAME "scalar"
+#endif
+
+#if defined(EW_SIMD_SCALAR)
+#define EW_SIMD_CONSTEXPR constexpr
+#define EW_IS_CONSTANT_EVALUATED() true
+#define EW_SIMD_HAS_CONSTEXPR 1
+#elif defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+#define EW_SIMD_CONSTEXPR constexpr
+#define EW_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#define EW_SIMD_HAS_CONSTEXPR 1
+#else
+#define EW_SIMD_CONSTEXPR inline
+#define EW_IS_CONSTANT_EVALUATED() false
+#endif
@@ -5,10 +5,11 @@
 #pragma once
 #include "mat4.h"
 #include "vec3.h"
+#include "trig.h"
 
 namespace ew {
 	//Identity matrix
-	inline ew::Mat4 Identity() {
+	constexpr ew::Mat4 Identity() {
 		return ew::Mat4(
 			1, 0, 0, 0,
 			0, 1, 0, 0,
@@ -17,7 +18,7 @@ namespace ew {
 		);
 	};
 	//Scale on x,y,z axes
-	inline ew::Mat4 Scale(const ew::Vec3& s) {
+	constexpr ew::Mat4 Scale(const ew::Vec3& s) {
 		return ew::Mat4(
 			s.x, 0, 0, 0,
 			0, s.y, 0, 0,
@@ -27,8 +28,8 @@ namespace ew {
 	};
 	//Rotation around X axis (pitch) in radians
 	inline ew::Mat4 RotateX(float rad) {
-		const float cosA = cosf(rad);
-		const float sinA = sinf(rad);
+		float sinA, cosA;
+		FastSinCos(rad, sinA, cosA);
 		return Mat4(
 			1.0f, 0.0f, 0.0f, 0.0f,
 			0.0f, cosA, -sinA, 0.0f,
@@ -38,8 +39,8 @@ namespace ew {
 	};
 	//Rotation around Y axis (yaw) in radians
 	inline ew::Mat4 RotateY(float rad) {
-		const float cosA = cosf(rad);
-		const float sinA = sinf(rad);
+		float sinA, cosA;
+		FastSinCos(rad, sinA, cosA);
 		return Mat4(
 			cosA, 0.0f, sinA, 0.0f,
 			0.0f, 1.0f, 0.0f, 0.0f,
@@ -49,8 +50,8 @@ namespace ew {
 	};
 	//Rotation around Z axis (roll) in radians
 	inline ew::Mat4 RotateZ(float rad) {
-		const float cosA = cosf(rad);
-		const float sinA = sinf(rad);
+		float sinA, cosA;
+		FastSinCos(rad, sinA, cosA);
 		return Mat4(
 			cosA, -sinA, 0.0f, 0.0f,
 			sinA, cosA, 0.0f, 0.0f,
@@ -59,7 +60,7 @@ namespace ew {
 		);
 	};
 	//Translate x,y,z
-	inline ew::Mat4 Translate(const ew::Vec3& t) {
+	constexpr ew::Mat4 Translate(const ew::Vec3& t) {
 		return Mat4(
 			1.0f, 0.0f, 0.0f, t.x,
 			0.0f, 1.0f, 0.0f, t.y,
@@ -67,6 +68,30 @@ namespace ew {
 			0.0f, 0.0f, 0.0f, 1.0f
 		);
 	};
+	//Translate(t) * RotateY(r.y) * RotateX(r.x) * RotateZ(r.z) * Scale(s), built directly.
+	//Rotation angles in radians. One sin/cos per axis and no matrix products.
+	inline ew::Mat4 TRS(const ew::Vec3& t, const ew::Vec3& r, const ew::Vec3& s) {
+		float cosX, sinX, cosY, sinY, cosZ, sinZ;
+		FastSinCos(r.x, sinX, cosX);
+		FastSinCos(r.y, sinY, cosY);
+		FastSinCos(r.z, sinZ, cosZ);
+		//Rows of RotateY * RotateX * RotateZ
+		const float r00 = cosY * cosZ + sinY * sinX * sinZ;
+		const float r01 = sinY * sinX * cosZ - cosY * sinZ;
+		const float r02 = sinY * cosX;
+		const float r10 = cosX * sinZ;
+		const float r11 = cosX * cosZ;
+		const float r12 = -sinX;
+		const float r20 = cosY * sinX * sinZ - sinY * cosZ;
+		const float r21 = sinY * sinZ + cosY * sinX * cosZ;
+		const float r22 = cosY * cosX;
+		return Mat4(
+			r00 * s.x, r01 * s.y, r02 * s.z, t.x,
+			r10 * s.x, r11 * s.y, r12 * s.z, t.y,
+			r20 * s.x, r21 * s.y, r22 * s.z, t.z,
+			0.0f, 0.0f, 0.0f, 1.0f
+		);
+	}
 
 	inline ew::Mat4 LookAt(const ew::Vec3& eyePos, const ew::Vec3& targetPos, const ew::Vec3& up) {
 		ew::Vec3 f = ew::Normalize(eyePos - targetPos);
@@ -91,7 +116,20 @@ namespace ew {
 		return m;
 	}
 
-	inline ew::Mat4 Orthographic(float height, float a, float n, float f) {
+	//Reverse-Z with an infinite far plane, for [0, 1] clip depth (glClipControl GL_ZERO_TO_ONE).
+	//The near plane maps to depth 1 and infinity to 0. Paired with a float depth buffer the precision
+	//is nearly even across the whole range, so there is no far plane to pick.
+	inline ew::Mat4 PerspectiveReverseZ(float fov, float a, float n) {
+		float c = tanf(fov / 2.0f);
+		Mat4 m = Mat4(0);
+		m[0][0] = 1.0f / (c * a);
+		m[1][1] = 1.0f / c;
+		m[3][2] = n; //Depth is n / -z
+		m[2][3] = -1.0f;
+		return m;
+	}
+
+	constexpr ew::Mat4 Orthographic(float height, float a, float n, float f) {
 		//Symmetrical bounds based on aspect ratio
 		float t = height / 2;
 		float b = -t;
@@ -108,4 +146,19 @@ namespace ew {
 		m[3][3] = 1.0f;
 		return m;
 	}
+
+	//Orthographic for [0, 1] clip depth with near at depth 1 and far at 0, to match PerspectiveReverseZ
+	constexpr ew::Mat4 OrthographicReverseZ(float height, float a, float n, float f) {
+		Mat4 m = Orthographic(height, a, n, f);
+		m[2][2] = 1 / (f - n);
+		m[3][2] = f / (f - n);
+		return m;
+	}
+
+	//Compile time checks. These avoid Mat4 products, which are only constexpr on compilers with __builtin_is_constant_evaluated.
+	static_assert(Identity()[3][3] == 1.0f && Identity()[3][0] == 0.0f, "Identity");
+	static_assert(Translate(ew::Vec3(1, 2, 3))[3][1] == 2.0f, "Translation lives in column 3");
+	static_assert(Inverse(Translate(ew::Vec3(1, 2, 3)))[3][2] == -3.0f, "Inverse of a translation");
+	static_assert(AffineInverse(Scale(ew::Vec3(2, 4, 8)))[2][2] == 0.125f, "AffineInverse of a scale");
+	static_assert(-1.0f * OrthographicReverseZ(2, 1, 1, 3)[2][2] + OrthographicReverseZ(2, 1, 1, 3)[3][2] == 1.0f, "Reverse-Z ortho maps near to 1");
 }
@@ -0,0 +1,160 @@
+#include "trig.h"
+#include "simd.h"
+#if defined(EW_SIMD_SSE)
+#include <emmintrin.h>
+#endif
+
+namespace {
+	using ew::TrigPrecision;
+	using namespace ew::detail;
+
+#if defined(EW_SIMD_SSE)
+	//AVX builds use this too. AVX1 has no 256-bit integer operations for the quadrant logic.
+	inline __m128 sinPoly4(__m128 r, __m128 r2, TrigPrecision precision) {
+		__m128 p;
+		if (precision == TrigPrecision::Fast) {
+			p = _mm_add_ps(_mm_set1_ps(-0.166628338f), _mm_mul_ps(r2, _mm_set1_ps(0.00815299234f)));
+		}
+		else {
+			p = _mm_add_ps(_mm_set1_ps(8.3321608736e-3f), _mm_mul_ps(r2, _mm_set1_ps(-1.9515295891e-4f)));
+			p = _mm_add_ps(_mm_set1_ps(-1.6666654611e-1f), _mm_mul_ps(r2, p));
+		}
+		return _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), p));
+	}
+	inline __m128 cosPoly4(__m128 r2, TrigPrecision precision) {
+		if (precision == TrigPrecision::Fast) {
+			__m128 p = _mm_add_ps(_mm_set1_ps(-0.499776307f), _mm_mul_ps(r2, _mm_set1_ps(0.0404889358f)));
+			return _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, p));
+		}
+		__m128 p = _mm_add_ps(_mm_set1_ps(-1.388731625493765e-3f), _mm_mul_ps(r2, _mm_set1_ps(2.443315711809948e-5f)));
+		p = _mm_add_ps(_mm_set1_ps(4.166664568298827e-2f), _mm_mul_ps(r2, p));
+		return _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_mul_ps(_mm_mul_ps(r2, r2), p));
+	}
+	//Returns false if any lane is out of range, leaving those for the caller
+	inline bool sinCos4(const float* in, float* sines, float* cosines, TrigPrecision precision) {
+		const __m128 x = _mm_loadu_ps(in);
+		const __m128 absX = _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+		const bool inRange = _mm_movemask_ps(_mm_cmple_ps(absX, _mm_set1_ps(MAX_REDUCED_ANGLE))) == 0xF;
+		//Adds +-0.5 and truncates, so halves round away from zero as in FastSinCos instead of to even
+		const __m128 scaled = _mm_mul_ps(x, _mm_set1_ps(TWO_OVER_PI));
+		const __m128 half = _mm_or_ps(_mm_set1_ps(0.5f), _mm_and_ps(x, _mm_set1_ps(-0.0f)));
+		const __m128i k = _mm_cvttps_epi32(_mm_add_ps(scaled, half));
+		const __m128 kf = _mm_cvtepi32_ps(k);
+		__m128 r = _mm_sub_ps(x, _mm_mul_ps(kf, _mm_set1_ps(HALF_PI_1)));
+		r = _mm_sub_ps(r, _mm_mul_ps(kf, _mm_set1_ps(HALF_PI_2)));
+		r = _mm_sub_ps(r, _mm_mul_ps(kf, _mm_set1_ps(HALF_PI_3)));
+		const __m128 r2 = _mm_mul_ps(r, r);
+		const __m128 sr = sinPoly4(r, r2, precision);
+		const __m128 cr = cosPoly4(r2, precision);
+		//Odd quadrants swap sin and cos. Bit 1 of k, and of k + 1, give the signs.
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(k, one), one));
+		const __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(k, _mm_set1_epi32(2)), 30));
+		const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(k, one), _mm_set1_epi32(2)), 30));
+		const __m128 s = _mm_or_ps(_mm_and_ps(swap, cr), _mm_andnot_ps(swap, sr));
+		const __m128 c = _mm_or_ps(_mm_and_ps(swap, sr), _mm_andnot_ps(swap, cr));
+		_mm_storeu_ps(sines, _mm_xor_ps(s, sinSign));
+		_mm_storeu_ps(cosines, _mm_xor_ps(c, cosSign));
+		return inRange;
+	}
+	const size_t LANES = 4;
+#elif defined(EW_SIMD_NEON)
+	inline float32x4_t sinPoly4(float32x4_t r, float32x4_t r2, TrigPrecision precision) {
+		float32x4_t p;
+		if (precision == TrigPrecision::Fast) {
+			p = vmlaq_n_f32(vdupq_n_f32(-0.166628338f), r2, 0.00815299234f);
+		}
+		else {
+			p = vmlaq_n_f32(vdupq_n_f32(8.3321608736e-3f), r2, -1.9515295891e-4f);
+			p = vmlaq_f32(vdupq_n_f32(-1.6666654611e-1f), r2, p);
+		}
+		return vmlaq_f32(r, vmulq_f32(r, r2), p);
+	}
+	inline float32x4_t cosPoly4(float32x4_t r2, TrigPrecision precision) {
+		if (precision == TrigPrecision::Fast) {
+			float32x4_t p = vmlaq_n_f32(vdupq_n_f32(-0.499776307f), r2, 0.0404889358f);
+			return vmlaq_f32(vdupq_n_f32(1.0f), r2, p);
+		}
+		float32x4_t p = vmlaq_n_f32(vdupq_n_f32(-1.388731625493765e-3f), r2, 2.443315711809948e-5f);
+		p = vmlaq_f32(vdupq_n_f32(4.166664568298827e-2f), r2, p);
+		return vmlaq_f32(vmlsq_n_f32(vdupq_n_f32(1.0f), r2, 0.5f), vmulq_f32(r2, r2), p);
+	}
+	inline bool sinCos4(const float* in, float* sines, float* cosines, TrigPrecision precision) {
+		const float32x4_t x = vld1q_f32(in);
+		const uint32x4_t inRangeLanes = vcleq_f32(vabsq_f32(x), vdupq_n_f32(MAX_REDUCED_ANGLE));
+		const uint32x2_t halves = vand_u32(vget_low_u32(inRangeLanes), vget_high_u32(inRangeLanes));
+		const bool inRange = (vget_lane_u32(halves, 0) & vget_lane_u32(halves, 1)) != 0;
+		//vcvtq truncates, so add +-0.5 first to round to nearest
+		const float32x4_t scaled = vmulq_n_f32(x, TWO_OVER_PI);
+		const uint32x4_t signBit = vdupq_n_u32(0x80000000u);
+		const float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(vdupq_n_f32(0.5f)), vandq_u32(vreinterpretq_u32_f32(scaled), signBit)));
+		const int32x4_t k = vcvtq_s32_f32(vaddq_f32(scaled, half));
+		const float32x4_t kf = vcvtq_f32_s32(k);
+		float32x4_t r = vmlsq_n_f32(x, kf, HALF_PI_1);
+		r = vmlsq_n_f32(r, kf, HALF_PI_2);
+		r = vmlsq_n_f32(r, kf, HALF_PI_3);
+		const float32x4_t r2 = vmulq_f32(r, r);
+		const float32x4_t sr = sinPoly4(r, r2, precision);
+		const float32x4_t cr = cosPoly4(r2, precision);
+		const int32x4_t one = vdupq_n_s32(1);
+		const uint32x4_t swap = vceqq_s32(vandq_s32(k, one), one);
+		const uint32x4_t sinSign = vshlq_n_u32(vreinterpretq_u32_s32(vandq_s32(k, vdupq_n_s32(2))), 30);
+		const uint32x4_t cosSign = vshlq_n_u32(vreinterpretq_u32_s32(vandq_s32(vaddq_s32(k, one), vdupq_n_s32(2))), 30);
+		const float32x4_t s = vbslq_f32(swap, cr, sr);
+		const float32x4_t c = vbslq_f32(swap, sr, cr);
+		vst1q_f32(sines, vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(s), sinSign)));
+		vst1q_f32(cosines, vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(c), cosSign)));
+		return inRange;
+	}
+	const size_t LANES = 4;
+#endif
+}
+
+namespace ew {
+	/// <summary>
+	/// Vector version of FastSinCos. Lanes that hit an out of range angle are redone with the scalar fallback.
+	/// </summary>
+	void SinCos(const float* radians, float* sines, float* cosines, size_t count, TrigPrecision precision) {
+		size_t i = 0;
+#if defined(EW_SIMD_SSE) || defined(EW_SIMD_NEON)
+		for (; i + LANES <= count; i += LANES) {
+			if (!sinCos4(radians + i, sines + i, cosines + i, precision)) {
+				for (size_t j = i; j < i + LANES; j++) {
+					FastSinCos(radians[j], sines[j], cosines[j], precision);
+				}
+			}
+		}
+#endif
+		for (; i < count; i++) {
+			FastSinCos(radians[i], sines[i], cosines[i], precision);
+		}
+	}
+	/// <summary>
+	/// Runs CHAINS interleaved recurrences, each rotating by CHAINS steps, so consecutive
+	/// rotations don't wait on each other's results
+	/// </summary>
+	void SinCosRecurrence(double start, double step, float* sines, float* cosines, size_t count) {
+		const size_t CHAINS = 4;
+		double c[CHAINS], s[CHAINS];
+		for (size_t j = 0; j < CHAINS; j++) {
+			c[j] = cos(start + j * step);
+			s[j] = sin(start + j * step);
+		}
+		const double stepCos = cos(step * CHAINS);
+		const double stepSin = sin(step * CHAINS);
+		size_t i = 0;
+		for (; i + CHAINS <= count; i += CHAINS) {
+			for (size_t j = 0; j < CHAINS; j++) {
+				cosines[i + j] = (float)c[j];
+				sines[i + j] = (float)s[j];
+				const double nextC = c[j] * stepCos - s[j] * stepSin;
+				s[j] = s[j] * stepCos + c[j] * stepSin;
+				c[j] = nextC;
+			}
+		}
+		for (size_t j = 0; i < count; i++, j++) {
+			cosines[i] = (float)c[j];
+			sines[i] = (float)s[j];
+		}
+	}
+}
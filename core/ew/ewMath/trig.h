@@ -0,0 +1,83 @@
+/*
+	Sine and cosine computed together, with a choice of precision.
+	One range reduction to [-pi/4, pi/4] is shared by both results, then each gets a short polynomial.
+	Inputs beyond +-MAX_REDUCED_ANGLE (or NaN/inf) fall back to sinf/cosf, since the reduction loses precision there.
+*/
+
+#pragma once
+#include <stddef.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace ew {
+	enum class TrigPrecision {
+		//Max error around 1.2e-5. For animation, noise and other purely visual uses.
+		Fast,
+		//Within a couple of float ulps of sinf/cosf
+		Accurate
+	};
+
+	namespace detail {
+		constexpr float TWO_OVER_PI = 0.636619772367581343f;
+		//pi/2 split in three so k * part is exact for the first two parts (Cody-Waite reduction)
+		constexpr float HALF_PI_1 = 1.5703125f;
+		constexpr float HALF_PI_2 = 4.83751296997070312e-4f;
+		constexpr float HALF_PI_3 = 7.54978995489188216e-8f;
+		constexpr float MAX_REDUCED_ANGLE = 8192.0f;
+
+		//Odd polynomial for sin and even polynomial for cos on [-pi/4, pi/4].
+		//Accurate uses the Cephes coefficients, Fast a minimax fit of lower degree.
+		inline float sinPoly(float r, float r2, TrigPrecision precision) {
+			if (precision == TrigPrecision::Fast)
+				return r + r * r2 * (-0.166628338f + r2 * 0.00815299234f);
+			return r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+		}
+		inline float cosPoly(float r2, TrigPrecision precision) {
+			if (precision == TrigPrecision::Fast)
+				return 1.0f + r2 * (-0.499776307f + r2 * 0.0404889358f);
+			return 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+		}
+	}
+
+	inline void FastSinCos(float radians, float& s, float& c, TrigPrecision precision = TrigPrecision::Accurate) {
+		if (!(fabsf(radians) <= detail::MAX_REDUCED_ANGLE)) {
+			s = sinf(radians);
+			c = cosf(radians);
+			return;
+		}
+		//Nearest multiple of pi/2, and the remainder
+		const int k = (int)(radians * detail::TWO_OVER_PI + copysignf(0.5f, radians));
+		const float kf = (float)k;
+		const float r = ((radians - kf * detail::HALF_PI_1) - kf * detail::HALF_PI_2) - kf * detail::HALF_PI_3;
+		const float r2 = r * r;
+		const float sr = detail::sinPoly(r, r2, precision);
+		const float cr = detail::cosPoly(r2, precision);
+		//Rotate the result by k quarter turns: odd k swaps sin and cos, bit 1 of k and k + 1 flips their signs.
+		//Done on the bits, since compilers turn float selects into branches and the quadrant is hard to predict.
+		uint32_t sBits, cBits;
+		memcpy(&sBits, &sr, 4);
+		memcpy(&cBits, &cr, 4);
+		const uint32_t swap = 0u - (uint32_t)(k & 1);
+		const uint32_t sinBits = ((cBits & swap) | (sBits & ~swap)) ^ ((uint32_t)(k & 2) << 30);
+		const uint32_t cosBits = ((sBits & swap) | (cBits & ~swap)) ^ ((uint32_t)((k + 1) & 2) << 30);
+		memcpy(&s, &sinBits, 4);
+		memcpy(&c, &cosBits, 4);
+	}
+	inline float FastSin(float radians, TrigPrecision precision = TrigPrecision::Accurate) {
+		float s, c;
+		FastSinCos(radians, s, c, precision);
+		return s;
+	}
+	inline float FastCos(float radians, TrigPrecision precision = TrigPrecision::Accurate) {
+		float s, c;
+		FastSinCos(radians, s, c, precision);
+		return c;
+	}
+
+	//Sine and cosine of count angles, 4 at a time with SSE or NEON. Bit identical to FastSinCos on SSE.
+	void SinCos(const float* radians, float* sines, float* cosines, size_t count, TrigPrecision precision = TrigPrecision::Accurate);
+	//sin and cos of start + i * step for i in [0, count), by rotating the previous point by step.
+	//Needs one sin/cos for the whole run. The rotation is done in double, so error stays at float rounding for any realistic count.
+	void SinCosRecurrence(double start, double step, float* sines, float* cosines, size_t count);
+}
@@ -0,0 +1,183 @@
+#include "fileWatcher.h"
+#include <memory>
+#include <set>
+#include <chrono>
+#include <stdio.h>
+#include "texture.h"
+#include "textureCache.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace ew {
+	FileWatcher::FileWatcher()
+	{
+#ifdef __linux__
+		m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_fd < 0) {
+			printf("Failed to create inotify instance, hot reload disabled\n");
+			return;
+		}
+		m_running = true;
+		m_thread = std::thread(&FileWatcher::run, this);
+#endif
+	}
+	FileWatcher::~FileWatcher()
+	{
+		m_running = false;
+		if (m_thread.joinable()) {
+			m_thread.join();
+		}
+#ifdef __linux__
+		if (m_fd >= 0) {
+			close(m_fd);
+		}
+#endif
+	}
+	/// <summary>
+	/// Registers a rebuild for a file. The file's directory is watched rather than the file itself,
+	/// since most editors save by writing a new file and renaming it over the old one.
+	/// </summary>
+	/// <param name="filePath">Path as passed to the loader</param>
+	/// <param name="rebuild">Called on the worker thread each time the file changes</param>
+	void FileWatcher::watch(const std::string& filePath, RebuildFn rebuild)
+	{
+#ifdef __linux__
+		if (m_fd < 0) {
+			return;
+		}
+		size_t slash = filePath.find_last_of('/');
+		std::string directory = slash == std::string::npos ? "." : filePath.substr(0, slash);
+		std::string fileName = slash == std::string::npos ? filePath : filePath.substr(slash + 1);
+
+		//Watching the same directory twice returns the same descriptor
+		int wd = inotify_add_watch(m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (wd < 0) {
+			printf("Failed to watch %s\n", filePath.c_str());
+			return;
+		}
+		std::lock_guard<std::mutex> lock(m_watchMutex);
+		m_watches[wd][fileName].push_back({ filePath, std::move(rebuild) });
+#endif
+	}
+	void FileWatcher::update()
+	{
+		std::vector<std::function<void()>> finished;
+		{
+			std::lock_guard<std::mutex> lock(m_finishedMutex);
+			finished.swap(m_finished);
+		}
+		for (auto& apply : finished) {
+			apply();
+		}
+	}
+	void FileWatcher::run()
+	{
+#ifdef __linux__
+		//Enough for several events with full length names
+		alignas(inotify_event) char buffer[4096];
+		while (m_running) {
+			pollfd pfd = { m_fd, POLLIN, 0 };
+			if (poll(&pfd, 1, 100) <= 0) {
+				continue;
+			}
+			//Saves usually arrive as a burst of events. Wait for the burst to settle, then
+			//rebuild each changed file once.
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			std::set<std::pair<int, std::string>> changedFiles;
+			ssize_t length;
+			while ((length = read(m_fd, buffer, sizeof(buffer))) > 0) {
+				for (char* p = buffer; p < buffer + length;) {
+					const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+					p += sizeof(inotify_event) + event->len;
+					if (event->len > 0) {
+						changedFiles.insert({ event->wd, event->name });
+					}
+				}
+			}
+			std::vector<Watch> changed;
+			{
+				std::lock_guard<std::mutex> lock(m_watchMutex);
+				for (const auto& changedFile : changedFiles) {
+					auto directory = m_watches.find(changedFile.first);
+					if (directory == m_watches.end()) {
+						continue;
+					}
+					auto file = directory->second.find(changedFile.second);
+					if (file != directory->second.end()) {
+						changed.insert(changed.end(), file->second.begin(), file->second.end());
+					}
+				}
+			}
+			for (const Watch& w : changed) {
+				printf("Reloading %s\n", w.filePath.c_str());
+				std::function<void()> apply = w.rebuild(w.filePath);
+				if (apply) {
+					std::lock_guard<std::mutex> lock(m_finishedMutex);
+					m_finished.push_back(std::move(apply));
+				}
+			}
+		}
+#endif
+	}
+
+	void watchShader(FileWatcher& watcher, Shader& shader)
+	{
+		Shader* target = &shader;
+		auto rebuild = [target](const std::string&) -> std::function<void()> {
+			std::string vertexSource = loadShaderSourceFromFile(target->getVertexPath());
+			std::string fragmentSource = loadShaderSourceFromFile(target->getFragmentPath());
+			return [target, vertexSource, fragmentSource]() {
+				target->reload(vertexSource, fragmentSource);
+			};
+		};
+		watcher.watch(shader.getVertexPath(), rebuild);
+		watcher.watch(shader.getFragmentPath(), rebuild);
+	}
+	void watchTexture(FileWatcher& watcher, unsigned int texture, const std::string& filePath)
+	{
+		watcher.watch(filePath, [texture](const std::string& path) -> std::function<void()> {
+			//The edit changed the source's timestamp, so this rebuilds the stale cache file
+			auto image = std::make_shared<TextureImage>();
+			if (!loadTextureImage(path.c_str(), *image)) {
+				printf("Failed to load image %s, keeping previous version\n", path.c_str());
+				return {};
+			}
+			return [texture, image]() {
+				uploadTextureImage(texture, *image);
+			};
+		});
+	}
+	void watchTextureLayer(FileWatcher& watcher, unsigned int texture, int layer, const std::string& filePath, TextureCompression compression)
+	{
+		compression = getSupportedCompression(compression);
+		watcher.watch(filePath, [texture, layer, compression](const std::string& path) -> std::function<void()> {
+			auto image = std::make_shared<TextureImage>();
+			if (!loadTextureImage(path.c_str(), *image, false, compression)) {
+				printf("Failed to load image %s, keeping previous version\n", path.c_str());
+				return {};
+			}
+			return [texture, layer, image, path]() {
+				if (!uploadTextureImageLayer(texture, layer, *image)) {
+					printf("%s no longer matches its texture array's size and format, keeping previous version\n", path.c_str());
+				}
+			};
+		});
+	}
+	void watchMesh(FileWatcher& watcher, Mesh& mesh, const std::string& filePath, std::function<MeshData(const char* filePath)> buildMesh)
+	{
+		Mesh* target = &mesh;
+		watcher.watch(filePath, [target, buildMesh](const std::string& path) -> std::function<void()> {
+			auto meshData = std::make_shared<MeshData>(buildMesh(path.c_str()));
+			if (meshData->vertices.empty()) {
+				return {};
+			}
+			return [target, meshData]() {
+				target->load(*meshData);
+			};
+		});
+	}
+}
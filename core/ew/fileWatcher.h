@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include "shader.h"
+#include "mesh.h"
+#include "textureCache.h"
+
+namespace ew {
+	//Watches asset files and rebuilds whatever was made from them when they change on disk.
+	//Uses inotify on Linux. On other platforms watch() is accepted but nothing is ever reloaded.
+	class FileWatcher {
+	public:
+		//Runs on the worker thread with the changed file's path. Does the CPU side of the rebuild
+		//(file reads, decoding, meshing) and returns a function that finishes it on the GL thread.
+		//Return an empty function to keep the current resource.
+		using RebuildFn = std::function<std::function<void()>(const std::string& filePath)>;
+
+		FileWatcher();
+		~FileWatcher();
+		FileWatcher(const FileWatcher&) = delete;
+		FileWatcher& operator=(const FileWatcher&) = delete;
+
+		void watch(const std::string& filePath, RebuildFn rebuild);
+		//Swaps in every finished rebuild. Call once per frame on the thread that owns the GL context.
+		void update();
+	private:
+		struct Watch {
+			std::string filePath;
+			RebuildFn rebuild;
+		};
+		void run();
+
+		int m_fd = -1; //inotify instance
+		std::atomic<bool> m_running{ false };
+		std::thread m_thread;
+		std::mutex m_watchMutex;
+		std::unordered_map<int, std::unordered_map<std::string, std::vector<Watch>>> m_watches; //Directory watch -> file name -> watches
+		std::mutex m_finishedMutex;
+		std::vector<std::function<void()>> m_finished;
+	};
+
+	//Recompiles the shader when either of its stages is saved. A failed compile keeps the old program.
+	void watchShader(FileWatcher& watcher, Shader& shader);
+	//Re-decodes the image, rebuilds its cache file and re-uploads every mip into the same texture handle
+	void watchTexture(FileWatcher& watcher, unsigned int texture, const std::string& filePath);
+	//The same for one layer of a texture array. Pass the compression the array was loaded with, since its storage
+	//can't change format.
+	void watchTextureLayer(FileWatcher& watcher, unsigned int texture, int layer, const std::string& filePath, TextureCompression compression = TextureCompression::None);
+	//Rebuilds mesh data with buildMesh (e.g. JSLib::createTerrain) and re-uploads it into the same mesh
+	void watchMesh(FileWatcher& watcher, Mesh& mesh, const std::string& filePath, std::function<MeshData(const char* filePath)> buildMesh);
+}
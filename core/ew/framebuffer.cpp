@@ -0,0 +1,57 @@
+#include "framebuffer.h"
+#include <stdio.h>
+#include "renderState.h"
+#include "external/glad.h"
+
+namespace ew {
+	/// <summary>
+	/// Creates a complete framebuffer. The default framebuffer is restored afterwards.
+	/// </summary>
+	/// <param name="width">Pixels</param>
+	/// <param name="height">Pixels</param>
+	/// <param name="floatDepth">32-bit float depth instead of 24-bit fixed point</param>
+	/// <returns>Framebuffer with fbo 0 if it was incomplete</returns>
+	Framebuffer createFramebuffer(int width, int height, bool floatDepth) {
+		Framebuffer framebuffer;
+		framebuffer.width = width;
+		framebuffer.height = height;
+
+		glGenFramebuffers(1, &framebuffer.fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.fbo);
+
+		glGenTextures(1, &framebuffer.colorTexture);
+		renderState::bindTexture(0, GL_TEXTURE_2D, framebuffer.colorTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, framebuffer.colorTexture, 0);
+		renderState::bindTexture(0, GL_TEXTURE_2D, 0);
+
+		glGenRenderbuffers(1, &framebuffer.depthBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, framebuffer.depthBuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, floatDepth ? GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT24, width, height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, framebuffer.depthBuffer);
+
+		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			printf("Framebuffer incomplete: 0x%x\n", status);
+			deleteFramebuffer(framebuffer);
+		}
+		return framebuffer;
+	}
+	void deleteFramebuffer(Framebuffer& framebuffer) {
+		glDeleteFramebuffers(1, &framebuffer.fbo);
+		renderState::deleteTexture(framebuffer.colorTexture);
+		glDeleteRenderbuffers(1, &framebuffer.depthBuffer);
+		framebuffer = Framebuffer();
+	}
+	std::vector<unsigned char> readFramebufferPixels(const Framebuffer& framebuffer) {
+		std::vector<unsigned char> pixels((size_t)framebuffer.width * framebuffer.height * 4);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer.fbo);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, framebuffer.width, framebuffer.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		return pixels;
+	}
+}
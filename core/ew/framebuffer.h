@@ -0,0 +1,18 @@
+#pragma once
+#include <vector>
+
+namespace ew {
+	//Offscreen render target with an RGBA8 color texture and a depth renderbuffer
+	struct Framebuffer {
+		unsigned int fbo = 0;
+		unsigned int colorTexture = 0;
+		unsigned int depthBuffer = 0;
+		int width = 0;
+		int height = 0;
+	};
+	//floatDepth uses a 32-bit float depth buffer, which reverse-Z needs for its precision
+	Framebuffer createFramebuffer(int width, int height, bool floatDepth = false);
+	void deleteFramebuffer(Framebuffer& framebuffer);
+	//Reads the color attachment as tightly packed RGBA8, bottom row first
+	std::vector<unsigned char> readFramebufferPixels(const Framebuffer& framebuffer);
+}
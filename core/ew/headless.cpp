@@ -0,0 +1,177 @@
+#include "headless.h"
+#include <stdio.h>
+#include <stdint.h>
+#include "external/glad.h"
+
+#ifdef __linux__
+#include <dlfcn.h>
+
+//The subset of EGL used here, declared locally so building does not need EGL headers
+typedef void* EGLDisplay;
+typedef void* EGLConfig;
+typedef void* EGLContext;
+typedef void* EGLSurface;
+typedef int32_t EGLint;
+typedef unsigned int EGLBoolean;
+typedef unsigned int EGLenum;
+
+#define EGL_NONE 0x3038
+#define EGL_RENDERABLE_TYPE 0x3040
+#define EGL_OPENGL_API 0x30A2
+#define EGL_OPENGL_BIT 0x0008
+#define EGL_CONTEXT_MAJOR_VERSION 0x3098
+#define EGL_CONTEXT_MINOR_VERSION 0x30FB
+#define EGL_CONTEXT_OPENGL_PROFILE_MASK 0x30FD
+#define EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT 0x00000001
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+
+typedef void* (*PFN_eglGetProcAddress)(const char* name);
+typedef EGLDisplay (*PFN_eglGetPlatformDisplayEXT)(EGLenum platform, void* nativeDisplay, const EGLint* attribs);
+typedef EGLDisplay (*PFN_eglGetDisplay)(void* nativeDisplay);
+typedef EGLBoolean (*PFN_eglInitialize)(EGLDisplay display, EGLint* major, EGLint* minor);
+typedef EGLBoolean (*PFN_eglTerminate)(EGLDisplay display);
+typedef EGLBoolean (*PFN_eglBindAPI)(EGLenum api);
+typedef EGLBoolean (*PFN_eglChooseConfig)(EGLDisplay display, const EGLint* attribs, EGLConfig* configs, EGLint configSize, EGLint* numConfigs);
+typedef EGLContext (*PFN_eglCreateContext)(EGLDisplay display, EGLConfig config, EGLContext shareContext, const EGLint* attribs);
+typedef EGLBoolean (*PFN_eglDestroyContext)(EGLDisplay display, EGLContext context);
+typedef EGLBoolean (*PFN_eglMakeCurrent)(EGLDisplay display, EGLSurface draw, EGLSurface read, EGLContext context);
+typedef EGLint (*PFN_eglGetError)();
+
+static PFN_eglGetProcAddress s_eglGetProcAddress = nullptr;
+
+static GLADapiproc loadGLFunction(const char* name) {
+	return (GLADapiproc)s_eglGetProcAddress(name);
+}
+#endif
+
+namespace ew {
+	HeadlessContext::~HeadlessContext()
+	{
+		destroy();
+	}
+	/// <summary>
+	/// Opens libEGL, creates a context on Mesa's surfaceless platform (falling back to the
+	/// default display) and makes it current with no surface. Render into an FBO afterwards,
+	/// since there is no default framebuffer.
+	/// </summary>
+	/// <param name="majorVersion">Requested GL version</param>
+	/// <param name="minorVersion"></param>
+	/// <returns>True if a context is current and GL functions are loaded</returns>
+	bool HeadlessContext::create(int majorVersion, int minorVersion)
+	{
+#ifdef __linux__
+		m_library = dlopen("libEGL.so.1", RTLD_NOW | RTLD_LOCAL);
+		if (m_library == nullptr) {
+			m_library = dlopen("libEGL.so", RTLD_NOW | RTLD_LOCAL);
+		}
+		if (m_library == nullptr) {
+			printf("Failed to open libEGL: %s\n", dlerror());
+			return false;
+		}
+		s_eglGetProcAddress = (PFN_eglGetProcAddress)dlsym(m_library, "eglGetProcAddress");
+		if (s_eglGetProcAddress == nullptr) {
+			printf("libEGL has no eglGetProcAddress\n");
+			destroy();
+			return false;
+		}
+		auto eglGetPlatformDisplayEXT = (PFN_eglGetPlatformDisplayEXT)s_eglGetProcAddress("eglGetPlatformDisplayEXT");
+		auto eglGetDisplay = (PFN_eglGetDisplay)s_eglGetProcAddress("eglGetDisplay");
+		auto eglInitialize = (PFN_eglInitialize)s_eglGetProcAddress("eglInitialize");
+		auto eglBindAPI = (PFN_eglBindAPI)s_eglGetProcAddress("eglBindAPI");
+		auto eglChooseConfig = (PFN_eglChooseConfig)s_eglGetProcAddress("eglChooseConfig");
+		auto eglCreateContext = (PFN_eglCreateContext)s_eglGetProcAddress("eglCreateContext");
+		auto eglMakeCurrent = (PFN_eglMakeCurrent)s_eglGetProcAddress("eglMakeCurrent");
+		auto eglGetError = (PFN_eglGetError)s_eglGetProcAddress("eglGetError");
+		if (!eglGetDisplay || !eglInitialize || !eglBindAPI || !eglChooseConfig || !eglCreateContext || !eglMakeCurrent || !eglGetError) {
+			printf("libEGL is missing core entry points\n");
+			destroy();
+			return false;
+		}
+
+		//Prefer the surfaceless platform, which needs no X/Wayland server or GPU device
+		EGLint major, minor;
+		if (eglGetPlatformDisplayEXT) {
+			m_display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, nullptr, nullptr);
+			if (m_display && !eglInitialize(m_display, &major, &minor)) {
+				m_display = nullptr;
+			}
+		}
+		if (m_display == nullptr) {
+			m_display = eglGetDisplay(nullptr);
+			if (m_display == nullptr || !eglInitialize(m_display, &major, &minor)) {
+				printf("Failed to initialize an EGL display (0x%x)\n", eglGetError());
+				m_display = nullptr;
+				destroy();
+				return false;
+			}
+		}
+		if (!eglBindAPI(EGL_OPENGL_API)) {
+			printf("EGL display does not support desktop OpenGL\n");
+			destroy();
+			return false;
+		}
+
+		//A config is only needed if the display has one. With no surface, EGL_NO_CONFIG is allowed.
+		const EGLint configAttribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+		EGLConfig config = nullptr;
+		EGLint numConfigs = 0;
+		eglChooseConfig(m_display, configAttribs, &config, 1, &numConfigs);
+		if (numConfigs == 0) {
+			config = nullptr;
+		}
+
+		const EGLint contextAttribs[] = {
+			EGL_CONTEXT_MAJOR_VERSION, majorVersion,
+			EGL_CONTEXT_MINOR_VERSION, minorVersion,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		m_context = eglCreateContext(m_display, config, nullptr, contextAttribs);
+		if (m_context == nullptr) {
+			printf("Failed to create a GL %d.%d context (0x%x)\n", majorVersion, minorVersion, eglGetError());
+			destroy();
+			return false;
+		}
+		if (!eglMakeCurrent(m_display, nullptr, nullptr, m_context)) {
+			printf("Failed to make the headless context current (0x%x)\n", eglGetError());
+			destroy();
+			return false;
+		}
+		if (!gladLoadGL(loadGLFunction)) {
+			printf("GLAD Failed to load GL headers");
+			destroy();
+			return false;
+		}
+		printf("Headless GL %s (%s)\n", (const char*)glGetString(GL_VERSION), (const char*)glGetString(GL_RENDERER));
+		return true;
+#else
+		printf("Headless contexts are only supported on Linux\n");
+		return false;
+#endif
+	}
+	void HeadlessContext::destroy()
+	{
+#ifdef __linux__
+		if (m_library == nullptr) {
+			return;
+		}
+		if (s_eglGetProcAddress) {
+			auto eglMakeCurrent = (PFN_eglMakeCurrent)s_eglGetProcAddress("eglMakeCurrent");
+			auto eglDestroyContext = (PFN_eglDestroyContext)s_eglGetProcAddress("eglDestroyContext");
+			auto eglTerminate = (PFN_eglTerminate)s_eglGetProcAddress("eglTerminate");
+			if (m_context) {
+				eglMakeCurrent(m_display, nullptr, nullptr, nullptr);
+				eglDestroyContext(m_display, m_context);
+			}
+			if (m_display) {
+				eglTerminate(m_display);
+			}
+		}
+		m_context = nullptr;
+		m_display = nullptr;
+		s_eglGetProcAddress = nullptr;
+		dlclose(m_library);
+		m_library = nullptr;
+#endif
+	}
+}
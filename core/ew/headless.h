@@ -0,0 +1,22 @@
+#pragma once
+
+namespace ew {
+	//An OpenGL context with no window, for rendering into framebuffers on machines without a display.
+	//Uses a surfaceless EGL display, loaded at runtime from libEGL so there is no link dependency.
+	//Only available on Linux; create() fails elsewhere.
+	class HeadlessContext {
+	public:
+		HeadlessContext() {};
+		~HeadlessContext();
+		HeadlessContext(const HeadlessContext&) = delete;
+		HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+		//Creates a core profile context, makes it current and loads GL functions through glad
+		bool create(int majorVersion = 4, int minorVersion = 5);
+		void destroy();
+	private:
+		void* m_library = nullptr; //libEGL handle
+		void* m_display = nullptr;
+		void* m_context = nullptr;
+	};
+}
@@ -0,0 +1,402 @@
+#include "imageDecoder.h"
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <mutex>
+#include <algorithm>
+#include "external/stb_image.h"
+
+#ifdef EW_USE_LIBJPEG
+#include <setjmp.h>
+#include <jpeglib.h>
+#endif
+
+namespace {
+	const size_t MAX_POOLED_BUFFERS = 8;
+	const size_t MAX_POOLED_BYTES = (size_t)256 << 20;
+
+	std::mutex poolMutex;
+	std::vector<std::vector<unsigned char>> pool;
+
+	std::mutex decoderMutex;
+	std::vector<std::shared_ptr<ew::ImageDecoder>> registeredDecoders;
+
+	void flipRows(unsigned char* pixels, int height, size_t stride) {
+		std::vector<unsigned char> row(stride);
+		for (int y = 0; y < height / 2; y++) {
+			unsigned char* top = pixels + y * stride;
+			unsigned char* bottom = pixels + (height - 1 - y) * stride;
+			memcpy(row.data(), top, stride);
+			memcpy(top, bottom, stride);
+			memcpy(bottom, row.data(), stride);
+		}
+	}
+
+	//Scales are powers of two up to 8, anything else rounds down to one
+	int roundScale(int scale) {
+		int rounded = 1;
+		while (rounded < 8 && rounded * 2 <= scale) {
+			rounded *= 2;
+		}
+		return rounded;
+	}
+
+	//Widens a row of width pixels in place, from channels 1 to 2 or 3 to 4, with opaque alpha
+	void addAlpha(unsigned char* row, int width, int channels) {
+		for (int x = width - 1; x >= 0; x--) {
+			row[x * (channels + 1) + channels] = 255;
+			for (int c = channels - 1; c >= 0; c--) {
+				row[x * (channels + 1) + c] = row[x * channels + c];
+			}
+		}
+	}
+
+	class StbImageDecoder : public ew::ImageDecoder {
+	public:
+		const char* getName()const override { return "stb_image"; }
+		bool readInfo(const unsigned char* data, size_t size, ew::ImageInfo& info)const override {
+			if (size > INT_MAX || !stbi_info_from_memory(data, (int)size, &info.width, &info.height, &info.channels))
+				return false;
+			info.type = stbi_is_hdr_from_memory(data, (int)size) ? ew::PixelType::Float : ew::PixelType::UInt8;
+			return true;
+		}
+		/// <summary>
+		/// stb_image decodes into its own allocation, so rows are copied out, flipped on the way if asked
+		/// </summary>
+		bool decode(const unsigned char* data, size_t size, int scale, int channels, bool flipY, unsigned char* pixels)const override {
+			if (scale != 1 || size > INT_MAX)
+				return false;
+			int width, height, fileChannels;
+			const bool hdr = stbi_is_hdr_from_memory(data, (int)size);
+			void* decoded = hdr ? (void*)stbi_loadf_from_memory(data, (int)size, &width, &height, &fileChannels, channels)
+				: (void*)stbi_load_from_memory(data, (int)size, &width, &height, &fileChannels, channels);
+			if (decoded == NULL)
+				return false;
+			const size_t stride = ew::getPixelSize(hdr ? ew::PixelType::Float : ew::PixelType::UInt8, channels) * width;
+			for (int y = 0; y < height; y++) {
+				memcpy(pixels + stride * (flipY ? height - 1 - y : y), (const unsigned char*)decoded + stride * y, stride);
+			}
+			stbi_image_free(decoded);
+			return true;
+		}
+	};
+
+#ifdef EW_USE_LIBJPEG
+	//libjpeg's default error handler exits the process, so errors jump back to the decode instead
+	struct JpegError {
+		jpeg_error_mgr manager;
+		jmp_buf jump;
+	};
+	void onJpegError(j_common_ptr info) {
+		longjmp(((JpegError*)info->err)->jump, 1);
+	}
+	void onJpegMessage(j_common_ptr) {}
+
+	class JpegImageDecoder : public ew::ImageDecoder {
+	public:
+		const char* getName()const override {
+#ifdef LIBJPEG_TURBO_VERSION
+			return "libjpeg-turbo";
+#else
+			return "libjpeg";
+#endif
+		}
+		bool readInfo(const unsigned char* data, size_t size, ew::ImageInfo& info)const override {
+			if (size < 3 || data[0] != 0xFF || data[1] != 0xD8 || data[2] != 0xFF)
+				return false;
+			jpeg_decompress_struct jpeg;
+			JpegError error;
+			if (!begin(jpeg, error, data, size))
+				return false;
+			if (setjmp(error.jump)) {
+				jpeg_destroy_decompress(&jpeg);
+				return false;
+			}
+			jpeg_read_header(&jpeg, TRUE);
+			//CMYK has no conversion to RGB, leave it to the next decoder
+			const bool ok = jpeg.jpeg_color_space != JCS_CMYK && jpeg.jpeg_color_space != JCS_YCCK;
+			info.width = jpeg.image_width;
+			info.height = jpeg.image_height;
+			info.channels = jpeg.num_components;
+			info.type = ew::PixelType::UInt8;
+			jpeg_destroy_decompress(&jpeg);
+			return ok;
+		}
+		int getNativeScales()const override { return 1 | 2 | 4 | 8; }
+		/// <summary>
+		/// Rows go straight to their place in pixels, bottom up when flipped, several per call so the merged
+		/// upsampler doesn't go through its spare row. Alpha is filled in after each call where libjpeg has no
+		/// output format for the channels.
+		/// </summary>
+		bool decode(const unsigned char* data, size_t size, int scale, int channels, bool flipY, unsigned char* pixels)const override {
+			jpeg_decompress_struct jpeg;
+			JpegError error;
+			if (!begin(jpeg, error, data, size))
+				return false;
+			if (setjmp(error.jump)) {
+				jpeg_destroy_decompress(&jpeg);
+				return false;
+			}
+			jpeg_read_header(&jpeg, TRUE);
+			jpeg.scale_num = 1;
+			jpeg.scale_denom = scale;
+			int decodedChannels = 3;
+			jpeg.out_color_space = JCS_RGB;
+			if (channels <= 2) {
+				decodedChannels = 1;
+				jpeg.out_color_space = JCS_GRAYSCALE;
+			}
+#ifdef JCS_EXTENSIONS
+			else if (channels == 4) {
+				decodedChannels = 4;
+				jpeg.out_color_space = JCS_EXT_RGBA;
+			}
+#endif
+			jpeg_start_decompress(&jpeg);
+			const int width = ew::getScaledSize(jpeg.image_width, scale), height = ew::getScaledSize(jpeg.image_height, scale);
+			if ((int)jpeg.output_width != width || (int)jpeg.output_height != height || jpeg.output_components != decodedChannels) {
+				jpeg_destroy_decompress(&jpeg);
+				return false;
+			}
+			const size_t stride = (size_t)width * channels;
+			const int MAX_ROWS = 16;
+			JSAMPROW rows[MAX_ROWS];
+			while (jpeg.output_scanline < jpeg.output_height) {
+				const int first = jpeg.output_scanline;
+				const int count = std::min(MAX_ROWS, height - first);
+				for (int i = 0; i < count; i++) {
+					rows[i] = pixels + stride * (flipY ? height - 1 - (first + i) : first + i);
+				}
+				const int read = jpeg_read_scanlines(&jpeg, rows, count);
+				if (decodedChannels < channels) {
+					for (int i = 0; i < read; i++) {
+						addAlpha(rows[i], width, decodedChannels);
+					}
+				}
+			}
+			jpeg_finish_decompress(&jpeg);
+			jpeg_destroy_decompress(&jpeg);
+			return true;
+		}
+	private:
+		static bool begin(jpeg_decompress_struct& jpeg, JpegError& error, const unsigned char* data, size_t size) {
+			if (size > ULONG_MAX)
+				return false;
+			jpeg.err = jpeg_std_error(&error.manager);
+			error.manager.error_exit = onJpegError;
+			error.manager.output_message = onJpegMessage;
+			jpeg_create_decompress(&jpeg);
+			//Older libjpegs take a non-const pointer, but only read it
+			jpeg_mem_src(&jpeg, (unsigned char*)data, (unsigned long)size);
+			return true;
+		}
+	};
+#endif
+}
+
+namespace ew {
+	int getDecodeScale(int width, int height, int minSize) {
+		int scale = 1;
+		while (scale < 8 && getScaledSize(width, scale * 2) >= minSize && getScaledSize(height, scale * 2) >= minSize) {
+			scale *= 2;
+		}
+		return scale;
+	}
+
+	void registerImageDecoder(std::shared_ptr<ImageDecoder> decoder) {
+		std::lock_guard<std::mutex> lock(decoderMutex);
+		registeredDecoders.push_back(decoder);
+	}
+	std::shared_ptr<ImageDecoder> getStbImageDecoder() {
+		static std::shared_ptr<ImageDecoder> decoder = std::make_shared<StbImageDecoder>();
+		return decoder;
+	}
+	std::shared_ptr<ImageDecoder> getJpegImageDecoder() {
+#ifdef EW_USE_LIBJPEG
+		static std::shared_ptr<ImageDecoder> decoder = std::make_shared<JpegImageDecoder>();
+		return decoder;
+#else
+		return nullptr;
+#endif
+	}
+
+	/// <summary>
+	/// Takes the smallest pooled buffer big enough, the last released of equal ones since it is likeliest to
+	/// still be in cache. Pooled buffers keep their size, so reusing one doesn't clear it the way resizing a
+	/// vector would.
+	/// </summary>
+	std::vector<unsigned char> acquireImageBuffer(size_t size) {
+		{
+			std::lock_guard<std::mutex> lock(poolMutex);
+			auto best = pool.end();
+			for (auto it = pool.begin(); it != pool.end(); it++) {
+				if (it->size() >= size && (best == pool.end() || it->size() <= best->size())) {
+					best = it;
+				}
+			}
+			if (best != pool.end()) {
+				std::vector<unsigned char> buffer = std::move(*best);
+				pool.erase(best);
+				return buffer;
+			}
+		}
+		return std::vector<unsigned char>(size);
+	}
+	/// <summary>
+	/// Past the pool's limits, the smallest buffers are freed first
+	/// </summary>
+	void releaseImageBuffer(std::vector<unsigned char>&& buffer) {
+		if (buffer.empty())
+			return;
+		std::lock_guard<std::mutex> lock(poolMutex);
+		pool.push_back(std::move(buffer));
+		size_t bytes = 0;
+		for (const auto& pooled : pool) {
+			bytes += pooled.size();
+		}
+		while (!pool.empty() && (pool.size() > MAX_POOLED_BUFFERS || bytes > MAX_POOLED_BYTES)) {
+			auto smallest = std::min_element(pool.begin(), pool.end(), [](const std::vector<unsigned char>& a, const std::vector<unsigned char>& b) {
+				return a.size() < b.size();
+			});
+			bytes -= smallest->size();
+			pool.erase(smallest);
+		}
+	}
+
+	DecodedImage::~DecodedImage() {
+		release();
+	}
+	DecodedImage::DecodedImage(DecodedImage&& other) noexcept
+		:m_info(other.m_info), m_buffer(std::move(other.m_buffer)), m_size(other.m_size)
+	{
+		other.m_size = 0;
+	}
+	DecodedImage& DecodedImage::operator=(DecodedImage&& other) noexcept {
+		if (this != &other) {
+			release();
+			m_info = other.m_info;
+			m_buffer = std::move(other.m_buffer);
+			m_size = other.m_size;
+			other.m_size = 0;
+		}
+		return *this;
+	}
+	std::vector<unsigned char> DecodedImage::takePixels() {
+		m_buffer.resize(m_size);
+		m_size = 0;
+		return std::move(m_buffer);
+	}
+	void DecodedImage::release() {
+		releaseImageBuffer(std::move(m_buffer));
+		m_buffer.clear();
+		m_size = 0;
+	}
+
+	ImageFile::~ImageFile() {
+		releaseImageBuffer(std::move(m_data));
+	}
+	/// <summary>
+	/// Registered decoders are asked first, last registered first
+	/// </summary>
+	bool ImageFile::open(const char* path) {
+		releaseImageBuffer(std::move(m_data));
+		m_data.clear();
+		m_size = 0;
+		m_decoder = nullptr;
+		m_info = {};
+		FILE* file = fopen(path, "rb");
+		if (file == NULL)
+			return false;
+		fseek(file, 0, SEEK_END);
+		const long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		if (size > 0) {
+			m_data = acquireImageBuffer((size_t)size);
+			m_size = fread(m_data.data(), 1, (size_t)size, file);
+		}
+		fclose(file);
+		if (m_size == 0 || m_size != (size_t)size)
+			return false;
+
+		std::vector<std::shared_ptr<ImageDecoder>> decoders;
+		{
+			std::lock_guard<std::mutex> lock(decoderMutex);
+			decoders.assign(registeredDecoders.rbegin(), registeredDecoders.rend());
+		}
+		if (getJpegImageDecoder()) {
+			decoders.push_back(getJpegImageDecoder());
+		}
+		decoders.push_back(getStbImageDecoder());
+		for (const auto& decoder : decoders) {
+			ImageInfo info;
+			if (decoder->readInfo(m_data.data(), m_size, info) && info.width > 0 && info.height > 0 && info.channels >= 1 && info.channels <= 4) {
+				m_decoder = decoder;
+				m_info = info;
+				return true;
+			}
+		}
+		return false;
+	}
+	ImageInfo ImageFile::getDecodedInfo(const DecodeOptions& options)const {
+		ImageInfo info = m_info;
+		const int scale = roundScale(options.scale);
+		info.width = getScaledSize(m_info.width, scale);
+		info.height = getScaledSize(m_info.height, scale);
+		if (options.channels >= 1 && options.channels <= 4) {
+			info.channels = options.channels;
+		}
+		return info;
+	}
+	size_t ImageFile::getDecodedSize(const DecodeOptions& options)const {
+		const ImageInfo info = getDecodedInfo(options);
+		return getPixelSize(info.type, info.channels) * info.width * info.height;
+	}
+	/// <summary>
+	/// A scale the decoder doesn't take is decoded at the largest one it does below it, then box filtered down
+	/// </summary>
+	bool ImageFile::decode(unsigned char* pixels, const DecodeOptions& options)const {
+		if (!m_decoder)
+			return false;
+		const int scale = roundScale(options.scale);
+		int nativeScale = scale;
+		while (nativeScale > 1 && !(m_decoder->getNativeScales() & nativeScale)) {
+			nativeScale /= 2;
+		}
+		const ImageInfo info = getDecodedInfo(options);
+		if (nativeScale == scale)
+			return m_decoder->decode(m_data.data(), m_size, scale, info.channels, options.flipY, pixels);
+
+		DecodeOptions nativeOptions = options;
+		nativeOptions.scale = nativeScale;
+		const ImageInfo nativeInfo = getDecodedInfo(nativeOptions);
+		std::vector<unsigned char> decoded = acquireImageBuffer(getDecodedSize(nativeOptions));
+		const bool ok = m_decoder->decode(m_data.data(), m_size, nativeScale, info.channels, false, decoded.data());
+		if (ok) {
+			resampleImage(decoded.data(), nativeInfo.width, nativeInfo.height, info.type, pixels, info.width, info.height, info.type, info.channels);
+			if (options.flipY) {
+				flipRows(pixels, info.height, getPixelSize(info.type, info.channels) * info.width);
+			}
+		}
+		releaseImageBuffer(std::move(decoded));
+		return ok;
+	}
+	bool ImageFile::decode(DecodedImage& image, const DecodeOptions& options)const {
+		image.release();
+		if (!m_decoder)
+			return false;
+		const size_t size = getDecodedSize(options);
+		image.m_buffer = acquireImageBuffer(size);
+		if (!decode(image.m_buffer.data(), options)) {
+			image.release();
+			return false;
+		}
+		image.m_info = getDecodedInfo(options);
+		image.m_size = size;
+		return true;
+	}
+
+	bool decodeImage(const char* path, DecodedImage& image, const DecodeOptions& options) {
+		ImageFile file;
+		return file.open(path) && file.decode(image, options);
+	}
+}
@@ -0,0 +1,113 @@
+/*
+	Image decoding for textures, cubemaps and terrain, behind one interface. A file is read into memory and
+	given to the first decoder that recognizes it: decoders added with registerImageDecoder first, then
+	libjpeg-turbo for JPEGs when the build finds it (EW_USE_LIBJPEG), then stb_image for everything else.
+
+	libjpeg-turbo runs the IDCT, upsampling and color conversion with SIMD, and writes rows straight into the
+	destination. It can also scale by 1/2, 1/4 or 1/8 inside the IDCT, so a reduced image costs a fraction of
+	a full decode. Decoders that can't scale natively decode in full and are box filtered down.
+
+	Pixels go to memory the caller provides, or to a buffer from a small pool that keeps freed buffers for the
+	next image, so decoding many images in a row doesn't allocate and fault in fresh pages each time.
+*/
+
+#pragma once
+#include <stddef.h>
+#include <vector>
+#include <memory>
+#include "imageResample.h"
+
+namespace ew {
+	struct ImageInfo {
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		PixelType type = PixelType::UInt8; //Float for .hdr images, which are linear
+	};
+
+	struct DecodeOptions {
+		int channels = 0; //1-4 converts to that many, 0 keeps the file's
+		int scale = 1; //1, 2, 4 or 8: decode at 1/scale of the size, rounded up. Others round down to one of those.
+		bool flipY = false; //First row at the bottom, as GL expects
+	};
+	inline int getScaledSize(int size, int scale) { return (size + scale - 1) / scale; }
+	//The largest scale that keeps both sides of a width x height image at least minSize
+	int getDecodeScale(int width, int height, int minSize);
+
+	//A file format. Decoders are shared between threads, so decode must be safe to call concurrently.
+	class ImageDecoder {
+	public:
+		virtual ~ImageDecoder() = default;
+		virtual const char* getName()const = 0;
+		//Reads the header from data, the whole file. False if it isn't a file this decoder reads.
+		virtual bool readInfo(const unsigned char* data, size_t size, ImageInfo& info)const = 0;
+		//Scales decode takes, as a mask of 1, 2, 4 and 8. Others are box filtered from the nearest smaller one.
+		virtual int getNativeScales()const { return 1; }
+		//Decodes at a native scale to pixels, rows tightly packed, with channels (1-4) of info.type each
+		virtual bool decode(const unsigned char* data, size_t size, int scale, int channels, bool flipY, unsigned char* pixels)const = 0;
+	};
+	//Tried before the built in decoders, last added first
+	void registerImageDecoder(std::shared_ptr<ImageDecoder> decoder);
+	//The built in decoders. The JPEG one is null when built without EW_USE_LIBJPEG.
+	std::shared_ptr<ImageDecoder> getStbImageDecoder();
+	std::shared_ptr<ImageDecoder> getJpegImageDecoder();
+
+	//Pooled buffers. acquire returns one of at least size bytes, not cleared; release gives it back for reuse.
+	std::vector<unsigned char> acquireImageBuffer(size_t size);
+	void releaseImageBuffer(std::vector<unsigned char>&& buffer);
+
+	//Pixels in a pooled buffer, returned to the pool when destroyed. Move only.
+	class DecodedImage {
+	public:
+		DecodedImage() {};
+		~DecodedImage();
+		DecodedImage(DecodedImage&& other) noexcept;
+		DecodedImage& operator=(DecodedImage&& other) noexcept;
+		DecodedImage(const DecodedImage&) = delete;
+		DecodedImage& operator=(const DecodedImage&) = delete;
+
+		inline bool isValid()const { return m_size > 0; }
+		inline const ImageInfo& getInfo()const { return m_info; }
+		inline unsigned char* getPixels() { return m_buffer.data(); }
+		inline const unsigned char* getPixels()const { return m_buffer.data(); }
+		inline size_t getSize()const { return m_size; }
+		//Moves the pixels out of the pool, into a vector of exactly getSize() bytes
+		std::vector<unsigned char> takePixels();
+		void release();
+	private:
+		friend class ImageFile;
+
+		ImageInfo m_info;
+		std::vector<unsigned char> m_buffer;
+		size_t m_size = 0;
+	};
+
+	//A file read into memory with the decoder that reads it, to query before decoding without reading it twice
+	class ImageFile {
+	public:
+		ImageFile() {};
+		~ImageFile();
+		ImageFile(const ImageFile&) = delete;
+		ImageFile& operator=(const ImageFile&) = delete;
+
+		//Reads path and its header. Safe to call from worker threads.
+		bool open(const char* path);
+		inline const ImageInfo& getInfo()const { return m_info; }
+		inline const char* getDecoderName()const { return m_decoder ? m_decoder->getName() : ""; }
+		//Size, channels and type decode gives with options
+		ImageInfo getDecodedInfo(const DecodeOptions& options)const;
+		size_t getDecodedSize(const DecodeOptions& options)const;
+		//Decodes into pixels, which holds getDecodedSize(options) bytes
+		bool decode(unsigned char* pixels, const DecodeOptions& options)const;
+		//Decodes into a pooled buffer
+		bool decode(DecodedImage& image, const DecodeOptions& options)const;
+	private:
+		std::vector<unsigned char> m_data; //Pooled
+		size_t m_size = 0;
+		std::shared_ptr<ImageDecoder> m_decoder;
+		ImageInfo m_info;
+	};
+
+	//Opens and decodes path into a pooled buffer
+	bool decodeImage(const char* path, DecodedImage& image, const DecodeOptions& options = {});
+}
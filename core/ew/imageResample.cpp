@@ -0,0 +1,351 @@
+#include "imageResample.h"
+#include "ewMath/simd.h"
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace {
+	using ew::PixelType;
+	using ew::ResampleFilter;
+
+	//Output rows per band. Taller bands filter fewer source rows twice, shorter ones balance threads better.
+	const int BAND_HEIGHT = 64;
+
+	//One pixel, up to 4 channels, in a vector register
+#if defined(EW_SIMD_SSE)
+	typedef __m128 Pixel;
+	inline Pixel pZero() { return _mm_setzero_ps(); }
+	inline Pixel pSet(float f) { return _mm_set1_ps(f); }
+	inline Pixel pLoad(const float* p) { return _mm_loadu_ps(p); }
+	inline void pStore(float* p, Pixel v) { _mm_storeu_ps(p, v); }
+	inline Pixel pMulAdd(Pixel a, Pixel b, Pixel c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+#elif defined(EW_SIMD_NEON)
+	typedef float32x4_t Pixel;
+	inline Pixel pZero() { return vdupq_n_f32(0.0f); }
+	inline Pixel pSet(float f) { return vdupq_n_f32(f); }
+	inline Pixel pLoad(const float* p) { return vld1q_f32(p); }
+	inline void pStore(float* p, Pixel v) { vst1q_f32(p, v); }
+	inline Pixel pMulAdd(Pixel a, Pixel b, Pixel c) { return vmlaq_f32(c, a, b); }
+#else
+	struct Pixel { float v[4]; };
+	inline Pixel pZero() { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+	inline Pixel pSet(float f) { return { { f, f, f, f } }; }
+	inline Pixel pLoad(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+	inline void pStore(float* p, Pixel v) { memcpy(p, v.v, sizeof(v.v)); }
+	inline Pixel pMulAdd(Pixel a, Pixel b, Pixel c) {
+		return { { a.v[0] * b.v[0] + c.v[0], a.v[1] * b.v[1] + c.v[1], a.v[2] * b.v[2] + c.v[2], a.v[3] * b.v[3] + c.v[3] } };
+	}
+#endif
+
+	const int LINEAR_STEPS = 16384;
+	struct SrgbTables {
+		float toLinear8[256];
+		std::vector<float> toLinear16;
+		unsigned char fromLinear8[LINEAR_STEPS + 1];
+		SrgbTables() {
+			for (int i = 0; i < 256; i++) {
+				toLinear8[i] = toLinear(i / 255.0f);
+			}
+			toLinear16.resize(65536);
+			for (int i = 0; i < 65536; i++) {
+				toLinear16[i] = toLinear(i / 65535.0f);
+			}
+			for (int i = 0; i <= LINEAR_STEPS; i++) {
+				fromLinear8[i] = (unsigned char)(fromLinear((float)i / LINEAR_STEPS) * 255.0f + 0.5f);
+			}
+		}
+		static float toLinear(float c) { return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f); }
+		static float fromLinear(float l) { return l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f; }
+	};
+	const SrgbTables& srgbTables() {
+		static const SrgbTables tables;
+		return tables;
+	}
+
+	inline float sinc(float x) {
+		if (fabsf(x) < 1e-6f)
+			return 1.0f;
+		x *= 3.14159265f;
+		return sinf(x) / x;
+	}
+	//Zeroth order modified Bessel function of the first kind, for the Kaiser window
+	float besselI0(float x) {
+		float sum = 1.0f, term = 1.0f;
+		for (int k = 1; k < 32; k++) {
+			term *= (x * 0.5f / k) * (x * 0.5f / k);
+			sum += term;
+			if (term < sum * 1e-8f)
+				break;
+		}
+		return sum;
+	}
+	const float KAISER_ALPHA = 4.0f;
+	const float WINDOW_RADIUS = 3.0f;
+	float getFilterRadius(ResampleFilter filter) {
+		return filter == ResampleFilter::Box ? 0.5f : WINDOW_RADIUS;
+	}
+	//Weight at x output pixels from the sample position, for the windowed filters
+	float evaluateFilter(ResampleFilter filter, float x) {
+		if (fabsf(x) >= WINDOW_RADIUS)
+			return 0.0f;
+		if (filter == ResampleFilter::Lanczos)
+			return sinc(x) * sinc(x / WINDOW_RADIUS);
+		const float t = x / WINDOW_RADIUS;
+		return sinc(x) * besselI0(KAISER_ALPHA * sqrtf(1.0f - t * t)) / besselI0(KAISER_ALPHA);
+	}
+
+	//The source pixels and weights behind every output pixel along one axis, a fixed number of taps each
+	struct Contributions {
+		int taps = 0;
+		std::vector<int> indices;
+		std::vector<float> weights;
+	};
+	/// <summary>
+	/// Centers each output pixel on the source, stretches the filter by the downscale factor so it averages
+	/// everything the output pixel covers, and normalizes the weights. Taps past an edge clamp or wrap.
+	/// </summary>
+	Contributions computeContributions(int srcSize, int dstSize, ResampleFilter filter, bool wrap) {
+		Contributions contributions;
+		const float scale = (float)srcSize / dstSize;
+		const float filterScale = std::max(scale, 1.0f);
+		const float support = getFilterRadius(filter) * filterScale;
+		contributions.taps = (int)ceilf(support * 2.0f) + 1;
+		contributions.indices.assign((size_t)dstSize * contributions.taps, 0);
+		contributions.weights.assign((size_t)dstSize * contributions.taps, 0.0f);
+		for (int i = 0; i < dstSize; i++) {
+			const float center = (i + 0.5f) * scale - 0.5f;
+			const int first = (int)floorf(center - support + 0.5f);
+			int* indices = &contributions.indices[(size_t)i * contributions.taps];
+			float* weights = &contributions.weights[(size_t)i * contributions.taps];
+			float total = 0.0f;
+			for (int tap = 0; tap < contributions.taps; tap++) {
+				const int j = first + tap;
+				float weight;
+				if (filter == ResampleFilter::Box) {
+					//How much of source pixel j lies under the output pixel
+					weight = std::max(0.0f, std::min(j + 0.5f, center + support) - std::max(j - 0.5f, center - support));
+				}
+				else {
+					weight = evaluateFilter(filter, (j - center) / filterScale);
+				}
+				indices[tap] = wrap ? ((j % srcSize) + srcSize) % srcSize : std::clamp(j, 0, srcSize - 1);
+				weights[tap] = weight;
+				total += weight;
+			}
+			for (int tap = 0; tap < contributions.taps; tap++) {
+				weights[tap] /= total;
+			}
+		}
+		//Drop the taps at the window's ends that no output pixel gives any weight
+		int first = contributions.taps, last = -1;
+		for (int i = 0; i < dstSize; i++) {
+			const float* weights = &contributions.weights[(size_t)i * contributions.taps];
+			for (int tap = 0; tap < contributions.taps; tap++) {
+				if (weights[tap] != 0.0f) {
+					first = std::min(first, tap);
+					last = std::max(last, tap);
+				}
+			}
+		}
+		if (first > 0 || last < contributions.taps - 1) {
+			const int taps = last - first + 1;
+			for (int i = 0; i < dstSize; i++) {
+				for (int tap = 0; tap < taps; tap++) {
+					contributions.indices[(size_t)i * taps + tap] = contributions.indices[(size_t)i * contributions.taps + first + tap];
+					contributions.weights[(size_t)i * taps + tap] = contributions.weights[(size_t)i * contributions.taps + first + tap];
+				}
+			}
+			contributions.taps = taps;
+			contributions.indices.resize((size_t)dstSize * taps);
+			contributions.weights.resize((size_t)dstSize * taps);
+		}
+		return contributions;
+	}
+
+	/// <summary>
+	/// Widens one row to 4 floats per pixel, in linear space for sRGB channels. Missing channels are 0.
+	/// </summary>
+	void loadRow(const void* src, PixelType type, int width, int channels, int srgbChannels, float* out) {
+		const SrgbTables& tables = srgbTables();
+		if (channels < 4) {
+			memset(out, 0, sizeof(float) * 4 * width);
+		}
+		for (int c = 0; c < channels; c++) {
+			float* dst = out + c;
+			if (type == PixelType::UInt8) {
+				const unsigned char* in = (const unsigned char*)src + c;
+				const float* table = c < srgbChannels ? tables.toLinear8 : nullptr;
+				for (int x = 0; x < width; x++, in += channels, dst += 4) {
+					*dst = table ? table[*in] : *in * (1.0f / 255.0f);
+				}
+			}
+			else if (type == PixelType::UInt16) {
+				const uint16_t* in = (const uint16_t*)src + c;
+				const float* table = c < srgbChannels ? tables.toLinear16.data() : nullptr;
+				for (int x = 0; x < width; x++, in += channels, dst += 4) {
+					*dst = table ? table[*in] : *in * (1.0f / 65535.0f);
+				}
+			}
+			else {
+				const float* in = (const float*)src + c;
+				for (int x = 0; x < width; x++, in += channels, dst += 4) {
+					*dst = *in;
+				}
+			}
+		}
+	}
+	//Narrows a row of 4 float pixels back to the output type
+	void storeRow(const float* row, PixelType type, int width, int channels, int srgbChannels, void* dst) {
+		const SrgbTables& tables = srgbTables();
+		for (int c = 0; c < channels; c++) {
+			const float* in = row + c;
+			const bool srgb = c < srgbChannels;
+			if (type == PixelType::UInt8) {
+				unsigned char* out = (unsigned char*)dst + c;
+				for (int x = 0; x < width; x++, in += 4, out += channels) {
+					const float v = std::clamp(*in, 0.0f, 1.0f);
+					*out = srgb ? tables.fromLinear8[(int)(v * LINEAR_STEPS + 0.5f)] : (unsigned char)(v * 255.0f + 0.5f);
+				}
+			}
+			else if (type == PixelType::UInt16) {
+				uint16_t* out = (uint16_t*)dst + c;
+				for (int x = 0; x < width; x++, in += 4, out += channels) {
+					const float v = std::clamp(*in, 0.0f, 1.0f);
+					*out = (uint16_t)((srgb ? SrgbTables::fromLinear(v) : v) * 65535.0f + 0.5f);
+				}
+			}
+			else {
+				float* out = (float*)dst + c;
+				for (int x = 0; x < width; x++, in += 4, out += channels) {
+					*out = *in;
+				}
+			}
+		}
+	}
+
+	void filterRow(const float* src, const Contributions& contributions, int dstWidth, float* dst) {
+		const int taps = contributions.taps;
+		for (int x = 0; x < dstWidth; x++) {
+			const int* indices = &contributions.indices[(size_t)x * taps];
+			const float* weights = &contributions.weights[(size_t)x * taps];
+			Pixel sum = pZero();
+			for (int tap = 0; tap < taps; tap++) {
+				sum = pMulAdd(pSet(weights[tap]), pLoad(src + (size_t)indices[tap] * 4), sum);
+			}
+			pStore(dst + (size_t)x * 4, sum);
+		}
+	}
+
+	struct ResampleJob {
+		const unsigned char* src;
+		int srcWidth, srcHeight;
+		PixelType srcType;
+		unsigned char* dst;
+		int dstWidth, dstHeight;
+		PixelType dstType;
+		int channels;
+		int srgbChannels;
+		Contributions horizontal, vertical;
+		std::atomic<int> nextBand{ 0 };
+	};
+
+	/// <summary>
+	/// Takes bands of output rows until none are left. Each band filters the source rows its vertical taps
+	/// read into a buffer once, then sums them into each output row.
+	/// </summary>
+	void runBands(ResampleJob& job) {
+		const size_t srcStride = getPixelSize(job.srcType, job.channels) * job.srcWidth;
+		const size_t dstStride = getPixelSize(job.dstType, job.channels) * job.dstWidth;
+		const size_t rowFloats = (size_t)job.dstWidth * 4;
+		const bool resizeRows = job.srcWidth != job.dstWidth;
+		std::vector<float> loaded(resizeRows ? (size_t)job.srcWidth * 4 : 0);
+		std::vector<float> rows, sum(rowFloats);
+		std::vector<int> rowSlots(job.srcHeight, -1);
+		std::vector<int> needed;
+		const int taps = job.vertical.taps;
+		const int numBands = (job.dstHeight + BAND_HEIGHT - 1) / BAND_HEIGHT;
+		for (int band = job.nextBand++; band < numBands; band = job.nextBand++) {
+			const int begin = band * BAND_HEIGHT, end = std::min(job.dstHeight, begin + BAND_HEIGHT);
+			needed.assign(job.vertical.indices.begin() + (size_t)begin * taps, job.vertical.indices.begin() + (size_t)end * taps);
+			std::sort(needed.begin(), needed.end());
+			needed.erase(std::unique(needed.begin(), needed.end()), needed.end());
+			rows.resize(needed.size() * rowFloats);
+			for (size_t slot = 0; slot < needed.size(); slot++) {
+				const int y = needed[slot];
+				rowSlots[y] = (int)slot;
+				float* row = &rows[slot * rowFloats];
+				if (resizeRows) {
+					loadRow(job.src + y * srcStride, job.srcType, job.srcWidth, job.channels, job.srgbChannels, loaded.data());
+					filterRow(loaded.data(), job.horizontal, job.dstWidth, row);
+				}
+				else {
+					loadRow(job.src + y * srcStride, job.srcType, job.srcWidth, job.channels, job.srgbChannels, row);
+				}
+			}
+			for (int y = begin; y < end; y++) {
+				const int* indices = &job.vertical.indices[(size_t)y * taps];
+				const float* weights = &job.vertical.weights[(size_t)y * taps];
+				std::fill(sum.begin(), sum.end(), 0.0f);
+				for (int tap = 0; tap < taps; tap++) {
+					if (weights[tap] == 0.0f)
+						continue;
+					const float* row = &rows[rowSlots[indices[tap]] * rowFloats];
+					const Pixel weight = pSet(weights[tap]);
+					for (size_t i = 0; i < rowFloats; i += 4) {
+						pStore(&sum[i], pMulAdd(weight, pLoad(row + i), pLoad(&sum[i])));
+					}
+				}
+				storeRow(sum.data(), job.dstType, job.dstWidth, job.channels, job.srgbChannels, job.dst + y * dstStride);
+			}
+			for (int y : needed) {
+				rowSlots[y] = -1;
+			}
+		}
+	}
+}
+
+namespace ew {
+	void resampleImage(const void* src, int srcWidth, int srcHeight, PixelType srcType,
+		void* dst, int dstWidth, int dstHeight, PixelType dstType, int channels, const ResampleOptions& options) {
+		if (srcWidth < 1 || srcHeight < 1 || dstWidth < 1 || dstHeight < 1 || channels < 1 || channels > 4)
+			return;
+		ResampleJob job;
+		job.src = (const unsigned char*)src;
+		job.srcWidth = srcWidth;
+		job.srcHeight = srcHeight;
+		job.srcType = srcType;
+		job.dst = (unsigned char*)dst;
+		job.dstWidth = dstWidth;
+		job.dstHeight = dstHeight;
+		job.dstType = dstType;
+		job.channels = channels;
+		job.srgbChannels = std::clamp(options.srgbChannels, 0, channels);
+		job.horizontal = computeContributions(srcWidth, dstWidth, options.filter, options.wrap);
+		job.vertical = computeContributions(srcHeight, dstHeight, options.filter, options.wrap);
+
+		const int numBands = (dstHeight + BAND_HEIGHT - 1) / BAND_HEIGHT;
+		unsigned int numThreads = options.numThreads > 0 ? options.numThreads : std::max(1u, std::thread::hardware_concurrency());
+		numThreads = std::min(numThreads, (unsigned int)numBands);
+		std::vector<std::thread> threads;
+		for (unsigned int i = 1; i < numThreads; i++) {
+			threads.emplace_back(runBands, std::ref(job));
+		}
+		runBands(job);
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+	}
+	void downsampleImage(const void* src, int width, int height, void* dst, int channels, PixelType type, const ResampleOptions& options) {
+		resampleImage(src, width, height, type, dst, getMipSize(width, 1), getMipSize(height, 1), type, channels, options);
+	}
+	float srgbToLinear(unsigned char value) {
+		return srgbTables().toLinear8[value];
+	}
+	unsigned char linearToSrgb(float value) {
+		return srgbTables().fromLinear8[(int)(std::clamp(value, 0.0f, 1.0f) * LINEAR_STEPS + 0.5f)];
+	}
+}
@@ -0,0 +1,48 @@
+/*
+	Image resampling and mip generation on the CPU, so mips come out the same on every driver.
+	Images are tightly packed with 1-4 channels of 8 bit, 16 bit or float data. Resizing is separable:
+	each row is filtered horizontally into a buffer of 4 floats per pixel, then the rows are filtered
+	vertically, a pixel (horizontal) or 4 floats (vertical) at a time with SIMD. The output is split into
+	bands of rows that threads take in turn, each band filtering only the source rows it needs.
+
+	Color channels marked sRGB are filtered in linear space. Float images are taken to be linear already.
+*/
+
+#pragma once
+#include <stddef.h>
+
+namespace ew {
+	//Bytes per channel
+	enum class PixelType {
+		UInt8 = 1,
+		UInt16 = 2,
+		Float = 4
+	};
+	inline size_t getPixelSize(PixelType type, int channels) { return (size_t)type * channels; }
+
+	//Box averages the source pixels each output pixel covers: cheap, and a little blurry.
+	//Kaiser is a Kaiser windowed sinc and Lanczos a 3 lobe Lanczos, both 3 pixels wide at the output's scale:
+	//sharper, at the cost of some ringing around hard edges. Integer outputs are clamped to their range.
+	enum class ResampleFilter {
+		Box,
+		Kaiser,
+		Lanczos
+	};
+
+	struct ResampleOptions {
+		ResampleFilter filter = ResampleFilter::Box;
+		int srgbChannels = 0; //Leading channels (of 8 and 16 bit images) filtered in linear space. 3 for color.
+		bool wrap = false; //Filter across the edges as for a repeating texture, instead of clamping to them
+		unsigned int numThreads = 1; //0 uses one per core
+	};
+
+	//Resizes src to dstWidth x dstHeight, converting from srcType to dstType. Integer types map to 0-1.
+	void resampleImage(const void* src, int srcWidth, int srcHeight, PixelType srcType,
+		void* dst, int dstWidth, int dstHeight, PixelType dstType, int channels, const ResampleOptions& options = {});
+	//The next mip of an image: max(width / 2, 1) x max(height / 2, 1) pixels of the same type
+	void downsampleImage(const void* src, int width, int height, void* dst, int channels, PixelType type, const ResampleOptions& options = {});
+	inline int getMipSize(int size, int level) { return size >> level > 1 ? size >> level : 1; }
+	//The sRGB conversions resampleImage uses for 8 bit channels, by table
+	float srgbToLinear(unsigned char value);
+	unsigned char linearToSrgb(float value);
+}
@@ -0,0 +1,116 @@
+#include "imageWriter.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+static uint32_t crc32(const unsigned char* data, size_t length, uint32_t crc = 0) {
+	static uint32_t table[256];
+	static bool tableBuilt = false;
+	if (!tableBuilt) {
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++) {
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			}
+			table[i] = c;
+		}
+		tableBuilt = true;
+	}
+	crc = ~crc;
+	for (size_t i = 0; i < length; i++) {
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static void appendBigEndian(std::vector<unsigned char>& out, uint32_t v) {
+	out.push_back((v >> 24) & 0xFF);
+	out.push_back((v >> 16) & 0xFF);
+	out.push_back((v >> 8) & 0xFF);
+	out.push_back(v & 0xFF);
+}
+
+static void writeChunk(FILE* file, const char* type, const std::vector<unsigned char>& data) {
+	std::vector<unsigned char> chunk;
+	chunk.reserve(data.size() + 12);
+	appendBigEndian(chunk, (uint32_t)data.size());
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	appendBigEndian(chunk, crc32(chunk.data() + 4, data.size() + 4));
+	fwrite(chunk.data(), 1, chunk.size(), file);
+}
+
+namespace ew {
+	/// <summary>
+	/// Writes a PNG using stored (uncompressed) deflate blocks. Files are larger than a real
+	/// encoder would make, but writing is fast and needs no dependencies.
+	/// </summary>
+	/// <param name="filePath">Output path</param>
+	/// <param name="numComponents">1 = gray, 2 = gray + alpha, 3 = RGB, 4 = RGBA</param>
+	/// <param name="data">Tightly packed rows</param>
+	/// <param name="flipVertically">Write rows bottom to top</param>
+	/// <returns>False if the file could not be written</returns>
+	bool writePNG(const char* filePath, int width, int height, int numComponents, const unsigned char* data, bool flipVertically) {
+		static const unsigned char colorTypes[5] = { 0, 0, 4, 2, 6 };
+		if (numComponents < 1 || numComponents > 4) {
+			return false;
+		}
+		FILE* file = fopen(filePath, "wb");
+		if (file == NULL) {
+			printf("Failed to open %s for writing\n", filePath);
+			return false;
+		}
+		static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		fwrite(signature, 1, 8, file);
+
+		std::vector<unsigned char> header;
+		appendBigEndian(header, width);
+		appendBigEndian(header, height);
+		header.push_back(8); //Bit depth
+		header.push_back(colorTypes[numComponents]);
+		header.push_back(0); //Deflate
+		header.push_back(0); //Adaptive filtering
+		header.push_back(0); //No interlace
+		writeChunk(file, "IHDR", header);
+
+		//Filter type 0 (none) before each row
+		const size_t rowSize = (size_t)width * numComponents;
+		std::vector<unsigned char> raw;
+		raw.reserve((rowSize + 1) * height);
+		for (int y = 0; y < height; y++) {
+			const unsigned char* row = data + rowSize * (flipVertically ? height - 1 - y : y);
+			raw.push_back(0);
+			raw.insert(raw.end(), row, row + rowSize);
+		}
+
+		//zlib stream of stored blocks, at most 65535 bytes each
+		std::vector<unsigned char> zlib;
+		zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+		zlib.push_back(0x78);
+		zlib.push_back(0x01);
+		size_t offset = 0;
+		do {
+			size_t blockSize = raw.size() - offset < 65535 ? raw.size() - offset : 65535;
+			bool last = offset + blockSize == raw.size();
+			zlib.push_back(last ? 1 : 0);
+			zlib.push_back(blockSize & 0xFF);
+			zlib.push_back((blockSize >> 8) & 0xFF);
+			zlib.push_back(~blockSize & 0xFF);
+			zlib.push_back((~blockSize >> 8) & 0xFF);
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+			offset += blockSize;
+		} while (offset < raw.size());
+		uint32_t a = 1, b = 0;
+		for (unsigned char c : raw) {
+			a = (a + c) % 65521;
+			b = (b + a) % 65521;
+		}
+		appendBigEndian(zlib, (b << 16) | a);
+		writeChunk(file, "IDAT", zlib);
+		writeChunk(file, "IEND", {});
+
+		bool ok = ferror(file) == 0;
+		fclose(file);
+		return ok;
+	}
+}
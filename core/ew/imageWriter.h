@@ -0,0 +1,7 @@
+#pragma once
+
+namespace ew {
+	//Writes 8-bit pixels (1-4 channels) as an uncompressed PNG. flipVertically writes the last row first,
+	//which is what glReadPixels output needs.
+	bool writePNG(const char* filePath, int width, int height, int numComponents, const unsigned char* data, bool flipVertically);
+}
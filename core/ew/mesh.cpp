@@ -4,9 +4,25 @@
 
 #include "mesh.h"
 #include "ewMath/ewMath.h"
+#include "ewMath/batchTransform.h"
+#include "renderState.h"
 #include "external/glad.h"
 
 namespace ew {
+	void computeBounds(MeshData& meshData)
+	{
+		const Vertex* vertices = meshData.vertices.data();
+		ew::ComputeBounds(&vertices->pos, meshData.vertices.size(), meshData.bounds, meshData.boundingSphere, sizeof(Vertex));
+	}
+	void transformMeshData(MeshData& meshData, const ew::Mat4& m)
+	{
+		if (meshData.vertices.empty()) {
+			return;
+		}
+		Vertex* vertices = meshData.vertices.data();
+		ew::TransformPointsAndNormals(m, &vertices->pos, &vertices->normal, &vertices->pos, &vertices->normal, meshData.vertices.size(), sizeof(Vertex));
+		computeBounds(meshData);
+	}
 	Mesh::Mesh(const MeshData& meshData)
 	{
 		load(meshData);
@@ -15,13 +31,13 @@ namespace ew {
 	{
 		if (!m_initialized) {
 			glGenVertexArrays(1, &m_vao);
-			glBindVertexArray(m_vao);
+			renderState::bindVertexArray(m_vao);
 
 			glGenBuffers(1, &m_vbo);
-			glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+			renderState::bindBuffer(GL_ARRAY_BUFFER, m_vbo);
 
 			glGenBuffers(1, &m_ebo);
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+			renderState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
 			//Position attribute
 			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos));
 			glEnableVertexAttribArray(0);
@@ -37,9 +53,9 @@ namespace ew {
 			m_initialized = true;
 		}
 
-		glBindVertexArray(m_vao);
-		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+		renderState::bindVertexArray(m_vao);
+		renderState::bindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		renderState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
 
 		if (meshData.vertices.size() > 0) {
 			glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * meshData.vertices.size(), meshData.vertices.data(), GL_STATIC_DRAW);
@@ -49,14 +65,22 @@ namespace ew {
 		}
 		m_numVertices = meshData.vertices.size();
 		m_numIndices = meshData.indices.size();
+		//Hand built MeshData may not have bounds yet
+		if (meshData.bounds.isEmpty() && !meshData.vertices.empty()) {
+			const Vertex* vertices = meshData.vertices.data();
+			ew::ComputeBounds(&vertices->pos, meshData.vertices.size(), m_bounds, m_boundingSphere, sizeof(Vertex));
+		}
+		else {
+			m_bounds = meshData.bounds;
+			m_boundingSphere = meshData.boundingSphere;
+		}
 
-		glBindVertexArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		renderState::bindVertexArray(0);
+		renderState::bindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 	void Mesh::draw(ew::DrawMode drawMode) const
 	{
-		glBindVertexArray(m_vao);
+		renderState::bindVertexArray(m_vao);
 		if (drawMode == DrawMode::TRIANGLES) {
 			glDrawElements(GL_TRIANGLES, m_numIndices, GL_UNSIGNED_INT, NULL);
 		}
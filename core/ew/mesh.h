@@ -4,6 +4,7 @@
 
 #pragma once
 #include "ewMath/ewMath.h"
+#include "ewMath/bounds.h"
 
 namespace ew {
 	struct Vertex {
@@ -15,8 +16,17 @@ namespace ew {
 	struct MeshData {
 		std::vector<Vertex> vertices;
 		std::vector<unsigned int> indices;
+		//Object space bounds of the vertices. Generators fill these in. Empty means not computed yet.
+		ew::AABB bounds = ew::EmptyAABB();
+		ew::BoundingSphere boundingSphere;
 	};
 
+	//Recomputes bounds and boundingSphere from the vertex positions. Call after editing vertices by hand.
+	void computeBounds(MeshData& meshData);
+
+	//Transforms positions and normals in place, e.g. to bake a model matrix into the vertices. Bounds are recomputed.
+	void transformMeshData(MeshData& meshData, const ew::Mat4& m);
+
 	enum class DrawMode {
 		TRIANGLES = 0,
 		POINTS = 1
@@ -30,6 +40,9 @@ namespace ew {
 		void draw(DrawMode drawMode = DrawMode::TRIANGLES)const;
 		inline int getNumVertices()const { return m_numVertices; }
 		inline int getNumIndices()const { return m_numIndices; }
+		//Object space bounds of the loaded MeshData. Use TransformAABB/TransformSphere with the model matrix for world bounds.
+		inline const ew::AABB& getBounds()const { return m_bounds; }
+		inline const ew::BoundingSphere& getBoundingSphere()const { return m_boundingSphere; }
 	private:
 		bool m_initialized = false;
 		unsigned int m_vao = 0;
@@ -37,5 +50,7 @@ namespace ew {
 		unsigned int m_ebo = 0;
 		int m_numVertices = 0;
 		int m_numIndices = 0;
+		ew::AABB m_bounds = ew::EmptyAABB();
+		ew::BoundingSphere m_boundingSphere;
 	};
 }
\ No newline at end of file
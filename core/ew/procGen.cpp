@@ -4,42 +4,53 @@
 
 
 #include "procGen.h"
+#include "ewMath/trig.h"
 #include <stdlib.h>
+#include <vector>
 
 namespace ew {
+	struct UnitCube {
+		Vertex vertices[24];
+		unsigned int indices[36];
+	};
 	/// <summary>
-	/// Helper function for createCube. Note that this is not meant to be used standalone
+	/// Builds a cube of size 1 at compile time. Each face gets its own 4 vertices so normals and UVs stay sharp.
 	/// </summary>
-	/// <param name="normal">Normal direction of the face</param>
-	/// <param name="size">Width/height of the face</param>
-	/// <param name="mesh">MeshData struct to fill</param>
-	static void createCubeFace(ew::Vec3 normal, float size, MeshData* mesh) {
-		unsigned int startVertex = mesh->vertices.size();
-		ew::Vec3 a = ew::Vec3(normal.z, normal.x, normal.y); //U axis
-		ew::Vec3 b = ew::Cross(normal, a); //V axis
-		for (int i = 0; i < 4; i++)
-		{
-			int col = i % 2;
-			int row = i / 2;
-
-			ew::Vec3 pos = normal * size * 0.5f;
-			pos -= (a + b) * size * 0.5f;
-			pos += (a * col + b * row) * size;
-			Vertex vertex;// = &mesh->vertices[mesh->vertices.size()];
-			vertex.pos = pos;
-			vertex.normal = normal;
-			vertex.uv = ew::Vec2(col, row);
-			mesh->vertices.push_back(vertex);
+	static constexpr UnitCube createUnitCube() {
+		constexpr ew::Vec3 normals[6] = {
+			{ +0.0f,+0.0f,+1.0f }, //Front
+			{ +1.0f,+0.0f,+0.0f }, //Right
+			{ +0.0f,+1.0f,+0.0f }, //Top
+			{ -1.0f,+0.0f,+0.0f }, //Left
+			{ +0.0f,-1.0f,+0.0f }, //Bottom
+			{ +0.0f,+0.0f,-1.0f }  //Back
+		};
+		UnitCube cube{};
+		for (int face = 0; face < 6; face++) {
+			ew::Vec3 normal = normals[face];
+			ew::Vec3 a = ew::Vec3(normal.z, normal.x, normal.y); //U axis
+			ew::Vec3 b = ew::Cross(normal, a); //V axis
+			for (int i = 0; i < 4; i++) {
+				int col = i % 2;
+				int row = i / 2;
+				Vertex& vertex = cube.vertices[face * 4 + i];
+				vertex.pos = normal * 0.5f - (a + b) * 0.5f + a * (float)col + b * (float)row;
+				vertex.normal = normal;
+				vertex.uv = ew::Vec2((float)col, (float)row);
+			}
+			const unsigned int start = face * 4;
+			const unsigned int faceIndices[6] = { start, start + 1, start + 3, start + 3, start + 2, start };
+			for (int i = 0; i < 6; i++) {
+				cube.indices[face * 6 + i] = faceIndices[i];
+			}
 		}
-
-		//Indices
-		mesh->indices.push_back(startVertex);
-		mesh->indices.push_back(startVertex + 1);
-		mesh->indices.push_back(startVertex + 3);
-		mesh->indices.push_back(startVertex + 3);
-		mesh->indices.push_back(startVertex + 2);
-		mesh->indices.push_back(startVertex);
+		return cube;
 	}
+	static constexpr UnitCube UNIT_CUBE = createUnitCube();
+	static_assert(UNIT_CUBE.vertices[0].pos.x == -0.5f && UNIT_CUBE.vertices[0].pos.z == 0.5f, "Front face starts at the bottom left");
+	static_assert(UNIT_CUBE.vertices[23].normal.z == -1.0f, "Back face is last");
+	static_assert(UNIT_CUBE.indices[35] == 20, "Last triangle closes the back face");
+
 	/// <summary>
 	/// Creates a cube of uniform size
 	/// </summary>
@@ -47,14 +58,13 @@ namespace ew {
 	/// <param name="mesh">MeshData struct to fill. Will be cleared.</param>
 	MeshData createCube(float size) {
 		MeshData mesh;
-		mesh.vertices.reserve(24); //6 x 4 vertices
-		mesh.indices.reserve(36); //6 x 6 indices
-		createCubeFace(ew::Vec3{ +0.0f,+0.0f,+1.0f }, size, &mesh); //Front
-		createCubeFace(ew::Vec3{ +1.0f,+0.0f,+0.0f }, size, &mesh); //Right
-		createCubeFace(ew::Vec3{ +0.0f,+1.0f,+0.0f }, size, &mesh); //Top
-		createCubeFace(ew::Vec3{ -1.0f,+0.0f,+0.0f }, size, &mesh); //Left
-		createCubeFace(ew::Vec3{ +0.0f,-1.0f,+0.0f }, size, &mesh); //Bottom
-		createCubeFace(ew::Vec3{ +0.0f,+0.0f,-1.0f }, size, &mesh); //Back
+		mesh.vertices.assign(UNIT_CUBE.vertices, UNIT_CUBE.vertices + 24);
+		mesh.indices.assign(UNIT_CUBE.indices, UNIT_CUBE.indices + 36);
+		for (Vertex& vertex : mesh.vertices) {
+			vertex.pos *= size;
+		}
+		mesh.bounds = AABB{ Vec3(-size * 0.5f), Vec3(size * 0.5f) };
+		mesh.boundingSphere = SphereAroundAABB(mesh.bounds);
 		return mesh;
 	}
 	MeshData createPlane(float width, float height, int subdivisions)
@@ -90,24 +100,38 @@ namespace ew {
 				mesh.indices.push_back(start);
 			}
 		}
+		mesh.bounds = AABB{ Vec3(-width * 0.5f, 0.0f, -height * 0.5f), Vec3(width * 0.5f, 0.0f, height * 0.5f) };
+		mesh.boundingSphere = SphereAroundAABB(mesh.bounds);
 		return mesh;
 	}
+	/// <summary>
+	/// Shared by the ew and ns generators so each ring angle is evaluated once per mesh instead of once per vertex
+	/// </summary>
+	void sampleUnitCircle(int subdivisions, float* cosines, float* sines) {
+		//Rotating by one step per entry costs a few multiplies instead of a sin and cos
+		ew::SinCosRecurrence(0.0, 6.283185307179586 / subdivisions, sines, cosines, subdivisions);
+		cosines[subdivisions] = cosines[0];
+		sines[subdivisions] = sines[0];
+	}
 	MeshData createSphere(float radius, int subdivisions)
 	{
 		MeshData mesh;
+		mesh.vertices.reserve((subdivisions + 1) * (subdivisions + 1));
+		mesh.indices.reserve(subdivisions * (subdivisions - 1) * 6);
 		//VERTICES
-		float thetaStep = ew::TAU / subdivisions;
-		float phiStep = ew::PI / subdivisions;
+		//Theta goes all the way around, phi half way. Phi's angles are the first half of a circle with twice the steps.
+		std::vector<float> cosTheta(subdivisions + 1), sinTheta(subdivisions + 1);
+		std::vector<float> cosPhi(subdivisions * 2 + 1), sinPhi(subdivisions * 2 + 1);
+		sampleUnitCircle(subdivisions, cosTheta.data(), sinTheta.data());
+		sampleUnitCircle(subdivisions * 2, cosPhi.data(), sinPhi.data());
 		for (size_t row = 0; row <= subdivisions; row++)
 		{
-			float phi = row * phiStep;
 			for (size_t col = 0; col <= subdivisions; col++)
 			{
-				float theta = thetaStep * col;
 				Vertex v;
-				v.normal.x = cosf(theta) * sinf(phi);
-				v.normal.y = cosf(phi);
-				v.normal.z = sinf(theta) * sinf(phi);
+				v.normal.x = cosTheta[col] * sinPhi[row];
+				v.normal.y = cosPhi[row];
+				v.normal.z = sinTheta[col] * sinPhi[row];
 				v.pos = v.normal * radius;
 				v.uv.x = (float)col / subdivisions;
 				v.uv.y = 1.0 - ((float)row / subdivisions);
@@ -149,15 +173,15 @@ namespace ew {
 			mesh.indices.push_back(sideStart + i + 1);
 			mesh.indices.push_back(poleStart + i);
 		}
+		mesh.bounds = AABB{ Vec3(-radius), Vec3(radius) };
+		mesh.boundingSphere.radius = radius;
 		return mesh;
 	}
-	void createCylinderRing(MeshData* meshData, float radius, int subdivisions, float y, bool sideFacing) {
-		float thetaStep = ew::TAU / subdivisions;
+	static void createCylinderRing(MeshData* meshData, const float* cosines, const float* sines, float radius, int subdivisions, float y, bool sideFacing) {
 		for (size_t i = 0; i <= subdivisions; i++)
 		{
-			float theta = i * thetaStep;
-			float cosA = cosf(theta);
-			float sinA = sinf(theta);
+			float cosA = cosines[i];
+			float sinA = sines[i];
 			ew::Vertex v;
 			v.pos = ew::Vec3(cosA * radius, y, sinA * radius);
 			if (sideFacing) {
@@ -175,9 +199,13 @@ namespace ew {
 	MeshData createCylinder(float radius, float height, int subdivisions)
 	{
 		MeshData mesh;
+		mesh.vertices.reserve((subdivisions + 1) * 4 + 2);
 
 		//VERTICES
 		{
+			//All four rings share one set of angles
+			std::vector<float> cosines(subdivisions + 1), sines(subdivisions + 1);
+			sampleUnitCircle(subdivisions, cosines.data(), sines.data());
 			const float topY = height * 0.5;
 			const float bottomY = -topY;
 
@@ -187,10 +215,10 @@ namespace ew {
 			topVertex.uv = ew::Vec2(0.5);
 			mesh.vertices.push_back(topVertex);
 
-			createCylinderRing(&mesh, radius, subdivisions, topY, false);
-			createCylinderRing(&mesh, radius, subdivisions, topY, true);
-			createCylinderRing(&mesh, radius, subdivisions, bottomY, true);
-			createCylinderRing(&mesh, radius, subdivisions, bottomY, false);
+			createCylinderRing(&mesh, cosines.data(), sines.data(), radius, subdivisions, topY, false);
+			createCylinderRing(&mesh, cosines.data(), sines.data(), radius, subdivisions, topY, true);
+			createCylinderRing(&mesh, cosines.data(), sines.data(), radius, subdivisions, bottomY, true);
+			createCylinderRing(&mesh, cosines.data(), sines.data(), radius, subdivisions, bottomY, false);
 
 			ew::Vertex bottomVertex;
 			bottomVertex.pos = ew::Vec3(0, bottomY, 0);
@@ -232,6 +260,9 @@ namespace ew {
 				mesh.indices.push_back(sideStart + i + 1);
 			}
 		}
+		mesh.bounds = AABB{ Vec3(-radius, -height * 0.5f, -radius), Vec3(radius, height * 0.5f, radius) };
+		//Rim to center, tighter than the box's corners
+		mesh.boundingSphere.radius = sqrtf(radius * radius + height * height * 0.25f);
 		return mesh;
 	}
 }
\ No newline at end of file
@@ -11,4 +11,7 @@ namespace ew {
 	MeshData createPlane(float width, float height, int subdivisions);
 	MeshData createSphere(float radius, int subdivisions);
 	MeshData createCylinder(float radius, float height, int subdivisions);
+	//cos and sin of subdivisions + 1 evenly spaced angles from 0 to TAU, for generators that build rings.
+	//The last entry is a copy of the first, so seam vertices match exactly. Arrays must hold subdivisions + 1 floats.
+	void sampleUnitCircle(int subdivisions, float* cosines, float* sines);
 }
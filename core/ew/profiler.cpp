@@ -0,0 +1,296 @@
+#include "profiler.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <imgui.h>
+#include "external/glad.h"
+
+namespace ew {
+	Profiler::Profiler()
+		:m_epoch(std::chrono::steady_clock::now())
+	{
+	}
+	Profiler::~Profiler()
+	{
+		for (FrameQueries& frame : m_frames) {
+			if (!frame.pool.empty()) {
+				glDeleteQueries((GLsizei)frame.pool.size(), frame.pool.data());
+			}
+		}
+	}
+	int64_t Profiler::now() const
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_epoch).count();
+	}
+	int Profiler::findScope(const char* name) const
+	{
+		for (size_t i = 0; i < m_scopes.size(); i++) {
+			if (m_scopes[i].name == name) {
+				return (int)i;
+			}
+		}
+		return -1;
+	}
+	int Profiler::getScope(const char* name)
+	{
+		int scope = findScope(name);
+		if (scope < 0) {
+			m_scopes.emplace_back();
+			m_scopes.back().name = name;
+			scope = (int)m_scopes.size() - 1;
+		}
+		return scope;
+	}
+	void Profiler::addSample(float* history, int& count, float value)
+	{
+		history[count % HISTORY] = value;
+		count++;
+	}
+	ProfileStats Profiler::computeStats(const float* history, int count)
+	{
+		ProfileStats stats;
+		stats.numSamples = std::min(count, (int)HISTORY);
+		if (stats.numSamples == 0) {
+			return stats;
+		}
+		float sorted[HISTORY];
+		memcpy(sorted, history, sizeof(float) * stats.numSamples);
+		std::sort(sorted, sorted + stats.numSamples);
+		float total = 0.0f;
+		for (int i = 0; i < stats.numSamples; i++) {
+			total += sorted[i];
+		}
+		stats.min = sorted[0];
+		stats.avg = total / stats.numSamples;
+		stats.p99 = sorted[(stats.numSamples * 99 + 99) / 100 - 1];
+		return stats;
+	}
+	/// <summary>
+	/// Records the previous frame's CPU time and collects GPU results from QUERY_LATENCY frames ago.
+	/// Queries that are still not available are dropped rather than waited on.
+	/// </summary>
+	void Profiler::beginFrame()
+	{
+		int64_t frameStart = now();
+		if (m_frameStart >= 0) {
+			int scope = getScope("Frame");
+			addSample(m_scopes[scope].cpuHistory, m_scopes[scope].cpuCount, (frameStart - m_frameStart) / 1000.0f);
+			if (m_capturing && m_trace.size() < MAX_TRACE_EVENTS) {
+				m_trace.push_back({ scope, false, m_frameStart, frameStart - m_frameStart });
+			}
+		}
+		m_frameStart = frameStart;
+
+		//Scopes left open by the last frame can not be matched up any more
+		if (m_gpuQueryOpen) {
+			glEndQuery(GL_TIME_ELAPSED);
+			m_gpuQueryOpen = false;
+		}
+		m_stack.clear();
+
+		m_frameIndex++;
+		FrameQueries& frame = m_frames[m_frameIndex % QUERY_LATENCY];
+		for (size_t i = 0; i < frame.pending.size(); i++) {
+			const PendingQuery& pending = frame.pending[i];
+			GLuint available = 0;
+			glGetQueryObjectuiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) {
+				//Replace the query so the next frame does not reuse one that is still in flight
+				glDeleteQueries(1, &frame.pool[i]);
+				glGenQueries(1, &frame.pool[i]);
+				continue;
+			}
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &elapsed);
+			Scope& scope = m_scopes[pending.scope];
+			addSample(scope.gpuHistory, scope.gpuCount, elapsed / 1000000.0f);
+			if (m_capturing && m_trace.size() < MAX_TRACE_EVENTS) {
+				//GPU start times are not queried, so events are placed at the CPU start
+				m_trace.push_back({ pending.scope, true, pending.cpuStart, (int64_t)(elapsed / 1000) });
+			}
+		}
+		frame.pending.clear();
+	}
+	void Profiler::begin(const char* name)
+	{
+		OpenScope open;
+		open.scope = getScope(name);
+		open.query = -1;
+		if (!m_gpuQueryOpen) {
+			FrameQueries& frame = m_frames[m_frameIndex % QUERY_LATENCY];
+			size_t index = frame.pending.size();
+			if (index == frame.pool.size()) {
+				GLuint query;
+				glGenQueries(1, &query);
+				frame.pool.push_back(query);
+			}
+			frame.pending.push_back({ open.scope, 0, frame.pool[index] });
+			glBeginQuery(GL_TIME_ELAPSED, frame.pool[index]);
+			m_gpuQueryOpen = true;
+			open.query = (int)index;
+		}
+		open.cpuStart = now();
+		if (open.query >= 0) {
+			m_frames[m_frameIndex % QUERY_LATENCY].pending[open.query].cpuStart = open.cpuStart;
+		}
+		m_stack.push_back(open);
+	}
+	void Profiler::end()
+	{
+		if (m_stack.empty()) {
+			return;
+		}
+		int64_t cpuEnd = now();
+		OpenScope open = m_stack.back();
+		m_stack.pop_back();
+		if (open.query >= 0) {
+			glEndQuery(GL_TIME_ELAPSED);
+			m_gpuQueryOpen = false;
+		}
+		Scope& scope = m_scopes[open.scope];
+		addSample(scope.cpuHistory, scope.cpuCount, (cpuEnd - open.cpuStart) / 1000.0f);
+		if (m_capturing && m_trace.size() < MAX_TRACE_EVENTS) {
+			m_trace.push_back({ open.scope, false, open.cpuStart, cpuEnd - open.cpuStart });
+		}
+	}
+	ProfileStats Profiler::getCpuStats(const char* name) const
+	{
+		int scope = findScope(name);
+		return scope < 0 ? ProfileStats() : computeStats(m_scopes[scope].cpuHistory, m_scopes[scope].cpuCount);
+	}
+	ProfileStats Profiler::getGpuStats(const char* name) const
+	{
+		int scope = findScope(name);
+		return scope < 0 ? ProfileStats() : computeStats(m_scopes[scope].gpuHistory, m_scopes[scope].gpuCount);
+	}
+	void Profiler::drawImGui()
+	{
+		ImGui::Begin("Profiler");
+		ImGui::Text("Last %d frames, milliseconds", HISTORY);
+		if (ImGui::BeginTable("Scopes", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+			ImGui::TableSetupColumn("Scope");
+			ImGui::TableSetupColumn("CPU min");
+			ImGui::TableSetupColumn("CPU avg");
+			ImGui::TableSetupColumn("CPU p99");
+			ImGui::TableSetupColumn("GPU min");
+			ImGui::TableSetupColumn("GPU avg");
+			ImGui::TableSetupColumn("GPU p99");
+			ImGui::TableHeadersRow();
+			for (const Scope& scope : m_scopes) {
+				ProfileStats cpu = computeStats(scope.cpuHistory, scope.cpuCount);
+				ProfileStats gpu = computeStats(scope.gpuHistory, scope.gpuCount);
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%s", scope.name.c_str());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", cpu.min);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", cpu.avg);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", cpu.p99);
+				if (gpu.numSamples > 0) {
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", gpu.min);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", gpu.avg);
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", gpu.p99);
+				}
+			}
+			ImGui::EndTable();
+		}
+		if (!m_counters.empty() && ImGui::BeginTable("Counters", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+			ImGui::TableSetupColumn("Counter");
+			ImGui::TableSetupColumn("Value");
+			ImGui::TableHeadersRow();
+			for (const Counter& counter : m_counters) {
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%s", counter.name.c_str());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.0f", counter.value);
+			}
+			ImGui::EndTable();
+		}
+		bool capture = m_capturing;
+		if (ImGui::Checkbox("Capture trace", &capture)) {
+			setTraceCapture(capture);
+		}
+		ImGui::SameLine();
+		ImGui::Text("%d events", (int)m_trace.size());
+		if (ImGui::Button("Write profile_trace.json")) {
+			writeChromeTrace("profile_trace.json");
+		}
+		ImGui::End();
+	}
+	void Profiler::setTraceCapture(bool capture)
+	{
+		if (capture && !m_capturing) {
+			m_trace.clear();
+			m_counterTrace.clear();
+		}
+		m_capturing = capture;
+	}
+	void Profiler::setCounter(const char* name, double value)
+	{
+		int counter = 0;
+		while (counter < (int)m_counters.size() && m_counters[counter].name != name) {
+			counter++;
+		}
+		if (counter == (int)m_counters.size()) {
+			m_counters.push_back({ name });
+		}
+		m_counters[counter].value = value;
+		if (m_capturing && m_counterTrace.size() < MAX_TRACE_EVENTS) {
+			m_counterTrace.push_back({ counter, now(), value });
+		}
+	}
+	double Profiler::getCounter(const char* name) const
+	{
+		for (const Counter& counter : m_counters) {
+			if (counter.name == name) {
+				return counter.value;
+			}
+		}
+		return 0.0;
+	}
+	static std::string escapeJson(const std::string& text)
+	{
+		std::string escaped;
+		for (char c : text) {
+			if (c == '"' || c == '\\') {
+				escaped += '\\';
+			}
+			escaped += c;
+		}
+		return escaped;
+	}
+	/// <summary>
+	/// Writes complete ("X") events, CPU scopes on thread 1 and GPU scopes on thread 2, and counter ("C") events
+	/// </summary>
+	/// <param name="filePath">Output .json path</param>
+	/// <returns>False if the file could not be opened</returns>
+	bool Profiler::writeChromeTrace(const char* filePath) const
+	{
+		FILE* file = fopen(filePath, "w");
+		if (file == NULL) {
+			printf("Failed to open %s for writing\n", filePath);
+			return false;
+		}
+		fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+		fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+		for (const TraceEvent& event : m_trace) {
+			fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%d}",
+				escapeJson(m_scopes[event.scope].name).c_str(), event.gpu ? "gpu" : "cpu", (long long)event.start, (long long)event.duration, event.gpu ? 2 : 1);
+		}
+		for (const CounterEvent& event : m_counterTrace) {
+			fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%lld,\"pid\":1,\"args\":{\"value\":%.17g}}",
+				escapeJson(m_counters[event.counter].name).c_str(), (long long)event.time, event.value);
+		}
+		fprintf(file, "\n]}\n");
+		fclose(file);
+		printf("Wrote %d trace events to %s\n", (int)(m_trace.size() + m_counterTrace.size()), filePath);
+		return true;
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <chrono>
+
+namespace ew {
+	//Rolling statistics for one scope, in milliseconds
+	struct ProfileStats {
+		float min = 0.0f;
+		float avg = 0.0f;
+		float p99 = 0.0f;
+		int numSamples = 0;
+	};
+
+	//Times named scopes on the CPU with steady_clock and on the GPU with GL_TIME_ELAPSED queries.
+	//GPU results are read back QUERY_LATENCY frames later, and only if they are already available,
+	//so the profiler never waits on the GPU. A late result is dropped instead.
+	//GL_TIME_ELAPSED queries cannot nest, so a scope opened inside another one is timed on the CPU only.
+	class Profiler {
+	public:
+		static const int QUERY_LATENCY = 3; //Frames in flight before a query is read
+		static const int HISTORY = 240; //Samples kept per scope for min/avg/p99
+		static const size_t MAX_TRACE_EVENTS = 200000;
+
+		Profiler();
+		~Profiler();
+		Profiler(const Profiler&) = delete;
+		Profiler& operator=(const Profiler&) = delete;
+
+		//Call at the start of each frame, with the GL context current
+		void beginFrame();
+		void begin(const char* name);
+		void end();
+
+		ProfileStats getCpuStats(const char* name)const;
+		ProfileStats getGpuStats(const char* name)const;
+		//Named values sampled once a frame, like bytes resident. Listed under the scopes, and written to the
+		//trace as counter tracks while capturing.
+		void setCounter(const char* name, double value);
+		double getCounter(const char* name)const;
+		//Draws a table of every scope. Call between ImGui::NewFrame and ImGui::Render.
+		void drawImGui();
+
+		//While capturing, every scope is kept as a trace event (up to MAX_TRACE_EVENTS)
+		void setTraceCapture(bool capture);
+		inline bool isCapturingTrace()const { return m_capturing; }
+		//Writes captured events in Chrome's trace event format (chrome://tracing, Perfetto)
+		bool writeChromeTrace(const char* filePath)const;
+	private:
+		struct Scope {
+			std::string name;
+			float cpuHistory[HISTORY];
+			float gpuHistory[HISTORY];
+			int cpuCount = 0;
+			int gpuCount = 0;
+		};
+		struct OpenScope {
+			int scope;
+			int64_t cpuStart; //Microseconds since profiler creation
+			int query; //Index into the frame's queries, -1 if CPU only
+		};
+		struct PendingQuery {
+			int scope;
+			int64_t cpuStart;
+			unsigned int query;
+		};
+		struct FrameQueries {
+			std::vector<unsigned int> pool; //Query objects owned by this frame slot
+			std::vector<PendingQuery> pending;
+		};
+		struct TraceEvent {
+			int scope;
+			bool gpu;
+			int64_t start; //Microseconds
+			int64_t duration;
+		};
+		struct Counter {
+			std::string name;
+			double value = 0.0;
+		};
+		struct CounterEvent {
+			int counter;
+			int64_t time; //Microseconds
+			double value;
+		};
+
+		int findScope(const char* name)const;
+		int getScope(const char* name);
+		int64_t now()const;
+		static void addSample(float* history, int& count, float value);
+		static ProfileStats computeStats(const float* history, int count);
+
+		std::chrono::steady_clock::time_point m_epoch;
+		std::vector<Scope> m_scopes;
+		std::vector<OpenScope> m_stack;
+		FrameQueries m_frames[QUERY_LATENCY];
+		int m_frameIndex = 0;
+		bool m_gpuQueryOpen = false;
+		int64_t m_frameStart = -1;
+		bool m_capturing = false;
+		std::vector<TraceEvent> m_trace;
+		std::vector<Counter> m_counters;
+		std::vector<CounterEvent> m_counterTrace;
+	};
+
+	//Times the enclosing block
+	class ProfileScope {
+	public:
+		ProfileScope(Profiler& profiler, const char* name) :m_profiler(profiler) { m_profiler.begin(name); }
+		~ProfileScope() { m_profiler.end(); }
+	private:
+		Profiler& m_profiler;
+	};
+}
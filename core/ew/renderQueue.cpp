@@ -0,0 +1,199 @@
+#include "renderQueue.h"
+#include <string.h>
+#include "renderState.h"
+#include "external/glad.h"
+
+namespace ew {
+	void MaterialBinding::bind() const
+	{
+		for (const TextureBinding& binding : textures) {
+			renderState::bindTexture(binding.unit, binding.target, binding.texture);
+		}
+	}
+
+	RenderQueue::RenderQueue()
+	{
+		m_view = ew::IdentityMatrix();
+		m_passStates[(int)RenderPass::SOLID] = { GL_BACK, GL_LESS, true, false };
+		m_passStates[(int)RenderPass::SKYBOX] = { GL_FRONT, GL_LEQUAL, true, false };
+		m_passStates[(int)RenderPass::BLENDED] = { GL_BACK, GL_LESS, false, true };
+	}
+	void RenderQueue::begin(const Camera& camera)
+	{
+		m_view = camera.ViewMatrix();
+		m_nearPlane = camera.nearPlane;
+		m_packets.clear();
+		//Ids only need to group one frame's draws. Starting over keeps them dense, so they stay inside their key
+		//fields, and drops pointers to objects that have since been freed.
+		m_programIds.clear();
+		m_materialIds.clear();
+		m_meshIds.clear();
+	}
+	void RenderQueue::submit(const DrawPacket& packet)
+	{
+		m_packets.push_back(packet);
+	}
+	void RenderQueue::setPassState(RenderPass pass, const PassState& state)
+	{
+		m_passStates[(int)pass] = state;
+	}
+	uint32_t RenderQueue::getId(std::unordered_map<const void*, uint32_t>& ids, const void* object)
+	{
+		auto it = ids.find(object);
+		if (it != ids.end()) {
+			return it->second;
+		}
+		uint32_t id = (uint32_t)ids.size();
+		ids[object] = id;
+		return id;
+	}
+	/// <summary>
+	/// Packs draw state into a key whose ascending order is the submission order.
+	/// Ids wider than their field wrap, which only costs some grouping.
+	/// </summary>
+	/// <param name="depth">View depth normalized to 0-1. Clamped.</param>
+	/// <returns></returns>
+	uint64_t RenderQueue::makeSortKey(RenderPass pass, uint32_t program, uint32_t material, float depth, uint32_t mesh)
+	{
+		const uint64_t DEPTH_MAX = (1 << 24) - 1;
+		depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+		uint64_t depthBits = (uint64_t)(depth * DEPTH_MAX);
+		uint64_t key = (uint64_t)((uint32_t)pass & 0xF) << 60;
+		if (pass == RenderPass::BLENDED) {
+			key |= (DEPTH_MAX - depthBits) << 36;
+			key |= (uint64_t)(program & 0x3FF) << 26;
+			key |= (uint64_t)(material & 0x3FFF) << 12;
+		}
+		else {
+			key |= (uint64_t)(program & 0x3FF) << 50;
+			key |= (uint64_t)(material & 0x3FFF) << 36;
+			key |= depthBits << 12;
+		}
+		key |= (uint64_t)(mesh & 0xFFF);
+		return key;
+	}
+	/// <summary>
+	/// The 24 bit key field then resolves distance finely up close and more coarsely far away, like the depth buffer
+	/// </summary>
+	float RenderQueue::makeSortDepth(float viewDistance, float nearPlane)
+	{
+		return viewDistance > nearPlane ? 1.0f - nearPlane / viewDistance : 0.0f;
+	}
+	void RenderQueue::radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch)
+	{
+		const size_t count = entries.size();
+		if (count < 2) {
+			return;
+		}
+		scratch.resize(count);
+
+		//Count all 8 digit histograms in one read of the keys
+		uint32_t histograms[8][256];
+		memset(histograms, 0, sizeof(histograms));
+		for (size_t i = 0; i < count; i++) {
+			uint64_t key = entries[i].key;
+			for (int digit = 0; digit < 8; digit++) {
+				histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+			}
+		}
+
+		SortEntry* src = entries.data();
+		SortEntry* dst = scratch.data();
+		for (int digit = 0; digit < 8; digit++) {
+			uint32_t* histogram = histograms[digit];
+			const int shift = digit * 8;
+			//Every key has the same byte here, so this pass would not move anything
+			if (histogram[(src[0].key >> shift) & 0xFF] == count) {
+				continue;
+			}
+			uint32_t offset = 0;
+			for (int bucket = 0; bucket < 256; bucket++) {
+				uint32_t bucketCount = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += bucketCount;
+			}
+			for (size_t i = 0; i < count; i++) {
+				dst[histogram[(src[i].key >> shift) & 0xFF]++] = src[i];
+			}
+			SortEntry* temp = src;
+			src = dst;
+			dst = temp;
+		}
+		if (src != entries.data()) {
+			entries.swap(scratch);
+		}
+	}
+	void RenderQueue::flush()
+	{
+		//Build keys
+		m_entries.resize(m_packets.size());
+		for (size_t i = 0; i < m_packets.size(); i++) {
+			const DrawPacket& packet = m_packets[i];
+			ew::Vec4 viewPos = m_view * packet.model[3];
+			m_entries[i].key = makeSortKey(packet.pass,
+				getId(m_programIds, packet.shader),
+				packet.material ? getId(m_materialIds, packet.material) + 1 : 0,
+				makeSortDepth(-viewPos.z, m_nearPlane),
+				getId(m_meshIds, packet.mesh));
+			m_entries[i].index = (uint32_t)i;
+		}
+		radixSort(m_entries, m_scratch);
+
+		//Submit, only touching state that differs from the previous draw
+		int pass = -1;
+		const Shader* shader = nullptr;
+		const MaterialBinding* material = nullptr;
+		const char* label = nullptr;
+		for (const SortEntry& entry : m_entries) {
+			const DrawPacket& packet = m_packets[entry.index];
+			if (m_profiler && packet.label != label && (!packet.label || !label || strcmp(packet.label, label) != 0)) {
+				if (label) {
+					m_profiler->end();
+				}
+				label = packet.label;
+				if (label) {
+					m_profiler->begin(label);
+				}
+			}
+			if ((int)packet.pass != pass) {
+				pass = (int)packet.pass;
+				const PassState& state = m_passStates[pass];
+				renderState::cullFace(state.cullFace);
+				renderState::depthFunc(state.depthFunc);
+				renderState::depthMask(state.depthWrite);
+				renderState::setEnabled(GL_BLEND, state.blend);
+				if (state.blend) {
+					renderState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+				}
+			}
+			if (packet.shader != shader) {
+				shader = packet.shader;
+				shader->use();
+			}
+			if (packet.material != material) {
+				material = packet.material;
+				if (material) {
+					material->bind();
+				}
+			}
+			shader->setMat4("_Model", packet.model);
+			shader->setMat4("_NormalMatrix", ew::NormalMatrix(packet.model));
+			if (packet.setUniforms) {
+				packet.setUniforms(*shader, packet.userData);
+			}
+			packet.mesh->draw(packet.drawMode);
+		}
+		if (label) {
+			m_profiler->end();
+		}
+
+		//Leave the default state for whatever draws next (and for glClear to write depth)
+		const PassState& state = m_passStates[(int)RenderPass::SOLID];
+		renderState::cullFace(state.cullFace);
+		renderState::depthFunc(state.depthFunc);
+		renderState::depthMask(state.depthWrite);
+		renderState::setEnabled(GL_BLEND, state.blend);
+
+		m_packets.clear();
+	}
+}
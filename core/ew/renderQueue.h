@@ -0,0 +1,97 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include "mesh.h"
+#include "shader.h"
+#include "camera.h"
+#include "profiler.h"
+
+namespace ew {
+	//Passes are drawn in this order
+	enum class RenderPass {
+		SOLID = 0, //Opaque, front to back, grouped by program and material
+		SKYBOX = 1, //Drawn behind everything with depth func LEQUAL
+		BLENDED = 2 //Transparent, back to front, no depth writes
+	};
+
+	struct TextureBinding {
+		unsigned int unit; //0-based texture unit
+		unsigned int target; //GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, etc.
+		unsigned int texture;
+	};
+
+	//Textures a group of draws shares. Packets with the same material are drawn together.
+	struct MaterialBinding {
+		std::vector<TextureBinding> textures;
+		void bind()const;
+	};
+
+	//GL state applied once at the start of each pass
+	struct PassState {
+		unsigned int cullFace;
+		unsigned int depthFunc;
+		bool depthWrite;
+		bool blend;
+	};
+
+	struct DrawPacket {
+		const Mesh* mesh = nullptr;
+		const Shader* shader = nullptr;
+		const MaterialBinding* material = nullptr; //Optional
+		ew::Mat4 model = ew::IdentityMatrix(); //Uploaded to "_Model", and its normal matrix to "_NormalMatrix"
+		RenderPass pass = RenderPass::SOLID;
+		DrawMode drawMode = DrawMode::TRIANGLES;
+		//Optional per-draw uniforms, called after the model matrix is set
+		void (*setUniforms)(const Shader& shader, const void* userData) = nullptr;
+		const void* userData = nullptr;
+		//Profiler scope for this draw. Consecutive draws with the same label share a scope.
+		const char* label = nullptr;
+	};
+
+	//Key and packet index, sorted by key
+	struct SortEntry {
+		uint64_t key;
+		uint32_t index;
+	};
+
+	//Collects draws for a frame and submits them in an order that minimizes state changes.
+	//Per-frame uniforms (view/projection, lights) live in the program, so set them before flush().
+	class RenderQueue {
+	public:
+		RenderQueue();
+		//Starts a new frame. Depth in the sort keys is measured along this camera's view direction.
+		void begin(const Camera& camera);
+		void submit(const DrawPacket& packet);
+		//Sorts and draws everything submitted since begin(), then empties the queue
+		void flush();
+		void setPassState(RenderPass pass, const PassState& state);
+		//Labeled packets are timed by this profiler during flush(). Pass nullptr to stop.
+		inline void setProfiler(Profiler* profiler) { m_profiler = profiler; }
+		inline size_t getNumPackets()const { return m_packets.size(); }
+
+		//Key layout, most significant first:
+		//pass (4) | program (10) | material (14) | depth (24) | mesh (12)
+		//Blended draws move depth (inverted, so far sorts first) ahead of program and material.
+		static uint64_t makeSortKey(RenderPass pass, uint32_t program, uint32_t material, float depth, uint32_t mesh);
+		//Depth for the key: 1 - near / distance, reverse-Z's n / -z flipped. Needs no far plane, so it keeps
+		//distant draws apart with an infinite reverse-Z projection. 0 at or before the near plane.
+		static float makeSortDepth(float viewDistance, float nearPlane);
+		//LSD radix sort by key. Stable, and skips byte positions where every key is the same.
+		static void radixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch);
+	private:
+		uint32_t getId(std::unordered_map<const void*, uint32_t>& ids, const void* object);
+
+		ew::Mat4 m_view;
+		float m_nearPlane = 0.01f;
+		std::vector<DrawPacket> m_packets;
+		std::vector<SortEntry> m_entries;
+		std::vector<SortEntry> m_scratch;
+		//Numbered in order of first submission, starting over each begin()
+		std::unordered_map<const void*, uint32_t> m_programIds;
+		std::unordered_map<const void*, uint32_t> m_materialIds;
+		std::unordered_map<const void*, uint32_t> m_meshIds;
+		PassState m_passStates[3];
+		Profiler* m_profiler = nullptr;
+	};
+}
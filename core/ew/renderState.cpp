@@ -0,0 +1,258 @@
+#include "renderState.h"
+#include <stdio.h>
+#include "external/glad.h"
+
+namespace ew {
+	namespace renderState {
+		//Marks a cached value as not known, forcing the next call through
+		static const unsigned int UNKNOWN = 0xFFFFFFFF;
+		static const int MAX_TEXTURE_UNITS = 32;
+
+		enum TextureSlot { TEX_2D, TEX_CUBE_MAP, TEX_2D_ARRAY, TEX_3D, TEX_SLOT_COUNT };
+		enum BufferSlot { BUF_ARRAY, BUF_ELEMENT_ARRAY, BUF_UNIFORM, BUF_SHADER_STORAGE, BUF_PIXEL_PACK, BUF_PIXEL_UNPACK, BUF_DRAW_INDIRECT, BUF_SLOT_COUNT };
+		enum CapabilitySlot { CAP_CULL_FACE, CAP_DEPTH_TEST, CAP_BLEND, CAP_SLOT_COUNT };
+
+		static struct {
+			unsigned int program;
+			unsigned int vao;
+			unsigned int buffers[BUF_SLOT_COUNT];
+			unsigned int activeUnit;
+			unsigned int textures[MAX_TEXTURE_UNITS][TEX_SLOT_COUNT];
+			unsigned int capabilities[CAP_SLOT_COUNT];
+			unsigned int cullFace;
+			unsigned int depthFunc;
+			unsigned int depthMask;
+			unsigned int blendSrc, blendDst;
+		} s_state;
+
+		//Conventions rather than GL state, so invalidate() leaves this alone
+		static bool s_reverseZ = false;
+
+		static void (*s_bindObserver)(unsigned int texture, void* userData) = nullptr;
+		static void* s_bindObserverData = nullptr;
+
+		static RenderStateStats s_frame;
+		static RenderStateStats s_lastFrame;
+		//Start with everything unknown so the first call of each kind goes through
+		static const bool s_initialized = (invalidate(), true);
+
+		static int getTextureSlot(unsigned int target) {
+			switch (target) {
+			case GL_TEXTURE_2D: return TEX_2D;
+			case GL_TEXTURE_CUBE_MAP: return TEX_CUBE_MAP;
+			case GL_TEXTURE_2D_ARRAY: return TEX_2D_ARRAY;
+			case GL_TEXTURE_3D: return TEX_3D;
+			default: return -1;
+			}
+		}
+		static int getBufferSlot(unsigned int target) {
+			switch (target) {
+			case GL_ARRAY_BUFFER: return BUF_ARRAY;
+			case GL_ELEMENT_ARRAY_BUFFER: return BUF_ELEMENT_ARRAY;
+			case GL_UNIFORM_BUFFER: return BUF_UNIFORM;
+			case GL_SHADER_STORAGE_BUFFER: return BUF_SHADER_STORAGE;
+			case GL_PIXEL_PACK_BUFFER: return BUF_PIXEL_PACK;
+			case GL_PIXEL_UNPACK_BUFFER: return BUF_PIXEL_UNPACK;
+			case GL_DRAW_INDIRECT_BUFFER: return BUF_DRAW_INDIRECT;
+			default: return -1;
+			}
+		}
+		static int getCapabilitySlot(unsigned int capability) {
+			switch (capability) {
+			case GL_CULL_FACE: return CAP_CULL_FACE;
+			case GL_DEPTH_TEST: return CAP_DEPTH_TEST;
+			case GL_BLEND: return CAP_BLEND;
+			default: return -1;
+			}
+		}
+		/// <summary>
+		/// Compares a cached value with the requested one and records whether the call is needed
+		/// </summary>
+		/// <param name="cached">Cached value. Updated to value.</param>
+		/// <param name="value">Requested value</param>
+		/// <returns>True if the caller should issue the GL call</returns>
+		static bool changed(unsigned int& cached, unsigned int value) {
+			if (cached == value) {
+				s_frame.elided++;
+				return false;
+			}
+			cached = value;
+			s_frame.issued++;
+			return true;
+		}
+
+		void useProgram(unsigned int program) {
+			if (changed(s_state.program, program)) {
+				glUseProgram(program);
+			}
+		}
+		void bindVertexArray(unsigned int vao) {
+			if (changed(s_state.vao, vao)) {
+				glBindVertexArray(vao);
+				//The element array binding belongs to the VAO
+				s_state.buffers[BUF_ELEMENT_ARRAY] = UNKNOWN;
+			}
+		}
+		void bindBuffer(unsigned int target, unsigned int buffer) {
+			int slot = getBufferSlot(target);
+			if (slot < 0) {
+				s_frame.issued++;
+				glBindBuffer(target, buffer);
+			}
+			else if (changed(s_state.buffers[slot], buffer)) {
+				glBindBuffer(target, buffer);
+			}
+		}
+		void bindTexture(unsigned int unit, unsigned int target, unsigned int texture) {
+			if (s_bindObserver && texture != 0) {
+				s_bindObserver(texture, s_bindObserverData);
+			}
+			int slot = getTextureSlot(target);
+			if (slot < 0 || unit >= MAX_TEXTURE_UNITS) {
+				s_frame.issued += 2;
+				s_state.activeUnit = unit;
+				glActiveTexture(GL_TEXTURE0 + unit);
+				glBindTexture(target, texture);
+				return;
+			}
+			//The unit is made active even when the texture is already bound to it, since callers go on to
+			//edit the texture through the active unit
+			if (changed(s_state.activeUnit, unit)) {
+				glActiveTexture(GL_TEXTURE0 + unit);
+			}
+			if (changed(s_state.textures[unit][slot], texture)) {
+				glBindTexture(target, texture);
+			}
+		}
+		void setTextureBindObserver(void (*observer)(unsigned int texture, void* userData), void* userData) {
+			s_bindObserver = observer;
+			s_bindObserverData = userData;
+		}
+		void setEnabled(unsigned int capability, bool enabled) {
+			int slot = getCapabilitySlot(capability);
+			if (slot >= 0 && !changed(s_state.capabilities[slot], enabled)) {
+				return;
+			}
+			if (slot < 0) {
+				s_frame.issued++;
+			}
+			if (enabled) {
+				glEnable(capability);
+			}
+			else {
+				glDisable(capability);
+			}
+		}
+		void cullFace(unsigned int mode) {
+			if (changed(s_state.cullFace, mode)) {
+				glCullFace(mode);
+			}
+		}
+		static unsigned int reverseDepthFunc(unsigned int func) {
+			switch (func) {
+			case GL_LESS: return GL_GREATER;
+			case GL_LEQUAL: return GL_GEQUAL;
+			case GL_GREATER: return GL_LESS;
+			case GL_GEQUAL: return GL_LEQUAL;
+			default: return func;
+			}
+		}
+		void depthFunc(unsigned int func) {
+			//Cached as requested, before any flip
+			if (changed(s_state.depthFunc, func)) {
+				glDepthFunc(s_reverseZ ? reverseDepthFunc(func) : func);
+			}
+		}
+		void depthMask(bool write) {
+			if (changed(s_state.depthMask, write)) {
+				glDepthMask(write ? GL_TRUE : GL_FALSE);
+			}
+		}
+		void blendFunc(unsigned int srcFactor, unsigned int dstFactor) {
+			if (s_state.blendSrc == srcFactor && s_state.blendDst == dstFactor) {
+				s_frame.elided++;
+				return;
+			}
+			s_state.blendSrc = srcFactor;
+			s_state.blendDst = dstFactor;
+			s_frame.issued++;
+			glBlendFunc(srcFactor, dstFactor);
+		}
+		bool setReverseZ(bool enabled) {
+			if (enabled && !glClipControl) {
+				printf("Reverse-Z needs glClipControl (OpenGL 4.5)\n");
+				enabled = false;
+			}
+			if (glClipControl) {
+				glClipControl(GL_LOWER_LEFT, enabled ? GL_ZERO_TO_ONE : GL_NEGATIVE_ONE_TO_ONE);
+			}
+			glClearDepth(enabled ? 0.0 : 1.0);
+			if (enabled != s_reverseZ && s_state.depthFunc != UNKNOWN) {
+				s_frame.issued++;
+				glDepthFunc(enabled ? reverseDepthFunc(s_state.depthFunc) : s_state.depthFunc);
+			}
+			s_reverseZ = enabled;
+			return enabled;
+		}
+		bool isReverseZ() {
+			return s_reverseZ;
+		}
+		float getFarDepth() {
+			return s_reverseZ ? 0.0f : 1.0f;
+		}
+		void deleteProgram(unsigned int program) {
+			glDeleteProgram(program);
+			if (s_state.program == program) {
+				s_state.program = UNKNOWN;
+			}
+		}
+		void deleteTexture(unsigned int texture) {
+			glDeleteTextures(1, &texture);
+			//Deleting a bound texture reverts that binding to 0
+			for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+				for (int slot = 0; slot < TEX_SLOT_COUNT; slot++) {
+					if (s_state.textures[unit][slot] == texture) {
+						s_state.textures[unit][slot] = 0;
+					}
+				}
+			}
+		}
+		void deleteBuffer(unsigned int buffer) {
+			glDeleteBuffers(1, &buffer);
+			//As with textures, every target it was bound to reverts to 0
+			for (int slot = 0; slot < BUF_SLOT_COUNT; slot++) {
+				if (s_state.buffers[slot] == buffer) {
+					s_state.buffers[slot] = 0;
+				}
+			}
+		}
+		void invalidate() {
+			s_state.program = UNKNOWN;
+			s_state.vao = UNKNOWN;
+			for (int i = 0; i < BUF_SLOT_COUNT; i++) {
+				s_state.buffers[i] = UNKNOWN;
+			}
+			s_state.activeUnit = UNKNOWN;
+			for (int unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+				for (int slot = 0; slot < TEX_SLOT_COUNT; slot++) {
+					s_state.textures[unit][slot] = UNKNOWN;
+				}
+			}
+			for (int i = 0; i < CAP_SLOT_COUNT; i++) {
+				s_state.capabilities[i] = UNKNOWN;
+			}
+			s_state.cullFace = UNKNOWN;
+			s_state.depthFunc = UNKNOWN;
+			s_state.depthMask = UNKNOWN;
+			s_state.blendSrc = UNKNOWN;
+			s_state.blendDst = UNKNOWN;
+		}
+		void beginFrame() {
+			s_lastFrame = s_frame;
+			s_frame = RenderStateStats();
+		}
+		const RenderStateStats& getFrameStats() {
+			return s_lastFrame;
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+namespace ew {
+	//Counts of GL calls made through renderState during one frame
+	struct RenderStateStats {
+		unsigned int issued = 0; //Calls passed through to GL
+		unsigned int elided = 0; //Calls skipped because GL was already in that state
+	};
+
+	//Shadows the GL state that changes most often and skips calls that would not change it.
+	//Core routes its program, VAO, buffer and texture binds through here. Code that changes
+	//this state with raw GL calls must call invalidate() before going back through renderState.
+	//ImGui's OpenGL3 backend restores everything it touches, so it is safe to mix with.
+	namespace renderState {
+		void useProgram(unsigned int program);
+		void bindVertexArray(unsigned int vao);
+		void bindBuffer(unsigned int target, unsigned int buffer);
+		//Binds texture to target on texture unit (0-based, not GL_TEXTURE0 + unit) and leaves unit active
+		void bindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+		//Called with every nonzero texture passed to bindTexture, skipped binds included, to track which textures
+		//are in use (TextureManager). One observer at a time; nullptr removes it.
+		void setTextureBindObserver(void (*observer)(unsigned int texture, void* userData), void* userData);
+		//capability is GL_CULL_FACE, GL_DEPTH_TEST or GL_BLEND. Others are passed straight through.
+		void setEnabled(unsigned int capability, bool enabled);
+		void cullFace(unsigned int mode);
+		//Under reverse-Z, LESS/LEQUAL/GREATER/GEQUAL are flipped before reaching GL, so callers keep writing
+		//comparisons for the standard convention
+		void depthFunc(unsigned int func);
+		void depthMask(bool write);
+		void blendFunc(unsigned int srcFactor, unsigned int dstFactor);
+
+		//Reverse-Z depth conventions, for use with Camera::reverseZ and a float depth buffer:
+		//[0, 1] clip depth through glClipControl, depth cleared to 0 and comparisons flipped.
+		//Returns false and keeps the standard conventions if the context lacks glClipControl (GL 4.5).
+		bool setReverseZ(bool enabled);
+		bool isReverseZ();
+		//Depth of the far plane: 1, or 0 under reverse-Z. For shaders that place geometry there, like skyboxes.
+		float getFarDepth();
+
+		//Deletes the object and forgets it, so a recycled handle is not mistaken for it
+		void deleteProgram(unsigned int program);
+		void deleteTexture(unsigned int texture);
+		void deleteBuffer(unsigned int buffer);
+
+		//Forget everything. The next call of each kind will always be issued.
+		void invalidate();
+		//Call once at the start of each frame to roll the counters over
+		void beginFrame();
+		//Totals for the last completed frame
+		const RenderStateStats& getFrameStats();
+	}
+}
@@ -1,6 +1,7 @@
 #include "shader.h"
 #include <fstream>
 #include <sstream>
+#include "renderState.h"
 #include "external/glad.h"
 
 namespace ew {
@@ -45,12 +46,14 @@ namespace ew {
 	}
 
 	/// <summary>
-	/// Creates a shader program with a vertex and fragment shader
+	/// Compiles and links a shader program, reporting whether linking succeeded.
+	/// A stage that failed to compile will also cause linking to fail.
 	/// </summary>
 	/// <param name="vertexShaderSource">GLSL source code for the vertex shader</param>
 	/// <param name="fragmentShaderSource">GLSL source code for the fragment shader</param>
+	/// <param name="linked">Set to true if the program is usable</param>
 	/// <returns></returns>
-	unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource) {
+	static unsigned int buildShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource, bool* linked) {
 		unsigned int vertexShader = createShader(GL_VERTEX_SHADER, vertexShaderSource);
 		unsigned int fragmentShader = createShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
 
@@ -70,22 +73,55 @@ namespace ew {
 		//The linked program now contains our compiled code, so we can delete these intermediate objects
 		glDeleteShader(vertexShader);
 		glDeleteShader(fragmentShader);
+		*linked = success;
 		return shaderProgram;
 	}
+
+	/// <summary>
+	/// Creates a shader program with a vertex and fragment shader
+	/// </summary>
+	/// <param name="vertexShaderSource">GLSL source code for the vertex shader</param>
+	/// <param name="fragmentShaderSource">GLSL source code for the fragment shader</param>
+	/// <returns></returns>
+	unsigned int createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource) {
+		bool linked;
+		return buildShaderProgram(vertexShaderSource, fragmentShaderSource, &linked);
+	}
 	/// <summary>
 	/// Creates a shader instance with vertex + fragment stages
 	/// </summary>
 	/// <param name="vertexShader">File path to vertex shader</param>
 	/// <param name="fragmentShader">File path to fragment shader</param>
 	Shader::Shader(const std::string& vertexShader, const std::string& fragmentShader)
+		:m_vertexPath(vertexShader), m_fragmentPath(fragmentShader)
 	{
 		std::string vertexShaderSource = ew::loadShaderSourceFromFile(vertexShader.c_str());
 		std::string fragmentShaderSource = ew::loadShaderSourceFromFile(fragmentShader.c_str());
 		m_id = ew::createShaderProgram(vertexShaderSource.c_str(), fragmentShaderSource.c_str());
 	}
+	/// <summary>
+	/// Swaps in a program built from new source. The current program is only replaced
+	/// if the new one links, so a bad edit leaves the shader usable.
+	/// </summary>
+	/// <param name="vertexShaderSource">GLSL source code for the vertex shader</param>
+	/// <param name="fragmentShaderSource">GLSL source code for the fragment shader</param>
+	/// <returns>True if the new program was swapped in</returns>
+	bool Shader::reload(const std::string& vertexShaderSource, const std::string& fragmentShaderSource)
+	{
+		bool linked;
+		unsigned int program = buildShaderProgram(vertexShaderSource.c_str(), fragmentShaderSource.c_str(), &linked);
+		if (!linked) {
+			glDeleteProgram(program);
+			printf("Keeping previous version of %s + %s\n", m_vertexPath.c_str(), m_fragmentPath.c_str());
+			return false;
+		}
+		renderState::deleteProgram(m_id);
+		m_id = program;
+		return true;
+	}
 	void Shader::use()const
 	{
-		glUseProgram(m_id);
+		renderState::useProgram(m_id);
 	}
 	void Shader::setInt(const std::string& name, int v) const
 	{
@@ -8,6 +8,8 @@ namespace ew {
 	class Shader {
 	public:
 		Shader(const std::string& vertexShader, const std::string& fragmentShader);
+		//Recompiles from source. On failure the previous program is kept and false is returned.
+		bool reload(const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
 		void use()const;
 		void setInt(const std::string& name, int v) const;
 		void setFloat(const std::string& name, float v) const;
@@ -18,7 +20,11 @@ namespace ew {
 		void setVec4(const std::string& name, float x, float y, float z, float w) const;
 		void setVec4(const std::string& name, const ew::Vec4& v) const;
 		void setMat4(const std::string& name, const ew::Mat4& m) const;
+		inline const std::string& getVertexPath()const { return m_vertexPath; }
+		inline const std::string& getFragmentPath()const { return m_fragmentPath; }
 	private:
 		unsigned int m_id; //Shader program handle
+		std::string m_vertexPath;
+		std::string m_fragmentPath;
 	};
 }
\ No newline at end of file
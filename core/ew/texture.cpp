@@ -1,4 +1,8 @@
 #include "texture.h"
+#include "renderState.h"
+#include "textureCache.h"
+#include "imageResample.h"
+#include <vector>
 #include "external/glad.h"
 #include "external/stb_image.h"
 
@@ -10,35 +14,118 @@ static int getTextureFormat(int numComponents) {
 		return GL_RGB;
 	case 2:
 		return GL_RG;
+	case 1:
+		return GL_RED;
 	}
 }
 namespace ew {
-	unsigned int loadTexture(const char* filePath, int wrapMode, int filterMode) {
-		int width, height, numComponents;
-		unsigned char* data = stbi_load(filePath, &width, &height, &numComponents, 0);
-		if (data == NULL) {
+	/// <summary>
+	/// Loads an image with its prebuilt mips from the texture cache, building the cache on first use
+	/// </summary>
+	unsigned int loadTexture(const char* filePath, int wrapMode, int filterMode, TextureCompression compression) {
+		TextureImage image;
+		if (!loadTextureImage(filePath, image, false, getSupportedCompression(compression))) {
 			printf("Failed to load image %s", filePath);
-			stbi_image_free(data);
 			return 0;
 		}
+		unsigned int texture = createTexture(wrapMode, filterMode);
+		uploadTextureImage(texture, image);
+
+		renderState::bindTexture(0, GL_TEXTURE_2D, 0);
+		return texture;
+	}
+	/// <summary>
+	/// Generates a texture and sets trilinear minification, so it is ready for an image with mipmaps.
+	/// Leaves the texture bound to target on unit 0.
+	/// </summary>
+	static unsigned int createTexture(GLenum target, int wrapMode, int filterMode) {
 		unsigned int texture;
 		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		int format = getTextureFormat(numComponents);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filterMode);
+		renderState::bindTexture(0, target, texture);
+		glTexParameteri(target, GL_TEXTURE_WRAP_S, wrapMode);
+		glTexParameteri(target, GL_TEXTURE_WRAP_T, wrapMode);
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, filterMode);
 
 		float borderColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
-		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glBindTexture(GL_TEXTURE_2D, NULL);
-		stbi_image_free(data);
+		glTexParameterfv(target, GL_TEXTURE_BORDER_COLOR, borderColor);
+		return texture;
+	}
+	unsigned int createTexture(int wrapMode, int filterMode) {
+		return createTexture(GL_TEXTURE_2D, wrapMode, filterMode);
+	}
+	static unsigned int createTextureForWorker(GLenum target, int wrapMode, int filterMode, TextureCompression& compression) {
+		unsigned int texture = createTexture(target, wrapMode, filterMode);
+		renderState::bindTexture(0, target, 0);
+		compression = getSupportedCompression(compression);
 		return texture;
 	}
+	unsigned int createTextureForWorker(int wrapMode, int filterMode, TextureCompression& compression) {
+		return createTextureForWorker(GL_TEXTURE_2D, wrapMode, filterMode, compression);
+	}
+	unsigned int createTextureArray(int wrapMode, int filterMode) {
+		return createTexture(GL_TEXTURE_2D_ARRAY, wrapMode, filterMode);
+	}
+	unsigned int createTextureArrayForWorker(int wrapMode, int filterMode, TextureCompression& compression) {
+		return createTextureForWorker(GL_TEXTURE_2D_ARRAY, wrapMode, filterMode, compression);
+	}
+	/// <summary>
+	/// Loads each layer through the texture cache and uploads it into one array. The first image that loads
+	/// sets the size and format; later layers that differ are reported and left black.
+	/// </summary>
+	unsigned int loadTextureArray(const std::vector<std::string>& filePaths, int wrapMode, int filterMode, TextureCompression compression) {
+		compression = getSupportedCompression(compression);
+		unsigned int texture = 0;
+		for (size_t layer = 0; layer < filePaths.size(); layer++) {
+			TextureImage image;
+			if (!loadTextureImage(filePaths[layer].c_str(), image, false, compression)) {
+				printf("Failed to load image %s\n", filePaths[layer].c_str());
+				continue;
+			}
+			if (texture == 0) {
+				texture = createTextureArray(wrapMode, filterMode);
+				allocateTextureArray(texture, image, (int)filePaths.size());
+			}
+			if (!uploadTextureImageLayer(texture, (int)layer, image)) {
+				printf("Texture array layer %s does not match the size and format of the first layer\n", filePaths[layer].c_str());
+			}
+		}
+		renderState::bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+		return texture;
+	}
+	/// <summary>
+	/// Uploads a new level 0 image to an existing 2D texture and rebuilds its mip chain on the CPU, filtered
+	/// as the texture cache does it. Leaves the texture bound to GL_TEXTURE_2D on unit 0.
+	/// </summary>
+	/// <param name="texture">Texture handle from loadTexture</param>
+	/// <param name="numComponents">Channels per pixel (1-4)</param>
+	/// <param name="data">Tightly packed 8-bit pixels</param>
+	void setTextureImage(unsigned int texture, int width, int height, int numComponents, const unsigned char* data) {
+		renderState::bindTexture(0, GL_TEXTURE_2D, texture);
+		int format = getTextureFormat(numComponents);
+		ResampleOptions mipOptions;
+		mipOptions.filter = ResampleFilter::Kaiser;
+		mipOptions.srgbChannels = numComponents >= 3 ? 3 : 0;
+		mipOptions.numThreads = 0;
+		std::vector<unsigned char> current, next;
+		const unsigned char* mip = data;
+		int level = 0;
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		while (true) {
+			glTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0, format, GL_UNSIGNED_BYTE, mip);
+			if (width == 1 && height == 1)
+				break;
+			next.resize((size_t)getMipSize(width, 1) * getMipSize(height, 1) * numComponents);
+			downsampleImage(mip, width, height, next.data(), numComponents, PixelType::UInt8, mipOptions);
+			current.swap(next);
+			mip = current.data();
+			width = getMipSize(width, 1);
+			height = getMipSize(height, 1);
+			level++;
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level);
+	}
 }
 
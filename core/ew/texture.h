@@ -1,5 +1,24 @@
+
 #pragma once
+#include <string>
+#include <vector>
+#include "textureCache.h"
 
 namespace ew {
-	unsigned int loadTexture(const char* filePath, int wrapMode, int filterMode);
+	//compression is used if the context supports it (or the other BCn color format), else the image loads uncompressed
+	unsigned int loadTexture(const char* filePath, int wrapMode, int filterMode, TextureCompression compression = TextureCompression::None);
+	//Creates a 2D texture with loadTexture's sampling state and no image yet. Fill it with setTextureImage.
+	unsigned int createTexture(int wrapMode, int filterMode);
+	//createTexture for an image a worker thread decodes: leaves it unbound and narrows compression to what the
+	//context supports, since workers have no GL context to check with
+	unsigned int createTextureForWorker(int wrapMode, int filterMode, TextureCompression& compression);
+	//The same for a GL_TEXTURE_2D_ARRAY. Give it storage with allocateTextureArray.
+	unsigned int createTextureArray(int wrapMode, int filterMode);
+	//createTextureForWorker for a GL_TEXTURE_2D_ARRAY
+	unsigned int createTextureArrayForWorker(int wrapMode, int filterMode, TextureCompression& compression);
+	//Packs same-size images into the layers of one GL_TEXTURE_2D_ARRAY, in order, with their mips.
+	//Sampled with one sampler2DArray and one bind however many layers there are. Returns 0 if no image loads.
+	unsigned int loadTextureArray(const std::vector<std::string>& filePaths, int wrapMode, int filterMode, TextureCompression compression = TextureCompression::None);
+	//Replaces the image of an existing texture and rebuilds its mipmaps on the CPU. Filtering and wrap modes are kept.
+	void setTextureImage(unsigned int texture, int width, int height, int numComponents, const unsigned char* data);
 }
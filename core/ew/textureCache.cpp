@@ -0,0 +1,565 @@
+#include "textureCache.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <thread>
+#include <filesystem>
+#include <algorithm>
+#include <system_error>
+#include "renderState.h"
+#include "blockCompression.h"
+#include "imageResample.h"
+#include "imageDecoder.h"
+#include "external/glad.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define EW_TEXTURE_CACHE_MMAP 1
+#endif
+
+//glad is generated without the S3TC extension
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+namespace {
+	const char MAGIC[4] = { 'E', 'W', 'T', 'X' };
+	const uint32_t VERSION = 2; //2: Kaiser filtered mips
+	const uint32_t FLAG_SRGB = 1; //Mips were averaged in linear space
+	const uint32_t FLAG_FLIP_Y = 2;
+	const size_t MIP_ALIGNMENT = 16;
+
+	struct FileHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t format; //ew::TextureFormat
+		uint32_t flags;
+		uint32_t width;
+		uint32_t height;
+		uint32_t numMips;
+		uint32_t reserved;
+		uint64_t sourceSize;
+		int64_t sourceTime; //Source modification time in filesystem clock ticks
+	};
+	struct MipEntry {
+		uint64_t offset; //From the start of the file
+		uint64_t size;
+	};
+
+	//Identifies the version of the source a cache was built from
+	struct SourceStamp {
+		uint64_t size = 0;
+		int64_t time = 0;
+	};
+	bool getSourceStamp(const char* filePath, SourceStamp& stamp) {
+		std::error_code error;
+		stamp.size = std::filesystem::file_size(filePath, error);
+		if (error)
+			return false;
+		stamp.time = (int64_t)std::filesystem::last_write_time(filePath, error).time_since_epoch().count();
+		return !error;
+	}
+	std::string getCachePath(const char* filePath, bool flipY, ew::TextureCompression compression) {
+		const char* suffix = compression == ew::TextureCompression::BC1 ? ".bc1" : (compression == ew::TextureCompression::BC7 ? ".bc7" : "");
+		return std::string(filePath) + (flipY ? ".flipped" : "") + suffix + ".ewtex";
+	}
+	bool isKnownFormat(uint32_t format) {
+		return (format >= (uint32_t)ew::TextureFormat::R8 && format <= (uint32_t)ew::TextureFormat::RGBA8)
+			|| (format >= (uint32_t)ew::TextureFormat::BC1 && format <= (uint32_t)ew::TextureFormat::BC7);
+	}
+	ew::TextureFormat getCompressedFormat(int channels, ew::TextureCompression compression) {
+		switch (channels) {
+		case 1:
+			return ew::TextureFormat::BC4;
+		case 2:
+			return ew::TextureFormat::BC5;
+		case 3:
+			return compression == ew::TextureCompression::BC1 ? ew::TextureFormat::BC1 : ew::TextureFormat::BC7;
+		default:
+			return ew::TextureFormat::BC7;
+		}
+	}
+	ew::BlockFormat getBlockFormat(ew::TextureFormat format) {
+		switch (format) {
+		case ew::TextureFormat::BC1:
+			return ew::BlockFormat::BC1;
+		case ew::TextureFormat::BC4:
+			return ew::BlockFormat::BC4;
+		case ew::TextureFormat::BC5:
+			return ew::BlockFormat::BC5;
+		default:
+			return ew::BlockFormat::BC7;
+		}
+	}
+	//Bytes a mip of format takes, as build lays it out
+	uint64_t getMipBytes(ew::TextureFormat format, int width, int height) {
+		if (ew::isCompressedFormat(format))
+			return ew::getCompressedSize(getBlockFormat(format), width, height);
+		return (uint64_t)width * height * (int)format;
+	}
+	//The flags build writes for format. Color formats, and BC1 and BC7 which only color images use, are sRGB.
+	uint32_t getExpectedFlags(ew::TextureFormat format, bool flipY) {
+		const bool srgb = format == ew::TextureFormat::RGB8 || format == ew::TextureFormat::RGBA8
+			|| format == ew::TextureFormat::BC1 || format == ew::TextureFormat::BC7;
+		return (srgb ? FLAG_SRGB : 0) | (flipY ? FLAG_FLIP_Y : 0);
+	}
+	size_t alignUp(size_t offset) {
+		return (offset + MIP_ALIGNMENT - 1) & ~(MIP_ALIGNMENT - 1);
+	}
+	int countMips(int width, int height) {
+		int numMips = 1;
+		while (width > 1 || height > 1) {
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+			numMips++;
+		}
+		return numMips;
+	}
+
+	/// <summary>
+	/// Writes to a temporary file and renames it over the cache, so a reader never sees half a file
+	/// </summary>
+	bool writeCacheFile(const std::string& cachePath, const FileHeader& header, const std::vector<MipEntry>& entries, const std::vector<unsigned char>& storage, size_t dataStart) {
+		std::string tempPath = cachePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+		FILE* file = fopen(tempPath.c_str(), "wb");
+		if (!file)
+			return false;
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+			&& fwrite(entries.data(), sizeof(MipEntry), entries.size(), file) == entries.size();
+		//Padding up to the first mip, then the mips exactly as laid out in memory
+		const unsigned char zeros[MIP_ALIGNMENT] = {};
+		const size_t tableEnd = sizeof(header) + sizeof(MipEntry) * entries.size();
+		ok = ok && fwrite(zeros, 1, dataStart - tableEnd, file) == dataStart - tableEnd;
+		ok = ok && fwrite(storage.data(), 1, storage.size(), file) == storage.size();
+		ok = fclose(file) == 0 && ok;
+		std::error_code error;
+		if (ok) {
+			std::filesystem::rename(tempPath, cachePath, error);
+		}
+		if (!ok || error) {
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+		return true;
+	}
+}
+
+namespace ew {
+	//Private access for the loaders below
+	struct TextureImageAccess {
+		/// <summary>
+		/// Maps a cache file and points the mips into it. Fails if it is missing, damaged or built from another version of the source.
+		/// </summary>
+		static bool readCache(const std::string& cachePath, const SourceStamp& stamp, bool flipY, TextureCompression compression, TextureImage& image) {
+			const unsigned char* bytes = nullptr;
+			size_t size = 0;
+#if defined(EW_TEXTURE_CACHE_MMAP)
+			int fd = open(cachePath.c_str(), O_RDONLY);
+			if (fd < 0)
+				return false;
+			struct stat info;
+			if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(FileHeader)) {
+				close(fd);
+				return false;
+			}
+			size = (size_t)info.st_size;
+			void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd);
+			if (mapping == MAP_FAILED)
+				return false;
+			image.m_mapping = mapping;
+			image.m_mappingSize = size;
+			bytes = (const unsigned char*)mapping;
+#else
+			FILE* file = fopen(cachePath.c_str(), "rb");
+			if (!file)
+				return false;
+			fseek(file, 0, SEEK_END);
+			long length = ftell(file);
+			fseek(file, 0, SEEK_SET);
+			if (length < (long)sizeof(FileHeader)) {
+				fclose(file);
+				return false;
+			}
+			image.m_storage.resize((size_t)length);
+			bool read = fread(image.m_storage.data(), 1, (size_t)length, file) == (size_t)length;
+			fclose(file);
+			if (!read) {
+				image.release();
+				return false;
+			}
+			size = (size_t)length;
+			bytes = image.m_storage.data();
+#endif
+			FileHeader header;
+			memcpy(&header, bytes, sizeof(header));
+			//A header that doesn't match what build writes, or a mip of the wrong size, means the file is damaged
+			//or from another writer, so the caller decodes the source instead
+			const bool current = memcmp(header.magic, MAGIC, 4) == 0 && header.version == VERSION
+				&& header.sourceSize == stamp.size && header.sourceTime == stamp.time
+				&& isKnownFormat(header.format) && isCompressedFormat((TextureFormat)header.format) == (compression != TextureCompression::None)
+				&& header.flags == getExpectedFlags((TextureFormat)header.format, flipY)
+				&& header.width > 0 && header.height > 0 && header.width <= INT32_MAX && header.height <= INT32_MAX
+				&& header.numMips == (uint32_t)countMips((int)header.width, (int)header.height)
+				&& sizeof(FileHeader) + header.numMips * sizeof(MipEntry) <= size;
+			if (!current) {
+				image.release();
+				return false;
+			}
+			image.m_format = (TextureFormat)header.format;
+			image.m_mips.resize(header.numMips);
+			for (uint32_t level = 0; level < header.numMips; level++) {
+				MipEntry entry;
+				memcpy(&entry, bytes + sizeof(FileHeader) + level * sizeof(MipEntry), sizeof(entry));
+				TextureMip& mip = image.m_mips[level];
+				mip.width = getMipSize(header.width, level);
+				mip.height = getMipSize(header.height, level);
+				if (entry.offset > size || entry.size > size - entry.offset
+					|| entry.size != getMipBytes(image.m_format, mip.width, mip.height)) {
+					image.release();
+					return false;
+				}
+				mip.data = bytes + entry.offset;
+				mip.size = (size_t)entry.size;
+			}
+			image.m_fromCache = true;
+			return true;
+		}
+		/// <summary>
+		/// Builds the source's mip chain in one buffer laid out like the file's data section. The source decodes
+		/// straight into level 0, flipped by the decoder.
+		/// </summary>
+		static bool build(const char* filePath, bool flipY, TextureCompression compression, const SourceStamp& stamp, const std::string& cachePath, TextureImage& image) {
+			ImageFile file;
+			if (!file.open(filePath))
+				return false;
+			const int width = file.getInfo().width, height = file.getInfo().height, channels = file.getInfo().channels;
+			const int numMips = countMips(width, height);
+			const uint32_t flags = (channels >= 3 ? FLAG_SRGB : 0) | (flipY ? FLAG_FLIP_Y : 0);
+			const size_t dataStart = alignUp(sizeof(FileHeader) + numMips * sizeof(MipEntry));
+			std::vector<MipEntry> entries(numMips);
+			size_t offset = dataStart;
+			for (int level = 0; level < numMips; level++) {
+				entries[level].offset = offset;
+				entries[level].size = (size_t)getMipSize(width, level) * getMipSize(height, level) * channels;
+				offset = alignUp(offset + (size_t)entries[level].size);
+			}
+			image.release();
+			image.m_format = (TextureFormat)channels;
+			image.m_storage.assign(offset - dataStart, 0);
+			image.m_mips.resize(numMips);
+			//Each mip is filtered from the one before, which keeps the filter small at every level
+			ResampleOptions mipOptions;
+			mipOptions.filter = ResampleFilter::Kaiser;
+			mipOptions.srgbChannels = channels >= 3 ? 3 : 0;
+			mipOptions.numThreads = 0;
+			for (int level = 0; level < numMips; level++) {
+				TextureMip& mip = image.m_mips[level];
+				mip.width = getMipSize(width, level);
+				mip.height = getMipSize(height, level);
+				mip.size = (size_t)entries[level].size;
+				unsigned char* data = image.m_storage.data() + (entries[level].offset - dataStart);
+				if (level == 0) {
+					DecodeOptions decodeOptions;
+					decodeOptions.flipY = flipY;
+					if (!decodeLevel0(file, decodeOptions, data)) {
+						image.release();
+						return false;
+					}
+				}
+				else {
+					const TextureMip& parent = image.m_mips[level - 1];
+					downsampleImage(parent.data, parent.width, parent.height, data, channels, PixelType::UInt8, mipOptions);
+				}
+				mip.data = data;
+			}
+			if (compression != TextureCompression::None) {
+				compress(image, getCompressedFormat(channels, compression), dataStart, entries);
+			}
+
+			FileHeader header = {};
+			memcpy(header.magic, MAGIC, 4);
+			header.version = VERSION;
+			header.format = (uint32_t)image.m_format;
+			header.flags = flags;
+			header.width = width;
+			header.height = height;
+			header.numMips = numMips;
+			header.sourceSize = stamp.size;
+			header.sourceTime = stamp.time;
+			if (!writeCacheFile(cachePath, header, entries, image.m_storage, dataStart)) {
+				printf("Could not write texture cache %s, using the decoded image\n", cachePath.c_str());
+			}
+			return true;
+		}
+		/// <summary>
+		/// Float (.hdr) images have no cache format, so they are stored as 8 bit sRGB
+		/// </summary>
+		static bool decodeLevel0(const ImageFile& file, const DecodeOptions& options, unsigned char* data) {
+			if (file.getInfo().type == PixelType::UInt8)
+				return file.decode(data, options);
+			DecodedImage decoded;
+			if (!file.decode(decoded, options))
+				return false;
+			const float* values = (const float*)decoded.getPixels();
+			const size_t count = decoded.getSize() / sizeof(float);
+			for (size_t i = 0; i < count; i++) {
+				data[i] = linearToSrgb(values[i]);
+			}
+			return true;
+		}
+		/// <summary>
+		/// Replaces an image's uncompressed mips with block compressed ones, and their file layout with the new sizes
+		/// </summary>
+		static void compress(TextureImage& image, TextureFormat format, size_t dataStart, std::vector<MipEntry>& entries) {
+			const BlockFormat blockFormat = getBlockFormat(format);
+			const int channels = (int)image.m_format;
+			size_t offset = dataStart;
+			for (int level = 0; level < image.getNumMips(); level++) {
+				entries[level].offset = offset;
+				entries[level].size = getCompressedSize(blockFormat, image.m_mips[level].width, image.m_mips[level].height);
+				offset = alignUp(offset + (size_t)entries[level].size);
+			}
+			std::vector<unsigned char> storage(offset - dataStart, 0);
+			for (int level = 0; level < image.getNumMips(); level++) {
+				TextureMip& mip = image.m_mips[level];
+				unsigned char* blocks = storage.data() + (entries[level].offset - dataStart);
+				compressImage(mip.data, mip.width, mip.height, channels, blockFormat, blocks);
+				mip.data = blocks;
+				mip.size = (size_t)entries[level].size;
+			}
+			image.m_storage.swap(storage);
+			image.m_format = format;
+		}
+	};
+
+	TextureImage::~TextureImage() {
+		release();
+	}
+	TextureImage::TextureImage(TextureImage&& other) noexcept {
+		*this = std::move(other);
+	}
+	TextureImage& TextureImage::operator=(TextureImage&& other) noexcept {
+		if (this != &other) {
+			release();
+			m_format = other.m_format;
+			m_mips = std::move(other.m_mips);
+			m_storage = std::move(other.m_storage);
+			m_mapping = other.m_mapping;
+			m_mappingSize = other.m_mappingSize;
+			m_fromCache = other.m_fromCache;
+			other.m_mapping = nullptr;
+			other.m_mappingSize = 0;
+			other.m_mips.clear();
+		}
+		return *this;
+	}
+	void TextureImage::release() {
+#if defined(EW_TEXTURE_CACHE_MMAP)
+		if (m_mapping) {
+			munmap(m_mapping, m_mappingSize);
+		}
+#endif
+		m_mapping = nullptr;
+		m_mappingSize = 0;
+		m_mips.clear();
+		m_storage.clear();
+		m_fromCache = false;
+	}
+
+	bool loadTextureImage(const char* filePath, TextureImage& image, bool flipY, TextureCompression compression) {
+		SourceStamp stamp;
+		if (!getSourceStamp(filePath, stamp))
+			return false;
+		const std::string cachePath = getCachePath(filePath, flipY, compression);
+		if (TextureImageAccess::readCache(cachePath, stamp, flipY, compression, image)) {
+			return true;
+		}
+		return TextureImageAccess::build(filePath, flipY, compression, stamp, cachePath, image);
+	}
+	bool buildTextureImage(const char* filePath, TextureImage& image, bool flipY, TextureCompression compression) {
+		SourceStamp stamp;
+		if (!getSourceStamp(filePath, stamp))
+			return false;
+		return TextureImageAccess::build(filePath, flipY, compression, stamp, getCachePath(filePath, flipY, compression), image);
+	}
+	void getGLFormat(TextureFormat format, unsigned int& internalFormat, unsigned int& pixelFormat) {
+		static const GLenum formats[] = { 0, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+		static const GLenum internalFormats[] = { 0, GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+		static const GLenum compressedFormats[] = { GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RED_RGTC1, GL_COMPRESSED_RG_RGTC2, GL_COMPRESSED_RGBA_BPTC_UNORM };
+		if (isCompressedFormat(format)) {
+			internalFormat = compressedFormats[(int)format - (int)TextureFormat::BC1];
+			pixelFormat = 0;
+		}
+		else {
+			internalFormat = internalFormats[(int)format];
+			pixelFormat = formats[(int)format];
+		}
+	}
+	size_t getRowSize(TextureFormat format, int width) {
+		if (isCompressedFormat(format))
+			return getCompressedSize(getBlockFormat(format), width, 1);
+		return (size_t)width * (int)format;
+	}
+	int getRowHeight(TextureFormat format) {
+		return isCompressedFormat(format) ? 4 : 1;
+	}
+	/// <summary>
+	/// Respecifying level 0 at a smaller size releases the larger image. Levels past the new chain keep their
+	/// old contents, the smallest mips of the old chain, but are outside GL_TEXTURE_MAX_LEVEL.
+	/// </summary>
+	void uploadTextureImage(unsigned int texture, const TextureImage& image, int firstMip) {
+		unsigned int internalFormat, pixelFormat;
+		getGLFormat(image.getFormat(), internalFormat, pixelFormat);
+		renderState::bindTexture(0, GL_TEXTURE_2D, texture);
+		firstMip = std::min(std::max(firstMip, 0), image.getNumMips() - 1);
+		if (isCompressedFormat(image.getFormat())) {
+			for (int level = firstMip; level < image.getNumMips(); level++) {
+				const TextureMip& mip = image.getMip(level);
+				glCompressedTexImage2D(GL_TEXTURE_2D, level - firstMip, internalFormat, mip.width, mip.height, 0, (GLsizei)mip.size, mip.data);
+			}
+		}
+		else {
+			//Small mips of RGB images have rows that are not a multiple of 4 bytes
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			for (int level = firstMip; level < image.getNumMips(); level++) {
+				const TextureMip& mip = image.getMip(level);
+				glTexImage2D(GL_TEXTURE_2D, level - firstMip, internalFormat, mip.width, mip.height, 0, pixelFormat, GL_UNSIGNED_BYTE, mip.data);
+			}
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.getNumMips() - 1 - firstMip);
+	}
+	/// <summary>
+	/// Gives an array texture immutable storage for numLayers images shaped like image, every mip included
+	/// </summary>
+	void allocateTextureArray(unsigned int texture, const TextureImage& image, int numLayers) {
+		unsigned int internalFormat, pixelFormat;
+		getGLFormat(image.getFormat(), internalFormat, pixelFormat);
+		renderState::bindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, image.getNumMips(), internalFormat, image.getWidth(), image.getHeight(), numLayers);
+	}
+	/// <summary>
+	/// The array's level 0 size and format are read back from GL
+	/// </summary>
+	bool matchesTextureArray(unsigned int texture, int layer, const TextureImage& image) {
+		unsigned int internalFormat, pixelFormat;
+		getGLFormat(image.getFormat(), internalFormat, pixelFormat);
+		renderState::bindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+		GLint width = 0, height = 0, layers = 0, arrayFormat = 0;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_HEIGHT, &height);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_DEPTH, &layers);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_INTERNAL_FORMAT, &arrayFormat);
+		return width == image.getWidth() && height == image.getHeight() && (GLenum)arrayFormat == internalFormat && layer >= 0 && layer < layers;
+	}
+	/// <summary>
+	/// Uploads every mip of image into one layer. A mismatched image is refused rather than corrupting the layer.
+	/// </summary>
+	bool uploadTextureImageLayer(unsigned int texture, int layer, const TextureImage& image) {
+		if (!matchesTextureArray(texture, layer, image)) {
+			return false;
+		}
+		unsigned int internalFormat, pixelFormat;
+		getGLFormat(image.getFormat(), internalFormat, pixelFormat);
+		GLint numLevels = 0;
+		glGetTexParameteriv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_IMMUTABLE_LEVELS, &numLevels);
+		if (numLevels == 0) {
+			//Mutable storage, from uploadTextureImageArray
+			glGetTexParameteriv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, &numLevels);
+			numLevels++;
+		}
+		const int numMips = std::min(image.getNumMips(), (int)numLevels);
+		if (isCompressedFormat(image.getFormat())) {
+			for (int level = 0; level < numMips; level++) {
+				const TextureMip& mip = image.getMip(level);
+				glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, mip.width, mip.height, 1, internalFormat, (GLsizei)mip.size, mip.data);
+			}
+		}
+		else {
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			for (int level = 0; level < numMips; level++) {
+				const TextureMip& mip = image.getMip(level);
+				glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, mip.width, mip.height, 1, pixelFormat, GL_UNSIGNED_BYTE, mip.data);
+			}
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		}
+		return true;
+	}
+	/// <summary>
+	/// Each level is specified empty for every layer, then filled a layer at a time, so the first image sets
+	/// the size and format the others must match
+	/// </summary>
+	bool uploadTextureImageArray(unsigned int texture, const std::vector<TextureImage>& images, int firstMip) {
+		const TextureImage& first = images[0];
+		unsigned int internalFormat, pixelFormat;
+		getGLFormat(first.getFormat(), internalFormat, pixelFormat);
+		renderState::bindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+		firstMip = std::min(std::max(firstMip, 0), first.getNumMips() - 1);
+		const int numLayers = (int)images.size();
+		const bool compressed = isCompressedFormat(first.getFormat());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (int level = firstMip; level < first.getNumMips(); level++) {
+			const TextureMip& mip = first.getMip(level);
+			if (compressed) {
+				glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level - firstMip, internalFormat, mip.width, mip.height, numLayers, 0, (GLsizei)(mip.size * numLayers), nullptr);
+			}
+			else {
+				glTexImage3D(GL_TEXTURE_2D_ARRAY, level - firstMip, internalFormat, mip.width, mip.height, numLayers, 0, pixelFormat, GL_UNSIGNED_BYTE, nullptr);
+			}
+		}
+		bool matched = true;
+		for (int layer = 0; layer < numLayers; layer++) {
+			const TextureImage& image = images[layer];
+			if (image.getFormat() != first.getFormat() || image.getWidth() != first.getWidth() || image.getHeight() != first.getHeight()) {
+				matched = false;
+				continue;
+			}
+			for (int level = firstMip; level < image.getNumMips(); level++) {
+				const TextureMip& mip = image.getMip(level);
+				if (compressed) {
+					glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level - firstMip, 0, 0, layer, mip.width, mip.height, 1, internalFormat, (GLsizei)mip.size, mip.data);
+				}
+				else {
+					glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level - firstMip, 0, 0, layer, mip.width, mip.height, 1, pixelFormat, GL_UNSIGNED_BYTE, mip.data);
+				}
+			}
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, first.getNumMips() - 1 - firstMip);
+		return matched;
+	}
+	static bool hasExtension(const char* name) {
+		GLint numExtensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+		for (GLint i = 0; i < numExtensions; i++) {
+			if (strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), name) == 0)
+				return true;
+		}
+		return false;
+	}
+	bool isTextureFormatSupported(TextureFormat format) {
+		switch (format) {
+		case TextureFormat::BC1:
+			return hasExtension("GL_EXT_texture_compression_s3tc");
+		case TextureFormat::BC7:
+			return GLAD_GL_VERSION_4_2 || hasExtension("GL_ARB_texture_compression_bptc");
+		default:
+			//BC4 and BC5 (RGTC) are core since GL 3.0
+			return true;
+		}
+	}
+	TextureCompression getSupportedCompression(TextureCompression preferred) {
+		const bool bc1 = isTextureFormatSupported(TextureFormat::BC1);
+		const bool bc7 = isTextureFormatSupported(TextureFormat::BC7);
+		if ((preferred == TextureCompression::BC1 && bc1) || (preferred == TextureCompression::BC7 && bc7) || preferred == TextureCompression::None)
+			return preferred;
+		return bc7 ? TextureCompression::BC7 : (bc1 ? TextureCompression::BC1 : TextureCompression::None);
+	}
+}
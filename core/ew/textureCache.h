@@ -0,0 +1,110 @@
+/*
+	GPU-ready texture files, written next to the source image as <image>.ewtex.
+	The first load of an image decodes it, builds its mip chain on the CPU and writes the file.
+	Later loads map the file and upload each level as is, with no decode and no glGenerateMipmap.
+	A file is rebuilt when the source's size or modification time no longer matches its header.
+
+	Layout: FileHeader, then a (offset, size) pair per mip, then the mips from largest to smallest,
+	each starting on a 16 byte boundary. Rows are tightly packed. Little endian.
+	Compressed caches (<image>.bc1.ewtex, <image>.bc7.ewtex) hold each mip as rows of 4x4 blocks instead.
+*/
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace ew {
+	enum class TextureFormat : uint32_t {
+		R8 = 1,
+		RG8 = 2,
+		RGB8 = 3,
+		RGBA8 = 4,
+		//Block compressed, see blockCompression.h
+		BC1 = 16,
+		BC4 = 17,
+		BC5 = 18,
+		BC7 = 19
+	};
+	inline bool isCompressedFormat(TextureFormat format) { return (uint32_t)format >= (uint32_t)TextureFormat::BC1; }
+
+	//Block compression to apply when building a cache. The value picks the format for color images.
+	//One and two channel images use BC4 and BC5 with either, and RGBA images always use BC7 since BC1 has no alpha.
+	enum class TextureCompression {
+		None,
+		BC1,
+		BC7
+	};
+
+	struct TextureMip {
+		int width = 0;
+		int height = 0;
+		const unsigned char* data = nullptr;
+		size_t size = 0;
+	};
+
+	//Every mip of one image, either mapped from a cache file or built in memory. Move only.
+	class TextureImage {
+	public:
+		TextureImage() {};
+		~TextureImage();
+		TextureImage(TextureImage&& other) noexcept;
+		TextureImage& operator=(TextureImage&& other) noexcept;
+		TextureImage(const TextureImage&) = delete;
+		TextureImage& operator=(const TextureImage&) = delete;
+
+		inline bool isValid()const { return !m_mips.empty(); }
+		inline TextureFormat getFormat()const { return m_format; }
+		inline int getNumMips()const { return (int)m_mips.size(); }
+		inline const TextureMip& getMip(int level)const { return m_mips[level]; }
+		inline int getWidth()const { return m_mips.empty() ? 0 : m_mips[0].width; }
+		inline int getHeight()const { return m_mips.empty() ? 0 : m_mips[0].height; }
+		//True if the image came from an existing cache file
+		inline bool isFromCache()const { return m_fromCache; }
+
+		void release();
+	private:
+		friend struct TextureImageAccess; //Fills images in textureCache.cpp
+
+		TextureFormat m_format = TextureFormat::RGBA8;
+		std::vector<TextureMip> m_mips;
+		std::vector<unsigned char> m_storage; //Mips when built in memory or read without mmap
+		void* m_mapping = nullptr; //Mapped cache file
+		size_t m_mappingSize = 0;
+		bool m_fromCache = false;
+	};
+
+	//Loads filePath's cache, or decodes filePath, builds its mips and writes the cache.
+	//Safe to call from worker threads. flipY puts the first row at the bottom, and has its own cache file.
+	//Color images (3 or 4 channels) are treated as sRGB, so mips are filtered in linear space (imageResample.h).
+	//Each compression has its own cache file too. Check the context supports it first (getSupportedCompression).
+	bool loadTextureImage(const char* filePath, TextureImage& image, bool flipY = false, TextureCompression compression = TextureCompression::None);
+	//Decodes and rewrites the cache even if it is current. For converting assets ahead of time.
+	bool buildTextureImage(const char* filePath, TextureImage& image, bool flipY = false, TextureCompression compression = TextureCompression::None);
+	//Uploads every mip from firstMip on into texture, firstMip as level 0, and limits GL_TEXTURE_MAX_LEVEL to
+	//them. Leaves the texture bound to GL_TEXTURE_2D on unit 0.
+	void uploadTextureImage(unsigned int texture, const TextureImage& image, int firstMip = 0);
+	//Allocates every mip of a GL_TEXTURE_2D_ARRAY with numLayers layers the size and format of image.
+	//The storage is immutable, so every layer must match. Leaves the texture bound to GL_TEXTURE_2D_ARRAY on unit 0.
+	void allocateTextureArray(unsigned int texture, const TextureImage& image, int numLayers);
+	//Whether image is the size and format of texture's level 0, a GL_TEXTURE_2D_ARRAY, and the array has layer.
+	//Leaves the texture bound to GL_TEXTURE_2D_ARRAY on unit 0.
+	bool matchesTextureArray(unsigned int texture, int layer, const TextureImage& image);
+	//Uploads every mip into one layer of an array from allocateTextureArray or uploadTextureImageArray. Returns false, uploading nothing, if the image's
+	//size or format differs from the array's. Leaves the texture bound to GL_TEXTURE_2D_ARRAY on unit 0.
+	bool uploadTextureImageLayer(unsigned int texture, int layer, const TextureImage& image);
+	//uploadTextureImage for a GL_TEXTURE_2D_ARRAY with a layer per image. The storage is mutable, so unlike
+	//allocateTextureArray's it can be respecified at another size. Layers whose size or format differ from the
+	//first image's are skipped, and false returned. Leaves the texture bound to GL_TEXTURE_2D_ARRAY on unit 0.
+	bool uploadTextureImageArray(unsigned int texture, const std::vector<TextureImage>& images, int firstMip = 0);
+	//GL internal format of format, and for uncompressed formats the pixel format to upload it with
+	void getGLFormat(TextureFormat format, unsigned int& internalFormat, unsigned int& pixelFormat);
+	//Bytes per row of pixels, or per row of 4x4 blocks for compressed formats, in a mip of the given width
+	size_t getRowSize(TextureFormat format, int width);
+	//Pixel rows per row of data: 4 for compressed formats, else 1
+	int getRowHeight(TextureFormat format);
+	//Whether the current GL context can sample format. Call on the GL thread.
+	bool isTextureFormatSupported(TextureFormat format);
+	//preferred if the current context supports it, else the other color format, else None. Call on the GL thread.
+	TextureCompression getSupportedCompression(TextureCompression preferred);
+}
@@ -0,0 +1,304 @@
+#include "textureManager.h"
+#include <stdio.h>
+#include <algorithm>
+#include <imgui.h>
+#include "texture.h"
+#include "renderState.h"
+#include "imageResample.h"
+#include "external/glad.h"
+
+namespace ew {
+	TextureManager::TextureManager(AssetLoader& loader, size_t budgetBytes, int minSize)
+		:m_loader(loader), m_minSize(std::max(minSize, 1)), m_self(std::make_shared<TextureManager*>(this))
+	{
+		m_stats.budget = budgetBytes;
+		renderState::setTextureBindObserver(onBind, this);
+	}
+	TextureManager::~TextureManager()
+	{
+		renderState::setTextureBindObserver(nullptr, nullptr);
+		m_self.reset();
+		for (auto& item : m_entries) {
+			renderState::deleteTexture(item.first);
+		}
+	}
+	unsigned int TextureManager::load(const std::string& filePath, int wrapMode, int filterMode, TextureCompression compression)
+	{
+		m_uploading = true;
+		unsigned int texture = createTextureForWorker(wrapMode, filterMode, compression);
+		m_uploading = false;
+		return add(texture, { filePath }, false, compression);
+	}
+	unsigned int TextureManager::loadArray(const std::vector<std::string>& filePaths, int wrapMode, int filterMode, TextureCompression compression)
+	{
+		m_uploading = true;
+		unsigned int texture = createTextureArrayForWorker(wrapMode, filterMode, compression);
+		m_uploading = false;
+		return add(texture, filePaths, true, compression);
+	}
+	void TextureManager::reload(unsigned int texture)
+	{
+		auto found = m_entries.find(texture);
+		if (found != m_entries.end()) {
+			found->second.reload = true;
+		}
+	}
+	void TextureManager::release(unsigned int texture)
+	{
+		auto found = m_entries.find(texture);
+		if (found == m_entries.end())
+			return;
+		m_plannedBytes -= getBytes(found->second, found->second.targetMip);
+		m_entries.erase(found);
+		renderState::deleteTexture(texture);
+	}
+	/// <summary>
+	/// Restores textures bound since the last update first, so a texture coming back into view wins over idle
+	/// ones, then drops idle mips until the targets fit, then starts uploads for every texture off its target
+	/// </summary>
+	void TextureManager::update()
+	{
+		//Binds since the last update carry this frame number
+		const uint64_t used = m_frame;
+		for (auto& item : m_entries) {
+			Entry& entry = item.second;
+			if (entry.chainBytes.empty() || entry.targetMip == 0 || entry.lastUsed < used)
+				continue;
+			const size_t available = getFreeableBytes(used) + (m_stats.budget > m_plannedBytes ? m_stats.budget - m_plannedBytes : 0);
+			int mip = 0;
+			while (mip < entry.targetMip && getBytes(entry, mip) - getBytes(entry, entry.targetMip) > available) {
+				mip++;
+			}
+			if (mip < entry.targetMip && makeRoom(getBytes(entry, mip) - getBytes(entry, entry.targetMip), used)) {
+				setTarget(entry, mip);
+			}
+		}
+		makeRoom(0, used);
+
+		m_stats.residentBytes = 0;
+		m_stats.fullBytes = 0;
+		m_stats.numTextures = (int)m_entries.size();
+		m_stats.numReduced = 0;
+		m_stats.numLoading = 0;
+		for (auto& item : m_entries) {
+			Entry& entry = item.second;
+			if (!entry.loading && !entry.chainBytes.empty() && (entry.targetMip != entry.residentMip || entry.reload)) {
+				requestUpload(item.first, entry);
+			}
+			if (entry.residentMip >= 0) {
+				m_stats.residentBytes += getBytes(entry, entry.residentMip);
+			}
+			m_stats.fullBytes += getBytes(entry, 0);
+			m_stats.numReduced += entry.residentMip > 0;
+			m_stats.numLoading += entry.loading;
+		}
+		m_frame++;
+	}
+	int TextureManager::getResidentMip(unsigned int texture) const
+	{
+		auto found = m_entries.find(texture);
+		return found == m_entries.end() ? -1 : found->second.residentMip;
+	}
+	void TextureManager::drawImGui()
+	{
+		ImGui::Begin("Textures");
+		int budgetMB = (int)(m_stats.budget >> 20);
+		if (ImGui::DragInt("Budget MB", &budgetMB, 1.0f, 1, 16384)) {
+			setBudget((size_t)std::max(budgetMB, 1) << 20);
+		}
+		const double toMB = 1.0 / (1 << 20);
+		ImGui::ProgressBar(m_stats.budget > 0 ? (float)m_stats.residentBytes / m_stats.budget : 0.0f, ImVec2(-1.0f, 0.0f));
+		ImGui::Text("Resident: %.1f MB of %.1f MB at full size", m_stats.residentBytes * toMB, m_stats.fullBytes * toMB);
+		ImGui::Text("Textures: %d, reduced: %d, loading: %d", m_stats.numTextures, m_stats.numReduced, m_stats.numLoading);
+		ImGui::Text("Mips dropped: %zu, restored: %zu, uploads: %zu (%.1f MB)", m_stats.mipsDropped, m_stats.mipsRestored,
+			m_stats.uploads, m_stats.bytesUploaded * toMB);
+		if (ImGui::BeginTable("Managed textures", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0.0f, 300.0f))) {
+			ImGui::TableSetupColumn("File");
+			ImGui::TableSetupColumn("Size");
+			ImGui::TableSetupColumn("MB");
+			ImGui::TableSetupColumn("Idle frames");
+			ImGui::TableHeadersRow();
+			for (const auto& item : m_entries) {
+				const Entry& entry = item.second;
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				if (entry.isArray) {
+					ImGui::Text("%s and %d more layers", entry.filePaths[0].c_str(), (int)entry.filePaths.size() - 1);
+				}
+				else {
+					ImGui::Text("%s", entry.filePaths[0].c_str());
+				}
+				ImGui::TableNextColumn();
+				const int mip = std::max(entry.residentMip, 0);
+				ImGui::Text("%dx%d%s", getMipSize(entry.width, mip), getMipSize(entry.height, mip), entry.residentMip > 0 ? " (reduced)" : "");
+				ImGui::TableNextColumn();
+				ImGui::Text("%.2f", entry.residentMip >= 0 ? getBytes(entry, entry.residentMip) * toMB : 0.0);
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", (unsigned long long)(m_frame - std::min(entry.lastUsed, m_frame)));
+			}
+			ImGui::EndTable();
+		}
+		ImGui::End();
+	}
+	void TextureManager::exportCounters(Profiler& profiler) const
+	{
+		const double toMB = 1.0 / (1 << 20);
+		profiler.setCounter("Texture MB resident", m_stats.residentBytes * toMB);
+		profiler.setCounter("Texture MB budget", m_stats.budget * toMB);
+		profiler.setCounter("Textures reduced", m_stats.numReduced);
+		profiler.setCounter("Texture mips dropped", (double)m_stats.mipsDropped);
+		profiler.setCounter("Texture mips restored", (double)m_stats.mipsRestored);
+		profiler.setCounter("Texture MB uploaded", m_stats.bytesUploaded * toMB);
+	}
+
+	void TextureManager::onBind(unsigned int texture, void* manager)
+	{
+		TextureManager* self = (TextureManager*)manager;
+		if (self->m_uploading)
+			return;
+		auto found = self->m_entries.find(texture);
+		if (found != self->m_entries.end()) {
+			found->second.lastUsed = self->m_frame;
+		}
+	}
+	unsigned int TextureManager::add(unsigned int texture, const std::vector<std::string>& filePaths, bool isArray, TextureCompression compression)
+	{
+		Entry& entry = m_entries[texture];
+		entry.filePaths = filePaths;
+		entry.isArray = isArray;
+		entry.compression = compression;
+		//Loading counts as a use, so a new texture isn't the first to be shrunk
+		entry.lastUsed = m_frame;
+		requestUpload(texture, entry);
+		return texture;
+	}
+	size_t TextureManager::getBytes(const Entry& entry, int mip) const
+	{
+		if (entry.chainBytes.empty())
+			return 0;
+		return entry.chainBytes[std::min(std::max(mip, 0), (int)entry.chainBytes.size() - 1)];
+	}
+	void TextureManager::setTarget(Entry& entry, int mip)
+	{
+		m_plannedBytes += getBytes(entry, mip);
+		m_plannedBytes -= getBytes(entry, entry.targetMip);
+		entry.targetMip = mip;
+	}
+	/// <summary>
+	/// Takes one mip at a time from the least recently used texture that can lose one
+	/// </summary>
+	bool TextureManager::makeRoom(size_t bytes, uint64_t usedBefore)
+	{
+		while (m_plannedBytes + bytes > m_stats.budget) {
+			Entry* victim = nullptr;
+			for (auto& item : m_entries) {
+				Entry& entry = item.second;
+				if (entry.lastUsed < usedBefore && entry.targetMip < entry.maxDrop && (!victim || entry.lastUsed < victim->lastUsed)) {
+					victim = &entry;
+				}
+			}
+			if (!victim)
+				return false;
+			setTarget(*victim, victim->targetMip + 1);
+		}
+		return true;
+	}
+	size_t TextureManager::getFreeableBytes(uint64_t usedBefore) const
+	{
+		size_t bytes = 0;
+		for (const auto& item : m_entries) {
+			const Entry& entry = item.second;
+			if (entry.lastUsed < usedBefore) {
+				bytes += getBytes(entry, entry.targetMip) - getBytes(entry, std::max(entry.maxDrop, entry.targetMip));
+			}
+		}
+		return bytes;
+	}
+	void TextureManager::requestUpload(unsigned int texture, Entry& entry)
+	{
+		entry.loading = true;
+		entry.reload = false;
+		std::weak_ptr<TextureManager*> self = m_self;
+		const std::vector<std::string> filePaths = entry.filePaths;
+		const TextureCompression compression = entry.compression;
+		m_loader.load(filePaths[0], [self, texture, filePaths, compression]() -> std::function<void()> {
+			//Maps the cache files: cheap when only a few mips are wanted
+			auto images = std::make_shared<std::vector<TextureImage>>(filePaths.size());
+			for (size_t layer = 0; layer < filePaths.size(); layer++) {
+				if (!loadTextureImage(filePaths[layer].c_str(), (*images)[layer], false, compression)) {
+					printf("Failed to load image %s\n", filePaths[layer].c_str());
+				}
+			}
+			return [self, texture, images]() {
+				std::shared_ptr<TextureManager*> manager = self.lock();
+				if (manager) {
+					(*manager)->finishUpload(texture, *images);
+				}
+			};
+		});
+	}
+	/// <summary>
+	/// Uploads at the texture's target, which may have moved while the image loaded. The chain's sizes are
+	/// learned from the first layer's image, and a texture loading for the first time takes whatever room it can get.
+	/// </summary>
+	void TextureManager::finishUpload(unsigned int texture, const std::vector<TextureImage>& images)
+	{
+		auto found = m_entries.find(texture);
+		if (found == m_entries.end())
+			return;
+		Entry& entry = found->second;
+		entry.loading = false;
+		const TextureImage& image = images[0];
+		if (!image.isValid())
+			return;
+
+		m_plannedBytes -= getBytes(entry, entry.targetMip);
+		entry.width = image.getWidth();
+		entry.height = image.getHeight();
+		entry.chainBytes.assign(image.getNumMips(), 0);
+		size_t total = 0;
+		for (int level = image.getNumMips() - 1; level >= 0; level--) {
+			total += image.getMip(level).size * images.size();
+			entry.chainBytes[level] = total;
+		}
+		//Stops at the last level at least minSize, or at level 0 if the image is smaller
+		entry.maxDrop = 0;
+		while (entry.maxDrop + 1 < image.getNumMips() && std::max(image.getMip(entry.maxDrop + 1).width, image.getMip(entry.maxDrop + 1).height) >= m_minSize) {
+			entry.maxDrop++;
+		}
+		entry.targetMip = std::min(entry.targetMip, image.getNumMips() - 1);
+		m_plannedBytes += getBytes(entry, entry.targetMip);
+		if (entry.residentMip < 0) {
+			//Jobs finish before the frame's binds, so the last frame's textures count as in use too
+			const uint64_t used = m_frame - 1;
+			setTarget(entry, entry.maxDrop);
+			//Its smallest size has to fit, so if idle textures can't make room, those in use give it up
+			makeRoom(0, m_frame + 1);
+			int mip = 0;
+			while (mip < entry.maxDrop && !makeRoom(getBytes(entry, mip) - getBytes(entry, entry.maxDrop), used)) {
+				mip++;
+			}
+			setTarget(entry, mip);
+		}
+
+		m_uploading = true;
+		if (entry.isArray) {
+			if (!uploadTextureImageArray(texture, images, entry.targetMip)) {
+				printf("Some layers of %s's array do not match its size and format\n", entry.filePaths[0].c_str());
+			}
+			renderState::bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+		}
+		else {
+			uploadTextureImage(texture, image, entry.targetMip);
+			renderState::bindTexture(0, GL_TEXTURE_2D, 0);
+		}
+		m_uploading = false;
+		if (entry.residentMip >= 0) {
+			m_stats.mipsDropped += std::max(entry.targetMip - entry.residentMip, 0);
+			m_stats.mipsRestored += std::max(entry.residentMip - entry.targetMip, 0);
+		}
+		m_stats.uploads++;
+		m_stats.bytesUploaded += getBytes(entry, entry.targetMip);
+		entry.residentMip = entry.targetMip;
+	}
+}
@@ -0,0 +1,106 @@
+/*
+	Keeps the textures it loads inside a budget of GPU memory. Sizes are estimated from the bytes of each mip in
+	the texture cache (textureCache.h), so an RGB texture a driver pads to RGBA counts for less than it takes.
+
+	Every bind through renderState::bindTexture marks a texture used. When the textures' total is over budget,
+	update() drops the top mip of the texture used least recently, and repeats until it fits. Textures used
+	since the last update() are never shrunk, nor is any texture below minSize, except to fit a new texture at
+	minSize when idle textures can't. A reduced texture that is bound again gets its mips back as soon as there
+	is room, dropping mips of idle textures to make it if needed.
+
+	Both ways, the texture is re-uploaded from its cache file by a job on the asset loader: the mips kept
+	become levels 0 and up of the same handle, so materials and shaders are unaffected and only see a blurrier
+	image until the restore lands.
+*/
+
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include "assetLoader.h"
+#include "profiler.h"
+
+namespace ew {
+	struct TextureManagerStats {
+		size_t budget = 0;
+		size_t residentBytes = 0; //Uploaded now
+		size_t fullBytes = 0; //With every texture at full size
+		int numTextures = 0;
+		int numReduced = 0; //With top mips dropped
+		int numLoading = 0; //Uploads in flight
+		//Totals since creation
+		size_t mipsDropped = 0;
+		size_t mipsRestored = 0;
+		size_t uploads = 0;
+		size_t bytesUploaded = 0;
+	};
+
+	class TextureManager {
+	public:
+		//minSize is the size, in pixels along the longer side, textures are never shrunk below.
+		//Observes renderState's binds, so only one manager can exist at a time.
+		TextureManager(AssetLoader& loader, size_t budgetBytes, int minSize = 64);
+		~TextureManager();
+		TextureManager(const TextureManager&) = delete;
+		TextureManager& operator=(const TextureManager&) = delete;
+
+		//loadTextureAsync with the texture managed. Returns the handle right away. If the budget is full of
+		//textures in use, the texture arrives reduced.
+		unsigned int load(const std::string& filePath, int wrapMode, int filterMode, TextureCompression compression = TextureCompression::None);
+		//The same for a GL_TEXTURE_2D_ARRAY with a layer per file, counted and shrunk as one texture. Layers that
+		//don't match the first's size and format are skipped.
+		unsigned int loadArray(const std::vector<std::string>& filePaths, int wrapMode, int filterMode, TextureCompression compression = TextureCompression::None);
+		//Re-reads the texture's caches, rebuilt if a source changed, and re-uploads it at its current size
+		void reload(unsigned int texture);
+		//Deletes a managed texture
+		void release(unsigned int texture);
+		//Drops and restores mips to fit the budget. Call once per frame on the GL thread, after the frame's binds.
+		void update();
+
+		inline void setBudget(size_t bytes) { m_stats.budget = bytes; }
+		inline size_t getBudget()const { return m_stats.budget; }
+		inline const TextureManagerStats& getStats()const { return m_stats; }
+		//Mip of the texture's full chain that is its level 0 now, or -1 if it isn't loaded or managed
+		int getResidentMip(unsigned int texture)const;
+
+		//Budget, totals and a row per texture. Call between ImGui::NewFrame and ImGui::Render.
+		void drawImGui();
+		//Sets profiler counters from the stats, so they show with the profiler's scopes and in its traces
+		void exportCounters(Profiler& profiler)const;
+	private:
+		struct Entry {
+			std::vector<std::string> filePaths; //One per layer
+			bool isArray = false;
+			TextureCompression compression = TextureCompression::None;
+			int width = 0;
+			int height = 0;
+			std::vector<size_t> chainBytes; //Bytes from each mip to the end of the chain, all layers. Empty until loaded.
+			int maxDrop = 0; //Most top mips that can be dropped, for minSize
+			int residentMip = -1;
+			int targetMip = 0;
+			bool loading = false;
+			bool reload = false; //Upload again even at the same size
+			uint64_t lastUsed = 0; //Frame of the last bind
+		};
+		static void onBind(unsigned int texture, void* manager);
+		unsigned int add(unsigned int texture, const std::vector<std::string>& filePaths, bool isArray, TextureCompression compression);
+		size_t getBytes(const Entry& entry, int mip)const;
+		void setTarget(Entry& entry, int mip);
+		//Drops mips of textures last used before usedBefore until bytes more fit. False if they don't.
+		bool makeRoom(size_t bytes, uint64_t usedBefore);
+		size_t getFreeableBytes(uint64_t usedBefore)const;
+		void requestUpload(unsigned int texture, Entry& entry);
+		void finishUpload(unsigned int texture, const std::vector<TextureImage>& images);
+
+		AssetLoader& m_loader;
+		int m_minSize;
+		std::unordered_map<unsigned int, Entry> m_entries;
+		uint64_t m_frame = 1;
+		size_t m_plannedBytes = 0; //Total at every texture's target size
+		bool m_uploading = false; //The manager's own binds aren't uses
+		std::shared_ptr<TextureManager*> m_self; //Lets upload jobs that outlive the manager see it is gone
+		TextureManagerStats m_stats;
+	};
+}
@@ -0,0 +1,292 @@
+#include "textureStreamer.h"
+#include <string.h>
+#include <stdio.h>
+#include <algorithm>
+#include "texture.h"
+#include "renderState.h"
+#include "external/glad.h"
+
+namespace {
+	//One band of rows of one mip, copied into the buffer at offset
+	struct Chunk {
+		unsigned int texture;
+		int layer;
+		std::shared_ptr<const ew::TextureImage> image;
+		int level;
+		int y;
+		int height;
+		size_t offset;
+		size_t size;
+		bool allocate; //First chunk of the image: replace the texture's storage before uploading
+		bool finishesLevel;
+	};
+
+	size_t alignUp(size_t offset) {
+		return (offset + 15) & ~(size_t)15;
+	}
+
+	/// <summary>
+	/// Gives every mip of the texture storage shaped like the image, with no data yet, and limits sampling
+	/// to the smallest mip until finer ones arrive
+	/// </summary>
+	void allocateStorage(unsigned int texture, const ew::TextureImage& image) {
+		unsigned int internalFormat, pixelFormat;
+		ew::getGLFormat(image.getFormat(), internalFormat, pixelFormat);
+		ew::renderState::bindTexture(0, GL_TEXTURE_2D, texture);
+		for (int level = 0; level < image.getNumMips(); level++) {
+			const ew::TextureMip& mip = image.getMip(level);
+			if (ew::isCompressedFormat(image.getFormat())) {
+				glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, mip.width, mip.height, 0, (GLsizei)mip.size, NULL);
+			}
+			else {
+				glTexImage2D(GL_TEXTURE_2D, level, internalFormat, mip.width, mip.height, 0, pixelFormat, GL_UNSIGNED_BYTE, NULL);
+			}
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, image.getNumMips() - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.getNumMips() - 1);
+	}
+}
+
+namespace ew {
+	TextureStreamer::TextureStreamer(size_t bytesPerFrame, int numBuffers)
+		:m_bytesPerFrame(std::max(bytesPerFrame, (size_t)16)), m_buffers(std::max(numBuffers, 1))
+	{
+	}
+	TextureStreamer::~TextureStreamer()
+	{
+		for (Buffer& buffer : m_buffers) {
+			if (buffer.fence) {
+				glDeleteSync((GLsync)buffer.fence);
+			}
+			if (buffer.pbo) {
+				renderState::deleteBuffer(buffer.pbo);
+			}
+		}
+	}
+	/// <summary>
+	/// (Re)creates every buffer at the current budget. GL keeps a deleted buffer alive until the GPU is done with it.
+	/// </summary>
+	void TextureStreamer::allocateBuffers()
+	{
+		m_bufferSize = m_bytesPerFrame;
+		for (Buffer& buffer : m_buffers) {
+			if (buffer.fence) {
+				glDeleteSync((GLsync)buffer.fence);
+				buffer.fence = nullptr;
+			}
+			if (buffer.pbo) {
+				renderState::deleteBuffer(buffer.pbo);
+			}
+			glGenBuffers(1, &buffer.pbo);
+			renderState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.pbo);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, m_bufferSize, NULL, GL_STREAM_DRAW);
+		}
+		renderState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	void TextureStreamer::stream(unsigned int texture, std::shared_ptr<const TextureImage> image)
+	{
+		if (!image || !image->isValid()) {
+			return;
+		}
+		queue(texture, -1, std::move(image));
+	}
+	bool TextureStreamer::streamLayer(unsigned int texture, int layer, std::shared_ptr<const TextureImage> image)
+	{
+		if (!image || !image->isValid()) {
+			return false;
+		}
+		const bool matches = matchesTextureArray(texture, layer, *image);
+		renderState::bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+		if (!matches) {
+			return false;
+		}
+		queue(texture, layer, std::move(image));
+		return true;
+	}
+	void TextureStreamer::queue(unsigned int texture, int layer, std::shared_ptr<const TextureImage> image)
+	{
+		//Level 0 has the longest rows
+		m_bytesPerFrame = std::max(m_bytesPerFrame, getRowSize(image->getFormat(), image->getWidth()));
+		for (int level = 0; level < image->getNumMips(); level++) {
+			m_bytesPending += image->getMip(level).size;
+		}
+		m_uploads.push_back({ texture, layer, std::move(image), -1, 0 });
+	}
+	/// <summary>
+	/// Copies rows into the next buffer until it is full, then issues the uploads. GL calls that would read
+	/// from the bound buffer (storage allocation passes NULL data) are made while it is unbound.
+	/// </summary>
+	size_t TextureStreamer::update()
+	{
+		if (m_uploads.empty()) {
+			return 0;
+		}
+		if (m_bufferSize < m_bytesPerFrame) {
+			allocateBuffers();
+		}
+		Buffer& buffer = m_buffers[m_nextBuffer];
+		if (buffer.fence) {
+			//Still in use by the GPU: try again next frame rather than stall this one
+			if (glClientWaitSync((GLsync)buffer.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+				return 0;
+			}
+			glDeleteSync((GLsync)buffer.fence);
+			buffer.fence = nullptr;
+		}
+
+		renderState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.pbo);
+		unsigned char* mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, m_bufferSize,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (mapped == NULL) {
+			renderState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			return 0;
+		}
+		std::vector<Chunk> chunks;
+		size_t used = 0;
+		while (!m_uploads.empty()) {
+			Upload& upload = m_uploads.front();
+			const TextureImage& image = *upload.image;
+			const bool starting = upload.level < 0;
+			if (starting) {
+				upload.level = image.getNumMips() - 1;
+			}
+			const TextureMip& mip = image.getMip(upload.level);
+			const size_t rowSize = getRowSize(image.getFormat(), mip.width);
+			const int rowHeight = getRowHeight(image.getFormat());
+			const int numRows = (mip.height + rowHeight - 1) / rowHeight;
+			const size_t offset = alignUp(used);
+			const int fit = offset < m_bufferSize ? (int)std::min((m_bufferSize - offset) / rowSize, (size_t)numRows) : 0;
+			const int rows = std::min(fit, numRows - upload.row);
+			if (rows <= 0) {
+				if (starting) {
+					upload.level = -1;
+				}
+				break;
+			}
+			Chunk chunk;
+			chunk.texture = upload.texture;
+			chunk.layer = upload.layer;
+			chunk.image = upload.image;
+			chunk.level = upload.level;
+			chunk.y = upload.row * rowHeight;
+			chunk.height = std::min(rows * rowHeight, mip.height - chunk.y);
+			chunk.offset = offset;
+			chunk.size = rows * rowSize;
+			chunk.allocate = starting && upload.layer < 0;
+			memcpy(mapped + offset, mip.data + upload.row * rowSize, chunk.size);
+			used = offset + chunk.size;
+			m_bytesPending -= chunk.size;
+
+			upload.row += rows;
+			chunk.finishesLevel = upload.row == numRows;
+			if (chunk.finishesLevel) {
+				upload.row = 0;
+				if (--upload.level < 0) {
+					m_uploads.pop_front();
+				}
+			}
+			chunks.push_back(std::move(chunk));
+		}
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		renderState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		for (const Chunk& chunk : chunks) {
+			if (chunk.allocate) {
+				allocateStorage(chunk.texture, *chunk.image);
+			}
+		}
+		renderState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.pbo);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (const Chunk& chunk : chunks) {
+			const TextureMip& mip = chunk.image->getMip(chunk.level);
+			unsigned int internalFormat, pixelFormat;
+			getGLFormat(chunk.image->getFormat(), internalFormat, pixelFormat);
+			const void* offset = (const void*)chunk.offset;
+			const bool compressed = isCompressedFormat(chunk.image->getFormat());
+			if (chunk.layer >= 0) {
+				renderState::bindTexture(0, GL_TEXTURE_2D_ARRAY, chunk.texture);
+				if (compressed) {
+					glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, chunk.level, 0, chunk.y, chunk.layer, mip.width, chunk.height, 1, internalFormat, (GLsizei)chunk.size, offset);
+				}
+				else {
+					glTexSubImage3D(GL_TEXTURE_2D_ARRAY, chunk.level, 0, chunk.y, chunk.layer, mip.width, chunk.height, 1, pixelFormat, GL_UNSIGNED_BYTE, offset);
+				}
+				continue;
+			}
+			renderState::bindTexture(0, GL_TEXTURE_2D, chunk.texture);
+			if (compressed) {
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, chunk.level, 0, chunk.y, mip.width, chunk.height, internalFormat, (GLsizei)chunk.size, offset);
+			}
+			else {
+				glTexSubImage2D(GL_TEXTURE_2D, chunk.level, 0, chunk.y, mip.width, chunk.height, pixelFormat, GL_UNSIGNED_BYTE, offset);
+			}
+			if (chunk.finishesLevel) {
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, chunk.level);
+			}
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		renderState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		renderState::bindTexture(0, GL_TEXTURE_2D, 0);
+		renderState::bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+
+		buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_nextBuffer = (m_nextBuffer + 1) % m_buffers.size();
+		return used;
+	}
+	void TextureStreamer::finish()
+	{
+		while (!m_uploads.empty()) {
+			if (update() == 0) {
+				//The next buffer is still in flight, so this time do wait for it
+				Buffer& buffer = m_buffers[m_nextBuffer];
+				if (buffer.fence) {
+					glClientWaitSync((GLsync)buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+				}
+			}
+		}
+	}
+
+	unsigned int createPlaceholderTexture(int wrapMode, int filterMode, const unsigned char color[4])
+	{
+		unsigned int texture = createTexture(wrapMode, filterMode);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, color);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		renderState::bindTexture(0, GL_TEXTURE_2D, 0);
+		return texture;
+	}
+	unsigned int loadTextureStreamed(AssetLoader& loader, TextureStreamer& streamer, const std::string& filePath, int wrapMode, int filterMode, TextureCompression compression)
+	{
+		const unsigned char gray[4] = { 128, 128, 128, 255 };
+		unsigned int texture = createPlaceholderTexture(wrapMode, filterMode, gray);
+		compression = getSupportedCompression(compression);
+		TextureStreamer* target = &streamer;
+		loader.load(filePath, [texture, filePath, compression, target]() -> std::function<void()> {
+			auto image = std::make_shared<TextureImage>();
+			if (!loadTextureImage(filePath.c_str(), *image, false, compression)) {
+				printf("Failed to load image %s\n", filePath.c_str());
+				return {};
+			}
+			return [texture, image, target]() {
+				target->stream(texture, image);
+			};
+		});
+		return texture;
+	}
+	void loadTextureLayerStreamed(AssetLoader& loader, TextureStreamer& streamer, unsigned int texture, int layer, const std::string& filePath, TextureCompression compression)
+	{
+		compression = getSupportedCompression(compression);
+		TextureStreamer* target = &streamer;
+		loader.load(filePath, [texture, layer, filePath, compression, target]() -> std::function<void()> {
+			auto image = std::make_shared<TextureImage>();
+			if (!loadTextureImage(filePath.c_str(), *image, false, compression)) {
+				printf("Failed to load image %s\n", filePath.c_str());
+				return {};
+			}
+			return [texture, layer, image, filePath, target]() {
+				if (!target->streamLayer(texture, layer, image)) {
+					printf("%s does not match the size and format of its texture array\n", filePath.c_str());
+				}
+			};
+		});
+	}
+}
@@ -0,0 +1,75 @@
+/*
+	Streams texture images to the GPU a little each frame, so a large load doesn't stall the frame it lands in.
+	Each update() copies at most a fixed budget of bytes into the next of a ring of pixel buffer objects and
+	issues glTexSubImage2D from it, so the driver can transfer asynchronously. A fence per buffer keeps the copy
+	from overwriting data the GPU hasn't consumed yet; update() skips a frame rather than wait on it.
+
+	Mips are sent smallest first, and GL_TEXTURE_BASE_LEVEL follows the finest complete mip, so a texture
+	starts from its placeholder, then shows a blurry version that sharpens as the rest arrives. A layer of a
+	texture array is written into the storage it already has, so it keeps its old mips until each new one lands.
+*/
+
+#pragma once
+#include <memory>
+#include <deque>
+#include <vector>
+#include <string>
+#include "textureCache.h"
+#include "assetLoader.h"
+
+namespace ew {
+	class TextureStreamer {
+	public:
+		//bytesPerFrame is the most update() uploads in one call. Rows are never split, so it is raised to fit
+		//at least one row of any image streamed. numBuffers is how many frames of uploads can be in flight.
+		explicit TextureStreamer(size_t bytesPerFrame = 4 << 20, int numBuffers = 3);
+		~TextureStreamer();
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+		//Queues image for upload into texture, a GL_TEXTURE_2D, replacing its storage with image's mips.
+		//Call on the GL thread. The texture keeps its current contents until the smallest mip is uploaded.
+		void stream(unsigned int texture, std::shared_ptr<const TextureImage> image);
+		//Queues image for upload into one layer of texture, a GL_TEXTURE_2D_ARRAY. Returns false, queuing nothing,
+		//if image isn't the size and format of the array (matchesTextureArray). Call on the GL thread.
+		bool streamLayer(unsigned int texture, int layer, std::shared_ptr<const TextureImage> image);
+		//Uploads up to the budget. Call once per frame on the GL thread. Returns the bytes uploaded.
+		size_t update();
+		//Calls update until everything queued is uploaded
+		void finish();
+
+		inline size_t getNumPending()const { return m_uploads.size(); }
+		inline size_t getBytesPending()const { return m_bytesPending; }
+		inline size_t getBytesPerFrame()const { return m_bytesPerFrame; }
+	private:
+		struct Upload {
+			unsigned int texture;
+			int layer; //-1 for a GL_TEXTURE_2D
+			std::shared_ptr<const TextureImage> image;
+			int level; //Mip being uploaded, counting down to 0
+			int row; //Next row of data within it
+		};
+		//A buffer in the ring, with the fence marking its last use by the GPU
+		struct Buffer {
+			unsigned int pbo = 0;
+			void* fence = nullptr;
+		};
+		void allocateBuffers();
+		void queue(unsigned int texture, int layer, std::shared_ptr<const TextureImage> image);
+
+		size_t m_bytesPerFrame;
+		size_t m_bufferSize = 0; //Current size of each buffer. Grows with the budget.
+		std::vector<Buffer> m_buffers;
+		size_t m_nextBuffer = 0;
+		std::deque<Upload> m_uploads;
+		size_t m_bytesPending = 0;
+	};
+
+	//A 1x1 texture of a single color, with loadTexture's sampling state, to show until a streamed image arrives
+	unsigned int createPlaceholderTexture(int wrapMode, int filterMode, const unsigned char color[4]);
+	//Like loadTextureAsync, but the image is handed to streamer instead of uploaded in one go.
+	//The texture shows a gray placeholder until the first mips arrive.
+	unsigned int loadTextureStreamed(AssetLoader& loader, TextureStreamer& streamer, const std::string& filePath, int wrapMode, int filterMode, TextureCompression compression = TextureCompression::None);
+	//Like loadTextureLayerAsync, but the image is handed to streamer.streamLayer
+	void loadTextureLayerStreamed(AssetLoader& loader, TextureStreamer& streamer, unsigned int texture, int layer, const std::string& filePath, TextureCompression compression = TextureCompression::None);
+}
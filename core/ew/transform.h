@@ -7,12 +7,9 @@ namespace ew {
 		ew::Vec3 rotation = ew::Vec3(0.0f, 0.0f, 0.0f); //Euler angles (Degrees)
 		ew::Vec3 scale = ew::Vec3(1.0f, 1.0f, 1.0f);
 
+		//Translate * RotateY * RotateX * RotateZ * Scale
 		ew::Mat4 getModelMatrix() const {
-			return ew::Translate(position)
-				* ew::RotateY(ew::Radians(rotation.y))
-				* ew::RotateX(ew::Radians(rotation.x))
-				* ew::RotateZ(ew::Radians(rotation.z))
-				* ew::Scale(scale);
+			return ew::TRS(position, ew::Vec3(ew::Radians(rotation.x), ew::Radians(rotation.y), ew::Radians(rotation.z)), scale);
 		}
 	};
 }
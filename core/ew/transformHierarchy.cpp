@@ -0,0 +1,97 @@
+#include "transformHierarchy.h"
+#include <algorithm>
+
+namespace ew {
+	int TransformHierarchy::addNode(const Transform& local, int parent)
+	{
+		m_locals.push_back(local);
+		m_localMatrices.emplace_back();
+		m_worldMatrices.emplace_back();
+		m_parents.push_back(-1);
+		m_children.emplace_back();
+		m_flags.push_back(LOCAL_DIRTY | WORLD_DIRTY);
+		int node = (int)m_parents.size() - 1;
+		if (parent >= 0) {
+			setParent(node, parent);
+		}
+		return node;
+	}
+	bool TransformHierarchy::setParent(int node, int parent)
+	{
+		for (int ancestor = parent; ancestor >= 0; ancestor = m_parents[ancestor]) {
+			if (ancestor == node) {
+				return false;
+			}
+		}
+		int oldParent = m_parents[node];
+		if (oldParent >= 0) {
+			std::vector<int>& siblings = m_children[oldParent];
+			siblings.erase(std::find(siblings.begin(), siblings.end(), node));
+		}
+		m_parents[node] = parent;
+		if (parent >= 0) {
+			m_children[parent].push_back(node);
+		}
+		markWorldDirty(node);
+		return true;
+	}
+	void TransformHierarchy::setLocal(int node, const Transform& local)
+	{
+		m_locals[node] = local;
+		m_flags[node] |= LOCAL_DIRTY;
+		markWorldDirty(node);
+	}
+	/// <summary>
+	/// Flags the node and everything below it. A dirty node's descendants are always dirty too,
+	/// so already dirty branches are skipped.
+	/// </summary>
+	void TransformHierarchy::markWorldDirty(int node)
+	{
+		m_stack.clear();
+		m_stack.push_back(node);
+		while (!m_stack.empty()) {
+			int current = m_stack.back();
+			m_stack.pop_back();
+			if (m_flags[current] & WORLD_DIRTY) {
+				continue;
+			}
+			m_flags[current] |= WORLD_DIRTY;
+			for (int child : m_children[current]) {
+				m_stack.push_back(child);
+			}
+		}
+	}
+	/// <summary>
+	/// Walks up to the highest dirty ancestor, then rebuilds world matrices on the way back down
+	/// </summary>
+	const Mat4& TransformHierarchy::getWorldMatrix(int node)
+	{
+		if (!(m_flags[node] & WORLD_DIRTY)) {
+			return m_worldMatrices[node];
+		}
+		m_stack.clear();
+		for (int current = node; current >= 0 && (m_flags[current] & WORLD_DIRTY); current = m_parents[current]) {
+			m_stack.push_back(current);
+		}
+		while (!m_stack.empty()) {
+			int current = m_stack.back();
+			m_stack.pop_back();
+			if (m_flags[current] & LOCAL_DIRTY) {
+				m_localMatrices[current] = m_locals[current].getModelMatrix();
+			}
+			int parent = m_parents[current];
+			m_worldMatrices[current] = parent >= 0 ? m_worldMatrices[parent] * m_localMatrices[current] : m_localMatrices[current];
+			m_flags[current] = 0;
+			m_numRebuilt++;
+		}
+		return m_worldMatrices[node];
+	}
+	void TransformHierarchy::updateWorldMatrices()
+	{
+		for (int i = 0; i < (int)m_flags.size(); i++) {
+			if (m_flags[i] & WORLD_DIRTY) {
+				getWorldMatrix(i);
+			}
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include "transform.h"
+
+namespace ew {
+	//Parent/child transforms with cached matrices. A node's local matrix is only rebuilt when its
+	//Transform changes, and its world matrix only when it or an ancestor changes.
+	//Nodes are referred to by the index returned from addNode.
+	class TransformHierarchy {
+	public:
+		//parent -1 for a root
+		int addNode(const Transform& local = Transform(), int parent = -1);
+		//Returns false (and changes nothing) if it would create a cycle
+		bool setParent(int node, int parent);
+		inline int getParent(int node)const { return m_parents[node]; }
+		inline const std::vector<int>& getChildren(int node)const { return m_children[node]; }
+		inline size_t getNumNodes()const { return m_parents.size(); }
+
+		inline const Transform& getLocal(int node)const { return m_locals[node]; }
+		void setLocal(int node, const Transform& local);
+		//Local to world, rebuilding this node and any dirty ancestors first
+		const Mat4& getWorldMatrix(int node);
+		//Brings every dirty node up to date
+		void updateWorldMatrices();
+		//Matrices rebuilt since the last call, for checking how much work the cache saves
+		inline int takeNumRebuilt() { int numRebuilt = m_numRebuilt; m_numRebuilt = 0; return numRebuilt; }
+	private:
+		enum Flags : unsigned char {
+			LOCAL_DIRTY = 1,
+			WORLD_DIRTY = 2
+		};
+		void markWorldDirty(int node);
+
+		//One entry per node in each array, so scanning for dirty nodes only touches m_flags
+		std::vector<Transform> m_locals;
+		std::vector<Mat4> m_localMatrices;
+		std::vector<Mat4> m_worldMatrices;
+		std::vector<int> m_parents;
+		std::vector<std::vector<int>> m_children;
+		std::vector<unsigned char> m_flags;
+		std::vector<int> m_stack;
+		int m_numRebuilt = 0;
+	};
+}
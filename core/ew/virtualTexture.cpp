@@ -0,0 +1,728 @@
+#include "virtualTexture.h"
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include "shader.h"
+#include "renderState.h"
+#include "blockCompression.h"
+#include "imageResample.h"
+#include "external/glad.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define EW_VIRTUAL_TEXTURE_MMAP 1
+#endif
+
+namespace {
+	const char MAGIC[4] = { 'E', 'W', 'V', 'T' };
+	const uint32_t VERSION = 1;
+	const unsigned char UNMAPPED = 255; //Table texel mip when no resident page covers it
+
+	struct VirtualTextureHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t format; //ew::TextureFormat
+		uint32_t size;
+		uint32_t pageSize;
+		uint32_t border;
+		uint32_t numMips;
+		uint32_t reserved;
+	};
+
+	bool isPowerOfTwo(int x) {
+		return x > 0 && (x & (x - 1)) == 0;
+	}
+	int countMips(int size, int pageSize) {
+		int numMips = 1;
+		while ((pageSize << (numMips - 1)) < size) {
+			numMips++;
+		}
+		return numMips;
+	}
+	bool isValidPage(const ew::VirtualTextureInfo& info, uint32_t page) {
+		const int mip = ew::getPageMip(page);
+		return page != ew::INVALID_PAGE && mip < info.numMips
+			&& ew::getPageX(page) < info.getPagesPerSide(mip) && ew::getPageY(page) < info.getPagesPerSide(mip);
+	}
+
+	/// <summary>
+	/// Copies one page and its border out of a mip, repeating the mip's edge pixels where the border runs off it
+	/// </summary>
+	void cutPage(const unsigned char* pixels, int mipSize, int channels, const ew::VirtualTextureInfo& info, int pageX, int pageY, unsigned char* dst) {
+		const int physicalSize = info.getPhysicalPageSize();
+		const int left = pageX * info.pageSize - info.border;
+		const int top = pageY * info.pageSize - info.border;
+		for (int y = 0; y < physicalSize; y++) {
+			const int srcY = std::clamp(top + y, 0, mipSize - 1);
+			const unsigned char* row = pixels + (size_t)srcY * mipSize * channels;
+			for (int x = 0; x < physicalSize; x++) {
+				const int srcX = std::clamp(left + x, 0, mipSize - 1);
+				memcpy(dst, row + (size_t)srcX * channels, channels);
+				dst += channels;
+			}
+		}
+	}
+
+	//Large file seek for the fallback reader
+	bool seekFile(FILE* file, size_t offset) {
+#if defined(_WIN32)
+		return _fseeki64(file, (long long)offset, SEEK_SET) == 0;
+#else
+		return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+	}
+}
+
+namespace ew {
+	size_t VirtualTextureInfo::getPageBytes() const {
+		const int physicalSize = getPhysicalPageSize();
+		return getRowSize(format, physicalSize) * (physicalSize / getRowHeight(format));
+	}
+
+	void encodeFeedbackTexel(uint32_t page, unsigned char texel[4]) {
+		if (page == INVALID_PAGE) {
+			memset(texel, 0, 4);
+			return;
+		}
+		const int x = getPageX(page), y = getPageY(page);
+		texel[0] = (unsigned char)(x & 255);
+		texel[1] = (unsigned char)(y & 255);
+		texel[2] = (unsigned char)((x >> 8) | (y >> 8) << 4);
+		texel[3] = (unsigned char)(getPageMip(page) + 1);
+	}
+	uint32_t decodeFeedbackTexel(const unsigned char texel[4]) {
+		if (texel[3] == 0) {
+			return INVALID_PAGE;
+		}
+		const int x = texel[0] | (texel[2] & 15) << 8;
+		const int y = texel[1] | (texel[2] >> 4) << 8;
+		return makePageId(texel[3] - 1, x, y);
+	}
+
+	/// <summary>
+	/// Writes one row of pages at a time, cutting (and compressing) the pages of a row in parallel, then halves the
+	/// mip for the next. Only the current mip and the next are in memory besides the source.
+	/// Written to a temporary file and renamed, so a reader never sees half a file.
+	/// </summary>
+	bool buildVirtualTexture(const char* filePath, const unsigned char* pixels, int size, int channels, const VirtualTextureBuildOptions& options) {
+		VirtualTextureInfo info;
+		info.size = size;
+		info.pageSize = options.pageSize;
+		info.border = options.border;
+		if (channels != 3 && channels != 4) {
+			printf("Virtual textures need 3 or 4 channels, not %d\n", channels);
+			return false;
+		}
+		if (!isPowerOfTwo(info.pageSize) || !isPowerOfTwo(size) || size < info.pageSize || size / info.pageSize > 4096 || info.border < 0) {
+			printf("Virtual texture size %d must be a power of two, at least the page size %d and at most 4096 pages\n", size, info.pageSize);
+			return false;
+		}
+		if (options.compression == TextureCompression::None) {
+			info.format = channels == 4 ? TextureFormat::RGBA8 : TextureFormat::RGB8;
+		}
+		else {
+			info.format = channels == 3 && options.compression == TextureCompression::BC1 ? TextureFormat::BC1 : TextureFormat::BC7;
+			if (info.getPhysicalPageSize() % 4 != 0) {
+				printf("Compressed virtual texture pages must be a multiple of 4 pixels, border %d makes them %d\n", info.border, info.getPhysicalPageSize());
+				return false;
+			}
+		}
+		info.numMips = countMips(size, info.pageSize);
+
+		const std::string tempPath = std::string(filePath) + ".tmp";
+		FILE* file = fopen(tempPath.c_str(), "wb");
+		if (!file) {
+			printf("Failed to open %s for writing\n", tempPath.c_str());
+			return false;
+		}
+		VirtualTextureHeader header = {};
+		memcpy(header.magic, MAGIC, 4);
+		header.version = VERSION;
+		header.format = (uint32_t)info.format;
+		header.size = (uint32_t)size;
+		header.pageSize = (uint32_t)info.pageSize;
+		header.border = (uint32_t)info.border;
+		header.numMips = (uint32_t)info.numMips;
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+		const size_t pageBytes = info.getPageBytes();
+		const int physicalSize = info.getPhysicalPageSize();
+		const bool compressed = isCompressedFormat(info.format);
+		const BlockFormat blockFormat = info.format == TextureFormat::BC1 ? BlockFormat::BC1 : BlockFormat::BC7;
+		unsigned int numThreads = options.numThreads > 0 ? options.numThreads : std::max(1u, std::thread::hardware_concurrency());
+
+		ResampleOptions mipOptions;
+		mipOptions.filter = ResampleFilter::Kaiser;
+		mipOptions.srgbChannels = 3;
+		mipOptions.numThreads = numThreads;
+
+		const unsigned char* mip = pixels;
+		std::vector<unsigned char> current, next;
+		for (int level = 0; level < info.numMips && ok; level++) {
+			const int mipSize = size >> level;
+			const int pagesPerSide = info.getPagesPerSide(level);
+			std::vector<unsigned char> row((size_t)pagesPerSide * pageBytes);
+			auto cutPages = [&](int pageY, int begin, int end) {
+				std::vector<unsigned char> page(compressed ? (size_t)physicalSize * physicalSize * channels : 0);
+				for (int pageX = begin; pageX < end; pageX++) {
+					unsigned char* out = row.data() + pageX * pageBytes;
+					if (compressed) {
+						cutPage(mip, mipSize, channels, info, pageX, pageY, page.data());
+						BlockCompressionOptions blockOptions;
+						blockOptions.numThreads = 1;
+						compressImage(page.data(), physicalSize, physicalSize, channels, blockFormat, out, blockOptions);
+					}
+					else {
+						cutPage(mip, mipSize, channels, info, pageX, pageY, out);
+					}
+				}
+			};
+			const unsigned int rowThreads = std::min(numThreads, (unsigned int)pagesPerSide);
+			const int pagesPerThread = (pagesPerSide + rowThreads - 1) / rowThreads;
+			for (int pageY = 0; pageY < pagesPerSide && ok; pageY++) {
+				std::vector<std::thread> threads;
+				for (int begin = pagesPerThread; begin < pagesPerSide; begin += pagesPerThread) {
+					threads.emplace_back(cutPages, pageY, begin, std::min(pagesPerSide, begin + pagesPerThread));
+				}
+				cutPages(pageY, 0, std::min(pagesPerSide, pagesPerThread));
+				for (std::thread& thread : threads) {
+					thread.join();
+				}
+				ok = fwrite(row.data(), 1, row.size(), file) == row.size();
+			}
+			if (level + 1 < info.numMips) {
+				next.resize((size_t)(mipSize / 2) * (mipSize / 2) * channels);
+				downsampleImage(mip, mipSize, mipSize, next.data(), channels, PixelType::UInt8, mipOptions);
+				current.swap(next);
+				mip = current.data();
+			}
+		}
+		ok = fclose(file) == 0 && ok;
+		std::error_code error;
+		if (ok) {
+			std::filesystem::rename(tempPath, filePath, error);
+		}
+		if (!ok || error) {
+			std::filesystem::remove(tempPath, error);
+			printf("Failed to write %s\n", filePath);
+			return false;
+		}
+		return true;
+	}
+
+	VirtualTextureFile::~VirtualTextureFile() {
+		close();
+	}
+	/// <summary>
+	/// Maps the file, or without mmap keeps it open to read pages from. Fails if the header is damaged or
+	/// the file is too short for the pages it describes.
+	/// </summary>
+	bool VirtualTextureFile::open(const char* filePath) {
+		close();
+		VirtualTextureHeader header;
+#if defined(EW_VIRTUAL_TEXTURE_MMAP)
+		int fd = ::open(filePath, O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat stats;
+		if (fstat(fd, &stats) != 0 || stats.st_size < (off_t)sizeof(header)) {
+			::close(fd);
+			return false;
+		}
+		m_fileSize = (size_t)stats.st_size;
+		void* mapping = mmap(nullptr, m_fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (mapping == MAP_FAILED)
+			return false;
+		m_mapping = mapping;
+		memcpy(&header, mapping, sizeof(header));
+#else
+		m_file = fopen(filePath, "rb");
+		if (!m_file)
+			return false;
+		bool read = fread(&header, sizeof(header), 1, m_file) == 1 && fseek(m_file, 0, SEEK_END) == 0;
+#if defined(_WIN32)
+		m_fileSize = read ? (size_t)_ftelli64(m_file) : 0;
+#else
+		m_fileSize = read ? (size_t)ftello(m_file) : 0;
+#endif
+		if (!read) {
+			close();
+			return false;
+		}
+#endif
+		VirtualTextureInfo info;
+		info.size = (int)header.size;
+		info.pageSize = (int)header.pageSize;
+		info.border = (int)header.border;
+		info.numMips = (int)header.numMips;
+		info.format = (TextureFormat)header.format;
+		const bool knownFormat = info.format == TextureFormat::RGB8 || info.format == TextureFormat::RGBA8
+			|| info.format == TextureFormat::BC1 || info.format == TextureFormat::BC7;
+		const bool valid = memcmp(header.magic, MAGIC, 4) == 0 && header.version == VERSION && knownFormat
+			&& isPowerOfTwo(info.pageSize) && isPowerOfTwo(info.size) && info.size >= info.pageSize && info.size / info.pageSize <= 4096
+			&& header.border < header.pageSize && info.numMips == countMips(info.size, info.pageSize);
+		if (!valid) {
+			close();
+			return false;
+		}
+		m_info = info;
+		m_dataStart = sizeof(header);
+		const uint32_t lastPage = makePageId(info.numMips - 1, 0, 0);
+		if (getPageOffset(lastPage) + info.getPageBytes() > m_fileSize) {
+			close();
+			return false;
+		}
+		return true;
+	}
+	void VirtualTextureFile::close() {
+#if defined(EW_VIRTUAL_TEXTURE_MMAP)
+		if (m_mapping) {
+			munmap(m_mapping, m_fileSize);
+		}
+#endif
+		if (m_file) {
+			fclose(m_file);
+		}
+		m_mapping = nullptr;
+		m_file = nullptr;
+		m_fileSize = 0;
+		m_info = VirtualTextureInfo();
+	}
+	size_t VirtualTextureFile::getPageOffset(uint32_t page) const {
+		size_t index = 0;
+		for (int mip = 0; mip < getPageMip(page); mip++) {
+			index += (size_t)m_info.getPagesPerSide(mip) * m_info.getPagesPerSide(mip);
+		}
+		index += (size_t)getPageY(page) * m_info.getPagesPerSide(getPageMip(page)) + getPageX(page);
+		return m_dataStart + index * m_info.getPageBytes();
+	}
+	bool VirtualTextureFile::readPage(uint32_t page, unsigned char* dst) const {
+		if (!isOpen() || !isValidPage(m_info, page)) {
+			return false;
+		}
+		const size_t offset = getPageOffset(page);
+		const size_t pageBytes = m_info.getPageBytes();
+		if (m_mapping) {
+			memcpy(dst, (const unsigned char*)m_mapping + offset, pageBytes);
+			return true;
+		}
+		std::lock_guard<std::mutex> lock(m_fileMutex);
+		return seekFile(m_file, offset) && fread(dst, 1, pageBytes, m_file) == pageBytes;
+	}
+
+	PageCache::PageCache(const VirtualTextureInfo& info, int atlasPagesPerSide)
+		:m_info(info), m_atlasPagesPerSide(atlasPagesPerSide), m_slots((size_t)atlasPagesPerSide * atlasPagesPerSide),
+		m_tables(info.numMips), m_dirty(info.numMips, true)
+	{
+		for (int slot = 0; slot < (int)m_slots.size(); slot++) {
+			m_slots[slot].lru = m_lru.insert(m_lru.end(), slot);
+		}
+		for (int mip = 0; mip < info.numMips; mip++) {
+			const int pagesPerSide = info.getPagesPerSide(mip);
+			m_tables[mip].resize((size_t)pagesPerSide * pagesPerSide * 4);
+			for (size_t i = 0; i < m_tables[mip].size(); i += 4) {
+				const unsigned char unmapped[4] = { 0, 0, UNMAPPED, 255 };
+				memcpy(&m_tables[mip][i], unmapped, 4);
+			}
+		}
+	}
+	void PageCache::processFeedback(const unsigned char* texels, size_t numTexels, std::vector<uint32_t>& missing) {
+		m_frame++;
+		m_counts.clear();
+		for (size_t i = 0; i < numTexels; i++) {
+			const uint32_t page = decodeFeedbackTexel(texels + i * 4);
+			if (isValidPage(m_info, page)) {
+				m_counts[page]++;
+			}
+		}
+		missing.clear();
+		for (const auto& [page, count] : m_counts) {
+			m_stats.requested++;
+			auto resident = m_resident.find(page);
+			if (resident != m_resident.end()) {
+				m_stats.hits++;
+				touch(resident->second);
+				continue;
+			}
+			missing.push_back(page);
+			//Keep what is drawn in its place until it arrives
+			const int pagesPerSide = m_info.getPagesPerSide(getPageMip(page));
+			const unsigned char* texel = &m_tables[getPageMip(page)][((size_t)getPageY(page) * pagesPerSide + getPageX(page)) * 4];
+			if (texel[2] != UNMAPPED) {
+				touch(texel[1] * m_atlasPagesPerSide + texel[0]);
+			}
+		}
+		std::sort(missing.begin(), missing.end(), [this](uint32_t a, uint32_t b) {
+			if (getPageMip(a) != getPageMip(b))
+				return getPageMip(a) > getPageMip(b);
+			const uint32_t countA = m_counts[a], countB = m_counts[b];
+			return countA != countB ? countA > countB : a < b;
+		});
+	}
+	int PageCache::insert(uint32_t page, bool pin) {
+		if (!isValidPage(m_info, page)) {
+			return -1;
+		}
+		auto resident = m_resident.find(page);
+		if (resident != m_resident.end()) {
+			touch(resident->second);
+			return resident->second;
+		}
+		if (m_lru.empty()) {
+			m_stats.dropped++;
+			return -1;
+		}
+		const int slot = m_lru.front();
+		Slot& s = m_slots[slot];
+		if (s.page != INVALID_PAGE) {
+			if (s.lastUsed == m_frame) {
+				//Everything else is in view too. Evicting it would only bring it straight back.
+				m_stats.dropped++;
+				return -1;
+			}
+			unmapPage(s.page);
+			m_resident.erase(s.page);
+			m_stats.evicted++;
+		}
+		s.page = page;
+		m_resident[page] = slot;
+		mapPage(page, slot);
+		m_stats.inserted++;
+		if (pin) {
+			s.pinned = true;
+			s.lastUsed = m_frame;
+			m_lru.erase(s.lru);
+		}
+		else {
+			touch(slot);
+		}
+		return slot;
+	}
+	bool PageCache::isResident(uint32_t page) const {
+		return m_resident.count(page) > 0;
+	}
+	int PageCache::getSlot(uint32_t page) const {
+		auto resident = m_resident.find(page);
+		return resident != m_resident.end() ? resident->second : -1;
+	}
+	void PageCache::clearDirty() {
+		std::fill(m_dirty.begin(), m_dirty.end(), false);
+	}
+	void PageCache::touch(int slot) {
+		Slot& s = m_slots[slot];
+		s.lastUsed = m_frame;
+		if (!s.pinned) {
+			m_lru.splice(m_lru.end(), m_lru, s.lru);
+		}
+	}
+	/// <summary>
+	/// A page covers 2^(mip - k) texels per side at each finer mip k. Texels there already showing a finer
+	/// resident page keep it.
+	/// </summary>
+	void PageCache::mapPage(uint32_t page, int slot) {
+		const int mip = getPageMip(page);
+		const unsigned char texel[4] = { (unsigned char)getSlotX(slot), (unsigned char)getSlotY(slot), (unsigned char)mip, 255 };
+		for (int level = mip; level >= 0; level--) {
+			const int shift = mip - level, pagesPerSide = m_info.getPagesPerSide(level);
+			const int x0 = getPageX(page) << shift, y0 = getPageY(page) << shift, span = 1 << shift;
+			for (int y = y0; y < y0 + span; y++) {
+				unsigned char* row = &m_tables[level][((size_t)y * pagesPerSide + x0) * 4];
+				for (int x = 0; x < span; x++) {
+					if (row[x * 4 + 2] > mip) {
+						memcpy(row + x * 4, texel, 4);
+					}
+				}
+			}
+			m_dirty[level] = true;
+		}
+	}
+	/// <summary>
+	/// The parent texel shows the finest resident page above this one, which is what every texel that showed
+	/// this page falls back to
+	/// </summary>
+	void PageCache::unmapPage(uint32_t page) {
+		const int mip = getPageMip(page), slot = m_resident[page];
+		const unsigned char texel[4] = { (unsigned char)getSlotX(slot), (unsigned char)getSlotY(slot), (unsigned char)mip, 255 };
+		unsigned char parent[4] = { 0, 0, UNMAPPED, 255 };
+		if (mip + 1 < m_info.numMips) {
+			const int parentPages = m_info.getPagesPerSide(mip + 1);
+			memcpy(parent, &m_tables[mip + 1][((size_t)(getPageY(page) >> 1) * parentPages + (getPageX(page) >> 1)) * 4], 4);
+		}
+		for (int level = mip; level >= 0; level--) {
+			const int shift = mip - level, pagesPerSide = m_info.getPagesPerSide(level);
+			const int x0 = getPageX(page) << shift, y0 = getPageY(page) << shift, span = 1 << shift;
+			for (int y = y0; y < y0 + span; y++) {
+				unsigned char* row = &m_tables[level][((size_t)y * pagesPerSide + x0) * 4];
+				for (int x = 0; x < span; x++) {
+					if (memcmp(row + x * 4, texel, 4) == 0) {
+						memcpy(row + x * 4, parent, 4);
+					}
+				}
+			}
+			m_dirty[level] = true;
+		}
+	}
+
+	PageLoader::PageLoader(const VirtualTextureFile& file, unsigned int numThreads)
+		:m_file(file)
+	{
+		numThreads = numThreads > 0 ? numThreads : 1;
+		for (unsigned int i = 0; i < numThreads; i++) {
+			m_threads.emplace_back(&PageLoader::run, this);
+		}
+	}
+	PageLoader::~PageLoader() {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_running = false;
+		}
+		m_pageReady.notify_all();
+		for (std::thread& thread : m_threads) {
+			thread.join();
+		}
+	}
+	void PageLoader::request(const std::vector<uint32_t>& pages) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queue.clear();
+			for (uint32_t page : pages) {
+				if (m_inFlight.count(page) == 0) {
+					m_queue.push_back(page);
+				}
+			}
+		}
+		m_pageReady.notify_all();
+	}
+	void PageLoader::collect(std::vector<LoadedPage>& pages) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (LoadedPage& loaded : m_loaded) {
+			m_inFlight.erase(loaded.page);
+			pages.push_back(std::move(loaded));
+		}
+		m_loaded.clear();
+	}
+	void PageLoader::finish() {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_pageLoaded.wait(lock, [this]() { return m_queue.empty() && m_numReading == 0; });
+	}
+	size_t PageLoader::getNumPending() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_queue.size() + m_numReading;
+	}
+	void PageLoader::run() {
+		while (true) {
+			uint32_t page;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_pageReady.wait(lock, [this]() { return !m_running || !m_queue.empty(); });
+				if (!m_running) {
+					return;
+				}
+				page = m_queue.front();
+				m_queue.pop_front();
+				m_inFlight.insert(page);
+				m_numReading++;
+			}
+			LoadedPage loaded;
+			loaded.page = page;
+			loaded.data.resize(m_file.getInfo().getPageBytes());
+			const bool read = m_file.readPage(page, loaded.data.data());
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_numReading--;
+				if (read) {
+					m_loaded.push_back(std::move(loaded));
+				}
+				else {
+					m_inFlight.erase(page);
+				}
+			}
+			m_pageLoaded.notify_all();
+		}
+	}
+
+	VirtualTexture::~VirtualTexture() {
+		close();
+	}
+	/// <summary>
+	/// The page table has a mip per virtual mip, so the shader fetches the texel of the mip it wants directly.
+	/// The atlas has one level: each page already is the right mip.
+	/// </summary>
+	bool VirtualTexture::open(const char* filePath, int atlasPagesPerSide, int feedbackScale) {
+		close();
+		if (!m_file.open(filePath)) {
+			printf("Failed to open virtual texture %s\n", filePath);
+			return false;
+		}
+		const VirtualTextureInfo& info = m_file.getInfo();
+		m_atlasPagesPerSide = std::clamp(atlasPagesPerSide, 1, 255);
+		m_feedbackScale = std::max(feedbackScale, 1);
+		m_cache = std::make_unique<PageCache>(info, m_atlasPagesPerSide);
+		m_loader = std::make_unique<PageLoader>(m_file);
+
+		glGenTextures(1, &m_pageTable);
+		renderState::bindTexture(0, GL_TEXTURE_2D, m_pageTable);
+		glTexStorage2D(GL_TEXTURE_2D, info.numMips, GL_RGBA8UI, info.getPagesPerSide(0), info.getPagesPerSide(0));
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		unsigned int internalFormat, pixelFormat;
+		getGLFormat(info.format, internalFormat, pixelFormat);
+		const int atlasSize = m_atlasPagesPerSide * info.getPhysicalPageSize();
+		glGenTextures(1, &m_atlas);
+		renderState::bindTexture(0, GL_TEXTURE_2D, m_atlas);
+		glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, atlasSize, atlasSize);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		renderState::bindTexture(0, GL_TEXTURE_2D, 0);
+
+		glGenBuffers(2, m_readback);
+
+		//The last mip is the fallback for everything, so it is loaded now and never evicted
+		const uint32_t lastPage = makePageId(info.numMips - 1, 0, 0);
+		std::vector<unsigned char> data(info.getPageBytes());
+		if (!m_file.readPage(lastPage, data.data())) {
+			close();
+			return false;
+		}
+		uploadPage(m_cache->insert(lastPage, true), data.data());
+		update(0);
+		return true;
+	}
+	void VirtualTexture::close() {
+		m_loader.reset();
+		m_cache.reset();
+		m_file.close();
+		if (m_pageTable) {
+			renderState::deleteTexture(m_pageTable);
+			renderState::deleteTexture(m_atlas);
+			renderState::deleteBuffer(m_readback[0]);
+			renderState::deleteBuffer(m_readback[1]);
+		}
+		if (m_feedback.fbo) {
+			deleteFramebuffer(m_feedback);
+		}
+		m_pageTable = m_atlas = 0;
+		m_readback[0] = m_readback[1] = 0;
+		m_readbackSize[0] = m_readbackSize[1] = 0;
+		m_ready.clear();
+	}
+	void VirtualTexture::beginFeedback(int width, int height) {
+		//Saved first, since creating the framebuffer unbinds the current one
+		glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_savedFramebuffer);
+		const int feedbackWidth = std::max(width / m_feedbackScale, 1), feedbackHeight = std::max(height / m_feedbackScale, 1);
+		if (m_feedback.width != feedbackWidth || m_feedback.height != feedbackHeight) {
+			if (m_feedback.fbo) {
+				deleteFramebuffer(m_feedback);
+			}
+			m_feedback = createFramebuffer(feedbackWidth, feedbackHeight, true);
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, m_feedback.fbo);
+		glViewport(0, 0, feedbackWidth, feedbackHeight);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	}
+	void VirtualTexture::endFeedback() {
+		const int buffer = m_nextReadback;
+		const int numTexels = m_feedback.width * m_feedback.height;
+		renderState::bindBuffer(GL_PIXEL_PACK_BUFFER, m_readback[buffer]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)numTexels * 4, NULL, GL_STREAM_READ);
+		glReadPixels(0, 0, m_feedback.width, m_feedback.height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+		renderState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		m_readbackSize[buffer] = numTexels;
+		m_nextReadback = 1 - buffer;
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_savedFramebuffer);
+		glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+	}
+	/// <summary>
+	/// Pages that arrived are mapped before the feedback is read, so it does not ask for them again.
+	/// The buffer read is the one endFeedback fills next, written two frames ago.
+	/// </summary>
+	int VirtualTexture::update(int maxUploads) {
+		if (!isOpen()) {
+			return 0;
+		}
+		m_loader->collect(m_ready);
+		int uploads = 0;
+		size_t used = 0;
+		for (; used < m_ready.size() && uploads < maxUploads; used++) {
+			const LoadedPage& loaded = m_ready[used];
+			if (m_cache->isResident(loaded.page)) {
+				continue;
+			}
+			const int slot = m_cache->insert(loaded.page);
+			if (slot >= 0) {
+				uploadPage(slot, loaded.data.data());
+				uploads++;
+			}
+		}
+		m_ready.erase(m_ready.begin(), m_ready.begin() + used);
+
+		const int buffer = m_nextReadback;
+		if (m_readbackSize[buffer] > 0) {
+			renderState::bindBuffer(GL_PIXEL_PACK_BUFFER, m_readback[buffer]);
+			const unsigned char* texels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)m_readbackSize[buffer] * 4, GL_MAP_READ_BIT);
+			if (texels) {
+				m_cache->processFeedback(texels, m_readbackSize[buffer], m_missing);
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				//Loaded pages still waiting for an upload are not read again
+				m_missing.erase(std::remove_if(m_missing.begin(), m_missing.end(), [this](uint32_t page) {
+					return std::any_of(m_ready.begin(), m_ready.end(), [page](const LoadedPage& loaded) { return loaded.page == page; });
+				}), m_missing.end());
+				m_loader->request(m_missing);
+			}
+			renderState::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			m_readbackSize[buffer] = 0;
+		}
+
+		const VirtualTextureInfo& info = m_file.getInfo();
+		for (int mip = 0; mip < info.numMips; mip++) {
+			if (m_cache->isTableDirty(mip)) {
+				const int pagesPerSide = info.getPagesPerSide(mip);
+				renderState::bindTexture(0, GL_TEXTURE_2D, m_pageTable);
+				glTexSubImage2D(GL_TEXTURE_2D, mip, 0, 0, pagesPerSide, pagesPerSide, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, m_cache->getTable(mip).data());
+			}
+		}
+		m_cache->clearDirty();
+		renderState::bindTexture(0, GL_TEXTURE_2D, 0);
+		return uploads;
+	}
+	void VirtualTexture::uploadPage(int slot, const unsigned char* data) {
+		const VirtualTextureInfo& info = m_file.getInfo();
+		const int physicalSize = info.getPhysicalPageSize();
+		const int x = m_cache->getSlotX(slot) * physicalSize, y = m_cache->getSlotY(slot) * physicalSize;
+		unsigned int internalFormat, pixelFormat;
+		getGLFormat(info.format, internalFormat, pixelFormat);
+		renderState::bindTexture(0, GL_TEXTURE_2D, m_atlas);
+		if (isCompressedFormat(info.format)) {
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, x, y, physicalSize, physicalSize, internalFormat, (GLsizei)info.getPageBytes(), data);
+		}
+		else {
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, physicalSize, physicalSize, pixelFormat, GL_UNSIGNED_BYTE, data);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		}
+	}
+	void VirtualTexture::setUniforms(const Shader& shader, int pageTableUnit, int atlasUnit) const {
+		const VirtualTextureInfo& info = m_file.getInfo();
+		shader.setInt("_PageTable", pageTableUnit);
+		shader.setInt("_PageAtlas", atlasUnit);
+		shader.setVec4("_VTParams", (float)info.size, (float)info.pageSize, (float)info.border, (float)(info.numMips - 1));
+		shader.setFloat("_VTAtlasSize", (float)(m_atlasPagesPerSide * info.getPhysicalPageSize()));
+	}
+	void VirtualTexture::setFeedbackUniforms(const Shader& shader) const {
+		const VirtualTextureInfo& info = m_file.getInfo();
+		shader.setVec4("_VTParams", (float)info.size, (float)info.pageSize, (float)info.border, (float)(info.numMips - 1));
+		shader.setFloat("_VTMipBias", -log2f((float)m_feedbackScale));
+	}
+}
@@ -0,0 +1,249 @@
+/*
+	Sparse virtual texturing, for color maps far larger than VRAM.
+	The image is cut into square pages at every mip and stored in a tiled file (.ewvt). Only the pages the camera
+	can see are kept on the GPU, in the slots of a physical atlas texture. A page table texture, one texel per
+	virtual page per mip, points each page at its slot, or at the slot of the finest resident page above it,
+	so a missing page draws blurrier rather than not at all.
+
+	Each frame a feedback pass draws the page every pixel wants into a small framebuffer. The CPU reads it back
+	two frames later, when the copy has long finished (PageCache::processFeedback), asks a PageLoader to read the
+	missing pages on a worker thread, and maps them into the atlas as they arrive, evicting the least recently
+	seen pages.
+	PageCache and PageLoader make no GL calls, so they can be driven by a feedback buffer built on the CPU.
+
+	File layout: VirtualTextureHeader, then every page of mip 0 row by row, then mip 1, up to the single page of
+	the last mip. Pages are pageSize + 2 * border pixels square, the border repeating neighboring pixels so
+	bilinear filtering never reads another page. Rows are packed as in textureCache. Little endian.
+*/
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <vector>
+#include <memory>
+#include <list>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
+#include "textureCache.h"
+#include "framebuffer.h"
+
+namespace ew {
+	class Shader;
+
+	struct VirtualTextureInfo {
+		int size = 0; //Width and height of mip 0, a power of two
+		int pageSize = 0; //Pixels per page side, not counting the border
+		int border = 0;
+		int numMips = 0; //The last mip is one page
+		TextureFormat format = TextureFormat::RGBA8;
+
+		inline int getPagesPerSide(int mip)const { return (size / pageSize) >> mip; }
+		inline int getPhysicalPageSize()const { return pageSize + 2 * border; }
+		//Bytes of one page in the file and in the atlas
+		size_t getPageBytes()const;
+	};
+
+	//Page ids pack a page's mip and position into 32 bits: mip << 24 | y << 12 | x
+	const uint32_t INVALID_PAGE = 0xFFFFFFFF;
+	inline uint32_t makePageId(int mip, int x, int y) { return (uint32_t)mip << 24 | (uint32_t)y << 12 | (uint32_t)x; }
+	inline int getPageMip(uint32_t page) { return (int)(page >> 24); }
+	inline int getPageX(uint32_t page) { return (int)(page & 0xFFF); }
+	inline int getPageY(uint32_t page) { return (int)((page >> 12) & 0xFFF); }
+
+	//Feedback texels are RGBA8: the low 8 bits of x and y, their high 4 bits, and the mip + 1.
+	//Alpha 0 means no page was wanted there (background, other objects).
+	void encodeFeedbackTexel(uint32_t page, unsigned char texel[4]);
+	uint32_t decodeFeedbackTexel(const unsigned char texel[4]);
+
+	struct VirtualTextureBuildOptions {
+		int pageSize = 128;
+		int border = 4;
+		//BC1 for RGB and BC7 for RGBA, as in textureCache. The border must keep pages a multiple of 4 pixels.
+		TextureCompression compression = TextureCompression::None;
+		unsigned int numThreads = 0; //0 uses one per core
+	};
+	//Writes a virtual texture file from tightly packed sRGB pixels, 3 or 4 channels, size x size with size a
+	//power of two no smaller than the page size. Mips are Kaiser filtered in linear space.
+	bool buildVirtualTexture(const char* filePath, const unsigned char* pixels, int size, int channels, const VirtualTextureBuildOptions& options = {});
+
+	//Random access to the pages of a virtual texture file. readPage is safe to call from several threads.
+	class VirtualTextureFile {
+	public:
+		VirtualTextureFile() {};
+		~VirtualTextureFile();
+		VirtualTextureFile(const VirtualTextureFile&) = delete;
+		VirtualTextureFile& operator=(const VirtualTextureFile&) = delete;
+
+		bool open(const char* filePath);
+		void close();
+		inline bool isOpen()const { return m_info.numMips > 0; }
+		inline const VirtualTextureInfo& getInfo()const { return m_info; }
+		//Copies getPageBytes() bytes of page into dst
+		bool readPage(uint32_t page, unsigned char* dst)const;
+	private:
+		size_t getPageOffset(uint32_t page)const;
+
+		VirtualTextureInfo m_info;
+		size_t m_dataStart = 0;
+		size_t m_fileSize = 0;
+		void* m_mapping = nullptr;
+		FILE* m_file = nullptr; //Without mmap, read under m_fileMutex
+		mutable std::mutex m_fileMutex;
+	};
+
+	struct PageCacheStats {
+		size_t requested = 0; //Distinct pages seen in feedback
+		size_t hits = 0; //...that were resident
+		size_t inserted = 0;
+		size_t evicted = 0;
+		size_t dropped = 0; //Loaded pages with no slot free of pages seen this frame
+	};
+
+	//Which virtual pages are in which atlas slots, and the page table that maps them. CPU only.
+	class PageCache {
+	public:
+		PageCache(const VirtualTextureInfo& info, int atlasPagesPerSide);
+
+		//Starts a frame from its feedback texels. Visible resident pages, and the resident pages drawn in place of
+		//missing ones, become most recently used. Fills missing with the visible pages that are not resident,
+		//coarsest first, then by how many texels wanted them.
+		void processFeedback(const unsigned char* texels, size_t numTexels, std::vector<uint32_t>& missing);
+		//Maps a loaded page into the least recently used slot and returns the slot. Returns -1, leaving the page out,
+		//if every slot holds a page seen this frame. A pinned page is never evicted.
+		int insert(uint32_t page, bool pin = false);
+		bool isResident(uint32_t page)const;
+		int getSlot(uint32_t page)const;
+		inline int getSlotX(int slot)const { return slot % m_atlasPagesPerSide; }
+		inline int getSlotY(int slot)const { return slot / m_atlasPagesPerSide; }
+		inline int getNumSlots()const { return (int)m_slots.size(); }
+		inline int getNumResident()const { return (int)m_resident.size(); }
+
+		//Page table texels for a mip, getPagesPerSide(mip) squared RGBA8: the slot's x and y, the mip of the page
+		//in it, and 255. Texels no resident page covers have mip 255.
+		inline const std::vector<unsigned char>& getTable(int mip)const { return m_tables[mip]; }
+		inline bool isTableDirty(int mip)const { return m_dirty[mip]; }
+		void clearDirty();
+
+		inline const PageCacheStats& getStats()const { return m_stats; }
+		inline const VirtualTextureInfo& getInfo()const { return m_info; }
+	private:
+		struct Slot {
+			uint32_t page = INVALID_PAGE;
+			uint64_t lastUsed = 0;
+			bool pinned = false;
+			std::list<int>::iterator lru;
+		};
+		void touch(int slot);
+		//Points the table texels under page that show a coarser page (or none) at slot
+		void mapPage(uint32_t page, int slot);
+		//Points the table texels that show page at whatever its parent texel shows
+		void unmapPage(uint32_t page);
+
+		VirtualTextureInfo m_info;
+		int m_atlasPagesPerSide;
+		std::vector<Slot> m_slots;
+		std::list<int> m_lru; //Least recently used first. Pinned slots are left out.
+		std::unordered_map<uint32_t, int> m_resident;
+		std::vector<std::vector<unsigned char>> m_tables;
+		std::vector<bool> m_dirty;
+		uint64_t m_frame = 0;
+		PageCacheStats m_stats;
+		std::unordered_map<uint32_t, uint32_t> m_counts; //processFeedback scratch
+	};
+
+	struct LoadedPage {
+		uint32_t page;
+		std::vector<unsigned char> data;
+	};
+
+	//Reads pages from a VirtualTextureFile on worker threads
+	class PageLoader {
+	public:
+		//0 threads picks one
+		explicit PageLoader(const VirtualTextureFile& file, unsigned int numThreads = 1);
+		~PageLoader();
+		PageLoader(const PageLoader&) = delete;
+		PageLoader& operator=(const PageLoader&) = delete;
+
+		//Replaces the queue with pages, highest priority first, skipping any being read or waiting to be collected.
+		//Pages queued before and no longer wanted are never read.
+		void request(const std::vector<uint32_t>& pages);
+		//Moves out the pages read since the last call
+		void collect(std::vector<LoadedPage>& pages);
+		//Waits until every queued page has been read
+		void finish();
+		size_t getNumPending();
+	private:
+		void run();
+
+		const VirtualTextureFile& m_file;
+		std::vector<std::thread> m_threads;
+		bool m_running = true;
+		std::mutex m_mutex;
+		std::condition_variable m_pageReady;
+		std::condition_variable m_pageLoaded;
+		std::deque<uint32_t> m_queue;
+		std::unordered_set<uint32_t> m_inFlight; //Being read, or read and not yet collected
+		std::vector<LoadedPage> m_loaded;
+		size_t m_numReading = 0;
+	};
+
+	//The GL side: page table and atlas textures, the feedback framebuffer, and a PageCache and PageLoader kept fed
+	class VirtualTexture {
+	public:
+		VirtualTexture() {};
+		~VirtualTexture();
+		VirtualTexture(const VirtualTexture&) = delete;
+		VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+		//Opens filePath and creates an atlas of atlasPagesPerSide squared slots. The feedback framebuffer is
+		//feedbackScale times smaller than the screen in each dimension. Loads and pins the last mip's page.
+		bool open(const char* filePath, int atlasPagesPerSide = 16, int feedbackScale = 8);
+		void close();
+		inline bool isOpen()const { return m_cache != nullptr; }
+
+		//Binds the feedback framebuffer for a screen of width x height and clears it. Draw everything that
+		//samples the texture with a feedback shader (vtFeedback.frag) and setFeedbackUniforms, then call endFeedback.
+		void beginFeedback(int width, int height);
+		//Starts reading the feedback back into a pixel buffer, and restores the framebuffer and viewport.
+		//The feedback is processed by the update() two frames from now.
+		void endFeedback();
+		//Processes the oldest feedback, queues missing pages, and uploads up to maxUploads loaded pages and
+		//any page table changes. Call once per frame on the GL thread. Returns the pages uploaded.
+		int update(int maxUploads = 32);
+
+		//Sets _PageTable and _PageAtlas to the given units and the sizes the shaders need
+		void setUniforms(const Shader& shader, int pageTableUnit, int atlasUnit)const;
+		//Sets the sizes, and a mip bias that makes up for the feedback framebuffer's lower resolution
+		void setFeedbackUniforms(const Shader& shader)const;
+		inline unsigned int getPageTable()const { return m_pageTable; }
+		inline unsigned int getAtlas()const { return m_atlas; }
+		inline const PageCache* getCache()const { return m_cache.get(); }
+		inline const VirtualTextureInfo& getInfo()const { return m_file.getInfo(); }
+		inline size_t getNumPending() { return m_loader ? m_loader->getNumPending() + m_ready.size() : 0; }
+	private:
+		void uploadPage(int slot, const unsigned char* data);
+
+		VirtualTextureFile m_file;
+		std::unique_ptr<PageCache> m_cache;
+		std::unique_ptr<PageLoader> m_loader;
+		unsigned int m_pageTable = 0;
+		unsigned int m_atlas = 0;
+		int m_atlasPagesPerSide = 0;
+		int m_feedbackScale = 8;
+		Framebuffer m_feedback;
+		int m_savedViewport[4] = {};
+		int m_savedFramebuffer = 0;
+		unsigned int m_readback[2] = { 0, 0 }; //Pixel buffers alternated between frames
+		int m_readbackSize[2] = { 0, 0 }; //Texels read into each, 0 if none pending
+		int m_nextReadback = 0;
+		std::vector<uint32_t> m_missing;
+		std::vector<LoadedPage> m_ready; //Loaded, waiting for an upload slot in a later frame
+	};
+}
@@ -2,39 +2,124 @@
     Author: Nate Spielman
 */
 #include "cubemap.h"
-#include "../ew/external/stb_image.h"
+#include <memory>
+#include <atomic>
 #include "../ew/external/glad.h"
+#include "../ew/renderState.h"
 
-namespace gjn {
-	unsigned int loadCubemap(std::vector<std::string> faces)
+namespace {
+	unsigned int createCubemapTexture()
 	{
 		unsigned int textureID;
 		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-        
-        int width, height, nrChannels;
-        for (unsigned int i = 0; i < faces.size(); i++)
-        {
-            unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-            if (data)
-            {
-                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                    0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data
-                );
-                stbi_image_free(data);
-            }
-            else
-            {
-                printf("Cubemap tex failed to load at path:", data);
-                stbi_image_free(data);
-            }
-        }
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
+		ew::renderState::bindTexture(0, GL_TEXTURE_CUBE_MAP, textureID);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, 0);
 		return textureID;
 	}
-}
\ No newline at end of file
+	gjn::Cubemap createCubemap(bool prefilter)
+	{
+		//Filtering across face edges keeps the seams out of the smaller mips
+		ew::renderState::setEnabled(GL_TEXTURE_CUBE_MAP_SEAMLESS, true);
+		gjn::Cubemap cubemap;
+		cubemap.environment = createCubemapTexture();
+		if (prefilter)
+		{
+			cubemap.specular = createCubemapTexture();
+			cubemap.irradiance = createCubemapTexture();
+		}
+		return cubemap;
+	}
+	void uploadChain(unsigned int textureID, const gjn::CubemapImage& image, const gjn::CubemapChain& chain)
+	{
+		if (textureID == 0 || chain.levels.empty())
+			return;
+		const bool isFloat = image.type == ew::PixelType::Float;
+		const GLenum format = image.channels == 4 ? GL_RGBA : GL_RGB;
+		const GLint internalFormat = isFloat ? (image.channels == 4 ? GL_RGBA16F : GL_RGB16F) : (image.channels == 4 ? GL_RGBA8 : GL_RGB8);
+		ew::renderState::bindTexture(0, GL_TEXTURE_CUBE_MAP, textureID);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (int level = 0; level < chain.getNumLevels(); level++)
+		{
+			const int size = chain.getSize(level);
+			for (int face = 0; face < 6; face++)
+			{
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, internalFormat, size, size, 0, format,
+					isFloat ? GL_FLOAT : GL_UNSIGNED_BYTE, chain.levels[level].data() + image.getFaceBytes(size) * face);
+			}
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, chain.getNumLevels() - 1);
+	}
+}
+
+namespace gjn {
+	unsigned int loadCubemap(std::vector<std::string> faces)
+	{
+		return loadEnvironment(faces).environment;
+	}
+	unsigned int loadCubemapAsync(ew::AssetLoader& loader, const std::vector<std::string>& faces)
+	{
+		return loadEnvironmentAsync(loader, faces).environment;
+	}
+	Cubemap loadEnvironment(const std::vector<std::string>& paths, const CubemapOptions& options)
+	{
+		Cubemap cubemap = createCubemap(options.prefilter);
+		CubemapImage image;
+		if (loadCubemapImage(paths, image, options))
+			uploadCubemapImage(cubemap, image);
+		return cubemap;
+	}
+	Cubemap loadEnvironmentAsync(ew::AssetLoader& loader, const std::vector<std::string>& paths, const CubemapOptions& options)
+	{
+		Cubemap cubemap = createCubemap(options.prefilter);
+		if (paths.empty())
+			return cubemap;
+		if (options.useCache && isCubemapCacheCurrent(paths, options))
+		{
+			loader.load(paths[0], [cubemap, paths, options]() -> std::function<void()> {
+				auto image = std::make_shared<CubemapImage>();
+				if (!loadCubemapImage(paths, *image, options))
+					return {};
+				return [cubemap, image]() { uploadCubemapImage(cubemap, *image); };
+			});
+			return cubemap;
+		}
+
+		struct Build {
+			std::vector<CubemapSource> sources;
+			std::atomic<int> remaining;
+			std::atomic<bool> failed;
+		};
+		auto build = std::make_shared<Build>();
+		build->sources.resize(paths.size());
+		build->remaining = (int)paths.size();
+		build->failed = false;
+		for (size_t i = 0; i < paths.size(); i++)
+		{
+			loader.load(paths[i], [cubemap, paths, options, build, i]() -> std::function<void()> {
+				if (!decodeCubemapSource(paths[i].c_str(), build->sources[i]))
+					build->failed = true;
+				if (--build->remaining > 0 || build->failed)
+					return {};
+				auto image = std::make_shared<CubemapImage>();
+				const bool built = buildCubemapImage(paths, build->sources, *image, options);
+				build->sources.clear();
+				if (!built)
+					return {};
+				return [cubemap, image]() { uploadCubemapImage(cubemap, *image); };
+			});
+		}
+		return cubemap;
+	}
+	void uploadCubemapImage(const Cubemap& cubemap, const CubemapImage& image)
+	{
+		uploadChain(cubemap.environment, image, image.environment);
+		uploadChain(cubemap.specular, image, image.specular);
+		uploadChain(cubemap.irradiance, image, image.irradiance);
+	}
+}
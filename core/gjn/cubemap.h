@@ -4,7 +4,26 @@
 #pragma once
 #include <sstream>
 #include <vector>
+#include "../ew/assetLoader.h"
+#include "cubemapImage.h"
 
 namespace gjn {
+	//Cubemap texture handles. specular and irradiance are 0 unless loaded with options.prefilter.
+	struct Cubemap {
+		unsigned int environment = 0;
+		unsigned int specular = 0; //Level l is for roughness l / (levels - 1). textureQueryLevels gives the count.
+		unsigned int irradiance = 0;
+	};
+
+	//Loads the six faces in GL order with box filtered mips. Faces may be any channel count; see cubemapImage.h.
 	unsigned int loadCubemap(std::vector<std::string> faces);
-}
\ No newline at end of file
+	//Returns the cubemap handle right away. Each face is decoded as its own job and uploaded by loader.update().
+	unsigned int loadCubemapAsync(ew::AssetLoader& loader, const std::vector<std::string>& faces);
+	//As loadCubemap, from six faces or one image in any layout in cubemapImage.h
+	Cubemap loadEnvironment(const std::vector<std::string>& paths, const CubemapOptions& options = {});
+	//Returns the handles right away, empty until loader.update() uploads them. Loads a current cache in one job;
+	//otherwise decodes each source as its own job, and the last one to finish builds the rest.
+	Cubemap loadEnvironmentAsync(ew::AssetLoader& loader, const std::vector<std::string>& paths, const CubemapOptions& options = {});
+	//Uploads every level of image into cubemap's textures
+	void uploadCubemapImage(const Cubemap& cubemap, const CubemapImage& image);
+}
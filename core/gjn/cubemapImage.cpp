@@ -0,0 +1,665 @@
+#include "cubemapImage.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <thread>
+#include <filesystem>
+#include <algorithm>
+#include <system_error>
+#include "../ew/ewMath/ewMath.h"
+#include "../ew/imageDecoder.h"
+
+namespace {
+	using ew::PixelType;
+	using ew::Vec3;
+
+	const char MAGIC[4] = { 'E', 'W', 'C', 'B' };
+	const uint32_t VERSION = 1;
+	const uint32_t FLAG_PREFILTERED = 1;
+	const int MAX_SOURCES = 6;
+	const int IRRADIANCE_SOURCE_SIZE = 64; //Largest level projected onto spherical harmonics for irradiance
+	const float PI = 3.14159265f;
+
+	//Identifies the version of a source a cache was built from
+	struct SourceStamp {
+		uint64_t size;
+		int64_t time;
+	};
+	struct FileHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t flags;
+		uint32_t channels;
+		uint32_t type; //ew::PixelType
+		uint32_t size;
+		uint32_t numLevels;
+		uint32_t specularSize; //As asked for in the options, so a cache built with other settings is rebuilt
+		uint32_t specularLevels;
+		uint32_t specularSamples;
+		uint32_t irradianceSize;
+		uint32_t numSources;
+		uint32_t specularBaseSize; //As built
+		uint32_t specularNumLevels;
+		SourceStamp sources[MAX_SOURCES];
+	};
+
+	std::string getCachePath(const std::vector<std::string>& paths) {
+		return paths[0] + ".ewcube";
+	}
+	bool getSourceStamps(const std::vector<std::string>& paths, SourceStamp* stamps) {
+		if (paths.empty() || paths.size() > MAX_SOURCES)
+			return false;
+		for (size_t i = 0; i < MAX_SOURCES; i++) {
+			stamps[i] = {};
+			if (i >= paths.size())
+				continue;
+			std::error_code error;
+			stamps[i].size = std::filesystem::file_size(paths[i], error);
+			if (error)
+				return false;
+			stamps[i].time = (int64_t)std::filesystem::last_write_time(paths[i], error).time_since_epoch().count();
+			if (error)
+				return false;
+		}
+		return true;
+	}
+	bool readHeader(FILE* file, const std::vector<std::string>& paths, const gjn::CubemapOptions& options, FileHeader& header) {
+		SourceStamp stamps[MAX_SOURCES];
+		if (!getSourceStamps(paths, stamps) || fread(&header, sizeof(header), 1, file) != 1)
+			return false;
+		const bool prefiltered = (header.flags & FLAG_PREFILTERED) != 0;
+		return memcmp(header.magic, MAGIC, 4) == 0 && header.version == VERSION
+			&& header.numSources == paths.size() && memcmp(header.sources, stamps, sizeof(stamps)) == 0
+			&& (header.channels == 3 || header.channels == 4)
+			&& (header.type == (uint32_t)PixelType::UInt8 || header.type == (uint32_t)PixelType::Float)
+			&& header.size > 0 && header.numLevels > 0 && header.numLevels <= 32
+			&& (!options.prefilter || (prefiltered && header.specularSize == (uint32_t)options.specularSize
+				&& header.specularLevels == (uint32_t)options.specularLevels && header.specularSamples == (uint32_t)options.specularSamples
+				&& header.irradianceSize == (uint32_t)options.irradianceSize))
+			&& (!prefiltered || (header.specularBaseSize > 0 && header.specularNumLevels > 0 && header.specularNumLevels <= 32 && header.irradianceSize > 0));
+	}
+	bool readChain(FILE* file, const gjn::CubemapImage& image, int size, int numLevels, gjn::CubemapChain& chain) {
+		chain.size = size;
+		chain.levels.resize(numLevels);
+		for (int level = 0; level < numLevels; level++) {
+			chain.levels[level].resize(image.getFaceBytes(chain.getSize(level)) * 6);
+			if (fread(chain.levels[level].data(), 1, chain.levels[level].size(), file) != chain.levels[level].size())
+				return false;
+		}
+		return true;
+	}
+	bool writeChain(FILE* file, const gjn::CubemapChain& chain) {
+		for (const std::vector<unsigned char>& level : chain.levels) {
+			if (fwrite(level.data(), 1, level.size(), file) != level.size())
+				return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Writes to a temporary file and renames it over the cache, so a reader never sees half a file
+	/// </summary>
+	bool writeCache(const std::vector<std::string>& paths, const gjn::CubemapImage& image, const gjn::CubemapOptions& options) {
+		FileHeader header = {};
+		if (!getSourceStamps(paths, header.sources))
+			return false;
+		memcpy(header.magic, MAGIC, 4);
+		header.version = VERSION;
+		header.flags = image.specular.levels.empty() ? 0 : FLAG_PREFILTERED;
+		header.channels = image.channels;
+		header.type = (uint32_t)image.type;
+		header.size = image.environment.size;
+		header.numLevels = image.environment.getNumLevels();
+		if (header.flags & FLAG_PREFILTERED) {
+			header.specularSize = options.specularSize;
+			header.specularLevels = options.specularLevels;
+			header.specularSamples = options.specularSamples;
+			header.irradianceSize = options.irradianceSize;
+			header.specularBaseSize = image.specular.size;
+			header.specularNumLevels = image.specular.getNumLevels();
+		}
+		header.numSources = (uint32_t)paths.size();
+
+		const std::string cachePath = getCachePath(paths);
+		std::string tempPath = cachePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+		FILE* file = fopen(tempPath.c_str(), "wb");
+		if (!file)
+			return false;
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && writeChain(file, image.environment)
+			&& writeChain(file, image.specular) && writeChain(file, image.irradiance);
+		ok = fclose(file) == 0 && ok;
+		std::error_code error;
+		if (ok) {
+			std::filesystem::rename(tempPath, cachePath, error);
+		}
+		if (!ok || error) {
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Runs fn(begin, end) over [0, count) split across one thread per core, the caller taking the first part
+	/// </summary>
+	template<typename Fn>
+	void parallelFor(int count, const Fn& fn) {
+		if (count <= 0)
+			return;
+		const int numThreads = std::min(count, (int)std::max(1u, std::thread::hardware_concurrency()));
+		const int perThread = (count + numThreads - 1) / numThreads;
+		std::vector<std::thread> threads;
+		for (int begin = perThread; begin < count; begin += perThread) {
+			threads.emplace_back(fn, begin, std::min(count, begin + perThread));
+		}
+		fn(0, std::min(count, perThread));
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+	}
+
+	//Texel to linear color and back. 8 bit color is sRGB, alpha and float are linear.
+	void readLinear(const unsigned char* pixel, int channels, PixelType type, float* color) {
+		color[3] = 1.0f;
+		for (int c = 0; c < channels; c++) {
+			if (type == PixelType::Float)
+				color[c] = ((const float*)pixel)[c];
+			else
+				color[c] = c < 3 ? ew::srgbToLinear(pixel[c]) : pixel[c] / 255.0f;
+		}
+	}
+	void writeEncoded(const float* color, int channels, PixelType type, unsigned char* pixel) {
+		for (int c = 0; c < channels; c++) {
+			if (type == PixelType::Float)
+				((float*)pixel)[c] = color[c];
+			else
+				pixel[c] = c < 3 ? ew::linearToSrgb(color[c]) : (unsigned char)(std::min(std::max(color[c], 0.0f), 1.0f) * 255.0f + 0.5f);
+		}
+	}
+
+	Vec3 getTexelDirection(int face, int x, int y, int size) {
+		return gjn::getCubemapDirection(face, 2.0f * (x + 0.5f) / size - 1.0f, 2.0f * (y + 0.5f) / size - 1.0f);
+	}
+	//Solid angle of a face texel, from the area of its corners' projection onto the unit sphere
+	float areaElement(float x, float y) {
+		return atan2f(x * y, sqrtf(x * x + y * y + 1.0f));
+	}
+	float getTexelSolidAngle(int x, int y, int size) {
+		const float x0 = 2.0f * x / size - 1.0f, x1 = 2.0f * (x + 1) / size - 1.0f;
+		const float y0 = 2.0f * y / size - 1.0f, y1 = 2.0f * (y + 1) / size - 1.0f;
+		return areaElement(x0, y0) - areaElement(x0, y1) - areaElement(x1, y0) + areaElement(x1, y1);
+	}
+
+	/// <summary>
+	/// Samples a 2:1 equirectangular image bilinearly in linear space, wrapping around and clamping at the poles
+	/// </summary>
+	void sampleEquirectangular(const gjn::CubemapSource& source, const Vec3& direction, float* color) {
+		const float u = 0.5f + atan2f(direction.x, -direction.z) / (2.0f * PI);
+		const float v = acosf(std::min(std::max(direction.y / ew::Magnitude(direction), -1.0f), 1.0f)) / PI;
+		const float px = u * source.width - 0.5f, py = v * source.height - 0.5f;
+		const int x0 = (int)floorf(px), y0 = (int)floorf(py);
+		const float fx = px - x0, fy = py - y0;
+		const size_t pixelSize = ew::getPixelSize(source.type, source.channels);
+		for (int c = 0; c < 4; c++) {
+			color[c] = 0.0f;
+		}
+		for (int i = 0; i < 4; i++) {
+			const int x = ((x0 + i % 2) % source.width + source.width) % source.width;
+			const int y = std::min(std::max(y0 + i / 2, 0), source.height - 1);
+			const float weight = (i % 2 ? fx : 1.0f - fx) * (i / 2 ? fy : 1.0f - fy);
+			float texel[4];
+			readLinear(&source.pixels[((size_t)y * source.width + x) * pixelSize], source.channels, source.type, texel);
+			for (int c = 0; c < 4; c++) {
+				color[c] += texel[c] * weight;
+			}
+		}
+	}
+	void projectEquirectangular(const gjn::CubemapSource& source, int size, PixelType type, int channels, unsigned char* faces) {
+		const size_t pixelSize = ew::getPixelSize(type, channels);
+		parallelFor(6 * size, [&](int begin, int end) {
+			for (int row = begin; row < end; row++) {
+				const int face = row / size, y = row % size;
+				unsigned char* out = faces + ((size_t)face * size + y) * size * pixelSize;
+				for (int x = 0; x < size; x++) {
+					float color[4];
+					sampleEquirectangular(source, getTexelDirection(face, x, y, size), color);
+					writeEncoded(color, channels, type, out + x * pixelSize);
+				}
+			}
+		});
+	}
+	/// <summary>
+	/// Copies the faces out of a horizontal or vertical cross. -Z of a vertical cross is upside down.
+	/// </summary>
+	void cutCross(const gjn::CubemapSource& source, int size, bool vertical, unsigned char* faces) {
+		//Column and row of each face, in faces
+		const int horizontalCells[6][2] = { { 2, 1 }, { 0, 1 }, { 1, 0 }, { 1, 2 }, { 1, 1 }, { 3, 1 } };
+		const int verticalCells[6][2] = { { 2, 1 }, { 0, 1 }, { 1, 0 }, { 1, 2 }, { 1, 1 }, { 1, 3 } };
+		const size_t pixelSize = ew::getPixelSize(source.type, source.channels);
+		for (int face = 0; face < 6; face++) {
+			const int* cell = vertical ? verticalCells[face] : horizontalCells[face];
+			const bool rotated = vertical && face == 5;
+			for (int y = 0; y < size; y++) {
+				unsigned char* out = faces + ((size_t)face * size + y) * size * pixelSize;
+				const int sourceY = cell[1] * size + (rotated ? size - 1 - y : y);
+				const unsigned char* row = &source.pixels[((size_t)sourceY * source.width + cell[0] * size) * pixelSize];
+				if (!rotated) {
+					memcpy(out, row, size * pixelSize);
+					continue;
+				}
+				for (int x = 0; x < size; x++) {
+					memcpy(out + x * pixelSize, row + (size_t)(size - 1 - x) * pixelSize, pixelSize);
+				}
+			}
+		}
+	}
+	void expandToRGBA(gjn::CubemapSource& source) {
+		const size_t numPixels = (size_t)source.width * source.height;
+		const size_t channelSize = (size_t)source.type;
+		std::vector<unsigned char> pixels(numPixels * 4 * channelSize);
+		for (size_t i = 0; i < numPixels; i++) {
+			memcpy(&pixels[i * 4 * channelSize], &source.pixels[i * 3 * channelSize], 3 * channelSize);
+			if (source.type == PixelType::Float)
+				((float*)pixels.data())[i * 4 + 3] = 1.0f;
+			else
+				pixels[i * 4 + 3] = 255;
+		}
+		source.pixels.swap(pixels);
+		source.channels = 4;
+	}
+
+	//Linear RGB faces of one level, for prefiltering
+	struct FloatCube {
+		int size = 0;
+		std::vector<float> texels;
+	};
+	FloatCube toFloatCube(const std::vector<unsigned char>& level, int size, int channels, PixelType type) {
+		FloatCube cube;
+		cube.size = size;
+		cube.texels.resize((size_t)6 * size * size * 3);
+		const size_t pixelSize = ew::getPixelSize(type, channels);
+		for (size_t i = 0; i < (size_t)6 * size * size; i++) {
+			float color[4];
+			readLinear(&level[i * pixelSize], channels, type, color);
+			memcpy(&cube.texels[i * 3], color, sizeof(float) * 3);
+		}
+		return cube;
+	}
+	//Bilinear within the face the direction hits, clamped at its edges
+	void sampleCube(const FloatCube& cube, const Vec3& direction, float* color) {
+		float s, t;
+		const int face = gjn::getCubemapFace(direction, s, t);
+		const float px = (s + 1.0f) * 0.5f * cube.size - 0.5f, py = (t + 1.0f) * 0.5f * cube.size - 0.5f;
+		const int x0 = (int)floorf(px), y0 = (int)floorf(py);
+		const float fx = px - x0, fy = py - y0;
+		color[0] = color[1] = color[2] = 0.0f;
+		for (int i = 0; i < 4; i++) {
+			const int x = std::min(std::max(x0 + i % 2, 0), cube.size - 1);
+			const int y = std::min(std::max(y0 + i / 2, 0), cube.size - 1);
+			const float weight = (i % 2 ? fx : 1.0f - fx) * (i / 2 ? fy : 1.0f - fy);
+			const float* texel = &cube.texels[(((size_t)face * cube.size + y) * cube.size + x) * 3];
+			color[0] += texel[0] * weight;
+			color[1] += texel[1] * weight;
+			color[2] += texel[2] * weight;
+		}
+	}
+	void sampleChain(const std::vector<FloatCube>& chain, const Vec3& direction, float lod, float* color) {
+		lod = std::min(std::max(lod, 0.0f), (float)(chain.size() - 1));
+		const int level = std::min((int)lod, (int)chain.size() - 2);
+		sampleCube(chain[std::max(level, 0)], direction, color);
+		if (level < 0)
+			return;
+		const float blend = lod - level;
+		float next[3];
+		sampleCube(chain[level + 1], direction, next);
+		for (int c = 0; c < 3; c++) {
+			color[c] += (next[c] - color[c]) * blend;
+		}
+	}
+
+	struct GGXSample {
+		Vec3 direction; //Tangent space, around +Z
+		float weight;
+		float lod;
+	};
+	float radicalInverse(uint32_t bits) {
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return bits * 2.3283064365386963e-10f;
+	}
+	/// <summary>
+	/// Light directions importance sampled from GGX at roughness, for a view straight down the normal as in the
+	/// split sum approximation. Each is read from the mip whose texels match the solid angle it stands for, which
+	/// keeps few samples from turning bright texels into speckles.
+	/// </summary>
+	std::vector<GGXSample> makeGGXSamples(float roughness, int numSamples, int baseSize) {
+		const float alpha = roughness * roughness;
+		const float texelSolidAngle = 4.0f * PI / (6.0f * baseSize * baseSize);
+		std::vector<GGXSample> samples;
+		for (int i = 0; i < numSamples; i++) {
+			const float u = (i + 0.5f) / numSamples, v = radicalInverse((uint32_t)i);
+			const float phi = 2.0f * PI * u;
+			const float cosTheta = sqrtf((1.0f - v) / (1.0f + (alpha * alpha - 1.0f) * v));
+			const float sinTheta = sqrtf(1.0f - cosTheta * cosTheta);
+			const Vec3 half(sinTheta * cosf(phi), sinTheta * sinf(phi), cosTheta);
+			const Vec3 light = half * (2.0f * cosTheta) - Vec3(0.0f, 0.0f, 1.0f);
+			if (light.z <= 0.0f)
+				continue;
+			//With the view on the normal, pdf(light) = D(h) / 4
+			const float d = alpha * alpha / (PI * powf(cosTheta * cosTheta * (alpha * alpha - 1.0f) + 1.0f, 2.0f));
+			const float sampleSolidAngle = 1.0f / (numSamples * d * 0.25f + 1e-6f);
+			samples.push_back({ light, light.z, std::max(0.5f * log2f(sampleSolidAngle / texelSolidAngle) + 1.0f, 0.0f) });
+		}
+		return samples;
+	}
+	void prefilterSpecular(const std::vector<FloatCube>& chain, float roughness, int numSamples, const gjn::CubemapImage& image, std::vector<unsigned char>& level, int size) {
+		const std::vector<GGXSample> samples = makeGGXSamples(roughness, numSamples, chain[0].size);
+		const size_t pixelSize = ew::getPixelSize(image.type, image.channels);
+		level.resize(pixelSize * 6 * size * size);
+		parallelFor(6 * size, [&](int begin, int end) {
+			for (int row = begin; row < end; row++) {
+				const int face = row / size, y = row % size;
+				for (int x = 0; x < size; x++) {
+					const Vec3 normal = ew::Normalize(getTexelDirection(face, x, y, size));
+					const Vec3 up = fabsf(normal.z) < 0.999f ? Vec3(0.0f, 0.0f, 1.0f) : Vec3(1.0f, 0.0f, 0.0f);
+					const Vec3 tangent = ew::Normalize(ew::Cross(up, normal));
+					const Vec3 bitangent = ew::Cross(normal, tangent);
+					float sum[4] = {}, total = 0.0f;
+					for (const GGXSample& sample : samples) {
+						const Vec3 direction = tangent * sample.direction.x + bitangent * sample.direction.y + normal * sample.direction.z;
+						float color[3];
+						sampleChain(chain, direction, sample.lod, color);
+						for (int c = 0; c < 3; c++) {
+							sum[c] += color[c] * sample.weight;
+						}
+						total += sample.weight;
+					}
+					for (int c = 0; c < 3; c++) {
+						sum[c] /= std::max(total, 1e-6f);
+					}
+					sum[3] = 1.0f;
+					writeEncoded(sum, image.channels, image.type, &level[(((size_t)face * size + y) * size + x) * pixelSize]);
+				}
+			}
+		});
+	}
+
+	//The first 9 real spherical harmonics
+	void evaluateSH(const Vec3& d, float* basis) {
+		basis[0] = 0.282095f;
+		basis[1] = 0.488603f * d.y;
+		basis[2] = 0.488603f * d.z;
+		basis[3] = 0.488603f * d.x;
+		basis[4] = 1.092548f * d.x * d.y;
+		basis[5] = 1.092548f * d.y * d.z;
+		basis[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+		basis[7] = 1.092548f * d.x * d.z;
+		basis[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+	}
+	/// <summary>
+	/// Irradiance from a 9 coefficient spherical harmonic projection of the environment, convolved with the cosine
+	/// lobe. Stored divided by pi, the light a white diffuse surface reflects.
+	/// </summary>
+	void buildIrradiance(const FloatCube& cube, const gjn::CubemapImage& image, std::vector<unsigned char>& level, int size) {
+		float sh[9][3] = {};
+		for (int face = 0; face < 6; face++) {
+			for (int y = 0; y < cube.size; y++) {
+				for (int x = 0; x < cube.size; x++) {
+					const float solidAngle = getTexelSolidAngle(x, y, cube.size);
+					const float* texel = &cube.texels[(((size_t)face * cube.size + y) * cube.size + x) * 3];
+					float basis[9];
+					evaluateSH(ew::Normalize(getTexelDirection(face, x, y, cube.size)), basis);
+					for (int i = 0; i < 9; i++) {
+						for (int c = 0; c < 3; c++) {
+							sh[i][c] += texel[c] * basis[i] * solidAngle;
+						}
+					}
+				}
+			}
+		}
+		const float bandScale[9] = { PI, 2.0f * PI / 3.0f, 2.0f * PI / 3.0f, 2.0f * PI / 3.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f };
+		const size_t pixelSize = ew::getPixelSize(image.type, image.channels);
+		level.resize(pixelSize * 6 * size * size);
+		for (int face = 0; face < 6; face++) {
+			for (int y = 0; y < size; y++) {
+				for (int x = 0; x < size; x++) {
+					float basis[9];
+					evaluateSH(ew::Normalize(getTexelDirection(face, x, y, size)), basis);
+					float color[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+					for (int i = 0; i < 9; i++) {
+						for (int c = 0; c < 3; c++) {
+							color[c] += bandScale[i] * sh[i][c] * basis[i] / PI;
+						}
+					}
+					for (int c = 0; c < 3; c++) {
+						color[c] = std::max(color[c], 0.0f);
+					}
+					writeEncoded(color, image.channels, image.type, &level[(((size_t)face * size + y) * size + x) * pixelSize]);
+				}
+			}
+		}
+	}
+
+	void buildMips(gjn::CubemapImage& image) {
+		ew::ResampleOptions options;
+		options.srgbChannels = image.type == PixelType::UInt8 ? 3 : 0;
+		options.numThreads = 0;
+		gjn::CubemapChain& chain = image.environment;
+		for (int level = 1; chain.getSize(level - 1) > 1; level++) {
+			const int parentSize = chain.getSize(level - 1), size = chain.getSize(level);
+			chain.levels.emplace_back(image.getFaceBytes(size) * 6);
+			for (int face = 0; face < 6; face++) {
+				ew::downsampleImage(chain.levels[level - 1].data() + image.getFaceBytes(parentSize) * face, parentSize, parentSize,
+					chain.levels[level].data() + image.getFaceBytes(size) * face, image.channels, image.type, options);
+			}
+		}
+	}
+	/// <summary>
+	/// The specular chain starts from the environment mip no larger than options.specularSize, level 0 a copy of it
+	/// </summary>
+	void prefilter(gjn::CubemapImage& image, const gjn::CubemapOptions& options) {
+		const gjn::CubemapChain& environment = image.environment;
+		int baseLevel = 0;
+		while (baseLevel + 1 < environment.getNumLevels() && environment.getSize(baseLevel) > std::max(options.specularSize, 1)) {
+			baseLevel++;
+		}
+		std::vector<FloatCube> chain;
+		for (int level = baseLevel; level < environment.getNumLevels(); level++) {
+			chain.push_back(toFloatCube(environment.levels[level], environment.getSize(level), image.channels, image.type));
+		}
+		image.specular.size = environment.getSize(baseLevel);
+		const int numLevels = std::max(1, std::min(options.specularLevels, (int)chain.size()));
+		image.specular.levels.resize(numLevels);
+		image.specular.levels[0] = environment.levels[baseLevel];
+		for (int level = 1; level < numLevels; level++) {
+			prefilterSpecular(chain, (float)level / (numLevels - 1), std::max(options.specularSamples, 1), image,
+				image.specular.levels[level], image.specular.getSize(level));
+		}
+
+		size_t irradianceSource = 0;
+		while (irradianceSource + 1 < chain.size() && chain[irradianceSource].size > IRRADIANCE_SOURCE_SIZE) {
+			irradianceSource++;
+		}
+		image.irradiance.size = std::max(options.irradianceSize, 1);
+		image.irradiance.levels.resize(1);
+		buildIrradiance(chain[irradianceSource], image, image.irradiance.levels[0], image.irradiance.size);
+	}
+}
+
+namespace gjn {
+	Vec3 getCubemapDirection(int face, float s, float t) {
+		switch (face) {
+		case 0:
+			return Vec3(1.0f, -t, -s);
+		case 1:
+			return Vec3(-1.0f, -t, s);
+		case 2:
+			return Vec3(s, 1.0f, t);
+		case 3:
+			return Vec3(s, -1.0f, -t);
+		case 4:
+			return Vec3(s, -t, 1.0f);
+		default:
+			return Vec3(-s, -t, -1.0f);
+		}
+	}
+	int getCubemapFace(const Vec3& direction, float& s, float& t) {
+		const float ax = fabsf(direction.x), ay = fabsf(direction.y), az = fabsf(direction.z);
+		if (ax >= ay && ax >= az) {
+			s = (direction.x > 0.0f ? -direction.z : direction.z) / ax;
+			t = -direction.y / ax;
+			return direction.x > 0.0f ? 0 : 1;
+		}
+		if (ay >= az) {
+			s = direction.x / ay;
+			t = (direction.y > 0.0f ? direction.z : -direction.z) / ay;
+			return direction.y > 0.0f ? 2 : 3;
+		}
+		s = (direction.z > 0.0f ? direction.x : -direction.x) / az;
+		t = -direction.y / az;
+		return direction.z > 0.0f ? 4 : 5;
+	}
+
+	/// <summary>
+	/// Reads the six faces in parallel, the caller decoding the first
+	/// </summary>
+	bool loadCubemapImage(const std::vector<std::string>& paths, CubemapImage& image, const CubemapOptions& options) {
+		if (options.useCache && readCubemapCache(paths, image, options))
+			return true;
+		std::vector<CubemapSource> sources(paths.size());
+		std::vector<char> decoded(paths.size(), 0);
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < paths.size(); i++) {
+			threads.emplace_back([&, i]() { decoded[i] = decodeCubemapSource(paths[i].c_str(), sources[i]); });
+		}
+		if (!paths.empty()) {
+			decoded[0] = decodeCubemapSource(paths[0].c_str(), sources[0]);
+		}
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+		if (std::find(decoded.begin(), decoded.end(), 0) != decoded.end())
+			return false;
+		return buildCubemapImage(paths, sources, image, options);
+	}
+	bool isCubemapCacheCurrent(const std::vector<std::string>& paths, const CubemapOptions& options) {
+		if (paths.empty())
+			return false;
+		FILE* file = fopen(getCachePath(paths).c_str(), "rb");
+		if (!file)
+			return false;
+		FileHeader header;
+		const bool current = readHeader(file, paths, options, header);
+		fclose(file);
+		return current;
+	}
+	bool readCubemapCache(const std::vector<std::string>& paths, CubemapImage& image, const CubemapOptions& options) {
+		if (paths.empty())
+			return false;
+		FILE* file = fopen(getCachePath(paths).c_str(), "rb");
+		if (!file)
+			return false;
+		FileHeader header;
+		image = CubemapImage();
+		bool ok = readHeader(file, paths, options, header);
+		if (ok) {
+			image.channels = header.channels;
+			image.type = (PixelType)header.type;
+			ok = readChain(file, image, header.size, header.numLevels, image.environment);
+			//A prefiltered cache serves a plain load too, without reading the rest
+			if (ok && options.prefilter) {
+				ok = readChain(file, image, header.specularBaseSize, header.specularNumLevels, image.specular)
+					&& readChain(file, image, header.irradianceSize, 1, image.irradiance);
+			}
+		}
+		fclose(file);
+		if (!ok) {
+			image = CubemapImage();
+			return false;
+		}
+		image.fromCache = true;
+		return true;
+	}
+	bool decodeCubemapSource(const char* path, CubemapSource& source) {
+		ew::ImageFile file;
+		ew::DecodeOptions options;
+		if (file.open(path)) {
+			const ew::ImageInfo& info = file.getInfo();
+			options.channels = info.type == PixelType::Float ? 3 : (info.channels == 2 || info.channels == 4 ? 4 : 3);
+			source.width = info.width;
+			source.height = info.height;
+			source.channels = options.channels;
+			source.type = info.type;
+			source.pixels.resize(file.getDecodedSize(options));
+			if (file.decode(source.pixels.data(), options))
+				return true;
+		}
+		printf("Cubemap tex failed to load at path: %s\n", path);
+		return false;
+	}
+	bool buildCubemapImage(const std::vector<std::string>& paths, std::vector<CubemapSource>& sources, CubemapImage& image, const CubemapOptions& options) {
+		if (sources.empty() || sources.size() != paths.size() || (sources.size() != 1 && sources.size() != 6)) {
+			printf("A cubemap needs six faces or one image, got %d\n", (int)sources.size());
+			return false;
+		}
+		image = CubemapImage();
+		image.type = sources[0].type;
+		image.channels = 3;
+		for (const CubemapSource& source : sources) {
+			if (source.type != image.type) {
+				printf("Cubemap faces mix HDR and 8 bit images: %s\n", paths[0].c_str());
+				return false;
+			}
+			image.channels = std::max(image.channels, source.channels);
+		}
+		for (CubemapSource& source : sources) {
+			if (source.channels < image.channels)
+				expandToRGBA(source);
+		}
+
+		CubemapChain& environment = image.environment;
+		environment.levels.resize(1);
+		std::vector<unsigned char>& faces = environment.levels[0];
+		const CubemapSource& first = sources[0];
+		if (sources.size() == 6) {
+			environment.size = first.width;
+			for (size_t i = 0; i < sources.size(); i++) {
+				if (sources[i].width != environment.size || sources[i].height != environment.size) {
+					printf("Cubemap face %s is %dx%d, not %dx%d\n", paths[i].c_str(), sources[i].width, sources[i].height, environment.size, environment.size);
+					return false;
+				}
+				faces.insert(faces.end(), sources[i].pixels.begin(), sources[i].pixels.end());
+			}
+		}
+		else if (first.width == first.height * 2) {
+			environment.size = std::max(first.width / 4, 1);
+			faces.resize(image.getFaceBytes(environment.size) * 6);
+			projectEquirectangular(first, environment.size, image.type, image.channels, faces.data());
+		}
+		else if (first.width * 3 == first.height * 4 || first.width * 4 == first.height * 3) {
+			const bool vertical = first.width * 4 == first.height * 3;
+			environment.size = vertical ? first.width / 3 : first.width / 4;
+			faces.resize(image.getFaceBytes(environment.size) * 6);
+			cutCross(first, environment.size, vertical, faces.data());
+		}
+		else {
+			printf("Cubemap image %s is %dx%d: not 2:1, 4:3 or 3:4\n", paths[0].c_str(), first.width, first.height);
+			return false;
+		}
+		if (environment.size <= 0)
+			return false;
+
+		buildMips(image);
+		if (options.prefilter) {
+			prefilter(image, options);
+		}
+		if (options.useCache && !writeCache(paths, image, options)) {
+			printf("Failed to write cubemap cache for %s\n", paths[0].c_str());
+		}
+		return true;
+	}
+}
@@ -0,0 +1,77 @@
+/*
+	Cubemaps built on the CPU: faces from six images, or cut or projected from one, a box filtered mip chain,
+	and optionally the prefiltered maps for image based lighting. Results are cached next to the first source
+	as <source>.ewcube, and rebuilt when a source's size or modification time changes.
+
+	Faces are in GL order: +X, -X, +Y, -Y, +Z, -Z. A single image is read as:
+	- 2:1 equirectangular, +Y along the top row and -Z in the middle column
+	- 4:3 horizontal cross: +Y over the second column, then -X, +Z, +X, -Z across the middle row, -Y below
+	- 3:4 vertical cross: the same down the middle column, with -Z under -Y, upside down
+	8 bit images are sRGB and filtered in linear space. .hdr images are decoded to linear float.
+
+	Mips halve each face with a box filter, so every texel is the average of the four under it and mips stay
+	seamless across faces when sampled with GL_TEXTURE_CUBE_MAP_SEAMLESS.
+*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include "../ew/imageResample.h"
+#include "../ew/ewMath/vec3.h"
+
+namespace gjn {
+	struct CubemapOptions {
+		//Also build a GGX prefiltered specular chain and a diffuse irradiance map
+		bool prefilter = false;
+		int specularSize = 128; //Faces of the sharpest specular level. Level l is for roughness l / (levels - 1).
+		int specularLevels = 6;
+		int specularSamples = 64; //GGX samples per texel
+		int irradianceSize = 32;
+		bool useCache = true;
+	};
+
+	//Square faces for every level of one cubemap. Level l is getSize(l) pixels square, its six faces one after another.
+	struct CubemapChain {
+		int size = 0;
+		std::vector<std::vector<unsigned char>> levels;
+
+		inline int getNumLevels()const { return (int)levels.size(); }
+		inline int getSize(int level)const { return ew::getMipSize(size, level); }
+	};
+
+	struct CubemapImage {
+		int channels = 3; //3 or 4
+		ew::PixelType type = ew::PixelType::UInt8; //Float for .hdr sources
+		CubemapChain environment; //The faces, with every mip
+		CubemapChain specular; //Empty unless prefiltered
+		CubemapChain irradiance; //One level, irradiance / pi: the light a white diffuse surface facing that way reflects
+		bool fromCache = false;
+
+		inline size_t getFaceBytes(int size)const { return ew::getPixelSize(type, channels) * size * size; }
+	};
+
+	//One decoded source image, before it is cut or projected into faces. 1 and 2 channel images become 3 and 4.
+	struct CubemapSource {
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		ew::PixelType type = ew::PixelType::UInt8;
+		std::vector<unsigned char> pixels;
+	};
+
+	//Direction through a point of a face, s and t from -1 to 1 across it with t = -1 on its first row
+	ew::Vec3 getCubemapDirection(int face, float s, float t);
+	//The face a direction hits, and s and t on it
+	int getCubemapFace(const ew::Vec3& direction, float& s, float& t);
+
+	//Loads paths' cache, or decodes them, six faces in parallel, builds the cubemap and writes the cache.
+	//paths is six faces or one image in a layout above. Safe to call from worker threads.
+	bool loadCubemapImage(const std::vector<std::string>& paths, CubemapImage& image, const CubemapOptions& options = {});
+	//Whether paths' cache is current and holds what options ask for. Reads only its header.
+	bool isCubemapCacheCurrent(const std::vector<std::string>& paths, const CubemapOptions& options);
+	//Reads paths' cache if it is current and holds what options ask for
+	bool readCubemapCache(const std::vector<std::string>& paths, CubemapImage& image, const CubemapOptions& options);
+	bool decodeCubemapSource(const char* path, CubemapSource& source);
+	//Builds the cubemap from paths' decoded sources and writes the cache if options.useCache
+	bool buildCubemapImage(const std::vector<std::string>& paths, std::vector<CubemapSource>& sources, CubemapImage& image, const CubemapOptions& options);
+}
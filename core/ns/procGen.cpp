@@ -1,28 +1,31 @@
 #include "procGen.h"
+#include <vector>
+#include "../ew/procGen.h"
 
 namespace ns {
 	
 	ew::MeshData createSphere(float radius, int numSegments)
 	{
 		ew::MeshData mesh;
+		mesh.vertices.reserve((numSegments + 1) * (numSegments + 1));
+		mesh.indices.reserve(numSegments * (numSegments - 1) * 6);
 		
 	//Verticies
-		float thetaStep = (ew::PI * 2.0f) / (float)numSegments;
-		float phiStep = ew::PI / (float)numSegments;
-		float theta;
-		float phi;
+		//Angles come from the shared ew tables, phi being the first half of a circle with twice the segments
+		std::vector<float> cosTheta(numSegments + 1), sinTheta(numSegments + 1);
+		std::vector<float> cosPhi(numSegments * 2 + 1), sinPhi(numSegments * 2 + 1);
+		ew::sampleUnitCircle(numSegments, cosTheta.data(), sinTheta.data());
+		ew::sampleUnitCircle(numSegments * 2, cosPhi.data(), sinPhi.data());
 		
 		for (int row = 0; row <= numSegments; row++) {
-			phi = (float)row * phiStep;
 			for (int col = 0; col <= numSegments; col++) {
 				ew::Vertex vertex;
-				theta = (float)col * thetaStep;
 				
-				vertex.pos.x = radius * cos(theta) * sin(phi);
-				vertex.pos.y = radius * cos(phi);
-				vertex.pos.z = radius * sin(theta) * sin(phi);
+				vertex.normal.x = cosTheta[col] * sinPhi[row];
+				vertex.normal.y = cosPhi[row];
+				vertex.normal.z = sinTheta[col] * sinPhi[row];
 
-				vertex.normal = ew::Normalize(vertex.pos);
+				vertex.pos = vertex.normal * radius;
 
 				vertex.uv.x = (float)col / (float)numSegments;
 				vertex.uv.y = (float)row / (float)numSegments;
@@ -66,18 +69,22 @@ namespace ns {
 			}
 		}
 
+		mesh.bounds = ew::AABB{ ew::Vec3(-radius), ew::Vec3(radius) };
+		mesh.boundingSphere.radius = radius;
 		return mesh;
 	}
 	
 	ew::MeshData createCylinder(float height, float radius, int numSegments)
 	{
 		ew::MeshData mesh;
-		mesh.vertices.reserve((numSegments + 1) * 2);
+		mesh.vertices.reserve((numSegments + 1) * 4 + 2);
 
 	//Vertices
 		float topY = height / 2.0f;
 		float bottomY = -topY;
-		float thetaStep = (ew::PI * 2.0f) / (float)numSegments;
+		//One set of angles shared by all four rings
+		std::vector<float> cosines(numSegments + 1), sines(numSegments + 1);
+		ew::sampleUnitCircle(numSegments, cosines.data(), sines.data());
 
 		//Top Center Vertex
 		ew::Vertex topVertex;
@@ -89,17 +96,17 @@ namespace ns {
 		//Top Ring Cap
 		for (int i = 0; i <= numSegments; i++) {
 			ew::Vertex vertex;
-			float theta;
-			theta = (float)i * thetaStep;
+			const float cosA = cosines[i];
+			const float sinA = sines[i];
 
-			vertex.pos.x = cos(theta) * radius;
-			vertex.pos.z = sin(theta) * radius;
+			vertex.pos.x = cosA * radius;
+			vertex.pos.z = sinA * radius;
 			vertex.pos.y = topY;
 
 			vertex.normal = ew::Vec3(0.0f, 1.0f, 0.0f);
 
-			vertex.uv.x = (cos(theta) + 1) * 0.5f;
-			vertex.uv.y = (sin(theta) + 1) * 0.5f;
+			vertex.uv.x = (cosA + 1) * 0.5f;
+			vertex.uv.y = (sinA + 1) * 0.5f;
 
 			mesh.vertices.push_back(vertex);
 		}
@@ -107,16 +114,16 @@ namespace ns {
 		//Top Ring Sides
 		for (int i = 0; i <= numSegments; i++) {
 			ew::Vertex vertex;
-			float theta;
-			theta = (float)i * thetaStep;
+			const float cosA = cosines[i];
+			const float sinA = sines[i];
 
-			vertex.pos.x = cos(theta) * radius;
-			vertex.pos.z = sin(theta) * radius;
+			vertex.pos.x = cosA * radius;
+			vertex.pos.z = sinA * radius;
 			vertex.pos.y = topY;
 
-			vertex.normal = ew::Normalize(ew::Vec3(cos(theta), 0.0f, sin(theta)));
+			vertex.normal = ew::Vec3(cosA, 0.0f, sinA);
 
-			vertex.uv.x = (cos(theta) + 1) * 0.5f;
+			vertex.uv.x = (cosA + 1) * 0.5f;
 			vertex.uv.y = 1;
 
 			mesh.vertices.push_back(vertex);
@@ -125,16 +132,16 @@ namespace ns {
 		//Bottom Ring Sides
 		for (int i = 0; i <= numSegments; i++) {
 			ew::Vertex vertex;
-			float theta;
-			theta = (float)i * thetaStep;
+			const float cosA = cosines[i];
+			const float sinA = sines[i];
 
-			vertex.pos.x = cos(theta) * radius;
-			vertex.pos.z = sin(theta) * radius;
+			vertex.pos.x = cosA * radius;
+			vertex.pos.z = sinA * radius;
 			vertex.pos.y = bottomY;
 
-			vertex.normal = ew::Normalize(ew::Vec3(cos(theta), 0.0f, sin(theta)));
+			vertex.normal = ew::Vec3(cosA, 0.0f, sinA);
 
-			vertex.uv.x = (cos(theta) + 1) * 0.5f;
+			vertex.uv.x = (cosA + 1) * 0.5f;
 			vertex.uv.y = 0;
 
 			mesh.vertices.push_back(vertex);
@@ -143,17 +150,17 @@ namespace ns {
 		//Bottom Ring Cap
 		for (int i = 0; i <= numSegments; i++) {
 			ew::Vertex vertex;
-			float theta;
-			theta = (float)i * thetaStep;
+			const float cosA = cosines[i];
+			const float sinA = sines[i];
 
-			vertex.pos.x = cos(theta) * radius;
-			vertex.pos.z = sin(theta) * radius;
+			vertex.pos.x = cosA * radius;
+			vertex.pos.z = sinA * radius;
 			vertex.pos.y = bottomY;
 
 			vertex.normal = ew::Vec3(0.0f, -1.0f, 0.0f);
 
-			vertex.uv.x = (cos(theta) + 1) * 0.5f;
-			vertex.uv.y = (sin(theta) + 1) * 0.5f;
+			vertex.uv.x = (cosA + 1) * 0.5f;
+			vertex.uv.y = (sinA + 1) * 0.5f;
 
 			mesh.vertices.push_back(vertex);
 		}
@@ -199,6 +206,8 @@ namespace ns {
 			mesh.indices.push_back(start + i + 1);
 		}
 
+		mesh.bounds = ew::AABB{ ew::Vec3(-radius, bottomY, -radius), ew::Vec3(radius, topY, radius) };
+		mesh.boundingSphere.radius = sqrtf(radius * radius + topY * topY);
 		return mesh;
 	}
 
@@ -239,6 +248,9 @@ namespace ns {
 			}
 		}
 
+		//Grows from the origin toward +x and -z
+		mesh.bounds = ew::AABB{ ew::Vec3(0.0f, 0.0f, -height), ew::Vec3(width, 0.0f, 0.0f) };
+		mesh.boundingSphere = ew::SphereAroundAABB(mesh.bounds);
 		return mesh;
 	}
 }
\ No newline at end of file
@@ -1,23 +1,8 @@
 #pragma once
-#include <sstream>
-#include <fstream>
-#include "../ew/ewMath/mat4.h"
+#include "../ew/shader.h"
 
+//Same loader and program wrapper as ew, kept under ns for the assignments that use it
 namespace ns {
-	std::string loadShaderSourceFromFile(const std::string& filePath);
-
-	
-	class Shader {
-	public:
-		Shader(const std::string& vertexShader, const std::string& fragmentShader);
-		void use();
-		void setInt(const std::string& name, int v) const;
-		void setFloat(const std::string& name, float v) const;
-		void setVec2(const std::string& name, float x, float y) const;
-		void setVec3(const std::string& name, float x, float y, float z) const;
-		void setVec4(const std::string& name, float x, float y, float z, float w) const;
-		void setMat4(const std::string& name, const ew::Mat4& v) const;
-	private:
-		unsigned int m_id;
-	};
-}
\ No newline at end of file
+	using ew::loadShaderSourceFromFile;
+	using ew::Shader;
+}
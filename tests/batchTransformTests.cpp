@@ -0,0 +1,184 @@
+#include "tests.h"
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include <random>
+
+#include <ew/ewMath/ewMath.h>
+#include <ew/ewMath/transformations.h>
+#include <ew/ewMath/batchTransform.h>
+
+namespace {
+	//None is a multiple of 4 or 8, so every SIMD path finishes on a partial block. The last is large enough
+	//to be split across threads.
+	const size_t COUNTS[] = { 1, 3, 7, 13, 257, 1001, 300007 };
+	const float EPSILON = 1e-4f;
+
+	enum Kind {
+		POINTS,
+		DIRECTIONS,
+		NORMALS
+	};
+	const char* KIND_NAMES[] = { "points", "directions", "normals" };
+
+	//A vertex layout like the meshes', so the strided path sees a stride other than sizeof(Vec3)
+	struct Vertex {
+		ew::Vec3 position;
+		ew::Vec3 normal;
+		ew::Vec2 uv;
+	};
+
+	//Mat4 * Vec4, one element at a time, as the batch functions replace
+	ew::Vec3 expected(const ew::Mat4& m, const ew::Mat4& normalMatrix, Kind kind, const ew::Vec3& v) {
+		switch (kind) {
+		case POINTS:
+			return (m * ew::Vec4(v, 1.0f)).toVec3();
+		case DIRECTIONS:
+			return (m * ew::Vec4(v, 0.0f)).toVec3();
+		default:
+			return ew::Normalize((normalMatrix * ew::Vec4(v, 0.0f)).toVec3());
+		}
+	}
+
+	float difference(const ew::Vec3& a, const ew::Vec3& b) {
+		return fmaxf(fmaxf(fabsf(a.x - b.x) / fmaxf(1.0f, fabsf(b.x)), fabsf(a.y - b.y) / fmaxf(1.0f, fabsf(b.y))), fabsf(a.z - b.z) / fmaxf(1.0f, fabsf(b.z)));
+	}
+
+	/// <summary>
+	/// Compares out against the per element result for in. Prints the first element off by more than EPSILON.
+	/// </summary>
+	bool check(const char* path, Kind kind, const ew::Mat4& m, const std::vector<ew::Vec3>& in, const std::vector<ew::Vec3>& out) {
+		const ew::Mat4 normalMatrix = ew::NormalMatrix(m);
+		for (size_t i = 0; i < in.size(); i++) {
+			const ew::Vec3 e = expected(m, normalMatrix, kind, in[i]);
+			if (!(difference(out[i], e) <= EPSILON)) {
+				printf("%s %s, %zu elements: element %zu is (%g, %g, %g), expected (%g, %g, %g)\n", path, KIND_NAMES[kind], in.size(), i,
+					out[i].x, out[i].y, out[i].z, e.x, e.y, e.z);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void transformPacked(const ew::Mat4& m, Kind kind, const ew::Vec3* in, ew::Vec3* out, size_t count) {
+		switch (kind) {
+		case POINTS:
+			ew::TransformPoints(m, in, out, count);
+			break;
+		case DIRECTIONS:
+			ew::TransformDirections(m, in, out, count);
+			break;
+		case NORMALS:
+			ew::TransformNormals(m, in, out, count);
+			break;
+		}
+	}
+
+	void transformStrided(const ew::Mat4& m, Kind kind, std::vector<Vertex>& vertices) {
+		switch (kind) {
+		case POINTS:
+			ew::TransformPoints(m, &vertices[0].position, &vertices[0].position, vertices.size(), sizeof(Vertex));
+			break;
+		case DIRECTIONS:
+			ew::TransformDirections(m, &vertices[0].position, &vertices[0].position, vertices.size(), sizeof(Vertex));
+			break;
+		case NORMALS:
+			ew::TransformNormals(m, &vertices[0].normal, &vertices[0].normal, vertices.size(), sizeof(Vertex));
+			break;
+		}
+	}
+
+	void transformSoA(const ew::Mat4& m, Kind kind, const std::vector<ew::Vec3>& in, std::vector<ew::Vec3>& out) {
+		const size_t count = in.size();
+		std::vector<float> x(count), y(count), z(count), ox(count), oy(count), oz(count);
+		for (size_t i = 0; i < count; i++) {
+			x[i] = in[i].x;
+			y[i] = in[i].y;
+			z[i] = in[i].z;
+		}
+		switch (kind) {
+		case POINTS:
+			ew::TransformPointsSoA(m, x.data(), y.data(), z.data(), ox.data(), oy.data(), oz.data(), count);
+			break;
+		case DIRECTIONS:
+			ew::TransformDirectionsSoA(m, x.data(), y.data(), z.data(), ox.data(), oy.data(), oz.data(), count);
+			break;
+		case NORMALS:
+			ew::TransformNormalsSoA(m, x.data(), y.data(), z.data(), ox.data(), oy.data(), oz.data(), count);
+			break;
+		}
+		for (size_t i = 0; i < count; i++) {
+			out[i] = ew::Vec3(ox[i], oy[i], oz[i]);
+		}
+	}
+
+	/// <summary>
+	/// Every path for one matrix and count: packed Vec3s into another array and in place, a Vec3 member of a
+	/// vertex struct, separate x/y/z arrays, and points with normals together
+	/// </summary>
+	bool checkCount(const ew::Mat4& m, size_t count, std::mt19937& random) {
+		std::uniform_real_distribution<float> value(-50.0f, 50.0f);
+		std::vector<ew::Vec3> in(count), out(count);
+		std::vector<Vertex> vertices(count);
+		for (size_t i = 0; i < count; i++) {
+			in[i] = ew::Vec3(value(random), value(random), value(random));
+		}
+		bool ok = true;
+		for (int k = POINTS; k <= NORMALS; k++) {
+			const Kind kind = (Kind)k;
+			transformPacked(m, kind, in.data(), out.data(), count);
+			ok = check("Packed", kind, m, in, out) && ok;
+
+			out = in;
+			transformPacked(m, kind, out.data(), out.data(), count);
+			ok = check("In place", kind, m, in, out) && ok;
+
+			for (size_t i = 0; i < count; i++) {
+				vertices[i].position = in[i];
+				vertices[i].normal = in[i];
+			}
+			transformStrided(m, kind, vertices);
+			for (size_t i = 0; i < count; i++) {
+				out[i] = kind == NORMALS ? vertices[i].normal : vertices[i].position;
+			}
+			ok = check("Strided", kind, m, in, out) && ok;
+
+			transformSoA(m, kind, in, out);
+			ok = check("SoA", kind, m, in, out) && ok;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			vertices[i].position = in[i];
+			vertices[i].normal = in[i];
+		}
+		ew::TransformPointsAndNormals(m, &vertices[0].position, &vertices[0].normal, &vertices[0].position, &vertices[0].normal, count, sizeof(Vertex));
+		std::vector<ew::Vec3> normals(count);
+		for (size_t i = 0; i < count; i++) {
+			out[i] = vertices[i].position;
+			normals[i] = vertices[i].normal;
+		}
+		ok = check("Points and normals", POINTS, m, in, out) && ok;
+		return check("Points and normals", NORMALS, m, in, normals) && ok;
+	}
+}
+
+/// <summary>
+/// Uses the SIMD or scalar kernels this build compiles (EW_SIMD_NAME). A mirrored matrix checks that normals
+/// keep the determinant's sign.
+/// </summary>
+bool testBatchTransform() {
+	const ew::Mat4 matrices[] = {
+		ew::Translate(ew::Vec3(3.0f, -7.0f, 12.0f)) * ew::RotateY(0.7f) * ew::RotateX(-1.2f) * ew::Scale(ew::Vec3(0.5f, 2.0f, 3.0f)),
+		ew::Translate(ew::Vec3(-1.0f, 4.0f, 0.5f)) * ew::RotateZ(2.1f) * ew::Scale(ew::Vec3(-1.0f, 1.5f, 1.0f)),
+	};
+	std::mt19937 random(32);
+	bool ok = true;
+	for (const ew::Mat4& m : matrices) {
+		for (size_t count : COUNTS) {
+			ok = checkCount(m, count, random) && ok;
+		}
+	}
+	printf("%s kernels: points, directions and normals, packed, in place, strided, SoA and combined, %zu counts up to %zu, %s\n",
+		EW_SIMD_NAME, sizeof(COUNTS) / sizeof(COUNTS[0]), COUNTS[sizeof(COUNTS) / sizeof(COUNTS[0]) - 1], ok ? "all match Mat4 * Vec4" : "mismatches");
+	return ok;
+}
@@ -0,0 +1,127 @@
+#include "tests.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include <ew/blockCompression.h>
+
+namespace {
+	struct Format {
+		const char* name;
+		ew::BlockFormat format;
+		int channels; //Channels the format stores, which the test images have
+		double minPSNR; //For the gradient image at Fast quality
+	};
+	const Format FORMATS[] = {
+		{ "BC1", ew::BlockFormat::BC1, 3, 33.0 },
+		{ "BC4", ew::BlockFormat::BC4, 1, 48.0 },
+		{ "BC5", ew::BlockFormat::BC5, 2, 48.0 },
+		{ "BC7", ew::BlockFormat::BC7, 4, 34.0 },
+	};
+	const ew::CompressionQuality QUALITIES[] = { ew::CompressionQuality::Fast, ew::CompressionQuality::Normal, ew::CompressionQuality::Best };
+	const char* QUALITY_NAMES[] = { "Fast", "Normal", "Best" };
+	//One a multiple of 4, one with partial blocks on both edges
+	const int SIZES[][2] = { { 64, 64 }, { 61, 37 } };
+
+	/// <summary>
+	/// Smooth gradients per channel with a ripple and a hard edge, so blocks hold both ramps and two tone splits
+	/// </summary>
+	std::vector<unsigned char> makeGradient(int width, int height, int channels) {
+		std::vector<unsigned char> pixels((size_t)width * height * channels);
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				const float u = (float)x / width, v = (float)y / height;
+				const float values[4] = {
+					u * 255.0f,
+					v * 200.0f + 20.0f * sinf(u * 12.0f),
+					(x + y < (width + height) / 2 ? 60.0f : 190.0f) + 30.0f * u,
+					(1.0f - u * v) * 255.0f
+				};
+				for (int c = 0; c < channels; c++) {
+					pixels[((size_t)y * width + x) * channels + c] = (unsigned char)fminf(fmaxf(values[c], 0.0f), 255.0f);
+				}
+			}
+		}
+		return pixels;
+	}
+
+	//BC1 endpoints are 565, so only colors 565 expands to exactly can come back exactly
+	unsigned char expandBits(unsigned char value, int bits) {
+		const int v = value >> (8 - bits);
+		return (unsigned char)((v << (8 - bits)) | (v >> (2 * bits - 8)));
+	}
+
+	/// <summary>
+	/// A different solid color in every 4x4 block, edge blocks included. BC1 colors are ones 565 holds. BC7 mode 6 can't
+	/// hit a color with both a 0 and a 255 channel exactly, so its values stay within 1 to 254.
+	/// </summary>
+	std::vector<unsigned char> makeSolidBlocks(int width, int height, int channels, ew::BlockFormat format) {
+		std::vector<unsigned char> pixels((size_t)width * height * channels);
+		const int bits[3] = { 5, 6, 5 };
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				const unsigned int block = (unsigned int)((y / 4) * 17 + (x / 4));
+				for (int c = 0; c < channels; c++) {
+					unsigned char value = (unsigned char)((block * 2654435761u) >> (8 * c));
+					if (format == ew::BlockFormat::BC1) {
+						value = expandBits(value, bits[c]);
+					}
+					else if (format == ew::BlockFormat::BC7) {
+						value = (unsigned char)(1 + value % 254);
+					}
+					pixels[((size_t)y * width + x) * channels + c] = value;
+				}
+			}
+		}
+		return pixels;
+	}
+
+	std::vector<unsigned char> roundTrip(const std::vector<unsigned char>& pixels, int width, int height, const Format& format, ew::CompressionQuality quality) {
+		std::vector<unsigned char> blocks(ew::getCompressedSize(format.format, width, height));
+		ew::BlockCompressionOptions options;
+		options.quality = quality;
+		ew::compressImage(pixels.data(), width, height, format.channels, format.format, blocks.data(), options);
+		std::vector<unsigned char> decoded(pixels.size());
+		ew::decompressImage(blocks.data(), width, height, format.format, decoded.data(), format.channels);
+		return decoded;
+	}
+}
+
+/// <summary>
+/// Each format at each quality on a generated image, with and without partial edge blocks. The gradient must come back
+/// within the format's PSNR bound and solid color blocks must come back exactly.
+/// </summary>
+bool testBlockCompression() {
+	bool ok = true;
+	for (const Format& format : FORMATS) {
+		for (int q = 0; q < 3; q++) {
+			double worstPSNR = INFINITY;
+			bool solidExact = true;
+			for (const int* size : SIZES) {
+				const int width = size[0], height = size[1];
+				const std::vector<unsigned char> gradient = makeGradient(width, height, format.channels);
+				const std::vector<unsigned char> decoded = roundTrip(gradient, width, height, format, QUALITIES[q]);
+				worstPSNR = fmin(worstPSNR, ew::computePSNR(gradient.data(), decoded.data(), width, height, format.channels));
+
+				const std::vector<unsigned char> solid = makeSolidBlocks(width, height, format.channels, format.format);
+				const std::vector<unsigned char> solidDecoded = roundTrip(solid, width, height, format, QUALITIES[q]);
+				for (size_t i = 0; i < solid.size() && solidExact; i++) {
+					if (solid[i] != solidDecoded[i]) {
+						const size_t pixel = i / format.channels;
+						printf("%s %s, %dx%d: solid block pixel (%zu, %zu) channel %zu is %d, expected %d\n", format.name, QUALITY_NAMES[q], width, height,
+							pixel % width, pixel / width, i % format.channels, solidDecoded[i], solid[i]);
+						solidExact = false;
+					}
+				}
+			}
+			printf("%s %-6s worst PSNR %.2f dB, solid blocks %s\n", format.name, QUALITY_NAMES[q], worstPSNR, solidExact ? "exact" : "changed");
+			if (worstPSNR < format.minPSNR) {
+				printf("%s %s: below %.1f dB\n", format.name, QUALITY_NAMES[q], format.minPSNR);
+				ok = false;
+			}
+			ok = solidExact && ok;
+		}
+	}
+	return ok;
+}
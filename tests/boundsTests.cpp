@@ -0,0 +1,168 @@
+#include "tests.h"
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+
+#include <ew/ewMath/bounds.h>
+#include <ew/ewMath/transformations.h>
+#include <ew/procGen.h>
+#include <ns/procGen.h>
+#include <JSLib/terrain.h>
+
+namespace {
+	const float EPSILON = 1e-4f;
+	const char* HEIGHTMAP_PATH = "assets/heightmaps/heightmap01.jpg";
+
+	//Box (-4, -1, -6) to (3, 5, 3), centered on (-0.5, 2, -1.5). The farthest point is (2, -1, -6), at sqrt(35.5).
+	const ew::Vec3 POINTS[] = {
+		ew::Vec3(1.0f, 2.0f, 3.0f),
+		ew::Vec3(-4.0f, 5.0f, 0.5f),
+		ew::Vec3(2.0f, -1.0f, -6.0f),
+		ew::Vec3(0.0f, 0.0f, 0.0f),
+		ew::Vec3(3.0f, 3.0f, 3.0f),
+	};
+	const int NUM_POINTS = sizeof(POINTS) / sizeof(POINTS[0]);
+	const ew::AABB POINTS_BOX = { ew::Vec3(-4.0f, -1.0f, -6.0f), ew::Vec3(3.0f, 5.0f, 3.0f) };
+	const float POINTS_RADIUS = 5.95818765f;
+
+	bool near(const ew::Vec3& a, const ew::Vec3& b, float tolerance = EPSILON) {
+		return fabsf(a.x - b.x) <= tolerance && fabsf(a.y - b.y) <= tolerance && fabsf(a.z - b.z) <= tolerance;
+	}
+	bool sameBox(const ew::AABB& a, const ew::AABB& b) {
+		return near(a.min, b.min) && near(a.max, b.max);
+	}
+
+	bool expectBounds(const char* what, const ew::AABB& box, const ew::BoundingSphere& sphere, const ew::AABB& expectedBox, const ew::Vec3& expectedCenter, float expectedRadius) {
+		if (!sameBox(box, expectedBox) || !near(sphere.center, expectedCenter) || fabsf(sphere.radius - expectedRadius) > EPSILON) {
+			printf("%s: box (%g, %g, %g) to (%g, %g, %g), sphere (%g, %g, %g) radius %g, expected box (%g, %g, %g) to (%g, %g, %g), sphere (%g, %g, %g) radius %g\n", what,
+				box.min.x, box.min.y, box.min.z, box.max.x, box.max.y, box.max.z, sphere.center.x, sphere.center.y, sphere.center.z, sphere.radius,
+				expectedBox.min.x, expectedBox.min.y, expectedBox.min.z, expectedBox.max.x, expectedBox.max.y, expectedBox.max.z,
+				expectedCenter.x, expectedCenter.y, expectedCenter.z, expectedRadius);
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// ComputeBounds on POINTS packed and inside a vertex struct, with each point last in turn, since the SIMD paths
+	/// load the last point separately. Then no points, one point and two.
+	/// </summary>
+	bool checkComputeBounds() {
+		bool ok = true;
+		std::vector<ew::Vec3> packed(NUM_POINTS);
+		std::vector<ew::Vertex> vertices(NUM_POINTS);
+		for (int rotation = 0; rotation < NUM_POINTS; rotation++) {
+			for (int i = 0; i < NUM_POINTS; i++) {
+				packed[i] = POINTS[(i + rotation) % NUM_POINTS];
+				vertices[i].pos = packed[i];
+				vertices[i].normal = ew::Vec3(1000.0f);
+			}
+			ew::AABB box;
+			ew::BoundingSphere sphere;
+			ew::ComputeBounds(packed.data(), NUM_POINTS, box, sphere);
+			ok = expectBounds("Packed points", box, sphere, POINTS_BOX, POINTS_BOX.center(), POINTS_RADIUS) && ok;
+			ew::ComputeBounds(&vertices[0].pos, NUM_POINTS, box, sphere, sizeof(ew::Vertex));
+			ok = expectBounds("Vertex positions", box, sphere, POINTS_BOX, POINTS_BOX.center(), POINTS_RADIUS) && ok;
+		}
+
+		ew::AABB box;
+		ew::BoundingSphere sphere;
+		ew::ComputeBounds(POINTS, 0, box, sphere);
+		if (!box.isEmpty() || sphere.radius != 0.0f) {
+			printf("No points: the box is not empty or the radius is %g\n", sphere.radius);
+			ok = false;
+		}
+		ew::ComputeBounds(POINTS, 1, box, sphere);
+		ok = expectBounds("One point", box, sphere, ew::AABB{ POINTS[0], POINTS[0] }, POINTS[0], 0.0f) && ok;
+		//(1, 2, 3) and (-4, 5, 0.5) are 6.34 apart
+		ew::ComputeBounds(POINTS, 2, box, sphere);
+		ok = expectBounds("Two points", box, sphere, ew::AABB{ ew::Vec3(-4.0f, 2.0f, 0.5f), ew::Vec3(1.0f, 5.0f, 3.0f) },
+			ew::Vec3(-1.5f, 3.5f, 1.75f), 3.1721443f) && ok;
+		return ok;
+	}
+
+	/// <summary>
+	/// A unit box and sphere through a translated, rotated and scaled matrix, worked out by hand
+	/// </summary>
+	bool checkTransforms() {
+		bool ok = true;
+		const ew::AABB unitBox = { ew::Vec3(-1.0f), ew::Vec3(1.0f) };
+		const ew::BoundingSphere sphere = ew::SphereAroundAABB(unitBox);
+		ok = expectBounds("Sphere around a box", unitBox, sphere, unitBox, ew::Vec3(0.0f), sqrtf(3.0f)) && ok;
+
+		//Scales x by 1, y by 2, z by 3, then turns x onto -z and z onto x
+		const ew::Mat4 m = ew::Translate(ew::Vec3(5.0f, 0.0f, -2.0f)) * ew::RotateY(ew::Radians(90.0f)) * ew::Scale(ew::Vec3(1.0f, 2.0f, 3.0f));
+		const ew::AABB box = ew::TransformAABB(m, unitBox);
+		ew::BoundingSphere unitSphere;
+		unitSphere.center = ew::Vec3(0.0f, 1.0f, 0.0f);
+		unitSphere.radius = 1.0f;
+		const ew::BoundingSphere transformed = ew::TransformSphere(m, unitSphere);
+		ok = expectBounds("Transformed", box, transformed, ew::AABB{ ew::Vec3(2.0f, -2.0f, -3.0f), ew::Vec3(8.0f, 2.0f, -1.0f) },
+			ew::Vec3(5.0f, 2.0f, -2.0f), 3.0f) && ok;
+		return ok;
+	}
+
+	/// <summary>
+	/// Every vertex must be inside the box and sphere the generator wrote. A tight box must also be no larger than the vertices' own.
+	/// </summary>
+	bool checkMesh(const char* name, const ew::MeshData& mesh, bool tight) {
+		if (mesh.vertices.empty() || mesh.bounds.isEmpty()) {
+			printf("%s: no vertices or no bounds\n", name);
+			return false;
+		}
+		const ew::AABB& box = mesh.bounds;
+		const ew::BoundingSphere& sphere = mesh.boundingSphere;
+		//Relative to the mesh's size, for the terrain's hundreds of units
+		const float tolerance = EPSILON * fmaxf(1.0f, sphere.radius);
+		ew::AABB vertexBox = ew::EmptyAABB();
+		for (size_t i = 0; i < mesh.vertices.size(); i++) {
+			const ew::Vec3& p = mesh.vertices[i].pos;
+			vertexBox.min = ew::Vec3(fminf(vertexBox.min.x, p.x), fminf(vertexBox.min.y, p.y), fminf(vertexBox.min.z, p.z));
+			vertexBox.max = ew::Vec3(fmaxf(vertexBox.max.x, p.x), fmaxf(vertexBox.max.y, p.y), fmaxf(vertexBox.max.z, p.z));
+			const bool inBox = p.x >= box.min.x - tolerance && p.y >= box.min.y - tolerance && p.z >= box.min.z - tolerance
+				&& p.x <= box.max.x + tolerance && p.y <= box.max.y + tolerance && p.z <= box.max.z + tolerance;
+			const float distance = ew::Magnitude(p - sphere.center);
+			if (!inBox || distance > sphere.radius + tolerance) {
+				printf("%s: vertex %zu at (%g, %g, %g) is outside the %s\n", name, i, p.x, p.y, p.z, inBox ? "sphere" : "box");
+				return false;
+			}
+		}
+		if (tight && (!near(vertexBox.min, box.min, tolerance) || !near(vertexBox.max, box.max, tolerance))) {
+			printf("%s: box (%g, %g, %g) to (%g, %g, %g) is larger than the vertices' (%g, %g, %g) to (%g, %g, %g)\n", name,
+				box.min.x, box.min.y, box.min.z, box.max.x, box.max.y, box.max.z, vertexBox.min.x, vertexBox.min.y, vertexBox.min.z, vertexBox.max.x, vertexBox.max.y, vertexBox.max.z);
+			return false;
+		}
+		return true;
+	}
+}
+
+/// <summary>
+/// ComputeBounds and the bounding volume helpers on hand computed values, then the bounds each generator writes
+/// without looking at its vertices
+/// </summary>
+bool testBounds() {
+	bool ok = checkComputeBounds();
+	ok = checkTransforms() && ok;
+	struct Generated {
+		const char* name;
+		ew::MeshData mesh;
+		//Round meshes are bounded by the circles their rings sample, which an odd number of segments doesn't reach
+		bool tight;
+	};
+	const Generated meshes[] = {
+		{ "ew::createCube", ew::createCube(2.5f), true },
+		{ "ew::createPlane", ew::createPlane(4.0f, 3.0f, 7), true },
+		{ "ew::createSphere", ew::createSphere(1.5f, 17), false },
+		{ "ew::createCylinder", ew::createCylinder(0.75f, 3.0f, 13), false },
+		{ "ns::createSphere", ns::createSphere(1.5f, 17), false },
+		{ "ns::createCylinder", ns::createCylinder(3.0f, 0.75f, 13), false },
+		{ "ns::createPlane", ns::createPlane(4.0f, 3.0f, 7), true },
+		{ "JSLib::createTerrain", JSLib::createTerrain(HEIGHTMAP_PATH), true },
+		{ "JSLib::createTerrainScaled", JSLib::createTerrainScaled(HEIGHTMAP_PATH, 97), true },
+	};
+	for (const Generated& generated : meshes) {
+		ok = checkMesh(generated.name, generated.mesh, generated.tight) && ok;
+	}
+	printf("ComputeBounds, transformed bounds and %zu generated meshes %s\n", sizeof(meshes) / sizeof(meshes[0]), ok ? "match" : "do not match");
+	return ok;
+}
@@ -0,0 +1,177 @@
+#include "tests.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <gjn/cubemapImage.h>
+#include <ew/blockCompression.h>
+
+namespace {
+	const float PI = 3.14159265f;
+	const char* FACES[] = { "assets/right.jpg", "assets/left.jpg", "assets/top.jpg", "assets/bottom.jpg", "assets/front.jpg", "assets/back.jpg" };
+
+	const unsigned char* getTexel(const gjn::CubemapImage& image, int level, int face, int x, int y) {
+		const int size = image.environment.getSize(level);
+		return image.environment.levels[level].data() + image.getFaceBytes(size) * face + ((size_t)y * size + x) * image.channels;
+	}
+
+	/// <summary>
+	/// Lays level 0 out as a cross, -Z upside down under -Y for the vertical one
+	/// </summary>
+	gjn::CubemapSource makeCross(const gjn::CubemapImage& image, bool vertical) {
+		const int cells[2][6][2] = {
+			{ { 2, 1 }, { 0, 1 }, { 1, 0 }, { 1, 2 }, { 1, 1 }, { 3, 1 } },
+			{ { 2, 1 }, { 0, 1 }, { 1, 0 }, { 1, 2 }, { 1, 1 }, { 1, 3 } }
+		};
+		const int size = image.environment.size;
+		gjn::CubemapSource source;
+		source.width = size * (vertical ? 3 : 4);
+		source.height = size * (vertical ? 4 : 3);
+		source.channels = image.channels;
+		source.pixels.assign((size_t)source.width * source.height * source.channels, 0);
+		for (int face = 0; face < 6; face++) {
+			const bool rotated = vertical && face == 5;
+			for (int y = 0; y < size; y++) {
+				for (int x = 0; x < size; x++) {
+					const int outX = cells[vertical][face][0] * size + (rotated ? size - 1 - x : x);
+					const int outY = cells[vertical][face][1] * size + (rotated ? size - 1 - y : y);
+					memcpy(&source.pixels[((size_t)outY * source.width + outX) * source.channels], getTexel(image, 0, face, x, y), source.channels);
+				}
+			}
+		}
+		return source;
+	}
+
+	/// <summary>
+	/// Projects level 0 to a 2:1 equirectangular image, bilinear within each face
+	/// </summary>
+	gjn::CubemapSource makeEquirectangular(const gjn::CubemapImage& image) {
+		const int size = image.environment.size;
+		gjn::CubemapSource source;
+		source.width = size * 4;
+		source.height = size * 2;
+		source.channels = image.channels;
+		source.pixels.resize((size_t)source.width * source.height * source.channels);
+		for (int y = 0; y < source.height; y++) {
+			for (int x = 0; x < source.width; x++) {
+				const float phi = ((x + 0.5f) / source.width - 0.5f) * 2.0f * PI, theta = (y + 0.5f) / source.height * PI;
+				float s, t;
+				const int face = gjn::getCubemapFace(ew::Vec3(sinf(theta) * sinf(phi), cosf(theta), -sinf(theta) * cosf(phi)), s, t);
+				const float px = (s + 1.0f) * 0.5f * size - 0.5f, py = (t + 1.0f) * 0.5f * size - 0.5f;
+				const int x0 = (int)floorf(px), y0 = (int)floorf(py);
+				const float fx = px - x0, fy = py - y0;
+				for (int c = 0; c < source.channels; c++) {
+					float value = 0.0f;
+					for (int i = 0; i < 4; i++) {
+						const int tx = std::min(std::max(x0 + i % 2, 0), size - 1), ty = std::min(std::max(y0 + i / 2, 0), size - 1);
+						value += getTexel(image, 0, face, tx, ty)[c] * (i % 2 ? fx : 1.0f - fx) * (i / 2 ? fy : 1.0f - fy);
+					}
+					source.pixels[((size_t)y * source.width + x) * source.channels + c] = (unsigned char)(value + 0.5f);
+				}
+			}
+		}
+		return source;
+	}
+
+	/// <summary>
+	/// Compares each edge texel with the texel across the seam on the neighboring face, against the difference
+	/// between it and its neighbor inside the face. A visible seam shows up as the first being much larger.
+	/// </summary>
+	bool checkSeams(const gjn::CubemapImage& image) {
+		bool ok = true;
+		printf("%-6s %8s %12s %12s\n", "Level", "Size", "seam diff", "inside diff");
+		for (int level = 0; level < image.environment.getNumLevels() && image.environment.getSize(level) >= 4; level++) {
+			const int size = image.environment.getSize(level);
+			double seam = 0.0, inside = 0.0;
+			for (int face = 0; face < 6; face++) {
+				for (int edge = 0; edge < 4; edge++) {
+					for (int i = 0; i < size; i++) {
+						//Edge texel, the one inside it, and a point one texel past the edge
+						const int x = edge == 0 ? size - 1 : (edge == 1 ? 0 : i), y = edge == 2 ? size - 1 : (edge == 3 ? 0 : i);
+						const int inX = x + (edge == 0 ? -1 : (edge == 1 ? 1 : 0)), inY = y + (edge == 2 ? -1 : (edge == 3 ? 1 : 0));
+						const float outS = 2.0f * (x + 0.5f) / size - 1.0f + (edge == 0 ? 2.0f : (edge == 1 ? -2.0f : 0.0f)) / size;
+						const float outT = 2.0f * (y + 0.5f) / size - 1.0f + (edge == 2 ? 2.0f : (edge == 3 ? -2.0f : 0.0f)) / size;
+						float s, t;
+						const int neighbor = gjn::getCubemapFace(gjn::getCubemapDirection(face, outS, outT), s, t);
+						const int nx = std::min(std::max((int)((s + 1.0f) * 0.5f * size), 0), size - 1);
+						const int ny = std::min(std::max((int)((t + 1.0f) * 0.5f * size), 0), size - 1);
+						const unsigned char* texel = getTexel(image, level, face, x, y);
+						for (int c = 0; c < 3; c++) {
+							seam += abs(texel[c] - getTexel(image, level, neighbor, nx, ny)[c]);
+							inside += abs(texel[c] - getTexel(image, level, face, inX, inY)[c]);
+						}
+					}
+				}
+			}
+			const double count = 6.0 * 4.0 * size * 3.0;
+			seam /= count;
+			inside /= count;
+			printf("%-6d %8d %12.2f %12.2f\n", level, size, seam, inside);
+			if (seam > inside * 1.5 + 1.0) {
+				printf("Level %d has a seam\n", level);
+				ok = false;
+			}
+		}
+		return ok;
+	}
+}
+
+/// <summary>
+/// Builds the skybox with its prefiltered maps, which a load through the cache must give back exactly, then
+/// checks the other layouts and the seams against its faces
+/// </summary>
+bool testCubemap() {
+	const std::vector<std::string> paths(FACES, FACES + 6);
+	gjn::CubemapOptions options;
+	options.useCache = false;
+	options.prefilter = true;
+	gjn::CubemapImage image;
+	std::vector<gjn::CubemapSource> sources(paths.size());
+	for (size_t i = 0; i < paths.size(); i++) {
+		if (!gjn::decodeCubemapSource(paths[i].c_str(), sources[i]))
+			return false;
+	}
+	if (!gjn::buildCubemapImage(paths, sources, image, options))
+		return false;
+	printf("%dx%d faces, %d levels, %d specular levels, %d irradiance\n", image.environment.size, image.environment.size,
+		image.environment.getNumLevels(), image.specular.getNumLevels(), image.irradiance.size);
+
+	//Twice, so the second comes from the cache even if an earlier run didn't leave one
+	options.useCache = true;
+	gjn::CubemapImage cached;
+	bool ok = gjn::loadCubemapImage(paths, cached, options) && gjn::loadCubemapImage(paths, cached, options);
+	if (!ok || !cached.fromCache || cached.environment.levels != image.environment.levels || cached.specular.levels != image.specular.levels
+		|| cached.irradiance.levels != image.irradiance.levels) {
+		printf("Cached cubemap differs from the one built\n");
+		ok = false;
+	}
+	if (image.type != ew::PixelType::UInt8) {
+		printf("Layout and seam checks need 8 bit images\n");
+		return false;
+	}
+
+	const std::vector<std::string> single{ paths[0] };
+	options = {};
+	options.useCache = false;
+	for (int vertical = 0; vertical < 2; vertical++) {
+		std::vector<gjn::CubemapSource> cross{ makeCross(image, vertical) };
+		gjn::CubemapImage fromCross;
+		if (!gjn::buildCubemapImage(single, cross, fromCross, options) || fromCross.environment.levels[0] != image.environment.levels[0]) {
+			printf("%s cross did not cut back to the same faces\n", vertical ? "Vertical" : "Horizontal");
+			ok = false;
+		}
+	}
+	std::vector<gjn::CubemapSource> equirectangular{ makeEquirectangular(image) };
+	gjn::CubemapImage fromEquirectangular;
+	ok = gjn::buildCubemapImage(single, equirectangular, fromEquirectangular, options) && ok;
+	const double psnr = fromEquirectangular.environment.size == image.environment.size ? ew::computePSNR(image.environment.levels[0].data(),
+		fromEquirectangular.environment.levels[0].data(), image.environment.size, image.environment.size * 6, image.channels) : 0.0;
+	printf("Equirectangular %dx%d back to faces: %.2f dB against the faces\n", equirectangular[0].width, equirectangular[0].height, psnr);
+	if (psnr < 30.0) {
+		ok = false;
+	}
+	return checkSeams(image) && ok;
+}
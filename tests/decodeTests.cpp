@@ -0,0 +1,105 @@
+#include "tests.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+#include <ew/imageDecoder.h>
+#include <ew/imageResample.h>
+#include <ew/blockCompression.h>
+#include <ew/external/stb_image.h>
+
+namespace {
+	//Color textures, a skybox face and a single channel heightmap
+	const char* IMAGES[] = {
+		"assets/brick_color.jpg",
+		"assets/textures/rock_color.jpg",
+		"assets/right.jpg",
+		"assets/heightmaps/heightmap01.jpg"
+	};
+	const int SCALES[] = { 2, 4, 8 };
+	const double MIN_PSNR = 30.0;
+
+	bool isFlipped(const ew::DecodedImage& image, const ew::DecodedImage& flipped) {
+		const ew::ImageInfo& info = image.getInfo();
+		const size_t stride = ew::getPixelSize(info.type, info.channels) * info.width;
+		if (flipped.getSize() != image.getSize())
+			return false;
+		for (int y = 0; y < info.height; y++) {
+			if (memcmp(image.getPixels() + stride * y, flipped.getPixels() + stride * (info.height - 1 - y), stride) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// The full decode against stb_image, and each reduced one against the stb_image decode box filtered down,
+	/// which scaling in the IDCT approximates
+	/// </summary>
+	bool checkImage(const char* path) {
+		ew::ImageFile file;
+		if (!file.open(path)) {
+			printf("%s: no decoder reads it\n", path);
+			return false;
+		}
+		int width, height, channels;
+		unsigned char* reference = stbi_load(path, &width, &height, &channels, 0);
+		ew::DecodedImage image;
+		ew::decodeImage(path, image);
+		if (reference == NULL || !image.isValid() || image.getInfo().type != ew::PixelType::UInt8 || image.getInfo().width != width
+			|| image.getInfo().height != height || image.getInfo().channels != channels) {
+			printf("%s did not decode the same as with stb_image\n", path);
+			stbi_image_free(reference);
+			return false;
+		}
+		bool ok = true;
+		double worstPSNR = ew::computePSNR(reference, image.getPixels(), width, height, channels);
+		for (int scale : SCALES) {
+			ew::DecodeOptions options;
+			options.scale = scale;
+			ew::DecodedImage scaled;
+			if (!ew::decodeImage(path, scaled, options) || scaled.getInfo().width != ew::getScaledSize(width, scale)
+				|| scaled.getInfo().height != ew::getScaledSize(height, scale)) {
+				printf("%s: 1/%d decode has the wrong size\n", path, scale);
+				ok = false;
+				continue;
+			}
+			const ew::ImageInfo& scaledInfo = scaled.getInfo();
+			std::vector<unsigned char> boxed(scaled.getSize());
+			ew::resampleImage(reference, width, height, ew::PixelType::UInt8, boxed.data(), scaledInfo.width, scaledInfo.height, ew::PixelType::UInt8, channels);
+			worstPSNR = std::min(worstPSNR, ew::computePSNR(boxed.data(), scaled.getPixels(), scaledInfo.width, scaledInfo.height, channels));
+		}
+		stbi_image_free(reference);
+
+		ew::DecodeOptions flipOptions;
+		flipOptions.flipY = true;
+		ew::DecodedImage flipped;
+		if (!file.decode(flipped, flipOptions) || !isFlipped(image, flipped)) {
+			printf("%s flipped is not the rows reversed\n", path);
+			ok = false;
+		}
+		printf("%-36s %-14s worst PSNR %.2f dB\n", path, file.getDecoderName(), worstPSNR);
+		if (worstPSNR < MIN_PSNR) {
+			printf("%s decodes too far from stb_image\n", path);
+			ok = false;
+		}
+		return ok;
+	}
+}
+
+bool testDecode() {
+	bool ok = true;
+	for (const char* path : IMAGES) {
+		ok = checkImage(path) && ok;
+	}
+
+	//A buffer released to the pool comes back for the next image of the same size
+	ew::DecodedImage first, second;
+	ew::decodeImage(IMAGES[0], first);
+	const unsigned char* pixels = first.getPixels();
+	first.release();
+	ew::decodeImage(IMAGES[0], second);
+	const bool reused = second.isValid() && second.getPixels() == pixels;
+	printf("Pooled buffer reused: %s\n", reused ? "yes" : "no");
+	return ok && reused;
+}
@@ -0,0 +1,205 @@
+#include "tests.h"
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include <random>
+
+#include <ew/camera.h>
+#include <ew/ewMath/frustum.h>
+
+namespace {
+	const float EPSILON = 1e-4f;
+	//How far the test volumes sit to either side of a plane
+	const float OFFSET = 0.5f;
+	//None is a multiple of 4 or 8. The last spans several of the blocks the AoS culls transpose.
+	const size_t BATCH_COUNTS[] = { 5, 37, 1003 };
+
+	//A camera at the origin looking down -z with a 90 degree field of view, a square aspect and near 1, far 100.
+	//The volume is then |x| <= -z, |y| <= -z and 1 <= -z <= 100.
+	const float NEAR_PLANE = 1.0f;
+	const float FAR_PLANE = 100.0f;
+	struct Side {
+		const char* name;
+		ew::Vec3 point; //On the plane, inside every other one
+		ew::Vec3 normal; //Unit length, pointing inside
+	};
+	const float R = 0.70710678f;
+	const Side SIDES[] = {
+		{ "left", ew::Vec3(-10.0f, 0.0f, -10.0f), ew::Vec3(R, 0.0f, -R) },
+		{ "right", ew::Vec3(10.0f, 0.0f, -10.0f), ew::Vec3(-R, 0.0f, -R) },
+		{ "bottom", ew::Vec3(0.0f, -10.0f, -10.0f), ew::Vec3(0.0f, R, -R) },
+		{ "top", ew::Vec3(0.0f, 10.0f, -10.0f), ew::Vec3(0.0f, -R, -R) },
+		{ "near", ew::Vec3(0.0f, 0.0f, -NEAR_PLANE), ew::Vec3(0.0f, 0.0f, -1.0f) },
+		{ "far", ew::Vec3(0.0f, 0.0f, -FAR_PLANE), ew::Vec3(0.0f, 0.0f, 1.0f) },
+	};
+	const int NEAR_SIDE = 4;
+	const int FAR_SIDE = 5;
+
+	ew::Camera makeCamera(const ew::Vec3& position, bool reverseZ) {
+		ew::Camera camera;
+		camera.position = position;
+		camera.target = position + ew::Vec3(0.0f, 0.0f, -1.0f);
+		camera.fov = 90.0f;
+		camera.aspectRatio = 1.0f;
+		camera.nearPlane = NEAR_PLANE;
+		camera.farPlane = FAR_PLANE;
+		camera.reverseZ = reverseZ;
+		return camera;
+	}
+
+	bool samePlane(const ew::Vec4& a, const ew::Vec4& b) {
+		return fabsf(a.x - b.x) <= EPSILON && fabsf(a.y - b.y) <= EPSILON && fabsf(a.z - b.z) <= EPSILON
+			&& fabsf(a.w - b.w) <= EPSILON * fmaxf(1.0f, fabsf(b.w));
+	}
+
+	/// <summary>
+	/// Planes against SIDES moved to position. Reverse-Z's depth 0 slot is the plane at infinity, which every point
+	/// is inside, and its depth 1 slot is the near plane.
+	/// </summary>
+	bool checkPlanes(const char* name, const ew::Frustum& frustum, const ew::Vec3& position, bool reverseZ) {
+		bool ok = true;
+		for (int i = 0; i < 6; i++) {
+			const int side = reverseZ && i == FAR_SIDE ? NEAR_SIDE : i;
+			ew::Vec4 expected = ew::Vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			if (!(reverseZ && i == NEAR_SIDE)) {
+				const ew::Vec3& n = SIDES[side].normal;
+				expected = ew::Vec4(n.x, n.y, n.z, -ew::Dot(n, SIDES[side].point + position));
+			}
+			if (!samePlane(frustum.planes[i], expected)) {
+				const ew::Vec4& p = frustum.planes[i];
+				printf("%s: plane %d is (%g, %g, %g, %g), expected (%g, %g, %g, %g)\n", name, i, p.x, p.y, p.z, p.w,
+					expected.x, expected.y, expected.z, expected.w);
+				ok = false;
+			}
+		}
+		return ok;
+	}
+
+	bool expect(const char* name, const char* what, const char* side, bool result, bool expected) {
+		if (result != expected) {
+			printf("%s: %s at the %s plane is %s, expected %s\n", name, what, side, result ? "visible" : "culled", expected ? "visible" : "culled");
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Points, spheres and boxes clearly inside, clearly outside, and just either side of or straddling each plane.
+	/// Without a far plane, everything past it stays visible.
+	/// </summary>
+	bool checkVolumes(const char* name, const ew::Frustum& frustum, const ew::Vec3& position, bool reverseZ) {
+		bool ok = true;
+		const ew::Vec3 inside = position + ew::Vec3(0.0f, 0.0f, -50.0f);
+		ok = expect(name, "A point in the middle", "any", ew::TestSphere(frustum, inside, 0.0f), true) && ok;
+		ok = expect(name, "A box in the middle", "any", ew::TestAABB(frustum, ew::AABB{ inside - ew::Vec3(1.0f), inside + ew::Vec3(1.0f) }), true) && ok;
+		const ew::Vec3 behind = position + ew::Vec3(0.0f, 0.0f, 50.0f);
+		ok = expect(name, "A point behind the camera", "near", ew::TestSphere(frustum, behind, 0.0f), false) && ok;
+		ok = expect(name, "A box behind the camera", "near", ew::TestAABB(frustum, ew::AABB{ behind - ew::Vec3(1.0f), behind + ew::Vec3(1.0f) }), false) && ok;
+
+		for (int i = 0; i < 6; i++) {
+			const Side& side = SIDES[i];
+			const bool hasPlane = !(reverseZ && i == FAR_SIDE);
+			const ew::Vec3 in = position + side.point + side.normal * OFFSET;
+			const ew::Vec3 out = position + side.point - side.normal * OFFSET;
+			const ew::Vec3 far = position + side.point - side.normal * 1000.0f;
+			ok = expect(name, "A point just inside", side.name, ew::TestSphere(frustum, in, 0.0f), true) && ok;
+			ok = expect(name, "A point just outside", side.name, ew::TestSphere(frustum, out, 0.0f), !hasPlane) && ok;
+			ok = expect(name, "A point far outside", side.name, ew::TestSphere(frustum, far, 0.0f), !hasPlane) && ok;
+			ok = expect(name, "A sphere straddling", side.name, ew::TestSphere(frustum, out, OFFSET * 2.0f), true) && ok;
+			ok = expect(name, "A sphere just outside", side.name, ew::TestSphere(frustum, out, OFFSET * 0.5f), !hasPlane) && ok;
+			//A box's reach toward the plane is its extents projected onto the normal, at least 0.7 of them here
+			ok = expect(name, "A box straddling", side.name, ew::TestAABB(frustum, ew::AABB{ out - ew::Vec3(OFFSET * 2.0f), out + ew::Vec3(OFFSET * 2.0f) }), true) && ok;
+			ok = expect(name, "A box just outside", side.name, ew::TestAABB(frustum, ew::AABB{ out - ew::Vec3(OFFSET * 0.2f), out + ew::Vec3(OFFSET * 0.2f) }), !hasPlane) && ok;
+		}
+		return ok;
+	}
+
+	/// <summary>
+	/// Every batch cull against TestSphere and TestAABB one object at a time, on random volumes around the frustum.
+	/// Bits past count in the last word must be clear.
+	/// </summary>
+	bool checkBatches(const char* name, const ew::Frustum& frustum, const ew::Vec3& position, std::mt19937& random) {
+		std::uniform_real_distribution<float> coordinate(-120.0f, 120.0f);
+		std::uniform_real_distribution<float> size(0.0f, 10.0f);
+		bool ok = true;
+		for (size_t count : BATCH_COUNTS) {
+			std::vector<ew::BoundingSphere> spheres(count);
+			std::vector<ew::AABB> boxes(count);
+			std::vector<float> x(count), y(count), z(count), radius(count), ex(count), ey(count), ez(count);
+			for (size_t i = 0; i < count; i++) {
+				const ew::Vec3 center = position + ew::Vec3(coordinate(random), coordinate(random), -fabsf(coordinate(random)));
+				const ew::Vec3 extents = ew::Vec3(size(random), size(random), size(random));
+				spheres[i].center = center;
+				spheres[i].radius = extents.x;
+				boxes[i] = ew::AABB{ center - extents, center + extents };
+				//From center() and extents(), which CullAABBs and TestAABB both compute the same way
+				x[i] = boxes[i].center().x;
+				y[i] = boxes[i].center().y;
+				z[i] = boxes[i].center().z;
+				ex[i] = boxes[i].extents().x;
+				ey[i] = boxes[i].extents().y;
+				ez[i] = boxes[i].extents().z;
+				radius[i] = spheres[i].radius;
+			}
+			const size_t words = ew::NumVisibilityWords(count);
+			//Filled with ones, so words that are not overwritten show up as stray bits
+			std::vector<uint32_t> sphereBits(words, ~0u), boxBits(words, ~0u), sphereSoABits(words, ~0u), boxSoABits(words, ~0u);
+			ew::CullSpheres(frustum, spheres.data(), count, sphereBits.data());
+			ew::CullAABBs(frustum, boxes.data(), count, boxBits.data());
+			std::vector<float> sx(count), sy(count), sz(count);
+			for (size_t i = 0; i < count; i++) {
+				sx[i] = spheres[i].center.x;
+				sy[i] = spheres[i].center.y;
+				sz[i] = spheres[i].center.z;
+			}
+			ew::CullSpheresSoA(frustum, sx.data(), sy.data(), sz.data(), radius.data(), count, sphereSoABits.data());
+			ew::CullAABBsSoA(frustum, x.data(), y.data(), z.data(), ex.data(), ey.data(), ez.data(), count, boxSoABits.data());
+
+			size_t visibleSpheres = 0, visibleBoxes = 0;
+			for (size_t i = 0; i < words * 32; i++) {
+				const bool sphere = i < count && ew::TestSphere(frustum, spheres[i].center, spheres[i].radius);
+				const bool box = i < count && ew::TestAABB(frustum, boxes[i]);
+				visibleSpheres += sphere;
+				visibleBoxes += box;
+				if (ew::IsVisible(sphereBits.data(), i) != sphere || ew::IsVisible(sphereSoABits.data(), i) != sphere
+					|| ew::IsVisible(boxBits.data(), i) != box || ew::IsVisible(boxSoABits.data(), i) != box) {
+					printf("%s, %zu objects: bit %zu is sphere %d, sphere SoA %d, box %d, box SoA %d, expected sphere %d, box %d\n", name, count, i,
+						ew::IsVisible(sphereBits.data(), i), ew::IsVisible(sphereSoABits.data(), i), ew::IsVisible(boxBits.data(), i),
+						ew::IsVisible(boxSoABits.data(), i), sphere, box);
+					ok = false;
+					break;
+				}
+			}
+			//Neither all nor none, or the comparison proves little
+			if (visibleSpheres == 0 || visibleSpheres == count || visibleBoxes == 0 || visibleBoxes == count) {
+				printf("%s, %zu objects: %zu spheres and %zu boxes visible\n", name, count, visibleSpheres, visibleBoxes);
+				ok = false;
+			}
+		}
+		return ok;
+	}
+
+	bool checkFrustum(const char* name, const ew::Frustum& frustum, const ew::Vec3& position, bool reverseZ, std::mt19937& random) {
+		bool ok = checkPlanes(name, frustum, position, reverseZ);
+		ok = checkVolumes(name, frustum, position, reverseZ) && ok;
+		return checkBatches(name, frustum, position, random) && ok;
+	}
+}
+
+/// <summary>
+/// ExtractFrustum on the projections directly, then through Camera::ViewFrustum away from the origin,
+/// so the planes are in world space. Uses the cull kernels this build compiles (EW_SIMD_NAME).
+/// </summary>
+bool testFrustum() {
+	std::mt19937 random(38);
+	const float fov = ew::Radians(90.0f);
+	const ew::Vec3 origin = ew::Vec3(0.0f);
+	const ew::Vec3 moved = ew::Vec3(12.0f, -3.0f, 40.0f);
+	bool ok = checkFrustum("Perspective", ew::ExtractFrustum(ew::Perspective(fov, 1.0f, NEAR_PLANE, FAR_PLANE)), origin, false, random);
+	ok = checkFrustum("Reverse-Z", ew::ExtractFrustum(ew::PerspectiveReverseZ(fov, 1.0f, NEAR_PLANE), true), origin, true, random) && ok;
+	ok = checkFrustum("Camera", makeCamera(moved, false).ViewFrustum(), moved, false, random) && ok;
+	ok = checkFrustum("Reverse-Z camera", makeCamera(moved, true).ViewFrustum(), moved, true, random) && ok;
+	printf("%s kernels: planes, points, spheres and boxes at each plane, and batch culls of up to %zu objects %s\n", EW_SIMD_NAME,
+		BATCH_COUNTS[sizeof(BATCH_COUNTS) / sizeof(BATCH_COUNTS[0]) - 1], ok ? "match" : "do not match");
+	return ok;
+}
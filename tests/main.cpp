@@ -0,0 +1,92 @@
+/*
+	Correctness checks for core. CTest runs each one on its own; run from bin, where the assets are copied.
+
+	Usage: coreTests               every check
+	       coreTests name [..]     the named checks
+
+	Exits 0 if all passed, 1 if any failed, and 77 (CTest's skip code here) if the only ones that didn't run
+	needed a GL context and none could be created.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include <ew/headless.h>
+
+#include "tests.h"
+
+namespace {
+	const int SKIPPED = 77;
+
+	struct Test {
+		const char* name;
+		bool (*run)();
+		bool needsContext;
+	};
+	const Test TESTS[] = {
+		{ "mat4", testMat4, false },
+		{ "quat", testQuat, false },
+		{ "transform", testTransform, false },
+		{ "batchTransform", testBatchTransform, false },
+		{ "frustum", testFrustum, false },
+		{ "bounds", testBounds, false },
+		{ "renderQueue", testRenderQueue, false },
+		{ "resample", testResample, false },
+		{ "blockCompression", testBlockCompression, false },
+		{ "decode", testDecode, false },
+		{ "cubemap", testCubemap, false },
+		{ "textureCache", testTextureCache, false },
+		{ "virtualTexture", testVirtualTexture, false },
+		{ "textureManager", testTextureManager, true },
+	};
+}
+
+int main(int argc, char** argv) {
+	std::vector<const Test*> selected;
+	for (int i = 1; i < argc; i++) {
+		const Test* found = nullptr;
+		for (const Test& test : TESTS) {
+			if (strcmp(argv[i], test.name) == 0)
+				found = &test;
+		}
+		if (!found) {
+			printf("Unknown test %s. Tests:", argv[i]);
+			for (const Test& test : TESTS) {
+				printf(" %s", test.name);
+			}
+			printf("\n");
+			return 1;
+		}
+		selected.push_back(found);
+	}
+	if (selected.empty()) {
+		for (const Test& test : TESTS) {
+			selected.push_back(&test);
+		}
+	}
+
+	//Created once, for the first check that needs it
+	ew::HeadlessContext context;
+	bool triedContext = false, hasContext = false;
+	int failed = 0, skipped = 0;
+	for (const Test* test : selected) {
+		printf("== %s\n", test->name);
+		if (test->needsContext && !triedContext) {
+			triedContext = true;
+			hasContext = context.create();
+		}
+		if (test->needsContext && !hasContext) {
+			printf("-- %s skipped, no GL context\n", test->name);
+			skipped++;
+			continue;
+		}
+		const bool passed = test->run();
+		printf("-- %s %s\n", test->name, passed ? "passed" : "FAILED");
+		failed += passed ? 0 : 1;
+	}
+	if (failed > 0) {
+		printf("%d of %d checks failed\n", failed, (int)selected.size());
+		return 1;
+	}
+	return skipped > 0 && skipped == (int)selected.size() ? SKIPPED : 0;
+}
@@ -0,0 +1,243 @@
+#include "tests.h"
+#include <stdio.h>
+#include <math.h>
+
+#include <ew/ewMath/ewMath.h>
+#include <ew/ewMath/transformations.h>
+
+namespace {
+	const float EPSILON = 1e-4f;
+
+	//Deterministic values in [-1, 1)
+	struct Random {
+		unsigned int state = 12345u;
+		float next() {
+			state = state * 1664525u + 1013904223u;
+			return (state >> 8) * (2.0f / 16777216.0f) - 1.0f;
+		}
+	};
+
+	float maxDifference(const ew::Mat4& a, const ew::Mat4& b) {
+		float worst = 0.0f;
+		for (int col = 0; col < 4; col++) {
+			for (int row = 0; row < 4; row++) {
+				worst = fmaxf(worst, fabsf(a[col][row] - b[col][row]));
+			}
+		}
+		return worst;
+	}
+
+	//q and -q are the same rotation
+	bool sameRotation(const ew::Quat& a, const ew::Quat& b) {
+		return fabsf(fabsf(ew::Dot(a, b)) - 1.0f) <= EPSILON;
+	}
+
+#if defined(EW_SIMD_HAS_CONSTEXPR)
+	const int NUM_MAT4_CASES = 64;
+
+	//Inputs and every Mat4 operation's result on them
+	struct Mat4Case {
+		ew::Mat4 a, affine;
+		ew::Vec4 v;
+		ew::Mat4 product, affineProduct, transpose, inverse, affineInverse, normal;
+		ew::Vec4 transformed;
+		float determinant = 0.0f;
+	};
+	struct Mat4Cases {
+		Mat4Case cases[NUM_MAT4_CASES];
+	};
+
+	constexpr float nextConstant(unsigned int& state) {
+		state = state * 1664525u + 1013904223u;
+		return (state >> 8) * (4.0f / 16777216.0f) - 2.0f;
+	}
+
+	constexpr Mat4Case computeMat4Case(const ew::Mat4& a, const ew::Mat4& affine, const ew::Vec4& v) {
+		Mat4Case c;
+		c.a = a;
+		c.affine = affine;
+		c.v = v;
+		c.product = a * affine;
+		c.affineProduct = affine * a;
+		c.transpose = ew::Transpose(a);
+		c.inverse = ew::Inverse(a);
+		c.affineInverse = ew::AffineInverse(affine);
+		c.normal = ew::NormalMatrix(affine);
+		c.transformed = a * v;
+		c.determinant = ew::Determinant(a);
+		return c;
+	}
+
+	//Random general matrices, affine matrices with a random 3x3 and translation, and vectors
+	constexpr Mat4Cases makeMat4Cases() {
+		Mat4Cases cases;
+		unsigned int state = 2024u;
+		for (int i = 0; i < NUM_MAT4_CASES; i++) {
+			ew::Mat4 a(0.0f), affine(0.0f);
+			for (int col = 0; col < 4; col++) {
+				for (int row = 0; row < 4; row++) {
+					a[col][row] = nextConstant(state);
+					affine[col][row] = row < 3 ? nextConstant(state) : (col == 3 ? 1.0f : 0.0f);
+				}
+			}
+			ew::Vec4 v;
+			v.x = nextConstant(state);
+			v.y = nextConstant(state);
+			v.z = nextConstant(state);
+			v.w = nextConstant(state);
+			cases.cases[i] = computeMat4Case(a, affine, v);
+		}
+		return cases;
+	}
+
+#if defined(__FMA__)
+	//The compiler may fuse multiplies and adds at run time but never in constant expressions, which rounds differently
+	const float MAT4_TOLERANCE = 1e-4f;
+#else
+	const float MAT4_TOLERANCE = 0.0f;
+#endif
+	bool equal(float a, float b) {
+		return a == b || fabsf(a - b) <= MAT4_TOLERANCE * fmaxf(1.0f, fabsf(b));
+	}
+	bool equal(const ew::Mat4& a, const ew::Mat4& b) {
+		for (int col = 0; col < 4; col++) {
+			for (int row = 0; row < 4; row++) {
+				if (!equal(a[col][row], b[col][row]))
+					return false;
+			}
+		}
+		return true;
+	}
+	bool equal(const ew::Vec4& a, const ew::Vec4& b) {
+		return equal(a.x, b.x) && equal(a.y, b.y) && equal(a.z, b.z) && equal(a.w, b.w);
+	}
+#endif
+
+	bool isIdentity(const ew::Quat& q) {
+		return q.x == 0.0f && q.y == 0.0f && q.z == 0.0f && q.w == 1.0f;
+	}
+
+	/// <summary>
+	/// Weights that cancel leave nothing to normalize. Every SIMD path must give identity there, as the scalar one does, not NaN.
+	/// </summary>
+	bool checkBlendZero() {
+		const ew::Quat q = ew::AngleAxis(0.7f, ew::Normalize(ew::Vec3(1.0f, 2.0f, 3.0f)));
+		const ew::Quat blends[] = {
+			ew::BlendNormalized(q, 1.0f, q, -1.0f),
+			ew::BlendNormalized(q, 0.0f, q, 0.0f),
+			ew::BlendNormalized(q, 0.5f, ew::Quat(-q.x, -q.y, -q.z, -q.w), 0.5f)
+		};
+		bool ok = true;
+		for (const ew::Quat& blend : blends) {
+			if (!isIdentity(blend)) {
+				printf("Zero length blend gave %g %g %g %g, not identity\n", blend.x, blend.y, blend.z, blend.w);
+				ok = false;
+			}
+		}
+		return ok;
+	}
+
+	/// <summary>
+	/// ToMat4 must rotate the way RotateX/Y/Z do, and FromMat4 must give back the rotation whichever of
+	/// w, x, y or z it divides by, so the angles go past 180 degrees around every axis
+	/// </summary>
+	bool checkMatrixRoundTrip() {
+		bool ok = true;
+		const float angles[] = { 0.0f, 0.3f, -1.2f, 2.5f, ew::PI, -3.0f };
+		for (float angle : angles) {
+			const float worst = fmaxf(maxDifference(ew::ToMat4(ew::AngleAxis(angle, ew::Vec3(1, 0, 0))), ew::RotateX(angle)),
+				fmaxf(maxDifference(ew::ToMat4(ew::AngleAxis(angle, ew::Vec3(0, 1, 0))), ew::RotateY(angle)),
+					maxDifference(ew::ToMat4(ew::AngleAxis(angle, ew::Vec3(0, 0, 1))), ew::RotateZ(angle))));
+			if (worst > EPSILON) {
+				printf("ToMat4 of %g radians differs from RotateX/Y/Z by %g\n", angle, worst);
+				ok = false;
+			}
+		}
+		Random random;
+		for (int i = 0; i < 1000 && ok; i++) {
+			const ew::Vec3 axis = i < 3 ? ew::Vec3(i == 0, i == 1, i == 2) : ew::Normalize(ew::Vec3(random.next(), random.next(), random.next()));
+			const ew::Quat q = ew::AngleAxis(random.next() * ew::PI * 2.0f, axis);
+			const ew::Mat4 m = ew::ToMat4(q);
+			const ew::Quat back = ew::FromMat4(m);
+			if (!sameRotation(q, back) || maxDifference(ew::ToMat4(back), m) > EPSILON) {
+				printf("Quat %g %g %g %g came back from its matrix as %g %g %g %g\n", q.x, q.y, q.z, q.w, back.x, back.y, back.z, back.w);
+				ok = false;
+			}
+		}
+		return ok;
+	}
+
+	/// <summary>
+	/// Slerp must start at a and end on b's rotation, on the shorter arc whether a and b are far apart, nearly
+	/// parallel or in opposite hemispheres, and stay unit length between
+	/// </summary>
+	bool checkSlerpEndpoints() {
+		Random random;
+		bool ok = true;
+		for (int i = 0; i < 1000 && ok; i++) {
+			const ew::Quat a = ew::AngleAxis(random.next() * ew::PI, ew::Normalize(ew::Vec3(random.next(), random.next(), random.next())));
+			ew::Quat b = i % 3 == 0 ? ew::AngleAxis(random.next() * 0.01f, ew::Vec3(0, 1, 0)) * a
+				: ew::AngleAxis(random.next() * ew::PI, ew::Normalize(ew::Vec3(random.next(), random.next(), random.next())));
+			if (i % 2 == 1) {
+				b = ew::Quat(-b.x, -b.y, -b.z, -b.w);
+			}
+			const ew::Quat start = ew::Slerp(a, b, 0.0f), end = ew::Slerp(a, b, 1.0f), middle = ew::Slerp(a, b, 0.5f);
+			if (!sameRotation(start, a) || ew::Dot(start, a) < 0.0f || !sameRotation(end, b)
+				|| fabsf(ew::Dot(middle, middle) - 1.0f) > EPSILON || ew::Dot(middle, a) < 0.0f) {
+				printf("Slerp from %g %g %g %g to %g %g %g %g: starts %g %g %g %g, ends %g %g %g %g\n", a.x, a.y, a.z, a.w, b.x, b.y, b.z, b.w,
+					start.x, start.y, start.z, start.w, end.x, end.y, end.z, end.w);
+				ok = false;
+			}
+		}
+		return ok;
+	}
+}
+
+/// <summary>
+/// The expected results are a constant expression, which takes the same scalar code an EW_NO_SIMD build
+/// runs. The same operations at run time take this build's SIMD path and must give the same bits, unless
+/// the build targets FMA.
+/// </summary>
+bool testMat4() {
+#if defined(EW_SIMD_HAS_CONSTEXPR)
+	static constexpr Mat4Cases EXPECTED = makeMat4Cases();
+	bool ok = true;
+	int numMismatched = 0;
+	for (const Mat4Case& expected : EXPECTED.cases) {
+		//volatile keeps the compiler from folding the run time calls into constants too
+		volatile float offset = 0.0f;
+		ew::Mat4 a = expected.a, affine = expected.affine;
+		a[0][0] += offset;
+		affine[0][0] += offset;
+		const Mat4Case actual = computeMat4Case(a, affine, expected.v);
+		const bool matches[] = {
+			equal(actual.product, expected.product),
+			equal(actual.affineProduct, expected.affineProduct),
+			equal(actual.transpose, expected.transpose),
+			equal(actual.inverse, expected.inverse),
+			equal(actual.affineInverse, expected.affineInverse),
+			equal(actual.normal, expected.normal),
+			equal(actual.transformed, expected.transformed),
+			equal(actual.determinant, expected.determinant)
+		};
+		const char* names[] = { "Mat4 * Mat4", "affine * Mat4", "Transpose", "Inverse", "AffineInverse", "NormalMatrix", "Mat4 * Vec4", "Determinant" };
+		for (int i = 0; i < 8; i++) {
+			if (!matches[i] && numMismatched++ < 8) {
+				printf("%s differs between the %s and scalar paths\n", names[i], EW_SIMD_NAME);
+			}
+			ok = ok && matches[i];
+		}
+	}
+	printf("%d cases, %s against scalar: %s\n", NUM_MAT4_CASES, EW_SIMD_NAME, ok ? "identical" : "DIFFERENT");
+	return ok;
+#else
+	printf("This compiler can't evaluate the SIMD functions as constant expressions, so there is no scalar result to compare with\n");
+	return true;
+#endif
+}
+
+bool testQuat() {
+	bool ok = checkBlendZero();
+	ok = checkMatrixRoundTrip() && ok;
+	return checkSlerpEndpoints() && ok;
+}
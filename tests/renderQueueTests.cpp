@@ -0,0 +1,84 @@
+#include "tests.h"
+#include <stdio.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <ew/renderQueue.h>
+
+namespace {
+	/// <summary>
+	/// radixSort must give the order std::stable_sort does, equal keys staying in submission order
+	/// </summary>
+	bool checkSort(std::vector<ew::SortEntry> entries, const char* name) {
+		std::vector<ew::SortEntry> expected = entries, scratch;
+		std::stable_sort(expected.begin(), expected.end(), [](const ew::SortEntry& a, const ew::SortEntry& b) { return a.key < b.key; });
+		ew::RenderQueue::radixSort(entries, scratch);
+		for (size_t i = 0; i < entries.size(); i++) {
+			if (entries[i].key != expected[i].key || entries[i].index != expected[i].index) {
+				printf("%s: entry %zu is key %llx index %u, expected key %llx index %u\n", name, i, (unsigned long long)entries[i].key,
+					entries[i].index, (unsigned long long)expected[i].key, expected[i].index);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::vector<ew::SortEntry> makeEntries(size_t count, uint64_t (*makeKey)(std::mt19937_64&)) {
+		std::mt19937_64 random(28);
+		std::vector<ew::SortEntry> entries(count);
+		for (size_t i = 0; i < count; i++) {
+			entries[i].key = makeKey(random);
+			entries[i].index = (uint32_t)i;
+		}
+		return entries;
+	}
+}
+
+/// <summary>
+/// Random keys, keys with many duplicates, keys that differ in only some bytes so passes are skipped, and keys
+/// packed by makeSortKey, at sizes down to none
+/// </summary>
+bool testRenderQueue() {
+	bool ok = true;
+	const size_t sizes[] = { 0, 1, 2, 3, 255, 256, 257, 10000, 100000 };
+	for (size_t count : sizes) {
+		ok = checkSort(makeEntries(count, [](std::mt19937_64& random) { return (uint64_t)random(); }), "Random keys") && ok;
+		ok = checkSort(makeEntries(count, [](std::mt19937_64& random) { return (uint64_t)(random() % 7) << 40; }), "Duplicate keys") && ok;
+		ok = checkSort(makeEntries(count, [](std::mt19937_64& random) { return (uint64_t)(random() & 0xFF00FF); }), "Sparse bytes") && ok;
+		ok = checkSort(makeEntries(count, [](std::mt19937_64&) { return (uint64_t)0x1234; }), "Equal keys") && ok;
+		ok = checkSort(makeEntries(count, [](std::mt19937_64& random) {
+			const ew::RenderPass pass = (ew::RenderPass)(random() % 3);
+			return ew::RenderQueue::makeSortKey(pass, (uint32_t)(random() % 8), (uint32_t)(random() % 64), (random() % 1000) / 999.0f, (uint32_t)(random() % 32));
+		}), "Packed keys") && ok;
+	}
+	printf("radixSort against std::stable_sort: %s\n", ok ? "same order" : "DIFFERENT");
+
+	//Passes draw in order, solid front to back, blended back to front
+	const uint64_t nearSolid = ew::RenderQueue::makeSortKey(ew::RenderPass::SOLID, 1, 1, 0.1f, 0);
+	const uint64_t farSolid = ew::RenderQueue::makeSortKey(ew::RenderPass::SOLID, 1, 1, 0.9f, 0);
+	const uint64_t sky = ew::RenderQueue::makeSortKey(ew::RenderPass::SKYBOX, 0, 0, 0.0f, 0);
+	const uint64_t nearBlended = ew::RenderQueue::makeSortKey(ew::RenderPass::BLENDED, 0, 0, 0.1f, 0);
+	const uint64_t farBlended = ew::RenderQueue::makeSortKey(ew::RenderPass::BLENDED, 0, 0, 0.9f, 0);
+	if (!(nearSolid < farSolid && farSolid < sky && sky < farBlended && farBlended < nearBlended)) {
+		printf("Sort keys don't order passes, or depth within them\n");
+		ok = false;
+	}
+
+	//With an infinite reverse-Z projection there is no far plane to clamp at, so distant draws must stay ordered
+	const float distances[] = { 0.5f, 10.0f, 100.0f, 200.0f, 1000.0f, 10000.0f, 100000.0f };
+	uint64_t previous = 0;
+	for (int i = 0; i < 7; i++) {
+		const uint64_t key = ew::RenderQueue::makeSortKey(ew::RenderPass::SOLID, 0, 0, ew::RenderQueue::makeSortDepth(distances[i], 0.1f), 0);
+		if (i > 0 && key <= previous) {
+			printf("Draws %g and %g away sort the same or the wrong way round\n", distances[i - 1], distances[i]);
+			ok = false;
+		}
+		previous = key;
+	}
+	if (ew::RenderQueue::makeSortDepth(0.0f, 0.1f) != 0.0f || ew::RenderQueue::makeSortDepth(-5.0f, 0.1f) != 0.0f) {
+		printf("Draws at or behind the camera don't sort first\n");
+		ok = false;
+	}
+	return ok;
+}
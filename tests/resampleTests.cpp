@@ -0,0 +1,140 @@
+#include "tests.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+#include <ew/imageResample.h>
+#include <ew/external/stb_image.h>
+
+namespace {
+	const char* filterNames[] = { "Box", "Kaiser", "Lanczos" };
+
+	float toLinear(float c) { return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f); }
+	float fromLinear(float l) { return l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f; }
+
+	/// <summary>
+	/// Halving an even sized 8 bit image with the box filter must match averaging each 2x2 block in linear space
+	/// </summary>
+	bool checkBox(const unsigned char* pixels, int width, int height, int channels) {
+		width &= ~1;
+		height &= ~1;
+		std::vector<unsigned char> source((size_t)width * height * channels);
+		for (int y = 0; y < height; y++) {
+			memcpy(&source[(size_t)y * width * channels], pixels + (size_t)y * width * channels, (size_t)width * channels);
+		}
+		std::vector<unsigned char> result((size_t)(width / 2) * (height / 2) * channels);
+		ew::ResampleOptions options;
+		options.srgbChannels = std::min(channels, 3);
+		ew::downsampleImage(source.data(), width, height, result.data(), channels, ew::PixelType::UInt8, options);
+		float worst = 0.0f;
+		for (int y = 0; y < height / 2; y++) {
+			for (int x = 0; x < width / 2; x++) {
+				for (int c = 0; c < channels; c++) {
+					float sum = 0.0f;
+					for (int i = 0; i < 4; i++) {
+						const unsigned char v = source[((size_t)(y * 2 + i / 2) * width + x * 2 + i % 2) * channels + c];
+						sum += c < options.srgbChannels ? toLinear(v / 255.0f) : v / 255.0f;
+					}
+					const float expected = (c < options.srgbChannels ? fromLinear(sum * 0.25f) : sum * 0.25f) * 255.0f;
+					worst = std::max(worst, fabsf(result[((size_t)y * (width / 2) + x) * channels + c] - expected));
+				}
+			}
+		}
+		printf("Box 2x against 2x2 averages: largest difference %.2f\n", worst);
+		return worst <= 1.0f;
+	}
+
+	/// <summary>
+	/// Every filter must leave a constant image constant, at any scale, for every pixel type
+	/// </summary>
+	bool checkConstant() {
+		const int srcWidth = 37, srcHeight = 23, channels = 4;
+		const int sizes[][2] = { { 18, 11 }, { 5, 3 }, { 64, 40 }, { 1, 1 } };
+		const float value[4] = { 0.2f, 0.5f, 0.8f, 1.0f };
+		bool ok = true;
+		for (int f = 0; f < 3; f++) {
+			for (int t = 0; t < 3; t++) {
+				const ew::PixelType type = t == 0 ? ew::PixelType::UInt8 : (t == 1 ? ew::PixelType::UInt16 : ew::PixelType::Float);
+				const float range = t == 0 ? 255.0f : (t == 1 ? 65535.0f : 1.0f);
+				std::vector<unsigned char> source(ew::getPixelSize(type, channels) * srcWidth * srcHeight);
+				for (int i = 0; i < srcWidth * srcHeight * channels; i++) {
+					const float v = value[i % channels] * range;
+					if (t == 0)
+						source[i] = (unsigned char)(v + 0.5f);
+					else if (t == 1)
+						((uint16_t*)source.data())[i] = (uint16_t)(v + 0.5f);
+					else
+						((float*)source.data())[i] = v;
+				}
+				for (const int* size : sizes) {
+					ew::ResampleOptions options;
+					options.filter = (ew::ResampleFilter)f;
+					options.srgbChannels = t < 2 ? 3 : 0;
+					options.wrap = size[0] == 5;
+					std::vector<unsigned char> result(ew::getPixelSize(type, channels) * size[0] * size[1]);
+					ew::resampleImage(source.data(), srcWidth, srcHeight, type, result.data(), size[0], size[1], type, channels, options);
+					for (int i = 0; i < size[0] * size[1] * channels && ok; i++) {
+						const float expected = t == 0 ? source[i % channels] : (t == 1 ? ((uint16_t*)source.data())[i % channels] : ((float*)source.data())[i % channels]);
+						const float actual = t == 0 ? result[i] : (t == 1 ? ((uint16_t*)result.data())[i] : ((float*)result.data())[i]);
+						if (fabsf(actual - expected) > (t == 2 ? 1e-5f : 1.0f)) {
+							printf("%s, type %d, %dx%d: constant %g came out %g\n", filterNames[f], t, size[0], size[1], expected, actual);
+							ok = false;
+						}
+					}
+				}
+			}
+		}
+		printf("Constant images: %s\n", ok ? "unchanged" : "CHANGED");
+		return ok;
+	}
+
+	/// <summary>
+	/// A mip chain must come out the same on one thread as on all of them, whatever the filter
+	/// </summary>
+	bool checkThreads(const unsigned char* pixels, int width, int height, int channels) {
+		bool ok = true;
+		for (int f = 0; f < 3; f++) {
+			ew::ResampleOptions options;
+			options.filter = (ew::ResampleFilter)f;
+			options.srgbChannels = channels >= 3 ? 3 : 0;
+			std::vector<unsigned char> results[2];
+			for (int run = 0; run < 2; run++) {
+				options.numThreads = run == 0 ? 1 : 0;
+				std::vector<unsigned char> current(pixels, pixels + (size_t)width * height * channels), next;
+				int mipWidth = width, mipHeight = height;
+				while (mipWidth > 1 || mipHeight > 1) {
+					next.resize((size_t)ew::getMipSize(mipWidth, 1) * ew::getMipSize(mipHeight, 1) * channels);
+					ew::downsampleImage(current.data(), mipWidth, mipHeight, next.data(), channels, ew::PixelType::UInt8, options);
+					results[run].insert(results[run].end(), next.begin(), next.end());
+					current.swap(next);
+					mipWidth = ew::getMipSize(mipWidth, 1);
+					mipHeight = ew::getMipSize(mipHeight, 1);
+				}
+			}
+			if (results[0] != results[1]) {
+				printf("%s: threaded mip chain differs from one thread\n", filterNames[f]);
+				ok = false;
+			}
+		}
+		return ok;
+	}
+}
+
+bool testResample() {
+	const char* imagePath = "assets/brick_color.jpg";
+	int width, height, channels;
+	unsigned char* pixels = stbi_load(imagePath, &width, &height, &channels, 0);
+	if (pixels == NULL) {
+		printf("Failed to load image %s\n", imagePath);
+		return false;
+	}
+	printf("%s: %dx%d, %d channels\n", imagePath, width, height, channels);
+	bool ok = checkBox(pixels, width, height, channels);
+	ok = checkConstant() && ok;
+	ok = checkThreads(pixels, width, height, channels) && ok;
+	stbi_image_free(pixels);
+	return ok;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+//Correctness checks for core, run from main.cpp. Each prints what it measured and returns false if a check failed.
+//Paths are relative to bin, where the finalProject assets are copied.
+
+//Every batch transform path, packed, strided, SoA and threaded, against Mat4 * Vec4 one element at a time
+bool testBatchTransform();
+//ExtractFrustum planes for perspective and reverse-Z, volumes at each plane, and the batch culls against the single tests
+bool testFrustum();
+//ComputeBounds and the bounding volume helpers on hand computed values, and generated meshes inside their analytic bounds
+bool testBounds();
+//Transform::getModelMatrix against the matrix product it replaced, and TransformHierarchy's cached world matrices
+bool testTransform();
+//RenderQueue::radixSort against std::stable_sort, and the order sort keys put passes and depths in
+bool testRenderQueue();
+//ew::resampleImage against a plain box filter and constant images, and the same result on any number of threads
+bool testResample();
+//BC1, BC4, BC5 and BC7 mode 6 round trips within a PSNR bound, with solid color blocks decoding exactly
+bool testBlockCompression();
+//The default decoder against stb_image, reduced decodes against a box filtered full one, flipped decodes and pool reuse
+bool testDecode();
+//The cubemap cache, cross and equirectangular layouts cutting back to the same faces, and seams across faces
+bool testCubemap();
+//Texture caches with damaged headers or mip sizes rejected, the source decoded and the cache rewritten
+bool testTextureCache();
+//The virtual texture page cache and loader over a camera panning a synthetic texture, then more pages than fit
+bool testVirtualTexture();
+//Mat4 operations on this build's SIMD path against the scalar code, bit for bit
+bool testMat4();
+//Quaternions to matrices and back, Slerp endpoints and blends that cancel out
+bool testQuat();
+//ew::TextureManager keeping a sliding window of textures and arrays at full size within its budget. Needs a GL context.
+bool testTextureManager();
@@ -0,0 +1,122 @@
+#include "tests.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+
+#include <ew/textureCache.h>
+
+namespace {
+	//Copied so the damaged caches sit next to a source of their own, not next to the assets'
+	const char* SOURCES[] = { "assets/brick_color.jpg", "assets/heightmaps/heightmap01.jpg" };
+	const char* COPY_PATH = "textureCacheTest.jpg";
+
+	//Where fields sit in a cache file, as FileHeader and MipEntry in textureCache.cpp lay them out
+	const size_t FLAGS_OFFSET = 12;
+	const size_t NUM_MIPS_OFFSET = 24;
+	const size_t MIP_TABLE_OFFSET = 48;
+	const size_t MIP_ENTRY_SIZE = 16;
+	const uint32_t FLAG_SRGB = 1;
+
+	struct Damage {
+		const char* what;
+		size_t offset;
+		uint64_t value;
+		size_t width; //Bytes of value written
+	};
+
+	std::vector<unsigned char> readFile(const std::string& path) {
+		std::ifstream file(path, std::ios::binary);
+		return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	void writeFile(const std::string& path, const std::vector<unsigned char>& bytes) {
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+	}
+	template <typename T>
+	T readField(const std::vector<unsigned char>& bytes, size_t offset) {
+		T value;
+		memcpy(&value, bytes.data() + offset, sizeof(T));
+		return value;
+	}
+
+	bool sameMips(const ew::TextureImage& a, const ew::TextureImage& b) {
+		if (a.getFormat() != b.getFormat() || a.getNumMips() != b.getNumMips())
+			return false;
+		for (int level = 0; level < a.getNumMips(); level++) {
+			const ew::TextureMip& mipA = a.getMip(level);
+			const ew::TextureMip& mipB = b.getMip(level);
+			if (mipA.width != mipB.width || mipA.height != mipB.height || mipA.size != mipB.size || memcmp(mipA.data, mipB.data, mipA.size) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Writes each damaged copy of a good cache over it. Loading must decode the source instead, to the same mips,
+	/// and rewrite the cache so the next load reads it.
+	/// </summary>
+	bool checkSource(const char* source, ew::TextureCompression compression) {
+		std::error_code error;
+		std::filesystem::copy_file(source, COPY_PATH, std::filesystem::copy_options::overwrite_existing, error);
+		ew::TextureImage built;
+		if (error || !ew::buildTextureImage(COPY_PATH, built, false, compression)) {
+			printf("Failed to build a cache for %s\n", source);
+			return false;
+		}
+		const std::string cachePath = std::string(COPY_PATH) + (compression == ew::TextureCompression::BC1 ? ".bc1" : "") + ".ewtex";
+		const std::vector<unsigned char> good = readFile(cachePath);
+		if (good.size() < MIP_TABLE_OFFSET) {
+			printf("No cache at %s\n", cachePath.c_str());
+			return false;
+		}
+		const uint32_t flags = readField<uint32_t>(good, FLAGS_OFFSET);
+		const uint32_t numMips = readField<uint32_t>(good, NUM_MIPS_OFFSET);
+		const size_t lastSize = MIP_TABLE_OFFSET + (numMips - 1) * MIP_ENTRY_SIZE + 8;
+		//Each stays inside the file, so only the checks on what the fields say catch it
+		const Damage damages[] = {
+			{ "Level 0 one byte short", MIP_TABLE_OFFSET + 8, readField<uint64_t>(good, MIP_TABLE_OFFSET + 8) - 1, 8 },
+			{ "Last level one block or pixel long", lastSize, readField<uint64_t>(good, lastSize) * 2, 8 },
+			{ "Unknown flag", FLAGS_OFFSET, flags | 8, 4 },
+			{ "sRGB flag flipped", FLAGS_OFFSET, flags ^ FLAG_SRGB, 4 },
+			{ "One mip fewer", NUM_MIPS_OFFSET, numMips - 1, 4 },
+		};
+		bool ok = true;
+		for (const Damage& damage : damages) {
+			std::vector<unsigned char> damaged = good;
+			memcpy(damaged.data() + damage.offset, &damage.value, damage.width);
+			writeFile(cachePath, damaged);
+			ew::TextureImage loaded, reloaded;
+			const bool read = ew::loadTextureImage(COPY_PATH, loaded, false, compression);
+			if (!read || loaded.isFromCache() || !sameMips(loaded, built)) {
+				printf("%s, %s: %s\n", source, damage.what, !read ? "failed to load" : (loaded.isFromCache() ? "read from the cache" : "decoded differently"));
+				ok = false;
+			}
+			else if (!ew::loadTextureImage(COPY_PATH, reloaded, false, compression) || !reloaded.isFromCache()) {
+				printf("%s, %s: the cache was not rewritten\n", source, damage.what);
+				ok = false;
+			}
+		}
+		printf("%s%s: %zu damaged caches %s\n", source, compression == ew::TextureCompression::BC1 ? " BC1" : "",
+			sizeof(damages) / sizeof(damages[0]), ok ? "rejected" : "not all rejected");
+		std::filesystem::remove(cachePath, error);
+		return ok;
+	}
+}
+
+/// <summary>
+/// Color and single channel sources, uncompressed and block compressed, so every sRGB flag and block size is checked
+/// </summary>
+bool testTextureCache() {
+	bool ok = true;
+	for (const char* source : SOURCES) {
+		ok = checkSource(source, ew::TextureCompression::None) && ok;
+		ok = checkSource(source, ew::TextureCompression::BC1) && ok;
+	}
+	std::error_code error;
+	std::filesystem::remove(COPY_PATH, error);
+	return ok;
+}
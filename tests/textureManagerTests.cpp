@@ -0,0 +1,102 @@
+#include "tests.h"
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#include <ew/external/glad.h>
+#include <ew/renderState.h>
+#include <ew/textureManager.h>
+#include <ew/imageResample.h>
+
+namespace {
+	const int NUM_TEXTURES = 24;
+	const int NUM_VISIBLE = 4;
+	const int BUDGET_TEXTURES = 6; //Budget in full size textures
+	const int FRAMES_PER_STEP = 5; //Frames before the window moves on by one texture
+	const int NUM_FRAMES = NUM_TEXTURES * FRAMES_PER_STEP * 2;
+	const int MIN_SIZE = 64;
+	const int ARRAY_EVERY = 6; //Every sixth texture is an array of two layers, counting double
+	const char* IMAGE_PATH = "assets/brick_color.jpg";
+}
+
+/// <summary>
+/// Each frame binds the window, updates the manager and waits for its uploads, so every check sees the state
+/// the manager settled on that frame
+/// </summary>
+bool testTextureManager() {
+	ew::TextureImage image;
+	if (!ew::loadTextureImage(IMAGE_PATH, image)) {
+		printf("Failed to load image %s\n", IMAGE_PATH);
+		return false;
+	}
+	size_t fullBytes = 0;
+	for (int level = 0; level < image.getNumMips(); level++) {
+		fullBytes += image.getMip(level).size;
+	}
+
+	ew::AssetLoader loader;
+	ew::TextureManager manager(loader, fullBytes * BUDGET_TEXTURES, MIN_SIZE);
+	std::vector<unsigned int> textures;
+	std::vector<unsigned int> targets;
+	for (int i = 0; i < NUM_TEXTURES; i++) {
+		const bool isArray = i % ARRAY_EVERY == ARRAY_EVERY - 1;
+		textures.push_back(isArray ? manager.loadArray({ IMAGE_PATH, IMAGE_PATH }, GL_REPEAT, GL_LINEAR) : manager.load(IMAGE_PATH, GL_REPEAT, GL_LINEAR));
+		targets.push_back(isArray ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D);
+	}
+	loader.finish();
+	printf("%d textures of %dx%d, %.2f MB each, budget %.2f MB\n", NUM_TEXTURES, image.getWidth(), image.getHeight(),
+		fullBytes / 1048576.0, manager.getBudget() / 1048576.0);
+
+	bool ok = true;
+	double updateMs = 0.0;
+	for (int frame = 0; frame < NUM_FRAMES && ok; frame++) {
+		ew::renderState::beginFrame();
+		const int first = frame / FRAMES_PER_STEP;
+		for (int i = 0; i < NUM_VISIBLE; i++) {
+			ew::renderState::bindTexture(i, targets[(first + i) % NUM_TEXTURES], textures[(first + i) % NUM_TEXTURES]);
+		}
+		auto start = std::chrono::steady_clock::now();
+		manager.update();
+		updateMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		loader.finish();
+
+		const ew::TextureManagerStats& stats = manager.getStats();
+		//Frame 0's stats are from before its drops uploaded, with the first textures loaded still at full size
+		if (frame > 0 && stats.residentBytes > stats.budget) {
+			printf("Frame %d: %zu bytes resident, over the budget of %zu\n", frame, stats.residentBytes, stats.budget);
+			ok = false;
+		}
+		for (int i = 0; i < NUM_TEXTURES; i++) {
+			const int mip = manager.getResidentMip(textures[i]);
+			//Read without binding, which would count as a use
+			GLint width = 0, layers = 0;
+			glGetTextureLevelParameteriv(textures[i], 0, GL_TEXTURE_WIDTH, &width);
+			glGetTextureLevelParameteriv(textures[i], 0, GL_TEXTURE_DEPTH, &layers);
+			const int expectedLayers = targets[i] == GL_TEXTURE_2D_ARRAY ? 2 : 1;
+			if (mip < 0 || width != ew::getMipSize(image.getWidth(), mip) || width < std::min(MIN_SIZE, image.getWidth()) || layers != expectedLayers) {
+				printf("Frame %d: texture %d is at mip %d, %d wide and %d layers in GL\n", frame, i, mip, width, layers);
+				ok = false;
+			}
+		}
+		//The window's textures have had a frame to come back since it last moved
+		if (frame % FRAMES_PER_STEP == FRAMES_PER_STEP - 1) {
+			for (int i = 0; i < NUM_VISIBLE; i++) {
+				if (manager.getResidentMip(textures[(first + i) % NUM_TEXTURES]) != 0) {
+					printf("Frame %d: visible texture %d is still reduced\n", frame, (first + i) % NUM_TEXTURES);
+					ok = false;
+				}
+			}
+		}
+	}
+
+	const ew::TextureManagerStats& stats = manager.getStats();
+	printf("Resident %.2f MB of %.2f MB at full size, %d textures reduced\n", stats.residentBytes / 1048576.0, stats.fullBytes / 1048576.0, stats.numReduced);
+	printf("Mips dropped %zu, restored %zu, %zu uploads (%.1f MB), update %.3f ms per frame\n", stats.mipsDropped, stats.mipsRestored,
+		stats.uploads, stats.bytesUploaded / 1048576.0, updateMs / NUM_FRAMES);
+	if (stats.mipsDropped == 0 || stats.mipsRestored == 0) {
+		printf("Nothing was dropped and restored\n");
+		ok = false;
+	}
+	return ok;
+}
@@ -0,0 +1,95 @@
+#include "tests.h"
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include <random>
+
+#include <ew/transform.h>
+#include <ew/transformHierarchy.h>
+#include <ew/ewMath/transformations.h>
+
+namespace {
+	const int NUM_TRANSFORMS = 100000;
+	const int NUM_EDITS = 1000;
+	//TRS multiplies in a different order than the five matrix product, so the two round differently
+	const float PRODUCT_TOLERANCE = 1e-5f;
+
+	std::vector<ew::Transform> makeTransforms(std::mt19937& random) {
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f), angle(-360.0f, 360.0f), scale(0.25f, 4.0f);
+		std::vector<ew::Transform> transforms(NUM_TRANSFORMS);
+		for (ew::Transform& t : transforms) {
+			t.position = ew::Vec3(position(random), position(random), position(random));
+			t.rotation = ew::Vec3(angle(random), angle(random), angle(random));
+			t.scale = ew::Vec3(scale(random), scale(random), scale(random));
+		}
+		return transforms;
+	}
+
+	float maxDifference(const ew::Mat4& a, const ew::Mat4& b) {
+		float worst = 0.0f;
+		for (int col = 0; col < 4; col++) {
+			for (int row = 0; row < 4; row++) {
+				worst = fmaxf(worst, fabsf(a[col][row] - b[col][row]) / fmaxf(1.0f, fabsf(b[col][row])));
+			}
+		}
+		return worst;
+	}
+
+	/// <summary>
+	/// Every world matrix must be its parent's times its own model matrix, exactly as the hierarchy computes it
+	/// </summary>
+	bool checkWorldMatrices(ew::TransformHierarchy& hierarchy, const char* when) {
+		for (int node = 0; node < (int)hierarchy.getNumNodes(); node++) {
+			const int parent = hierarchy.getParent(node);
+			const ew::Mat4 local = hierarchy.getLocal(node).getModelMatrix();
+			const ew::Mat4 expected = parent >= 0 ? hierarchy.getWorldMatrix(parent) * local : local;
+			if (maxDifference(hierarchy.getWorldMatrix(node), expected) != 0.0f) {
+				printf("%s: node %d's world matrix is not its parent's times its model matrix\n", when, node);
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+/// <summary>
+/// getModelMatrix against the five matrix product it replaced, and the hierarchy's cached world matrices against
+/// getModelMatrix per node, after building and after editing some nodes
+/// </summary>
+bool testTransform() {
+	std::mt19937 random(33);
+	const std::vector<ew::Transform> transforms = makeTransforms(random);
+	float worst = 0.0f;
+	for (const ew::Transform& t : transforms) {
+		const ew::Mat4 product = ew::Translate(t.position) * ew::RotateY(ew::Radians(t.rotation.y)) * ew::RotateX(ew::Radians(t.rotation.x))
+			* ew::RotateZ(ew::Radians(t.rotation.z)) * ew::Scale(t.scale);
+		worst = fmaxf(worst, maxDifference(t.getModelMatrix(), product));
+	}
+	printf("%d transforms: getModelMatrix within %.2e of Translate * RotateY * RotateX * RotateZ * Scale\n", NUM_TRANSFORMS, worst);
+	bool ok = worst <= PRODUCT_TOLERANCE;
+
+	//Each node's parent is a random earlier node, or none
+	ew::TransformHierarchy hierarchy;
+	for (int i = 0; i < NUM_TRANSFORMS; i++) {
+		const int parent = i > 0 && random() % 8 != 0 ? (int)(random() % i) : -1;
+		hierarchy.addNode(transforms[i], parent);
+	}
+	hierarchy.updateWorldMatrices();
+	ok = checkWorldMatrices(hierarchy, "Built") && ok;
+
+	for (int i = 0; i < NUM_EDITS; i++) {
+		const int node = i * (NUM_TRANSFORMS / NUM_EDITS);
+		ew::Transform local = hierarchy.getLocal(node);
+		local.position.y += 1.0f;
+		hierarchy.setLocal(node, local);
+	}
+	hierarchy.takeNumRebuilt();
+	hierarchy.updateWorldMatrices();
+	const int numRebuilt = hierarchy.takeNumRebuilt();
+	printf("Editing %d nodes rebuilt %d matrices\n", NUM_EDITS, numRebuilt);
+	if (numRebuilt < NUM_EDITS || numRebuilt >= NUM_TRANSFORMS) {
+		printf("Expected the edited nodes and their descendants rebuilt, not %d\n", numRebuilt);
+		ok = false;
+	}
+	return checkWorldMatrices(hierarchy, "Edited") && ok;
+}
@@ -0,0 +1,194 @@
+#include "tests.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+#include <ew/virtualTexture.h>
+
+namespace {
+	const int TEXTURE_SIZE = 2048;
+	const int ATLAS_PAGES_PER_SIDE = 4;
+	const char* FILE_PATH = "virtualTextureTest.ewvt";
+
+	/// <summary>
+	/// Every table texel must show the finest resident page at or above it, or be unmapped if there is none
+	/// </summary>
+	bool checkTable(const ew::PageCache& cache) {
+		const ew::VirtualTextureInfo& info = cache.getInfo();
+		for (int mip = 0; mip < info.numMips; mip++) {
+			const int pagesPerSide = info.getPagesPerSide(mip);
+			const std::vector<unsigned char>& table = cache.getTable(mip);
+			for (int y = 0; y < pagesPerSide; y++) {
+				for (int x = 0; x < pagesPerSide; x++) {
+					unsigned char expected[4] = { 0, 0, 255, 255 };
+					for (int above = mip; above < info.numMips; above++) {
+						const int slot = cache.getSlot(ew::makePageId(above, x >> (above - mip), y >> (above - mip)));
+						if (slot >= 0) {
+							expected[0] = (unsigned char)cache.getSlotX(slot);
+							expected[1] = (unsigned char)cache.getSlotY(slot);
+							expected[2] = (unsigned char)above;
+							break;
+						}
+					}
+					if (memcmp(&table[((size_t)y * pagesPerSide + x) * 4], expected, 4) != 0) {
+						printf("Page table mip %d texel %d,%d does not show the finest resident page\n", mip, x, y);
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	//Spreads pages over a feedback buffer round robin, the top rows left empty like sky
+	void fillFeedback(const std::vector<uint32_t>& pages, int width, int height, std::vector<unsigned char>& texels) {
+		texels.assign((size_t)width * height * 4, 0);
+		size_t next = 0;
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				if (y >= height / 4 && !pages.empty()) {
+					ew::encodeFeedbackTexel(pages[next++ % pages.size()], &texels[((size_t)y * width + x) * 4]);
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// Reads the requested pages, checks mip 0 pages against the source, and maps them. Returns the pages mapped.
+	/// </summary>
+	int loadPages(ew::PageCache& cache, ew::PageLoader& loader, const std::vector<uint32_t>& missing, const std::vector<unsigned char>& source, bool& ok) {
+		const ew::VirtualTextureInfo& info = cache.getInfo();
+		const int physicalSize = info.getPhysicalPageSize();
+		loader.request(missing);
+		loader.finish();
+		std::vector<ew::LoadedPage> loaded;
+		loader.collect(loaded);
+		if (loaded.size() != missing.size()) {
+			printf("Asked for %zu pages, loaded %zu\n", missing.size(), loaded.size());
+			ok = false;
+		}
+		int mapped = 0;
+		for (const ew::LoadedPage& page : loaded) {
+			if (ew::getPageMip(page.page) == 0) {
+				for (int y = 0; y < physicalSize && ok; y++) {
+					for (int x = 0; x < physicalSize && ok; x++) {
+						const int srcX = std::clamp(ew::getPageX(page.page) * info.pageSize - info.border + x, 0, TEXTURE_SIZE - 1);
+						const int srcY = std::clamp(ew::getPageY(page.page) * info.pageSize - info.border + y, 0, TEXTURE_SIZE - 1);
+						if (memcmp(&page.data[((size_t)y * physicalSize + x) * 3], &source[((size_t)srcY * TEXTURE_SIZE + srcX) * 3], 3) != 0) {
+							printf("Page %d,%d pixel %d,%d differs from the source\n", ew::getPageX(page.page), ew::getPageY(page.page), x, y);
+							ok = false;
+						}
+					}
+				}
+			}
+			mapped += cache.insert(page.page) >= 0 ? 1 : 0;
+		}
+		return mapped;
+	}
+}
+
+/// <summary>
+/// A 2048 texture in 128 pixel pages has 16x16 pages at mip 0 and 5 mips. The atlas holds 16 pages, one of them
+/// the pinned last mip, so the 13 visible pages of the panning camera fit and older pages must be evicted.
+/// </summary>
+bool testVirtualTexture() {
+	std::vector<unsigned char> source((size_t)TEXTURE_SIZE * TEXTURE_SIZE * 3);
+	for (int y = 0; y < TEXTURE_SIZE; y++) {
+		for (int x = 0; x < TEXTURE_SIZE; x++) {
+			unsigned char* pixel = &source[((size_t)y * TEXTURE_SIZE + x) * 3];
+			pixel[0] = (unsigned char)(x * 7 ^ y * 3);
+			pixel[1] = (unsigned char)(x + y);
+			pixel[2] = (unsigned char)(x / 8 * 31 + y / 8 * 17);
+		}
+	}
+	if (!ew::buildVirtualTexture(FILE_PATH, source.data(), TEXTURE_SIZE, 3)) {
+		return false;
+	}
+	ew::VirtualTextureFile file;
+	if (!file.open(FILE_PATH)) {
+		printf("Failed to open %s\n", FILE_PATH);
+		return false;
+	}
+	const ew::VirtualTextureInfo& info = file.getInfo();
+	printf("%s: %d pixels, %d pixel pages, %d mips\n", FILE_PATH, info.size, info.pageSize, info.numMips);
+
+	bool ok = true;
+	ew::PageCache cache(info, ATLAS_PAGES_PER_SIDE);
+	ew::PageLoader loader(file, 2);
+	const uint32_t lastPage = ew::makePageId(info.numMips - 1, 0, 0);
+	cache.insert(lastPage, true);
+	ok = ok && checkTable(cache);
+
+	//Pan across the texture: 3x3 pages at mip 0 around the center, and 2x2 at mip 2 further away
+	const int feedbackWidth = 80, feedbackHeight = 45;
+	std::vector<unsigned char> feedback;
+	std::vector<uint32_t> missing;
+	for (int frame = 0; frame < 30 && ok; frame++) {
+		const int centerX = 1 + frame % 14, centerY = 8;
+		std::vector<uint32_t> visible;
+		for (int dy = -1; dy <= 1; dy++) {
+			for (int dx = -1; dx <= 1; dx++) {
+				visible.push_back(ew::makePageId(0, centerX + dx, centerY + dy));
+			}
+		}
+		for (int dy = 0; dy < 2; dy++) {
+			for (int dx = 0; dx < 2; dx++) {
+				visible.push_back(ew::makePageId(2, std::min(centerX / 4 + dx, 3), centerY / 4 + dy));
+			}
+		}
+		std::sort(visible.begin(), visible.end());
+		visible.erase(std::unique(visible.begin(), visible.end()), visible.end());
+		fillFeedback(visible, feedbackWidth, feedbackHeight, feedback);
+
+		cache.processFeedback(feedback.data(), (size_t)feedbackWidth * feedbackHeight, missing);
+		for (size_t i = 1; i < missing.size(); i++) {
+			if (ew::getPageMip(missing[i - 1]) < ew::getPageMip(missing[i])) {
+				printf("Frame %d: missing pages are not coarsest first\n", frame);
+				ok = false;
+			}
+		}
+		loadPages(cache, loader, missing, source, ok);
+		for (uint32_t page : visible) {
+			if (!cache.isResident(page)) {
+				printf("Frame %d: visible page mip %d %d,%d was not made resident\n", frame, ew::getPageMip(page), ew::getPageX(page), ew::getPageY(page));
+				ok = false;
+			}
+		}
+		ok = ok && checkTable(cache) && cache.isResident(lastPage) && cache.getNumResident() <= cache.getNumSlots();
+
+		//The same view again needs nothing new
+		cache.processFeedback(feedback.data(), (size_t)feedbackWidth * feedbackHeight, missing);
+		if (!missing.empty()) {
+			printf("Frame %d: %zu pages missing right after loading\n", frame, missing.size());
+			ok = false;
+		}
+	}
+	const ew::PageCacheStats panStats = cache.getStats();
+	printf("Pan: %zu requests, %zu hits, %zu inserted, %zu evicted\n", panStats.requested, panStats.hits, panStats.inserted, panStats.evicted);
+	if (ok && panStats.evicted == 0) {
+		printf("The pan never filled the atlas\n");
+		ok = false;
+	}
+
+	//More visible pages than slots: the ones that don't fit are dropped, and no visible page is evicted for them.
+	//They are away from the pan, so nothing resident but the last mip is drawn in their place.
+	std::vector<uint32_t> crowd;
+	for (int x = 0; x < 10; x++) {
+		crowd.push_back(ew::makePageId(0, x, 0));
+		crowd.push_back(ew::makePageId(0, x, 1));
+	}
+	fillFeedback(crowd, feedbackWidth, feedbackHeight, feedback);
+	cache.processFeedback(feedback.data(), (size_t)feedbackWidth * feedbackHeight, missing);
+	const int mapped = loadPages(cache, loader, missing, source, ok);
+	int visibleResident = 0;
+	for (uint32_t page : crowd) {
+		visibleResident += cache.isResident(page) ? 1 : 0;
+	}
+	printf("Crowd: %zu visible, %d mapped, %zu dropped\n", crowd.size(), mapped, cache.getStats().dropped - panStats.dropped);
+	if (mapped != cache.getNumSlots() - 1 || visibleResident != mapped || cache.getStats().dropped - panStats.dropped != crowd.size() - mapped) {
+		printf("Expected %d of the crowd mapped over older pages and the rest dropped\n", cache.getNumSlots() - 1);
+		ok = false;
+	}
+	return ok && checkTable(cache) && cache.isResident(lastPage);
+}